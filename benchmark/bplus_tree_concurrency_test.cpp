@@ -12,6 +12,7 @@ See the Mulan PSL v2 for more details. */
 // Created by Wangyunlai on 2023/03/14
 //
 #include <inttypes.h>
+#include <list>
 #include <stdexcept>
 #include <benchmark/benchmark.h>
 
@@ -37,6 +38,10 @@ struct Stat
   int64_t not_exist_count      = 0;
   int64_t delete_other_count   = 0;
 
+  int64_t lookup_success_count   = 0;
+  int64_t lookup_miss_count      = 0;
+  int64_t lookup_other_count     = 0;
+
   int64_t scan_success_count     = 0;
   int64_t scan_open_failed_count = 0;
   int64_t mismatch_count         = 0;
@@ -154,6 +159,21 @@ public:
     }
   }
 
+  void Lookup(uint32_t value, Stat &stat)
+  {
+    const char *key = reinterpret_cast<const char *>(&value);
+
+    list<RID> rids;
+    RC        rc = handler_.get_entry(key, sizeof(value), rids);
+    if (rc != RC::SUCCESS) {
+      stat.lookup_other_count++;
+    } else if (rids.empty()) {
+      stat.lookup_miss_count++;
+    } else {
+      stat.lookup_success_count++;
+    }
+  }
+
   void Scan(uint32_t begin, uint32_t end, Stat &stat)
   {
     const char *begin_key = reinterpret_cast<const char *>(&begin);
@@ -296,6 +316,94 @@ BENCHMARK_REGISTER_F(ScanBenchmark, Scan)->Threads(10)->Arg(4 * 10000);
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * 点查询，查找路径上只有叶子节点加锁，线程数增加时吞吐量应该随之增加
+ */
+class PointLookupBenchmark : public BenchmarkBase
+{
+public:
+  string Name() const override { return "point_lookup"; }
+
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    BenchmarkBase::SetUp(state);
+
+    uint32_t max = GetRangeMax(state);
+    ASSERT(max > 0, "invalid argument count. %ld", state.range(0));
+    FillUp(0, max);
+  }
+};
+
+BENCHMARK_DEFINE_F(PointLookupBenchmark, PointLookup)(State &state)
+{
+  IntegerGenerator generator(0, GetRangeMax(state) - 1);
+  Stat             stat;
+
+  for (auto _ : state) {
+    uint32_t value = static_cast<uint32_t>(generator.next());
+    Lookup(value, stat);
+  }
+
+  state.counters["success"] = Counter(stat.lookup_success_count, Counter::kIsRate);
+  state.counters["miss"]    = Counter(stat.lookup_miss_count, Counter::kIsRate);
+  state.counters["other"]   = Counter(stat.lookup_other_count, Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(PointLookupBenchmark, PointLookup)->ThreadRange(1, 16)->Arg(4 * 10000);
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 向已经有数据的索引中插入，大部分插入不会引起分裂，只需要锁住叶子节点
+ */
+class HotInsertionBenchmark : public BenchmarkBase
+{
+public:
+  string Name() const override { return "hot_insertion"; }
+
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    BenchmarkBase::SetUp(state);
+
+    // 只插入偶数，测试时插入的奇数分散在已有的叶子节点中
+    uint32_t max = GetRangeMax(state);
+    ASSERT(max > 0, "invalid argument count. %ld", state.range(0));
+    for (uint32_t value = 0; value < max; value += 2) {
+      const char *key = reinterpret_cast<const char *>(&value);
+      RID         rid(value, value);
+      [[maybe_unused]] RC rc = handler_.insert_entry(key, &rid);
+      ASSERT(rc == RC::SUCCESS, "failed to insert entry into btree. key=%" PRIu32, value);
+    }
+  }
+};
+
+BENCHMARK_DEFINE_F(HotInsertionBenchmark, HotInsertion)(State &state)
+{
+  IntegerGenerator generator(0, GetRangeMax(state) / 2 - 1);
+  Stat             stat;
+
+  for (auto _ : state) {
+    uint32_t value = static_cast<uint32_t>(generator.next()) * 2 + 1;
+    Insert(value, stat);
+  }
+
+  state.counters["success"]   = Counter(stat.insert_success_count, Counter::kIsRate);
+  state.counters["duplicate"] = Counter(stat.duplicate_count, Counter::kIsRate);
+  state.counters["other"]     = Counter(stat.insert_other_count, Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(HotInsertionBenchmark, HotInsertion)->ThreadRange(1, 16)->Arg(4 * 10000);
+
+////////////////////////////////////////////////////////////////////////////////
+
 struct MixtureBenchmark : public BenchmarkBase
 {
   string Name() const override { return "mixture"; }
@@ -0,0 +1,136 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <inttypes.h>
+#include <stdexcept>
+#include <benchmark/benchmark.h>
+
+#include "storage/buffer/disk_buffer_pool.h"
+#include "common/log/log.h"
+#include "integer_generator.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/// 只有一个内存池(128个页帧)，而文件中的页面要多得多，绝大部分访问都不会命中
+BufferPoolManager bpm{DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE};
+
+struct Stat
+{
+  int64_t get_success_count = 0;
+  int64_t get_other_count   = 0;
+  int64_t mismatch_count    = 0;
+};
+
+/**
+ * @brief 测试页面不在内存中时，并发读取页面的吞吐量
+ * @details 每个线程随机读取文件中的页面，几乎每次都需要从磁盘加载。
+ * 不同的页面可以并行加载，所以吞吐量应该随着线程数增加而增加。
+ */
+class BufferPoolMissBenchmark : public Fixture
+{
+public:
+  string Name() const { return "buffer_pool_miss"; }
+
+  string filename() const { return this->Name() + ".bp"; }
+
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    string log_name = this->Name() + ".log";
+    LoggerFactory::init_default(log_name.c_str(), LOG_LEVEL_INFO);
+
+    ::remove(filename().c_str());
+    RC rc = bpm.create_file(filename().c_str());
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("failed to create buffer pool file. filename=%s, rc=%s", filename().c_str(), strrc(rc));
+      throw runtime_error("failed to create buffer pool file.");
+    }
+
+    rc = bpm.open_file(filename().c_str(), buffer_pool_);
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("failed to open buffer pool file. filename=%s, rc=%s", filename().c_str(), strrc(rc));
+      throw runtime_error("failed to open buffer pool file");
+    }
+
+    const int page_num = static_cast<int>(state.range(0));
+    for (int i = 0; i < page_num; i++) {
+      Frame *frame = nullptr;
+      rc = buffer_pool_->allocate_page(&frame);
+      ASSERT(rc == RC::SUCCESS, "failed to allocate page. rc=%s", strrc(rc));
+      *(PageNum *)frame->data() = frame->page_num();
+      frame->mark_dirty();
+      buffer_pool_->unpin_page(frame);
+    }
+    buffer_pool_->flush_all_pages();
+    max_page_num_ = page_num;
+    LOG_INFO("test %s setup done. threads=%d, pages=%d", this->Name().c_str(), state.threads(), page_num);
+  }
+
+  void TearDown(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    buffer_pool_->close_file();
+    buffer_pool_ = nullptr;
+    ::remove(filename().c_str());
+    LOG_INFO("test %s teardown done. threads=%d", this->Name().c_str(), state.threads());
+  }
+
+  void Get(PageNum page_num, Stat &stat)
+  {
+    Frame *frame = nullptr;
+    RC rc = buffer_pool_->get_this_page(page_num, &frame);
+    if (rc != RC::SUCCESS) {
+      stat.get_other_count++;
+      return;
+    }
+
+    if (*(PageNum *)frame->data() != page_num) {
+      stat.mismatch_count++;
+    } else {
+      stat.get_success_count++;
+    }
+    buffer_pool_->unpin_page(frame);
+  }
+
+protected:
+  DiskBufferPool *buffer_pool_  = nullptr;
+  int             max_page_num_ = 0;
+};
+
+BENCHMARK_DEFINE_F(BufferPoolMissBenchmark, RandomGet)(State &state)
+{
+  IntegerGenerator generator(1, max_page_num_);
+  Stat             stat;
+
+  for (auto _ : state) {
+    Get(generator.next(), stat);
+  }
+
+  state.counters["success"]  = Counter(stat.get_success_count, Counter::kIsRate);
+  state.counters["mismatch"] = Counter(stat.mismatch_count, Counter::kIsRate);
+  state.counters["other"]    = Counter(stat.get_other_count, Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(BufferPoolMissBenchmark, RandomGet)
+    ->Arg(16 * DEFAULT_ITEM_NUM_PER_POOL)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+////////////////////////////////////////////////////////////////////////////////
+
+BENCHMARK_MAIN();
@@ -14,6 +14,7 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <sys/types.h>
 #include <string>
 #include <vector>
 
@@ -77,4 +78,26 @@ int writen(int fd, const void *buf, int size);
  */
 int readn(int fd, void *buf, int size);
 
+/**
+ * @brief 从指定位置一次性写入所有指定数据，不修改文件的读写位置，多个线程可以同时使用同一个描述符
+ *
+ * @param fd  写入的描述符
+ * @param buf 写入的数据
+ * @param size 写入多少数据
+ * @param offset 写入的位置
+ * @return int 0 表示成功，否则返回errno
+ */
+int pwriten(int fd, const void *buf, int size, off_t offset);
+
+/**
+ * @brief 从指定位置一次性读取指定长度的数据，不修改文件的读写位置
+ *
+ * @param fd  读取的描述符
+ * @param buf 读取到这里
+ * @param size 读取的数据长度
+ * @param offset 读取的位置
+ * @return int 返回0表示成功。-1 表示读取到文件尾，并且没有读到size大小数据，其它表示errno
+ */
+int preadn(int fd, void *buf, int size, off_t offset);
+
 }  // namespace common
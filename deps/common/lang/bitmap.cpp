@@ -82,9 +82,9 @@ int Bitmap::next_unsetted_bit(int start)
         ret = iter * 8 + index_in_byte;
         break;
       }
-
-      start_in_byte = 0;
     }
+    // 不管当前字节有没有被跳过，后面的字节都从第0位开始找
+    start_in_byte = 0;
   }
 
   if (ret >= size_) {
@@ -105,9 +105,9 @@ int Bitmap::next_setted_bit(int start)
         ret = iter * 8 + index_in_byte;
         break;
       }
-
-      start_in_byte = 0;
     }
+    // 不管当前字节有没有被跳过，后面的字节都从第0位开始找
+    start_in_byte = 0;
   }
 
   if (ret >= size_) {
@@ -24,7 +24,11 @@ int compare_int(void *arg1, void *arg2)
 {
   int v1 = *(int *)arg1;
   int v2 = *(int *)arg2;
-  return v1 - v2;
+  // 不能直接相减，INT_MIN 这样的值会溢出
+  if (v1 < v2) {
+    return -1;
+  }
+  return v1 > v2 ? 1 : 0;
 }
 
 int compare_float(void *arg1, void *arg2)
@@ -14,6 +14,7 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 namespace common {
@@ -130,12 +131,12 @@ public:
     return trx_kit_name_;
   }
 
-  void set_buffer_pool_memory_size(int bytes)
+  void set_buffer_pool_memory_size(int64_t bytes)
   {
     buffer_pool_memory_size_ = bytes;
   }
 
-  int buffer_pool_memory_size() const
+  int64_t buffer_pool_memory_size() const
   {
     return buffer_pool_memory_size_;
   }
@@ -151,7 +152,7 @@ private:
   std::string unix_socket_path_;
   std::string protocol_;
   std::string trx_kit_name_;
-  int buffer_pool_memory_size_ = -1;
+  int64_t buffer_pool_memory_size_ = -1;
 };
 
 ProcessParam *&the_process_param();
@@ -14,7 +14,10 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <stddef.h>
+
 class BufferPoolManager;
+class IoBackend;
 class DefaultHandler;
 class TrxKit;
 
@@ -24,9 +27,13 @@ class TrxKit;
  */
 struct GlobalContext
 {
+  IoBackend *io_backend_ = nullptr;
   BufferPoolManager *buffer_pool_manager_ = nullptr;
   DefaultHandler *handler_ = nullptr;
   TrxKit *trx_kit_ = nullptr;
+  int sql_thread_num_ = 1;  ///< SQLThreads 线程池的线程数，也是并行表扫描最多使用的线程数
+  int index_fill_factor_ = 90;  ///< 创建索引时批量构建的节点填充比例，百分比
+  size_t index_sort_memory_ = 64 * 1024 * 1024;  ///< 创建索引时排序使用的内存，超过时使用外部排序
 
   static GlobalContext &instance();
 };
@@ -25,3 +25,16 @@ See the Mulan PSL v2 for more details. */
 #define SOCKET_BUFFER_SIZE 81920
 
 #define SESSION_STAGE_NAME "SessionStage"
+
+#define BUFFER_POOL "BufferPool"
+#define BUFFER_POOL_MEMORY_SIZE "MemorySize"
+#define BUFFER_POOL_SHARD_NUM "ShardNum"
+#define BUFFER_POOL_REPLACEMENT_POLICY "ReplacementPolicy"
+#define BUFFER_POOL_CLEANER_LOW_WATERMARK "CleanerLowWatermark"
+#define BUFFER_POOL_CLEANER_HIGH_WATERMARK "CleanerHighWatermark"
+#define BUFFER_POOL_CLEANER_INTERVAL "CleanerInterval"
+#define BUFFER_POOL_READ_AHEAD_PAGES "ReadAheadPages"
+#define BUFFER_POOL_IO_BACKEND "IoBackend"
+#define BUFFER_POOL_DIRECT_IO "DirectIO"
+#define BUFFER_POOL_HUGE_PAGE "HugePage"
+#define BUFFER_POOL_DUMP_FILE "DumpFile"
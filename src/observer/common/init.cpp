@@ -14,10 +14,13 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/init.h"
 
+#include <strings.h>
+
 #include "common/ini_setting.h"
 #include "common/conf/ini.h"
 #include "common/lang/string.h"
 #include "common/log/log.h"
+#include "common/os/os.h"
 #include "common/os/path.h"
 #include "common/os/pidfile.h"
 #include "common/os/process.h"
@@ -34,6 +37,7 @@ See the Mulan PSL v2 for more details. */
 #include "sql/query_cache/query_cache_stage.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/default/default_handler.h"
+#include "storage/index/bplus_tree_bulk_loader.h"
 #include "storage/trx/trx.h"
 #include "global_context.h"
 
@@ -151,11 +155,125 @@ int prepare_init_seda()
   return 0;
 }
 
+int init_buffer_pool_param(ProcessParam *process_param, Ini &properties, BufferPoolParam &param)
+{
+  std::map<std::string, std::string> section = properties.get(BUFFER_POOL);
+
+  auto it = section.find(BUFFER_POOL_MEMORY_SIZE);
+  if (it != section.end()) {
+    str_to_val(it->second, param.memory_size);
+  }
+  if (process_param->buffer_pool_memory_size() > 0) {
+    param.memory_size = process_param->buffer_pool_memory_size();
+    LOG_INFO("Use buffer pool memory size in command line: %lld", (long long)param.memory_size);
+  }
+
+  it = section.find(BUFFER_POOL_SHARD_NUM);
+  if (it != section.end()) {
+    str_to_val(it->second, param.shard_num);
+  }
+
+  it = section.find(BUFFER_POOL_REPLACEMENT_POLICY);
+  if (it != section.end()) {
+    param.replacer = it->second;
+  }
+  it = section.find(BUFFER_POOL_CLEANER_LOW_WATERMARK);
+  if (it != section.end()) {
+    str_to_val(it->second, param.cleaner_low_watermark);
+  }
+  it = section.find(BUFFER_POOL_CLEANER_HIGH_WATERMARK);
+  if (it != section.end()) {
+    str_to_val(it->second, param.cleaner_high_watermark);
+  }
+  it = section.find(BUFFER_POOL_CLEANER_INTERVAL);
+  if (it != section.end()) {
+    str_to_val(it->second, param.cleaner_interval_ms);
+  }
+  if (param.cleaner_low_watermark > 0 &&
+      (param.cleaner_low_watermark > 100 || param.cleaner_high_watermark < param.cleaner_low_watermark ||
+       param.cleaner_high_watermark > 100)) {
+    LOG_ERROR("invalid buffer pool cleaner watermark. low=%d, high=%d",
+              param.cleaner_low_watermark, param.cleaner_high_watermark);
+    return -1;
+  }
+
+  it = section.find(BUFFER_POOL_READ_AHEAD_PAGES);
+  if (it != section.end()) {
+    str_to_val(it->second, param.read_ahead_pages);
+  }
+  if (param.read_ahead_pages < 0 || param.read_ahead_pages > ReadAheadWorker::MAX_PENDING_PAGES) {
+    LOG_ERROR("invalid buffer pool read ahead pages: %d", param.read_ahead_pages);
+    return -1;
+  }
+
+  it = section.find(BUFFER_POOL_IO_BACKEND);
+  if (it != section.end()) {
+    param.io_backend = it->second;
+  }
+  if (0 != strcasecmp(param.io_backend.c_str(), "sync") && 0 != strcasecmp(param.io_backend.c_str(), "io_uring")) {
+    LOG_ERROR("invalid io backend: %s", param.io_backend.c_str());
+    return -1;
+  }
+
+  it = section.find(BUFFER_POOL_DIRECT_IO);
+  if (it != section.end()) {
+    param.direct_io = (0 == strcasecmp(it->second.c_str(), "true"));
+  }
+
+  it = section.find(BUFFER_POOL_HUGE_PAGE);
+  if (it != section.end()) {
+    param.huge_page = it->second;
+  }
+  FrameAllocator::HugePage huge_page;
+  if (!FrameAllocator::huge_page_from_name(param.huge_page.c_str(), huge_page)) {
+    LOG_ERROR("invalid buffer pool huge page mode: %s", param.huge_page.c_str());
+    return -1;
+  }
+
+  it = section.find(BUFFER_POOL_DUMP_FILE);
+  if (it != section.end()) {
+    param.dump_file = it->second;
+  }
+
+  std::unique_ptr<FrameReplacer> replacer(FrameReplacer::create(param.replacer.c_str(), 1));
+  if (replacer == nullptr) {
+    LOG_ERROR("invalid buffer pool replacement policy: %s", param.replacer.c_str());
+    return -1;
+  }
+  return 0;
+}
+
 int init_global_objects(ProcessParam *process_param, Ini &properties)
 {
-  GCTX.buffer_pool_manager_ = new BufferPoolManager();
+  BufferPoolParam buffer_pool_param;
+  if (init_buffer_pool_param(process_param, properties, buffer_pool_param) != 0) {
+    LOG_ERROR("failed to init buffer pool param");
+    return -1;
+  }
+  GCTX.io_backend_ = IoBackend::create(buffer_pool_param.io_backend.c_str()).release();
+  IoBackend::set_instance(GCTX.io_backend_);
+  LOG_INFO("use io backend %s", GCTX.io_backend_->name());
+
+  GCTX.buffer_pool_manager_ = new BufferPoolManager(buffer_pool_param);
   BufferPoolManager::set_instance(GCTX.buffer_pool_manager_);
 
+  // 并行表扫描使用的线程数与 SQLThreads 线程池相同，0表示CPU的核数
+  str_to_val(properties.get("count", "0", "SQLThreads"), GCTX.sql_thread_num_);
+  if (GCTX.sql_thread_num_ < 1) {
+    GCTX.sql_thread_num_ = getCpuNum();
+  }
+
+  // 创建索引时批量构建B+树的参数
+  str_to_val(properties.get("FillFactor", "90", "Index"), GCTX.index_fill_factor_);
+  int64_t sort_memory = 0;
+  str_to_val(properties.get("SortMemorySize", "67108864", "Index"), sort_memory);
+  if (sort_memory < static_cast<int64_t>(BplusTreeBulkLoader::MIN_MEMORY_LIMIT)) {
+    LOG_ERROR("invalid index sort memory size: %lld, should not be less than %zu",
+              (long long)sort_memory, BplusTreeBulkLoader::MIN_MEMORY_LIMIT);
+    return -1;
+  }
+  GCTX.index_sort_memory_ = static_cast<size_t>(sort_memory);
+
   GCTX.handler_ = new DefaultHandler();
   
   DefaultHandler::set_default(GCTX.handler_);
@@ -173,11 +291,21 @@ int init_global_objects(ProcessParam *process_param, Ini &properties)
     LOG_ERROR("failed to init handler. rc=%s", strrc(rc));
     return -1;
   }
+
+  // 数据库中的文件都已经打开了，把上次关闭时在内存中的页面加载回来
+  if (!buffer_pool_param.dump_file.empty()) {
+    (void)GCTX.buffer_pool_manager_->load_pages();
+  }
   return ret;
 }
 
 int uninit_global_objects()
 {
+  // 关闭文件时会清理它们的页面，所以要在关闭数据库之前记录内存中的页面
+  if (GCTX.buffer_pool_manager_ != nullptr) {
+    (void)GCTX.buffer_pool_manager_->dump_pages();
+  }
+
   // TODO use global context
   DefaultHandler *default_handler = &DefaultHandler::get_default();
   if (default_handler != nullptr) {
@@ -190,6 +318,12 @@ int uninit_global_objects()
     BufferPoolManager::set_instance(nullptr);
     delete bpm;
   }
+
+  if (GCTX.io_backend_ != nullptr) {
+    IoBackend::set_instance(nullptr);
+    delete GCTX.io_backend_;
+    GCTX.io_backend_ = nullptr;
+  }
   return 0;
 }
 
@@ -79,7 +79,7 @@ void parse_parameter(int argc, char **argv)
         process_param->set_trx_kit_name(optarg);
         break;
       case 'n':
-        process_param->set_buffer_pool_memory_size(atoi(optarg));
+        process_param->set_buffer_pool_memory_size(atoll(optarg));
         break;
       case 'h':
         usage();
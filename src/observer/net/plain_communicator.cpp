@@ -233,23 +233,14 @@ RC PlainCommunicator::write_tuple(SqlResult *sql_result) {
       if (rc != RC::SUCCESS)
         return rc;
 
-      if (value.attr_type() == TEXTS)
-      {
-        RID *rid = reinterpret_cast<RID *>(const_cast<char *>(value.data()));
-        size_t len = rid->text_value;
-        char *ss = new char[len + 1];
-        char *p = ss;
-        while (rid != nullptr && rid->init) {
-          Record rec_new;
-          tuple->get_text_record(rec_new, rid);
-          memcpy(p, rec_new.data(), rec_new.len());
-          p += rec_new.len();
-          rid = rid->next_RID;
+      if (value.attr_type() == TEXTS) {
+        // 记录中只有文本的位置，按页面把文本直接写到输出中
+        rc = tuple->read_text(i, [this](const char *data, int length) { return writer_->writen(data, length); });
+        if (rc != RC::SUCCESS) {
+          LOG_WARN("failed to read text. rc=%s", strrc(rc));
+          return rc;
         }
-        writer_->writen(ss, len);
-        delete ss;
-      }
-      if (!aggregate && value.attr_type() != TEXTS) {
+      } else if (!aggregate) {
         writer_->writen(value.to_string().c_str(), value.to_string().size());
       }
 
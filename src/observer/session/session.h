@@ -79,6 +79,18 @@ public:
   void set_sql_debug(bool sql_debug) { sql_debug_ = sql_debug; }
   bool sql_debug_on() const { return sql_debug_; }
 
+  /**
+   * @brief 之后创建的表使用的页面压缩算法，参考 PageCodec::create
+   */
+  void set_table_compression(const std::string &compression) { table_compression_ = compression; }
+  const std::string &table_compression() const { return table_compression_; }
+
+  /**
+   * @brief 之后创建的表使用的记录格式，参考 RecordFormat
+   */
+  void set_table_record_format(const std::string &record_format) { table_record_format_ = record_format; }
+  const std::string &table_record_format() const { return table_record_format_; }
+
   /**
    * @brief 将指定会话设置到线程变量中
    * 
@@ -97,4 +109,6 @@ private:
   SessionEvent *current_request_ = nullptr; ///< 当前正在处理的请求
   bool trx_multi_operation_mode_ = false;   ///< 当前事务的模式，是否多语句模式. 单语句模式自动提交
   bool sql_debug_ = false;                  ///< 是否输出SQL调试信息
+  std::string table_compression_;           ///< 新建的表使用的页面压缩算法，为空表示不压缩
+  std::string table_record_format_;         ///< 新建的表使用的记录格式，为空表示定长格式
 };
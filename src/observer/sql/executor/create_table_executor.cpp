@@ -39,12 +39,16 @@ RC CreateTableExecutor::execute(SQLStageEvent *sql_event)
     std::vector<std::vector<Value>> *values_list = create_table_stmt->values_list();
 
     const int attribute_count = static_cast<int>(attrs->size());
-    rc = session->get_current_db()->create_table(table_name, attribute_count, attrs->data(), values_list);
+    rc = session->get_current_db()->create_table(
+        table_name, attribute_count, attrs->data(), values_list,
+        session->table_compression().c_str(), session->table_record_format().c_str());
     delete attrs;
     delete values_list;
   } else {
     const int attribute_count = static_cast<int>(create_table_stmt->attr_infos().size());
-    rc = session->get_current_db()->create_table(table_name, attribute_count, create_table_stmt->attr_infos().data(), nullptr);
+    rc = session->get_current_db()->create_table(table_name, attribute_count,
+        create_table_stmt->attr_infos().data(), nullptr,
+        session->table_compression().c_str(), session->table_record_format().c_str());
   }
 
   return rc;
@@ -14,6 +14,8 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <errno.h>
+
 #include "common/rc.h"
 #include "sql/operator/string_list_physical_operator.h"
 #include "event/sql_event.h"
@@ -21,6 +23,10 @@ See the Mulan PSL v2 for more details. */
 #include "sql/executor/sql_result.h"
 #include "session/session.h"
 #include "sql/stmt/set_variable_stmt.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/common/meta_util.h"
+#include "storage/db/db.h"
+#include "storage/table/table.h"
 
 /**
  * @brief SetVariable语句执行器
@@ -49,14 +55,86 @@ public:
 
       session->set_sql_debug(bool_value);
       LOG_TRACE("set sql_debug to %d", bool_value);
+    } else if (strcasecmp(var_name, "buffer_pool_size") == 0) {
+      // 缓冲池的内存大小，单位字节
+      int64_t memory_size = 0;
+      rc = var_value_to_int64(var_value, memory_size);
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+      rc = BufferPoolManager::instance().resize(memory_size);
+    } else if (strcasecmp(var_name, "table_compression") == 0) {
+      // 之后创建的表使用的页面压缩算法，none 表示不压缩
+      if (var_value.attr_type() != AttrType::CHARS) {
+        return RC::VARIABLE_NOT_VALID;
+      }
+      const std::string codec = var_value.get_string();
+      if (PageCodec::enabled(codec.c_str()) && PageCodec::create(codec.c_str()) == nullptr) {
+        return RC::VARIABLE_NOT_VALID;
+      }
+      session->set_table_compression(codec);
+    } else if (strcasecmp(var_name, "table_record_format") == 0) {
+      // 之后创建的表使用的记录格式，fixed 或者 slotted
+      if (var_value.attr_type() != AttrType::CHARS) {
+        return RC::VARIABLE_NOT_VALID;
+      }
+      const std::string format_name = var_value.get_string();
+      RecordFormat format;
+      if (!record_format_from_name(format_name.c_str(), format)) {
+        return RC::VARIABLE_NOT_VALID;
+      }
+      session->set_table_record_format(format_name);
+    } else if (strcasecmp(var_name, "buffer_pool_table_quota") == 0) {
+      // 格式为 '表名:页帧个数'，页帧个数为0表示取消限制
+      rc = set_table_frame_quota(session, var_value);
     } else {
       rc = RC::VARIABLE_NOT_EXISTS;
     }
 
-    return RC::SUCCESS;
+    return rc;
   }
 
 private:
+  /**
+   * @brief 限制一个表最多占用多少个页帧，表的数据文件和每个索引文件分别使用这个配额
+   */
+  RC set_table_frame_quota(Session *session, const Value &var_value) const
+  {
+    if (var_value.attr_type() != AttrType::CHARS) {
+      return RC::VARIABLE_NOT_VALID;
+    }
+
+    const std::string quota_string = var_value.get_string();
+    const size_t pos = quota_string.rfind(':');
+    if (pos == std::string::npos || pos == 0 || pos + 1 == quota_string.size()) {
+      return RC::VARIABLE_NOT_VALID;
+    }
+
+    char *end = nullptr;
+    const long frame_num = strtol(quota_string.c_str() + pos + 1, &end, 10);
+    if (*end != '\0' || frame_num < 0 || frame_num > INT32_MAX) {
+      return RC::VARIABLE_NOT_VALID;
+    }
+
+    const std::string table_name = quota_string.substr(0, pos);
+    Db *db = session->get_current_db();
+    Table *table = db == nullptr ? nullptr : db->find_table(table_name.c_str());
+    if (table == nullptr || table->type() != Table::PHYSICAL) {
+      LOG_WARN("no such table. table=%s", table_name.c_str());
+      return RC::SCHEMA_TABLE_NOT_EXIST;
+    }
+
+    BufferPoolManager &bpm = BufferPoolManager::instance();
+    std::string file_name = table_data_file(table->table_dir(), table->name());
+    RC rc = bpm.set_frame_quota(file_name.c_str(), static_cast<int>(frame_num));
+    const TableMeta &table_meta = table->table_meta();
+    for (int i = 0; OB_SUCC(rc) && i < table_meta.index_num(); i++) {
+      file_name = table_index_file(table->table_dir(), table->name(), table_meta.index(i)->name());
+      rc = bpm.set_frame_quota(file_name.c_str(), static_cast<int>(frame_num));
+    }
+    return rc;
+  }
+
   RC var_value_to_boolean(const Value &var_value, bool &bool_value) const
   {
     RC rc = RC::SUCCESS;
@@ -103,4 +181,29 @@ private:
 
     return rc;
   }
+
+  /**
+   * @brief 整数类型的变量值
+   * @details SQL 中的整数常量只有32位，超过的值(比如大于2G的内存大小)可以写成字符串
+   */
+  RC var_value_to_int64(const Value &var_value, int64_t &int_value) const
+  {
+    if (var_value.attr_type() == AttrType::INTS) {
+      int_value = var_value.get_int();
+      return RC::SUCCESS;
+    }
+    if (var_value.attr_type() != AttrType::CHARS) {
+      return RC::VARIABLE_NOT_VALID;
+    }
+
+    const std::string str = var_value.get_string();
+    char *end = nullptr;
+    errno = 0;
+    const long long value = strtoll(str.c_str(), &end, 10);
+    if (str.empty() || *end != '\0' || errno == ERANGE) {
+      return RC::VARIABLE_NOT_VALID;
+    }
+    int_value = value;
+    return RC::SUCCESS;
+  }
 };
\ No newline at end of file
@@ -14,6 +14,7 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <vector>
 #include <string>
@@ -26,8 +27,7 @@ See the Mulan PSL v2 for more details. */
 #include "sql/parser/value.h"
 #include "sql/expr/expression.h"
 #include "storage/record/record.h"
-
-class Table;
+#include "storage/table/table.h"
 
 /**
  * @defgroup Tuple
@@ -111,7 +111,21 @@ public:
    */
   virtual RC cell_at(int index, Value &cell) const = 0;
 
-  virtual RC get_text_record(Record &rec,RID *rid) = 0;
+  /**
+   * @brief 读取指定位置上 TEXT 字段的内容
+   * @details 直接来自表的 TEXT 字段只是文本在溢出文件中的位置，要知道字段来自哪张表才能读出来，
+   * 参考 Table::read_text。只有输出时才需要读取文本。
+   * 不知道来源表的元组（比如分组的结果）在物化时已经把文本内容读到了 cell 里，直接输出即可
+   */
+  virtual RC read_text(int index, const std::function<RC(const char *, int)> &consumer) const
+  {
+    Value cell;
+    RC rc = cell_at(index, cell);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    return consumer(cell.data(), cell.length());
+  }
 
   /**
    * @brief 根据cell的描述，获取cell的值
@@ -262,9 +276,14 @@ public:
   std::vector<FieldExpr *> &speces() { return speces_; }
   void set_speces(std::vector<FieldExpr *> &speces) {  speces_ = speces; };
 
-  RC get_text_record(Record &rec,RID *rid) override {
-    RC rc = const_cast<Table *>(table_)->get_record(*rid, rec);
-    return rc;
+  RC read_text(int index, const std::function<RC(const char *, int)> &consumer) const override
+  {
+    Value cell;
+    RC rc = cell_at(index, cell);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    return table_->read_text(cell, consumer);
   }
 
 private:
@@ -328,26 +347,43 @@ public:
     bool isagg;
     exprs_[0]->is_aggregate(isagg);
 
-    int field_num = 0;
-    int last_field_num = 0;
-    size_t expr_index;
-    for (expr_index = 0; expr_index < exprs_.size(); expr_index++) {
-      Expression *expr = exprs_[expr_index];
-      last_field_num = field_num;
-      if (expr->type() == ExprType::STAR && !isagg) 
-        field_num += static_cast<StarExpr *>(expr)->field().size();
-      else 
-        field_num += 1;
-      if (field_num > index) 
-        break;
-    }
-
-    Expression *expr = exprs_[expr_index];
+    int star_index = 0;
+    Expression *expr = find_expr(index, isagg, star_index);
     if (expr->type() == ExprType::STAR) {
       StarExpr *star_expr = static_cast<StarExpr *>(expr);
-      return star_expr->get_value(index - last_field_num, *tuple_, cell);
+      return star_expr->get_value(star_index, *tuple_, cell);
     } 
-    return exprs_[expr_index]->get_value(*tuple_, cell);
+    return expr->get_value(*tuple_, cell);
+  }
+
+  RC read_text(int index, const std::function<RC(const char *, int)> &consumer) const override
+  {
+    if (tuple_ == nullptr || exprs_.size() == 0 || !exprs_[0]) {
+      return RC::INTERNAL;
+    }
+
+    bool isagg;
+    exprs_[0]->is_aggregate(isagg);
+
+    // 只有直接投影出来的字段才知道来自哪张表
+    int star_index = 0;
+    Expression *expr = find_expr(index, isagg, star_index);
+    const Table *table = nullptr;
+    if (expr->type() == ExprType::STAR) {
+      table = static_cast<StarExpr *>(expr)->field()[star_index].table();
+    } else if (expr->type() == ExprType::FIELD) {
+      table = static_cast<FieldExpr *>(expr)->field().table();
+    }
+    if (table == nullptr) {
+      return Tuple::read_text(index, consumer);
+    }
+
+    Value cell;
+    RC rc = cell_at(index, cell);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    return table->read_text(cell, consumer);
   }
 
   RC find_cell(const TupleCellSpec &spec, Value &cell) const override
@@ -379,16 +415,34 @@ public:
     }
   }
 
-  RC get_text_record(Record &rec,RID *rid) override {
-    static_cast<RowTuple *>(tuple_)->get_text_record(rec, rid);
-    RC rc = RC::SUCCESS;
-    return rc;
-  }
-
   std::vector<Expression *> &exprs() {
     return exprs_;
   }
 
+private:
+  /**
+   * @brief 找到第 index 个cell对应的表达式
+   * @param[out] star_index 表达式是 * 时，cell是其中的第几个字段
+   */
+  Expression *find_expr(int index, bool isagg, int &star_index) const
+  {
+    int field_num = 0;
+    int last_field_num = 0;
+    size_t expr_index;
+    for (expr_index = 0; expr_index < exprs_.size(); expr_index++) {
+      Expression *expr = exprs_[expr_index];
+      last_field_num = field_num;
+      if (expr->type() == ExprType::STAR && !isagg) 
+        field_num += static_cast<StarExpr *>(expr)->field().size();
+      else 
+        field_num += 1;
+      if (field_num > index) 
+        break;
+    }
+    star_index = index - last_field_num;
+    return exprs_[expr_index];
+  }
+
 private:
   std::vector<Expression *> exprs_;
   Tuple *tuple_ = nullptr;
@@ -439,12 +493,6 @@ public:
     return RC::NOTFOUND;
   }
 
-  RC get_text_record(Record &rec,RID *rid) override {
-    RC rc = RC::SUCCESS;
-    return rc;
-  }
-
-
 private:
   const std::vector<std::unique_ptr<Expression>> &expressions_;
 };
@@ -488,11 +536,6 @@ public:
     return RC::INTERNAL;
   }
 
-  RC get_text_record(Record &rec,RID *rid) override {
-    RC rc = RC::SUCCESS;
-    return rc;
-  }
-
 private:
   std::vector<Value> cells_;
 };
@@ -560,9 +603,18 @@ public:
     return right_->find_cell(spec, value);
   }
 
-  RC get_text_record(Record &rec,RID *rid) override {
-    RC rc = RC::SUCCESS;
-    return rc;
+  RC read_text(int index, const std::function<RC(const char *, int)> &consumer) const override
+  {
+    const int left_cell_num = left_->cell_num();
+    if (index >= 0 && index < left_cell_num) {
+      return left_->read_text(index, consumer);
+    }
+
+    if (index >= left_cell_num && index < left_cell_num + right_->cell_num()) {
+      return right_->read_text(index - left_cell_num, consumer);
+    }
+
+    return RC::NOTFOUND;
   }
 
 private:
@@ -604,7 +656,5 @@ public:
     return RC::INTERNAL;
   }
 
-  RC get_text_record(Record &rec,RID *rid) override { return RC::SUCCESS; };
-
   std::vector<Value> cells_;
 };
\ No newline at end of file
@@ -36,6 +36,29 @@ bool is_a_group(std::vector<Value> &a, std::vector<Value> &b) {
 	return true;
 }
 
+/**
+ * @brief 分组结果不再知道字段来自哪张表，把 TEXT 字段的内容读出来放到 value 里
+ * @details 参考 Tuple::read_text
+ */
+static RC materialize_text(Expression *attr, Value &v)
+{
+	if (v.attr_type() != TEXTS || attr->type() != ExprType::FIELD) {
+		return RC::SUCCESS;
+	}
+
+	const Table *table = static_cast<FieldExpr *>(attr)->field().table();
+	std::string text;
+	RC rc = table->read_text(v, [&text](const char *data, int length) {
+		text.append(data, length);
+		return RC::SUCCESS;
+	});
+	if (rc != RC::SUCCESS) {
+		return rc;
+	}
+	v.set_text(text.data(), static_cast<int>(text.size()));
+	return RC::SUCCESS;
+}
+
 RC GroupByPhysicalOperator::next()
 {
   RC rc = RC::SUCCESS;
@@ -116,6 +139,11 @@ RC GroupByPhysicalOperator::next()
 				// if it is the last iterate, push the value
 				if (&t == &group.back()) {
 					attr->reset_aggregate();
+					rc = materialize_text(attr, v);
+					if (rc != RC::SUCCESS) {
+						LOG_WARN("group by read text error");
+						return rc;
+					}
 					group_tuple.cells_.push_back(v);
 				}
 			}
@@ -12,27 +12,26 @@ See the Mulan PSL v2 for more details. */
 // Created by Wangyunlai on 2022/07/08.
 //
 
+#include <string.h>
+#include <algorithm>
+#include <limits>
+
 #include "sql/operator/index_scan_physical_operator.h"
 #include "storage/index/index.h"
 #include "storage/trx/trx.h"
 
 IndexScanPhysicalOperator::IndexScanPhysicalOperator(
     Table *table, Index *index, bool readonly, 
-    const Value *left_value, bool left_inclusive, 
-    const Value *right_value, bool right_inclusive)
+    const std::vector<Value> &left_values, bool left_inclusive, 
+    const std::vector<Value> &right_values, bool right_inclusive)
     : table_(table), 
       index_(index), 
       readonly_(readonly), 
+      left_values_(left_values), 
+      right_values_(right_values), 
       left_inclusive_(left_inclusive), 
       right_inclusive_(right_inclusive)
-{
-  if (left_value) {
-    left_value_ = *left_value;
-  }
-  if (right_value) {
-    right_value_ = *right_value;
-  }
-}
+{}
 
 RC IndexScanPhysicalOperator::open(Trx *trx)
 {
@@ -40,24 +39,34 @@ RC IndexScanPhysicalOperator::open(Trx *trx)
     return RC::INTERNAL;
   }
 
-  IndexScanner *index_scanner = index_->create_scanner(left_value_.data(),
-      left_value_.length(),
-      left_inclusive_,
-      right_value_.data(),
-      right_value_.length(),
-      right_inclusive_);
-  if (nullptr == index_scanner) {
-    LOG_WARN("failed to create index scanner");
-    return RC::INTERNAL;
-  }
-
   record_handler_ = table_->record_handler();
   if (nullptr == record_handler_) {
     LOG_WARN("invalid record handler");
-    index_scanner->destroy();
     return RC::INTERNAL;
   }
-  index_scanner_ = index_scanner;
+
+  // 空的范围不能交给索引，B+树会认为是非法参数
+  if (!empty_range()) {
+    std::string left_key;
+    std::string right_key;
+    bool left_inclusive = left_inclusive_;
+    bool right_inclusive = right_inclusive_;
+    make_key(left_values_, true /*is_left*/, left_inclusive, left_key);
+    make_key(right_values_, false /*is_left*/, right_inclusive, right_key);
+
+    IndexScanner *index_scanner = index_->create_scanner(
+        left_values_.empty() ? nullptr : left_key.data(),
+        static_cast<int>(left_key.size()),
+        left_inclusive,
+        right_values_.empty() ? nullptr : right_key.data(),
+        static_cast<int>(right_key.size()),
+        right_inclusive);
+    if (nullptr == index_scanner) {
+      LOG_WARN("failed to create index scanner");
+      return RC::INTERNAL;
+    }
+    index_scanner_ = index_scanner;
+  }
 
   tuple_.set_schema(table_, table_->table_meta().field_metas());
 
@@ -67,6 +76,10 @@ RC IndexScanPhysicalOperator::open(Trx *trx)
 
 RC IndexScanPhysicalOperator::next()
 {
+  if (nullptr == index_scanner_) {
+    return RC::RECORD_EOF;
+  }
+
   RID rid;
   RC rc = RC::SUCCESS;
 
@@ -102,8 +115,10 @@ RC IndexScanPhysicalOperator::next()
 
 RC IndexScanPhysicalOperator::close()
 {
-  index_scanner_->destroy();
-  index_scanner_ = nullptr;
+  if (index_scanner_ != nullptr) {
+    index_scanner_->destroy();
+    index_scanner_ = nullptr;
+  }
   return RC::SUCCESS;
 }
 
@@ -118,6 +133,80 @@ void IndexScanPhysicalOperator::set_predicates(std::vector<std::unique_ptr<Expre
   predicates_ = std::move(exprs);
 }
 
+bool IndexScanPhysicalOperator::empty_range() const
+{
+  if (left_values_.empty() || right_values_.empty()) {
+    return false;
+  }
+
+  const size_t common_num = std::min(left_values_.size(), right_values_.size());
+  for (size_t i = 0; i < common_num; i++) {
+    int result = 0;
+    if (left_values_[i].compare(right_values_[i], result) != RC::SUCCESS) {
+      return false;
+    }
+    if (result != 0) {
+      return result > 0;
+    }
+  }
+
+  if (left_values_.size() == right_values_.size()) {
+    return !(left_inclusive_ && right_inclusive_);
+  }
+  // 较短的前缀不包含边界时，排除了所有以它开头的键值，另一边的边界也在其中
+  return left_values_.size() < right_values_.size() ? !left_inclusive_ : !right_inclusive_;
+}
+
+void IndexScanPhysicalOperator::make_key(
+    const std::vector<Value> &values, bool is_left, bool &inclusive, std::string &key) const
+{
+  const std::vector<FieldMeta> &field_metas = index_->field_meta();
+
+  key.clear();
+  size_t i = 0;
+  while (i < values.size() && i < field_metas.size()) {
+    const FieldMeta &field_meta = field_metas[i];
+    const Value &value = values[i];
+    i++;
+
+    const size_t offset = key.size();
+    key.append(field_meta.len(), 0);
+    memcpy(&key[offset], value.data(), std::min(field_meta.len(), value.length()));
+    if (value.length() > field_meta.len() && (value.attr_type() == CHARS || value.attr_type() == DATES)) {
+      inclusive = true;
+      break;
+    }
+  }
+
+  // 包含边界的左边界和不包含边界的右边界填最小值，其它情况填最大值
+  const bool fill_max = (is_left != inclusive);
+  for (; i < field_metas.size(); i++) {
+    const FieldMeta &field_meta = field_metas[i];
+    const size_t offset = key.size();
+    key.append(field_meta.len(), fill_max ? static_cast<char>(0xFF) : 0);
+
+    char *data = &key[offset];
+    switch (field_meta.type()) {
+      case INTS: {
+        const int32_t bound = fill_max ? std::numeric_limits<int32_t>::max() : std::numeric_limits<int32_t>::min();
+        memcpy(data, &bound, std::min(field_meta.len(), static_cast<int>(sizeof(bound))));
+      } break;
+      case FLOATS: {
+        const float bound = fill_max ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+        memcpy(data, &bound, std::min(field_meta.len(), static_cast<int>(sizeof(bound))));
+      } break;
+      case DATES: {
+        const char *bound = fill_max ? "9999-12-31" : "0000-01-01";
+        memset(data, 0, field_meta.len());
+        memcpy(data, bound, std::min(field_meta.len(), static_cast<int>(strlen(bound))));
+      } break;
+      default: {
+        // 字符串按字节比较，全0最小，全0xFF最大
+      } break;
+    }
+  }
+}
+
 RC IndexScanPhysicalOperator::filter(RowTuple &tuple, bool &result)
 {
   RC rc = RC::SUCCESS;
@@ -141,5 +230,17 @@ RC IndexScanPhysicalOperator::filter(RowTuple &tuple, bool &result)
 
 std::string IndexScanPhysicalOperator::param() const
 {
-  return std::string(index_->index_meta().name()) + " ON " + table_->name();
+  auto bound_string = [](const std::vector<Value> &values) {
+    std::string result;
+    for (const Value &value : values) {
+      result += (result.empty() ? "" : ",") + value.to_string();
+    }
+    return values.size() > 1 ? "(" + result + ")" : result;
+  };
+
+  std::string range;
+  range += left_values_.empty() ? "(-inf" : (left_inclusive_ ? "[" : "(") + bound_string(left_values_);
+  range += ", ";
+  range += right_values_.empty() ? "+inf)" : bound_string(right_values_) + (right_inclusive_ ? "]" : ")");
+  return std::string(index_->index_meta().name()) + " ON " + table_->name() + " " + range;
 }
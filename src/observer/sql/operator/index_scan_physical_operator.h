@@ -21,13 +21,17 @@ See the Mulan PSL v2 for more details. */
 /**
  * @brief 索引扫描物理算子
  * @ingroup PhysicalOperator
+ * @details 扫描索引上左右边界之间的数据。边界是索引键值的前缀，按照索引字段的顺序给出前几个字段的值，
+ * 比如索引 (a, b, c) 上 a = 1 AND b > 5 的左边界是 (1, 5)，不包含边界，右边界是 (1)，包含边界。
+ * 前缀是空的表示这一边没有边界。
+ * 范围是空的(比如 a > 20 AND a < 10)时不访问索引，直接返回没有数据。
  */
 class IndexScanPhysicalOperator : public PhysicalOperator
 {
 public:
   IndexScanPhysicalOperator(Table *table, Index *index, bool readonly, 
-      const Value *left_value, bool left_inclusive,
-      const Value *right_value, bool right_inclusive);
+      const std::vector<Value> &left_values, bool left_inclusive,
+      const std::vector<Value> &right_values, bool right_inclusive);
 
   virtual ~IndexScanPhysicalOperator() = default;
 
@@ -47,6 +51,18 @@ public:
   void set_predicates(std::vector<std::unique_ptr<Expression>> &&exprs);
 
 private:
+  /**
+   * @brief 左边界大于右边界，或者两者相等但不是闭区间
+   */
+  bool empty_range() const;
+
+  /**
+   * @brief 把边界前缀补齐成完整的索引键值
+   * @details 没有给出的字段填上最小值或者最大值，使边界包含或者排除所有以这个前缀开头的键值。
+   * 字符串比字段长时截断，同时把边界改成包含，多扫描的数据由谓词过滤掉
+   */
+  void make_key(const std::vector<Value> &values, bool is_left, bool &inclusive, std::string &key) const;
+
   // 与TableScanPhysicalOperator代码相同，可以优化
   RC filter(RowTuple &tuple, bool &result);
 
@@ -62,8 +78,8 @@ private:
   Record current_record_;
   RowTuple tuple_;
 
-  Value left_value_;
-  Value right_value_;
+  std::vector<Value> left_values_;
+  std::vector<Value> right_values_;
   bool left_inclusive_ = false;
   bool right_inclusive_ = false;
 
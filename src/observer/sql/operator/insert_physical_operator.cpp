@@ -25,19 +25,20 @@ InsertPhysicalOperator::InsertPhysicalOperator(Table *table, std::vector<std::ve
 
 RC InsertPhysicalOperator::open(Trx *trx)
 {
-  RC rc = RC::SUCCESS;
-  for (vector<Value> &values : *values_list_) {
-    Record record;
-    RC rc = table_->make_record(static_cast<int>(values.size()), values.data(), record);
+  // 先生成所有的记录，然后一次性插入，同一个页面上的记录只需要加一次锁，整批记录也只写一条日志
+  vector<Record> records(values_list_->size());
+  for (size_t i = 0; i < values_list_->size(); i++) {
+    vector<Value> &values = (*values_list_)[i];
+    RC rc = table_->make_record(static_cast<int>(values.size()), values.data(), records[i]);
     if (rc != RC::SUCCESS) {
       LOG_WARN("failed to make record. rc=%s", strrc(rc));
       return rc;
     }
-    rc = trx->insert_record(table_, record);
-    if (rc != RC::SUCCESS) {
-      LOG_WARN("failed to insert record by transaction. rc=%s", strrc(rc));
-      return rc;
-    }
+  }
+
+  RC rc = trx->insert_records(table_, records);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to insert records by transaction. rc=%s", strrc(rc));
   }
   return rc;
 }
@@ -0,0 +1,232 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "sql/operator/parallel_scanner.h"
+#include "common/log/log.h"
+#include "sql/expr/expression.h"
+#include "sql/expr/tuple.h"
+#include "storage/record/record_manager.h"
+#include "storage/table/table.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief 表达式能不能在多个线程中同时计算
+ * @details 这些表达式计算时只读取自己的成员，子查询等表达式计算时会修改内部的状态
+ */
+bool thread_safe_expression(Expression *expr)
+{
+  Expression *left  = nullptr;
+  Expression *right = nullptr;
+  switch (expr->type()) {
+    case ExprType::VALUE:
+    case ExprType::FIELD: {
+      return true;
+    }
+    case ExprType::COMPARISON: {
+      left  = static_cast<ComparisonExpr *>(expr)->left().get();
+      right = static_cast<ComparisonExpr *>(expr)->right().get();
+    } break;
+    case ExprType::CONJUNCTION: {
+      left  = static_cast<ConjunctionExpr *>(expr)->left().get();
+      right = static_cast<ConjunctionExpr *>(expr)->right().get();
+    } break;
+    case ExprType::ARITHMETIC: {
+      left  = static_cast<ArithmeticExpr *>(expr)->left().get();
+      right = static_cast<ArithmeticExpr *>(expr)->right().get();
+    } break;
+    default: {
+      return false;
+    }
+  }
+  return (left == nullptr || thread_safe_expression(left)) && (right == nullptr || thread_safe_expression(right));
+}
+
+}  // namespace
+
+ParallelScanner::~ParallelScanner() { close(); }
+
+bool ParallelScanner::can_parallel(const vector<unique_ptr<Expression>> &predicates)
+{
+  for (const unique_ptr<Expression> &predicate : predicates) {
+    if (!thread_safe_expression(predicate.get())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+RC ParallelScanner::open(Table *table, Trx *trx, const vector<unique_ptr<Expression>> &predicates,
+    const vector<ZoneCondition> &zone_conditions, int page_count, int worker_num)
+{
+  if (!workers_.empty()) {
+    LOG_WARN("parallel scanner has been opened");
+    return RC::RECORD_OPENNED;
+  }
+  if (worker_num <= 0 || page_count <= 0) {
+    return RC::INVALID_ARGUMENT;
+  }
+
+  table_           = table;
+  trx_             = trx;
+  predicates_      = &predicates;
+  zone_conditions_ = zone_conditions;
+  page_count_      = page_count;
+  morsel_num_      = (page_count + MORSEL_PAGES - 1) / MORSEL_PAGES;
+  window_          = 2 * worker_num;
+  next_morsel_     = 0;
+  current_morsel_  = 0;
+  stopped_         = false;
+  morsels_.clear();
+  morsels_.resize(window_);
+  current_.reset();
+  current_pos_ = 0;
+
+  worker_num = min(worker_num, morsel_num_);
+  for (int i = 0; i < worker_num; i++) {
+    workers_.emplace_back(&ParallelScanner::worker_func, this);
+  }
+  LOG_TRACE("parallel scan started. table=%s, pages=%d, morsels=%d, workers=%d",
+            table->name(), page_count, morsel_num_, worker_num);
+  return RC::SUCCESS;
+}
+
+RC ParallelScanner::next(Record &record)
+{
+  while (true) {
+    if (current_ != nullptr && current_pos_ < current_->records.size()) {
+      Record &result = current_->records[current_pos_++];
+      record         = Record();
+      record.set_data(result.data(), result.len());
+      record.set_rid(result.rid());
+      return RC::SUCCESS;
+    }
+
+    unique_lock<mutex> lock(mutex_);
+    if (current_morsel_ >= morsel_num_) {
+      current_.reset();
+      return RC::RECORD_EOF;
+    }
+
+    unique_ptr<Morsel> &slot = morsels_[current_morsel_ % window_];
+    consumer_cond_.wait(lock, [&slot]() { return slot != nullptr; });
+    current_     = std::move(slot);
+    current_pos_ = 0;
+    current_morsel_++;
+    worker_cond_.notify_all();
+    lock.unlock();
+
+    if (OB_FAIL(current_->rc)) {
+      LOG_WARN("failed to scan morsel. table=%s, morsel=%d, rc=%s", table_->name(), current_morsel_ - 1, strrc(current_->rc));
+      return current_->rc;
+    }
+  }
+}
+
+void ParallelScanner::close()
+{
+  if (workers_.empty()) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> guard(mutex_);
+    stopped_ = true;
+  }
+  worker_cond_.notify_all();
+  for (thread &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+  morsels_.clear();
+  current_.reset();
+  current_pos_ = 0;
+}
+
+void ParallelScanner::worker_func()
+{
+  unique_lock<mutex> lock(mutex_);
+  while (!stopped_ && next_morsel_ < morsel_num_) {
+    // 调用者还没有读完之前的结果，不能再往前扫描了
+    if (next_morsel_ >= current_morsel_ + window_) {
+      worker_cond_.wait(lock);
+      continue;
+    }
+
+    const int morsel_index = next_morsel_++;
+    lock.unlock();
+
+    unique_ptr<Morsel> morsel(new Morsel);
+    morsel->rc = scan_morsel(morsel_index, morsel->records);
+
+    lock.lock();
+    morsels_[morsel_index % window_] = std::move(morsel);
+    consumer_cond_.notify_all();
+  }
+}
+
+RC ParallelScanner::scan_morsel(int morsel_index, vector<Record> &records)
+{
+  // 扫描器遍历页面号大于 start_page 并且小于 end_page 的页面
+  const PageNum start_page = morsel_index * MORSEL_PAGES - 1;
+  const PageNum end_page   = min((morsel_index + 1) * MORSEL_PAGES, page_count_);
+
+  RecordFileScanner scanner;
+  if (!zone_conditions_.empty()) {
+    scanner.set_zone_conditions(&table_->record_handler()->zone_map(), zone_conditions_);
+  }
+  RC rc = table_->get_record_scanner(scanner, trx_, true /*readonly*/, start_page, end_page);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  const int record_size = table_->table_meta().record_size();
+  RowTuple  tuple;
+  tuple.set_schema(table_, table_->table_meta().field_metas());
+
+  Record record;
+  Value  value;
+  while (OB_SUCC(rc) && scanner.has_next()) {
+    rc = scanner.next(record);
+    if (OB_FAIL(rc)) {
+      break;
+    }
+
+    tuple.set_record(&record);
+    bool matched = true;
+    for (const unique_ptr<Expression> &predicate : *predicates_) {
+      rc = predicate->get_value(tuple, value);
+      if (OB_FAIL(rc) || !value.get_boolean()) {
+        matched = false;
+        break;
+      }
+    }
+
+    // 只读扫描返回的记录指向扫描器中的页面，换页之后就失效了，所以要复制出来
+    if (matched) {
+      char *data = static_cast<char *>(malloc(record_size));
+      ASSERT(nullptr != data, "failed to allocate memory. size=%d", record_size);
+      memcpy(data, record.data(), record_size);
+      records.emplace_back();
+      records.back().set_data_owner(data, record_size);
+      records.back().set_rid(record.rid());
+    }
+  }
+
+  scanner.close_scan();
+  tuple.clean();
+  return rc;
+}
@@ -0,0 +1,110 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/rc.h"
+#include "storage/record/record.h"
+#include "storage/record/zone_map.h"
+
+class Table;
+class Trx;
+class Expression;
+
+/**
+ * @brief 多线程并行扫描一张表
+ * @ingroup PhysicalOperator
+ * @details 把数据文件的页面按顺序切成若干小段(morsel)，每段 MORSEL_PAGES 个页面。
+ * 几个工作线程每次领取下一个还没有扫描的小段，用自己的 RecordFileScanner 扫描这一段，
+ * 并在工作线程中计算过滤条件，把满足条件的记录复制出来。
+ * 调用者按照小段的顺序读取结果，所以返回记录的顺序与单线程扫描相同。
+ * 为了限制内存，工作线程最多领先调用者 2 * 线程数个小段。
+ *
+ * 过滤条件由所有工作线程共享，只有不带子查询等内部状态的表达式才能并行计算，参考 can_parallel。
+ * 只读扫描才能并行，页面访问依赖页帧的读写锁，所以只有编译时开启 CONCURRENCY 才会使用。
+ */
+class ParallelScanner
+{
+public:
+  static constexpr int MORSEL_PAGES = 16;                ///< 每个小段包含多少个页面
+  static constexpr int MIN_PAGES    = 4 * MORSEL_PAGES;  ///< 页面数少于这个值的表不值得并行扫描
+
+public:
+  ParallelScanner() = default;
+  ~ParallelScanner();
+
+  /**
+   * @brief 过滤条件能不能在多个线程中同时计算
+   */
+  static bool can_parallel(const std::vector<std::unique_ptr<Expression>> &predicates);
+
+  /**
+   * @brief 启动工作线程开始扫描
+   * @param page_count 数据文件的页面数，只扫描这些页面
+   * @param predicates 过滤条件，在扫描结束之前不能修改或释放
+   * @param zone_conditions 下推到扫描器中用来跳过页面的条件，参考 RecordFileScanner::set_zone_conditions
+   * @param worker_num 工作线程的个数
+   */
+  RC open(Table *table, Trx *trx, const std::vector<std::unique_ptr<Expression>> &predicates,
+          const std::vector<ZoneCondition> &zone_conditions, int page_count, int worker_num);
+
+  /**
+   * @brief 获取下一条满足过滤条件的记录
+   * @details 返回的记录不拥有数据，下次调用 next 或者 close 之后就不能再访问
+   * @return 没有数据时返回 RECORD_EOF
+   */
+  RC next(Record &record);
+
+  /**
+   * @brief 停止所有的工作线程，释放结果
+   */
+  void close();
+
+private:
+  /**
+   * @brief 一个小段的扫描结果
+   */
+  struct Morsel
+  {
+    RC                  rc = RC::SUCCESS;
+    std::vector<Record> records;
+  };
+
+  void worker_func();
+  RC   scan_morsel(int morsel_index, std::vector<Record> &records);
+
+private:
+  Table                                          *table_      = nullptr;
+  Trx                                            *trx_        = nullptr;
+  const std::vector<std::unique_ptr<Expression>> *predicates_ = nullptr;
+  std::vector<ZoneCondition>                      zone_conditions_;
+  int                                             page_count_ = 0;
+  int                                             morsel_num_ = 0;
+  int                                             window_     = 0;  ///< 工作线程最多领先调用者多少个小段
+
+  std::mutex              mutex_;
+  std::condition_variable worker_cond_;    ///< 工作线程等待调用者读取结果
+  std::condition_variable consumer_cond_;  ///< 调用者等待工作线程扫描完下一个小段
+  int                     next_morsel_    = 0;  ///< 下一个要领取的小段
+  int                     current_morsel_ = 0;  ///< 调用者下一个要读取的小段
+  bool                    stopped_        = false;
+  std::vector<std::unique_ptr<Morsel>> morsels_;  ///< 下标是 小段编号 % window_
+
+  std::unique_ptr<Morsel> current_;          ///< 调用者正在读取的结果
+  size_t                  current_pos_ = 0;
+
+  std::vector<std::thread> workers_;
+};
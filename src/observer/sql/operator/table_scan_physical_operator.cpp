@@ -13,14 +13,42 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "sql/operator/table_scan_physical_operator.h"
+#include "sql/expr/expression.h"
 #include "storage/table/table.h"
 #include "event/sql_debug.h"
+#include "common/log/log.h"
 
 using namespace std;
 
 RC TableScanPhysicalOperator::open(Trx *trx)
 {
-  RC rc = table_->get_record_scanner(record_scanner_, trx, readonly_);
+  RC rc = RC::SUCCESS;
+  RecordFileHandler *record_handler = table_->record_handler();
+
+  vector<ZoneCondition> zone_conditions;
+  if (record_handler != nullptr && record_handler->zone_map().is_open()) {
+    for (unique_ptr<Expression> &predicate : predicates_) {
+      make_zone_conditions(predicate.get(), record_handler->zone_map(), zone_conditions);
+    }
+  }
+
+  if (parallelism_ > 1 && readonly_ && record_handler != nullptr &&
+      record_handler->page_count() >= ParallelScanner::MIN_PAGES) {
+    parallel_scanner_.reset(new ParallelScanner);
+    rc = parallel_scanner_->open(table_, trx, predicates_, zone_conditions, record_handler->page_count(), parallelism_);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to open parallel scanner, fall back to single thread scan. table=%s, rc=%s",
+               table_->name(), strrc(rc));
+      parallel_scanner_.reset();
+    }
+  }
+
+  if (parallel_scanner_ == nullptr) {
+    if (!zone_conditions.empty()) {
+      record_scanner_.set_zone_conditions(&record_handler->zone_map(), std::move(zone_conditions));
+    }
+    rc = table_->get_record_scanner(record_scanner_, trx, readonly_);
+  }
   if (rc == RC::SUCCESS) {
     tuple_.set_schema(table_, table_->table_meta().field_metas());
   }
@@ -30,6 +58,11 @@ RC TableScanPhysicalOperator::open(Trx *trx)
 
 RC TableScanPhysicalOperator::next()
 {
+  // 并行扫描时工作线程已经过滤过了
+  if (parallel_scanner_ != nullptr) {
+    return parallel_scanner_->next(current_record_);
+  }
+
   if (!record_scanner_.has_next()) {
     return RC::RECORD_EOF;
   }
@@ -60,6 +93,11 @@ RC TableScanPhysicalOperator::next()
 
 RC TableScanPhysicalOperator::close()
 {
+  if (parallel_scanner_ != nullptr) {
+    parallel_scanner_->close();
+    parallel_scanner_.reset();
+    return RC::SUCCESS;
+  }
   return record_scanner_.close_scan();
 }
 
@@ -99,3 +137,64 @@ RC TableScanPhysicalOperator::filter(RowTuple &tuple, bool &result)
   result = true;
   return rc;
 }
+
+void TableScanPhysicalOperator::make_zone_conditions(
+    Expression *expr, const ZoneMap &zone_map, vector<ZoneCondition> &conditions) const
+{
+  if (!expr->funcs().empty()) {
+    return;
+  }
+
+  if (expr->type() == ExprType::CONJUNCTION) {
+    ConjunctionExpr *conjunction = static_cast<ConjunctionExpr *>(expr);
+    if (conjunction->conjunction_type() == CONJ_AND) {
+      make_zone_conditions(conjunction->left().get(), zone_map, conditions);
+      make_zone_conditions(conjunction->right().get(), zone_map, conditions);
+    }
+    return;
+  }
+
+  if (expr->type() != ExprType::COMPARISON) {
+    return;
+  }
+
+  ComparisonExpr *comparison = static_cast<ComparisonExpr *>(expr);
+  CompOp          op         = comparison->comp();
+  Expression     *field      = comparison->left().get();
+  Expression     *value      = comparison->right().get();
+  if (field->type() == ExprType::VALUE && value->type() == ExprType::FIELD) {
+    // 常量在左边时交换两边，比较方向也要反过来
+    std::swap(field, value);
+    switch (op) {
+      case LESS_THAN: op = GREAT_THAN; break;
+      case LESS_EQUAL: op = GREAT_EQUAL; break;
+      case GREAT_THAN: op = LESS_THAN; break;
+      case GREAT_EQUAL: op = LESS_EQUAL; break;
+      default: break;
+    }
+  }
+  if (field->type() != ExprType::FIELD || value->type() != ExprType::VALUE || !field->funcs().empty()) {
+    return;
+  }
+  if (op != EQUAL_TO && op != NOT_EQUAL && op != LESS_THAN && op != LESS_EQUAL && op != GREAT_THAN &&
+      op != GREAT_EQUAL) {
+    return;
+  }
+
+  const Field &table_field = static_cast<FieldExpr *>(field)->field();
+  if (table_field.table() != table_ || table_field.meta() == nullptr) {
+    return;
+  }
+  const int column = zone_map.find_column(table_field.meta()->offset());
+  if (column < 0) {
+    return;
+  }
+
+  ZoneCondition condition;
+  condition.column = column;
+  condition.op     = op;
+  if (OB_FAIL(value->try_get_value(condition.value))) {
+    return;
+  }
+  conditions.push_back(condition);
+}
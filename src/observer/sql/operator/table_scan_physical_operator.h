@@ -15,6 +15,7 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include "sql/operator/physical_operator.h"
+#include "sql/operator/parallel_scanner.h"
 #include "storage/record/record_manager.h"
 #include "common/rc.h"
 
@@ -23,6 +24,8 @@ class Table;
 /**
  * @brief 表扫描物理算子
  * @ingroup PhysicalOperator
+ * @details 设置了并行度并且表足够大时，使用 ParallelScanner 多线程扫描，过滤条件在工作线程中计算。
+ * 字段与常量比较的过滤条件会下推到扫描器中，根据页面的区间摘要跳过整个页面
  */
 class TableScanPhysicalOperator : public PhysicalOperator
 {
@@ -46,9 +49,20 @@ public:
 
   void set_predicates(std::vector<std::unique_ptr<Expression>> &&exprs);
 
+  /**
+   * @brief 设置并行扫描使用的线程数，1表示不并行
+   */
+  void set_parallelism(int parallelism) { parallelism_ = parallelism; }
+
 private:
   RC filter(RowTuple &tuple, bool &result);
 
+  /**
+   * @brief 从过滤条件中找出可以用区间摘要判断的比较条件
+   * @details 只看 AND 连接的 字段 op 常量 形式的比较，字段和比较上都不能有函数
+   */
+  void make_zone_conditions(Expression *expr, const ZoneMap &zone_map, std::vector<ZoneCondition> &conditions) const;
+
 private:
   Table *                                  table_ = nullptr;
   Trx *                                    trx_ = nullptr;
@@ -57,4 +71,6 @@ private:
   Record                                   current_record_;
   RowTuple                                 tuple_;
   std::vector<std::unique_ptr<Expression>> predicates_; // TODO chang predicate to table tuple filter
+  int                                      parallelism_ = 1;
+  std::unique_ptr<ParallelScanner>         parallel_scanner_;  ///< 并行扫描时使用，否则为空
 };
@@ -30,6 +30,21 @@ RC UpdatePhysicalOperator::next()
     return RC::RECORD_EOF;
   }
 
+  for (size_t i = 0; i < values_.size(); i++) {
+    FieldMeta *field_meta = const_cast<FieldMeta *>(field_metas_[i]);
+    Value &v = values_[i];
+    if (!field_meta->match(v)) {
+      LOG_WARN("field does not match value(%s and %s)", 
+          attr_type_to_string(field_meta->type()), 
+          attr_type_to_string(v.attr_type()));
+      return RC::SCHEMA_FIELD_TYPE_MISMATCH;
+    }
+  }
+
+  // 先收集所有要修改的记录再修改。变长记录在原来的页面放不下时会移动到其它页面，
+  // 边扫描边修改的话，扫描可能会再次遇到移动过的记录，同一行就被修改了两次
+  const int record_size = table_->table_meta().record_size();
+  std::vector<Record> records;
   PhysicalOperator *child = children_[0].get();
   while (RC::SUCCESS == (rc = child->next())) {
     Tuple *tuple = child->current_tuple();
@@ -38,17 +53,6 @@ RC UpdatePhysicalOperator::next()
       return rc;
     }
 
-    for (size_t i = 0; i < values_.size(); i++) {
-      FieldMeta *field_meta = const_cast<FieldMeta *>(field_metas_[i]);
-      Value &v = values_[i];
-      if (!field_meta->match(v)) {
-        LOG_WARN("field does not match value(%s and %s)", 
-            attr_type_to_string(field_meta->type()), 
-            attr_type_to_string(v.attr_type()));
-        return RC::SCHEMA_FIELD_TYPE_MISMATCH;
-      }
-    }
-
     RowTuple *row_tuple = static_cast<RowTuple *>(tuple);
     Record &record = row_tuple->record();
 
@@ -60,16 +64,27 @@ RC UpdatePhysicalOperator::next()
       return rc;
     }
 
-    char *data_changed = (char *)malloc(table_->table_meta().record_size());
-    memcpy(data_changed, record.data(), table_->table_meta().record_size());
-    Record record_changed(record);
-    record_changed.set_data_owner(data_changed, table_->table_meta().record_size());
+    char *data_changed = (char *)malloc(record_size);
+    memcpy(data_changed, record.data(), record_size);
+    Record &record_changed = records.emplace_back();
+    record_changed.set_rid(record.rid());
+    record_changed.set_data_owner(data_changed, record_size);
+  }
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to scan records to update: %s", strrc(rc));
+    return rc;
+  }
 
-    table_->update_record_impl(field_metas_, values_, record_changed);
+  for (Record &record_changed : records) {
+    rc = table_->update_record_impl(field_metas_, values_, record_changed);
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("failed to set new values of record: %s", strrc(rc));
+      return rc;
+    }
 
     rc = trx_->update_record(table_, record_changed);
     if (rc != RC::SUCCESS) {
-      LOG_WARN("failed to delete record: %s", strrc(rc));
+      LOG_WARN("failed to update record: %s", strrc(rc));
       return rc;
     }
   }
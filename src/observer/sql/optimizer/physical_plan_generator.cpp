@@ -12,6 +12,7 @@ See the Mulan PSL v2 for more details. */
 // Created by Wangyunlai on 2022/12/14.
 //
 
+#include <algorithm>
 #include <utility>
 
 #include "sql/optimizer/physical_plan_generator.h"
@@ -39,7 +40,9 @@ See the Mulan PSL v2 for more details. */
 #include "sql/operator/groupby_logical_operator.h"
 #include "sql/operator/groupby_physical_operator.h"
 #include "sql/expr/expression.h"
+#include "storage/index/index.h"
 #include "common/log/log.h"
+#include "common/global_context.h"
 
 using namespace std;
 
@@ -99,66 +102,260 @@ RC PhysicalPlanGenerator::create(LogicalOperator &logical_operator, unique_ptr<P
   return rc;
 }
 
+namespace {
+
+/**
+ * @brief 一个字段上的比较条件合并之后的范围
+ * @details 同一个字段上的多个比较条件合并成一个范围，比如 a > 10 AND a <= 20 合并成 (10, 20]。
+ * 没有设置的一边表示没有边界。
+ */
+struct FieldRange
+{
+  std::string field_name;
+
+  bool  has_left       = false;
+  Value left;
+  bool  left_inclusive = false;
+
+  bool  has_right       = false;
+  Value right;
+  bool  right_inclusive = false;
+
+  int predicate_num = 0;  ///< 合并了多少个比较条件
+
+  void add_left(const Value &value, bool inclusive)
+  {
+    int result = 0;
+    if (has_left && value.compare(left, result) != RC::SUCCESS) {
+      return;
+    }
+    if (!has_left || result > 0) {
+      has_left       = true;
+      left           = value;
+      left_inclusive = inclusive;
+    } else if (result == 0) {
+      left_inclusive = left_inclusive && inclusive;
+    }
+  }
+
+  void add_right(const Value &value, bool inclusive)
+  {
+    int result = 0;
+    if (has_right && value.compare(right, result) != RC::SUCCESS) {
+      return;
+    }
+    if (!has_right || result < 0) {
+      has_right       = true;
+      right           = value;
+      right_inclusive = inclusive;
+    } else if (result == 0) {
+      right_inclusive = right_inclusive && inclusive;
+    }
+  }
+
+  /**
+   * @brief 范围是否只有一个值，即等值条件
+   */
+  bool is_point() const
+  {
+    int result = 0;
+    return has_left && has_right && left_inclusive && right_inclusive && left.compare(right, result) == RC::SUCCESS &&
+           result == 0;
+  }
+};
+
+/**
+ * @brief 一个索引上的扫描范围
+ * @details 索引字段最左边的若干个字段是等值条件，后面最多再跟一个字段的范围条件。
+ * 边界是索引键值的前缀，参考 IndexScanPhysicalOperator
+ */
+struct IndexRange
+{
+  Index        *index = nullptr;
+  vector<Value> left_values;
+  bool          left_inclusive = true;
+  vector<Value> right_values;
+  bool          right_inclusive = true;
+
+  int predicate_num = 0;  ///< 用到了多少个比较条件
+  int equal_num     = 0;  ///< 等值条件的字段个数
+
+  /**
+   * @brief 用到的条件越多越好，一样多时等值条件多的范围更窄
+   */
+  bool better_than(const IndexRange &other) const
+  {
+    if (predicate_num != other.predicate_num) {
+      return predicate_num > other.predicate_num;
+    }
+    return equal_num > other.equal_num;
+  }
+};
+
+/**
+ * @brief 从谓词中收集每个字段上的范围
+ * @details 只处理 字段 op 常量 形式的比较，多个条件之间必须是 AND 的关系。
+ * 常量的类型必须与字段类型一致，因为索引直接比较键值的二进制内容。
+ */
+void collect_field_ranges(Table *table, Expression *expr, vector<FieldRange> &ranges)
+{
+  if (!expr->funcs().empty()) {
+    return;
+  }
+
+  if (expr->type() == ExprType::CONJUNCTION) {
+    ConjunctionExpr *conjunction = static_cast<ConjunctionExpr *>(expr);
+    if (conjunction->conjunction_type() == CONJ_AND) {
+      collect_field_ranges(table, conjunction->left().get(), ranges);
+      collect_field_ranges(table, conjunction->right().get(), ranges);
+    }
+    return;
+  }
+
+  if (expr->type() != ExprType::COMPARISON) {
+    return;
+  }
+
+  ComparisonExpr *comparison = static_cast<ComparisonExpr *>(expr);
+  CompOp          op         = comparison->comp();
+  Expression     *field      = comparison->left().get();
+  Expression     *value      = comparison->right().get();
+  if (field->type() == ExprType::VALUE && value->type() == ExprType::FIELD) {
+    // 常量在左边时交换两边，比较方向也要反过来
+    std::swap(field, value);
+    switch (op) {
+      case LESS_THAN: op = GREAT_THAN; break;
+      case LESS_EQUAL: op = GREAT_EQUAL; break;
+      case GREAT_THAN: op = LESS_THAN; break;
+      case GREAT_EQUAL: op = LESS_EQUAL; break;
+      default: break;
+    }
+  }
+  if (field->type() != ExprType::FIELD || value->type() != ExprType::VALUE || !field->funcs().empty()) {
+    return;
+  }
+  if (op != EQUAL_TO && op != LESS_THAN && op != LESS_EQUAL && op != GREAT_THAN && op != GREAT_EQUAL) {
+    return;
+  }
+
+  const Field &table_field = static_cast<FieldExpr *>(field)->field();
+  if (table_field.table() != table || table_field.meta() == nullptr) {
+    return;
+  }
+
+  Value bound;
+  if (value->try_get_value(bound) != RC::SUCCESS || bound.attr_type() != table_field.attr_type()) {
+    return;
+  }
+
+  const char *field_name = table_field.field_name();
+  auto        iter       = std::find_if(
+      ranges.begin(), ranges.end(), [field_name](const FieldRange &range) { return range.field_name == field_name; });
+  if (iter == ranges.end()) {
+    iter             = ranges.emplace(ranges.end());
+    iter->field_name = field_name;
+  }
+
+  switch (op) {
+    case EQUAL_TO: {
+      iter->add_left(bound, true);
+      iter->add_right(bound, true);
+    } break;
+    case LESS_THAN: iter->add_right(bound, false); break;
+    case LESS_EQUAL: iter->add_right(bound, true); break;
+    case GREAT_THAN: iter->add_left(bound, false); break;
+    case GREAT_EQUAL: iter->add_left(bound, true); break;
+    default: break;
+  }
+  iter->predicate_num++;
+}
+
+/**
+ * @brief 按照索引字段的顺序匹配字段上的范围
+ * @details 从第一个索引字段开始，等值条件可以一直向后匹配，遇到第一个不是等值条件的字段就停止，
+ * 这个字段上的范围作为最后一个字段的边界。第一个字段上没有条件时索引不可用，返回的 predicate_num 为0
+ */
+IndexRange match_index(Index *index, const vector<FieldRange> &ranges)
+{
+  IndexRange index_range;
+  index_range.index = index;
+
+  for (const FieldMeta &field_meta : index->field_meta()) {
+    auto iter = std::find_if(ranges.begin(), ranges.end(), [&field_meta](const FieldRange &range) {
+      return range.field_name == field_meta.name();
+    });
+    if (iter == ranges.end()) {
+      break;
+    }
+
+    index_range.predicate_num += iter->predicate_num;
+    if (iter->is_point()) {
+      index_range.left_values.push_back(iter->left);
+      index_range.right_values.push_back(iter->right);
+      index_range.equal_num++;
+      continue;
+    }
+
+    if (iter->has_left) {
+      index_range.left_values.push_back(iter->left);
+      index_range.left_inclusive = iter->left_inclusive;
+    }
+    if (iter->has_right) {
+      index_range.right_values.push_back(iter->right);
+      index_range.right_inclusive = iter->right_inclusive;
+    }
+    break;
+  }
+  return index_range;
+}
+
+}  // namespace
+
 RC PhysicalPlanGenerator::create_plan(TableGetLogicalOperator &table_get_oper, unique_ptr<PhysicalOperator> &oper)
 {
   vector<unique_ptr<Expression>> &predicates = table_get_oper.predicates();
   // 看看是否有可以用于索引查找的表达式
   Table *table = table_get_oper.table();
 
-  Index *index = nullptr;
-  ValueExpr *value_expr = nullptr;
+  vector<FieldRange> field_ranges;
   for (auto &expr : predicates) {
-    if (expr->type() == ExprType::COMPARISON) {
-      auto comparison_expr = static_cast<ComparisonExpr *>(expr.get());
-      // 简单处理: 就找等值查询
-      if (comparison_expr->comp() != EQUAL_TO) {
-        continue;
-      }
-
-      unique_ptr<Expression> &left_expr = comparison_expr->left();
-      unique_ptr<Expression> &right_expr = comparison_expr->right();
-      // 左右比较的一边最少是一个值
-      if (left_expr->type() != ExprType::VALUE && right_expr->type() != ExprType::VALUE) {
-        continue;
-      }
-
-      FieldExpr *field_expr = nullptr;
-      if (left_expr->type() == ExprType::FIELD) {
-        ASSERT(right_expr->type() == ExprType::VALUE, "right expr should be a value expr while left is field expr");
-        field_expr = static_cast<FieldExpr *>(left_expr.get());
-        value_expr = static_cast<ValueExpr *>(right_expr.get());
-      } else if (right_expr->type() == ExprType::FIELD) {
-        ASSERT(left_expr->type() == ExprType::VALUE, "left expr should be a value expr while right is a field expr");
-        field_expr = static_cast<FieldExpr *>(right_expr.get());
-        value_expr = static_cast<ValueExpr *>(left_expr.get());
-      }
+    collect_field_ranges(table, expr.get(), field_ranges);
+  }
 
-      if (field_expr == nullptr || value_expr->value_type() == NULL_TYPE) {
+  IndexRange best_range;
+  if (!field_ranges.empty()) {
+    const TableMeta &table_meta = table->table_meta();
+    for (int i = 0; i < table_meta.index_num(); i++) {
+      Index *index = table->find_index(table_meta.index(i)->name());
+      if (nullptr == index) {
         continue;
       }
 
-      const Field &field = field_expr->field();
-      index = table->find_index_by_field(field.field_name());
-      if (nullptr != index) {
-        break;
+      IndexRange index_range = match_index(index, field_ranges);
+      if (index_range.predicate_num > 0 && (best_range.index == nullptr || index_range.better_than(best_range))) {
+        best_range = std::move(index_range);
       }
     }
   }
 
-  if (index != nullptr) {
-    ASSERT(value_expr != nullptr, "got an index but value expr is null ?");
-
-    const Value &value = value_expr->get_value();
+  if (best_range.index != nullptr) {
+    // 谓词仍然全部保留在算子中，范围之外的条件还需要逐条过滤
     IndexScanPhysicalOperator *index_scan_oper = new IndexScanPhysicalOperator(
-          table, index, table_get_oper.readonly(), 
-          &value, true /*left_inclusive*/, 
-          &value, true /*right_inclusive*/);
-          
+          table, best_range.index, table_get_oper.readonly(),
+          best_range.left_values, best_range.left_inclusive,
+          best_range.right_values, best_range.right_inclusive);
+
     index_scan_oper->set_predicates(std::move(predicates));
     oper = unique_ptr<PhysicalOperator>(index_scan_oper);
     LOG_TRACE("use index scan");
   } else {
     auto table_scan_oper = new TableScanPhysicalOperator(table, table_get_oper.readonly());
+#ifdef CONCURRENCY
+    // 页面访问依赖页帧的读写锁，只有并发编译时才能多线程扫描
+    if (join_inner_depth_ == 0 && table_get_oper.readonly() && ParallelScanner::can_parallel(predicates)) {
+      table_scan_oper->set_parallelism(GCTX.sql_thread_num_);
+    }
+#endif
     table_scan_oper->set_predicates(std::move(predicates));
     oper = unique_ptr<PhysicalOperator>(table_scan_oper);
     LOG_TRACE("use table scan");
@@ -333,9 +530,13 @@ RC PhysicalPlanGenerator::create_plan(JoinLogicalOperator &join_oper, unique_ptr
   }
 
   unique_ptr<PhysicalOperator> join_physical_oper(new NestedLoopJoinPhysicalOperator);
-  for (auto &child_oper : child_opers) {
+  for (size_t i = 0; i < child_opers.size(); i++) {
+    // 右孩子是内侧，对左孩子的每一行都会重新打开
+    const bool inner = (i == 1);
     unique_ptr<PhysicalOperator> child_physical_oper;
-    rc = create(*child_oper, child_physical_oper);
+    join_inner_depth_ += inner ? 1 : 0;
+    rc = create(*child_opers[i], child_physical_oper);
+    join_inner_depth_ -= inner ? 1 : 0;
     if (rc != RC::SUCCESS) {
       LOG_WARN("failed to create physical child oper. rc=%s", strrc(rc));
       return rc;
@@ -58,4 +58,9 @@ private:
   RC create_plan(CalcLogicalOperator &logical_oper, std::unique_ptr<PhysicalOperator> &oper);
   RC create_plan(OrderByLogicalOperator &logical_oper, std::unique_ptr<PhysicalOperator> &oper);
   RC create_plan(GroupByLogicalOperator &groupby_oper, std::unique_ptr<PhysicalOperator> &oper);
+
+private:
+  /// 正在生成的算子位于几层嵌套循环连接的内侧。内侧的算子对外侧的每一行都要重新打开一次，
+  /// 并行扫描每次打开都要创建工作线程，所以内侧不使用并行扫描
+  int join_inner_depth_ = 0;
 };
@@ -0,0 +1,59 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/buffer/buffer_ring.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "common/log/log.h"
+
+bool BufferRing::init(DiskBufferPool &buffer_pool, int ring_size /* = DEFAULT_RING_SIZE */)
+{
+  reset();
+  buffer_pool_ = &buffer_pool;
+  ring_size_   = ring_size;
+
+  const int64_t frame_num = static_cast<int64_t>(buffer_pool.total_frame_num());
+  enabled_ = ring_size_ > 0 && static_cast<int64_t>(buffer_pool.page_count()) * 100 > frame_num * MIN_FILE_PERCENT;
+  if (enabled_) {
+    LOG_DEBUG("use buffer ring to scan file %s. page count=%d, frame num=%ld, ring size=%d",
+              buffer_pool.filename().c_str(), buffer_pool.page_count(), frame_num, ring_size_);
+  }
+  return enabled_;
+}
+
+void BufferRing::reset()
+{
+  buffer_pool_ = nullptr;
+  enabled_     = false;
+  pages_.clear();
+}
+
+RC BufferRing::get_this_page(PageNum page_num, Frame **frame)
+{
+  if (!enabled_) {
+    return buffer_pool_->get_this_page(page_num, frame);
+  }
+
+  RC rc = buffer_pool_->get_this_page(page_num, frame, false /*touch*/);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  // 访问时间是0表示页面是这次扫描加载或者预读进来的，之后也没有其它人访问过
+  if ((*frame)->acc_time() != 0) {
+    return rc;
+  }
+
+  pages_.push_back(page_num);
+  while (static_cast<int>(pages_.size()) > ring_size_) {
+    buffer_pool_->purge_untouched_page(pages_.front());
+    pages_.pop_front();
+  }
+  return rc;
+}
@@ -0,0 +1,63 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <deque>
+
+#include "common/rc.h"
+#include "storage/buffer/page.h"
+
+class DiskBufferPool;
+class Frame;
+
+/**
+ * @brief 大表扫描使用的页帧环
+ * @ingroup BufferPool
+ * @details 一次扫描整个大表时，如果每个页面都和普通访问一样放进缓冲池，会把其它事务经常访问的页面都淘汰掉，
+ * 而扫描过的页面通常很快就不会再被访问了。
+ * 使用页帧环时，扫描自己加载进来的页面(包括预读的页面)只在一个很小的环中轮转：环满了之后，
+ * 最早进入环的页面如果没有被其它人访问过，就直接淘汰掉，让出的页帧给下一个页面使用。
+ * 扫描访问页面时也不会调整置换策略中的顺序，原本就在缓冲池中的页面不受影响。
+ * 只有文件的页面数超过缓冲池页帧的 MIN_FILE_PERCENT 时才会启用，小表的扫描和普通访问一样。
+ */
+class BufferRing
+{
+public:
+  static constexpr int DEFAULT_RING_SIZE = 32;  ///< 环中最多有多少个页面
+  static constexpr int MIN_FILE_PERCENT  = 25;  ///< 文件的页面数超过页帧总数的这个百分比时才启用
+
+public:
+  BufferRing() = default;
+
+  /**
+   * @brief 准备扫描某个文件，文件足够大时启用页帧环
+   * @return 是否启用了页帧环
+   */
+  bool init(DiskBufferPool &buffer_pool, int ring_size = DEFAULT_RING_SIZE);
+
+  /**
+   * @brief 结束扫描。环中的页面留在缓冲池中，按照普通的置换策略淘汰
+   */
+  void reset();
+
+  bool enabled() const { return enabled_; }
+
+  /**
+   * @brief 获取页面，与 DiskBufferPool::get_this_page 相同，没有启用时就是普通的访问
+   */
+  RC get_this_page(PageNum page_num, Frame **frame);
+
+private:
+  DiskBufferPool     *buffer_pool_ = nullptr;
+  bool                enabled_     = false;
+  int                 ring_size_   = 0;
+  std::deque<PageNum> pages_;  ///< 按照进入环的顺序排列
+};
@@ -0,0 +1,526 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <algorithm>
+
+#include "storage/buffer/compressed_page_file.h"
+#include "common/log/log.h"
+#include "storage/common/io_backend.h"
+
+using namespace std;
+
+static_assert(sizeof(CompressedFileHeader) <= CompressedPageFile::SECTOR_SIZE, "file header should fit in a sector");
+static_assert(sizeof(PageSlot) == 16, "page slot is stored in the map file");
+
+CompressedPageFile::~CompressedPageFile()
+{
+  close();
+}
+
+string CompressedPageFile::map_file_name(const char *file_name)
+{
+  return string(file_name) + ".pmap";
+}
+
+RC CompressedPageFile::create(const char *file_name, const char *codec_name, const Page &header_page)
+{
+  unique_ptr<PageCodec> codec = PageCodec::create(codec_name);
+  if (codec == nullptr) {
+    LOG_WARN("invalid page codec. file=%s, codec=%s", file_name, codec_name);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  int fd = ::open(file_name, O_RDWR | O_CREAT, S_IREAD | S_IWRITE);
+  if (fd < 0) {
+    LOG_ERROR("Failed to open compressed file %s, due to %s.", file_name, strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+
+  char sector[SECTOR_SIZE];
+  memset(sector, 0, sizeof(sector));
+  CompressedFileHeader *header = reinterpret_cast<CompressedFileHeader *>(sector);
+  memcpy(header->magic, CompressedFileHeader::MAGIC, sizeof(header->magic));
+  header->version = CompressedFileHeader::VERSION;
+  snprintf(header->codec, sizeof(header->codec), "%s", codec->name());
+
+  RC rc = IoBackend::instance().write(fd, sector, sizeof(sector), 0);
+  ::close(fd);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to write header of compressed file %s. rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+
+  const string map_file = map_file_name(file_name);
+  fd = ::open(map_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IREAD | S_IWRITE);
+  if (fd < 0) {
+    LOG_ERROR("Failed to create page map file %s, due to %s.", map_file.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+  ::close(fd);
+
+  CompressedPageFile file;
+  rc = file.open(file_name);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  rc = file.write_pages({&header_page}, true /*sync*/);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to write first page of compressed file %s. rc=%s", file_name, strrc(rc));
+    return rc;
+  }
+  return file.close();
+}
+
+bool CompressedPageFile::is_compressed(const char *file_name)
+{
+  int fd = ::open(file_name, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  char magic[sizeof(CompressedFileHeader::MAGIC)];
+  const ssize_t size = pread(fd, magic, sizeof(magic), 0);
+  ::close(fd);
+  return size == static_cast<ssize_t>(sizeof(magic)) && 0 == memcmp(magic, CompressedFileHeader::MAGIC, sizeof(magic));
+}
+
+RC CompressedPageFile::open(const char *file_name)
+{
+  if (data_fd_ >= 0) {
+    LOG_WARN("compressed file has been opened. file=%s", file_name_.c_str());
+    return RC::BUFFERPOOL_OPEN;
+  }
+
+  int data_fd = ::open(file_name, O_RDWR);
+  if (data_fd < 0) {
+    LOG_ERROR("Failed to open file %s, because %s.", file_name, strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+
+  char sector[SECTOR_SIZE];
+  RC rc = IoBackend::instance().read(data_fd, sector, sizeof(sector), 0);
+  const CompressedFileHeader *header = reinterpret_cast<const CompressedFileHeader *>(sector);
+  if (OB_FAIL(rc) || 0 != memcmp(header->magic, CompressedFileHeader::MAGIC, sizeof(header->magic)) ||
+      header->version != CompressedFileHeader::VERSION) {
+    LOG_ERROR("Invalid compressed file header. file=%s, rc=%s", file_name, strrc(rc));
+    ::close(data_fd);
+    return OB_FAIL(rc) ? rc : RC::INTERNAL;
+  }
+
+  char codec_name[sizeof(header->codec) + 1] = {0};
+  memcpy(codec_name, header->codec, sizeof(header->codec));
+  unique_ptr<PageCodec> codec = PageCodec::create(codec_name);
+  if (codec == nullptr) {
+    LOG_ERROR("Unknown page codec of compressed file. file=%s, codec=%s", file_name, codec_name);
+    ::close(data_fd);
+    return RC::INTERNAL;
+  }
+
+  const string map_file = map_file_name(file_name);
+  int map_fd = ::open(map_file.c_str(), O_RDWR);
+  if (map_fd < 0) {
+    LOG_ERROR("Failed to open page map file %s, because %s.", map_file.c_str(), strerror(errno));
+    ::close(data_fd);
+    return RC::IOERR_ACCESS;
+  }
+
+  file_name_ = file_name;
+  data_fd_   = data_fd;
+  map_fd_    = map_fd;
+  codec_     = std::move(codec);
+
+  rc = load_map();
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to load page map. file=%s, rc=%s", file_name, strrc(rc));
+    ::close(data_fd_);
+    ::close(map_fd_);
+    data_fd_ = -1;
+    map_fd_  = -1;
+    codec_.reset();
+    return rc;
+  }
+
+  LOG_INFO("Successfully open compressed file %s. codec=%s, page num=%zu, file end=%ld, free extents=%zu",
+           file_name, codec_->name(), slots_.size(), file_end_, free_extents_.size());
+  return RC::SUCCESS;
+}
+
+RC CompressedPageFile::load_map()
+{
+  struct stat st;
+  if (fstat(map_fd_, &st) < 0) {
+    LOG_ERROR("Failed to stat page map file. file=%s, error=%s", file_name_.c_str(), strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+
+  slots_.clear();
+  slots_.resize(st.st_size / sizeof(PageSlot));
+  if (!slots_.empty()) {
+    RC rc = IoBackend::instance().read(map_fd_, slots_.data(), static_cast<int>(slots_.size() * sizeof(PageSlot)), 0);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+  while (!slots_.empty() && slots_.back().empty()) {
+    slots_.pop_back();
+  }
+
+  // 页面之间的空隙就是空闲的空间
+  vector<pair<int64_t, int64_t>> extents;
+  for (const PageSlot &slot : slots_) {
+    if (slot.empty()) {
+      continue;
+    }
+    if (slot.offset < SECTOR_SIZE || slot.offset % SECTOR_SIZE != 0 || slot.length <= 0 || slot.length > BP_PAGE_SIZE) {
+      LOG_ERROR("Invalid page slot. file=%s, offset=%ld, length=%d", file_name_.c_str(), slot.offset, slot.length);
+      return RC::INTERNAL;
+    }
+    extents.emplace_back(slot.offset, align_up(slot.length));
+  }
+  sort(extents.begin(), extents.end());
+
+  free_extents_.clear();
+  free_by_size_.clear();
+  file_end_ = SECTOR_SIZE;
+  for (const auto &[offset, size] : extents) {
+    if (offset < file_end_) {
+      LOG_ERROR("Page slots overlap. file=%s, offset=%ld", file_name_.c_str(), offset);
+      return RC::INTERNAL;
+    }
+    if (offset > file_end_) {
+      free_extents_[file_end_] = offset - file_end_;
+      free_by_size_.emplace(offset - file_end_, file_end_);
+    }
+    file_end_ = offset + size;
+  }
+  return RC::SUCCESS;
+}
+
+RC CompressedPageFile::close()
+{
+  if (data_fd_ < 0) {
+    return RC::SUCCESS;
+  }
+
+  RC rc = sync();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to sync compressed file before close. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+  }
+
+  ::close(map_fd_);
+  if (::close(data_fd_) < 0) {
+    LOG_ERROR("Failed to close file %s, error:%s", file_name_.c_str(), strerror(errno));
+    rc = RC::IOERR_CLOSE;
+  }
+  data_fd_ = -1;
+  map_fd_  = -1;
+  slots_.clear();
+  dirty_blocks_.clear();
+  free_extents_.clear();
+  free_by_size_.clear();
+  pending_extents_.clear();
+  pending_size_ = 0;
+  file_end_     = SECTOR_SIZE;
+  return rc;
+}
+
+RC CompressedPageFile::read_page(PageNum page_num, Page &page)
+{
+  vector<RC> results;
+  return read_pages({page_num}, {&page}, results);
+}
+
+RC CompressedPageFile::read_pages(const vector<PageNum> &page_nums, const vector<Page *> &pages, vector<RC> &results)
+{
+  const size_t count = page_nums.size();
+  results.assign(count, RC::SUCCESS);
+
+  vector<PageSlot> slots(count);
+  {
+    lock_guard<mutex> guard(lock_);
+    for (size_t i = 0; i < count; i++) {
+      if (page_nums[i] >= 0 && page_nums[i] < static_cast<PageNum>(slots_.size())) {
+        slots[i] = slots_[page_nums[i]];
+      }
+    }
+  }
+
+  // 没有压缩的页面直接读到页面中，压缩的先读到缓冲区里再解压
+  vector<char>      buffer(count * BP_PAGE_SIZE);
+  vector<IoRequest> requests;
+  vector<size_t>    request_pages;
+  requests.reserve(count);
+  request_pages.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    if (slots[i].empty()) {
+      LOG_WARN("page has not been written. file=%s, page num=%d", file_name_.c_str(), page_nums[i]);
+      results[i] = RC::IOERR_READ;
+      continue;
+    }
+    char *buf = slots[i].length == BP_PAGE_SIZE ? reinterpret_cast<char *>(pages[i]) : &buffer[i * BP_PAGE_SIZE];
+    requests.push_back(IoRequest::read(data_fd_, buf, slots[i].length, slots[i].offset));
+    request_pages.push_back(i);
+  }
+
+  (void)IoBackend::instance().submit(requests);
+
+  RC rc = RC::SUCCESS;
+  for (size_t r = 0; r < requests.size(); r++) {
+    const size_t i = request_pages[r];
+    if (requests[r].error != 0) {
+      LOG_ERROR("Failed to read compressed page. file=%s, page num=%d, error=%d",
+                file_name_.c_str(), page_nums[i], requests[r].error);
+      results[i] = RC::IOERR_READ;
+    } else if (slots[i].length != BP_PAGE_SIZE) {
+      results[i] = codec_->decompress(&buffer[i * BP_PAGE_SIZE], slots[i].length,
+                                      reinterpret_cast<char *>(pages[i]), BP_PAGE_SIZE);
+      if (OB_FAIL(results[i])) {
+        LOG_ERROR("Failed to decompress page. file=%s, page num=%d", file_name_.c_str(), page_nums[i]);
+      }
+    }
+  }
+
+  for (RC result : results) {
+    if (OB_FAIL(result)) {
+      rc = result;
+      break;
+    }
+  }
+  return rc;
+}
+
+RC CompressedPageFile::write_pages(const vector<const Page *> &pages, bool sync)
+{
+  if (pages.empty()) {
+    return RC::SUCCESS;
+  }
+
+  struct Item
+  {
+    const Page *page;
+    const char *data;
+    int         length;
+    int64_t     offset;
+  };
+
+  // 至少要节省一个扇区，否则按原样保存
+  vector<char> buffer(pages.size() * BP_PAGE_SIZE);
+  vector<Item> items(pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    char *dst        = &buffer[i * BP_PAGE_SIZE];
+    const int length = codec_->compress(reinterpret_cast<const char *>(pages[i]), BP_PAGE_SIZE, dst,
+                                        BP_PAGE_SIZE - SECTOR_SIZE);
+    if (length > 0) {
+      items[i] = {pages[i], dst, length, 0};
+    } else {
+      items[i] = {pages[i], reinterpret_cast<const char *>(pages[i]), BP_PAGE_SIZE, 0};
+    }
+  }
+
+  {
+    lock_guard<mutex> guard(lock_);
+    for (Item &item : items) {
+      item.offset = alloc_extent(align_up(item.length));
+    }
+  }
+
+  // 新分配的空间通常是连续的，合并成一个向量写请求，页面之间用0补齐到扇区边界
+  static const char padding[SECTOR_SIZE] = {0};
+  sort(items.begin(), items.end(), [](const Item &left, const Item &right) { return left.offset < right.offset; });
+
+  vector<struct iovec> iovecs;
+  vector<IoRequest>    requests;
+  vector<size_t>       request_starts;  ///< 每个请求的第一个页面在 items 中的位置
+  vector<size_t>       iovec_starts;
+  iovecs.reserve(items.size() * 2);
+  for (size_t i = 0; i < items.size(); i++) {
+    const bool contiguous = i > 0 && items[i].offset == items[i - 1].offset + align_up(items[i - 1].length);
+    if (!contiguous) {
+      request_starts.push_back(i);
+      iovec_starts.push_back(iovecs.size());
+    }
+    iovecs.push_back({const_cast<char *>(items[i].data), static_cast<size_t>(items[i].length)});
+    const int64_t padding_size = align_up(items[i].length) - items[i].length;
+    if (padding_size > 0) {
+      iovecs.push_back({const_cast<char *>(padding), static_cast<size_t>(padding_size)});
+    }
+  }
+  for (size_t r = 0; r < request_starts.size(); r++) {
+    const size_t start = iovec_starts[r];
+    const size_t end   = r + 1 < iovec_starts.size() ? iovec_starts[r + 1] : iovecs.size();
+    requests.push_back(IoRequest::writev(data_fd_, &iovecs[start], static_cast<int>(end - start),
+                                         items[request_starts[r]].offset));
+  }
+
+  RC rc = IoBackend::instance().submit(requests);
+
+  {
+    lock_guard<mutex> guard(lock_);
+    for (size_t r = 0; r < request_starts.size(); r++) {
+      const size_t end = r + 1 < request_starts.size() ? request_starts[r + 1] : items.size();
+      for (size_t i = request_starts[r]; i < end; i++) {
+        const Item &item = items[i];
+        if (requests[r].error != 0) {
+          free_extent(item.offset, align_up(item.length));
+          continue;
+        }
+
+        const PageNum page_num = item.page->page_num;
+        if (page_num >= static_cast<PageNum>(slots_.size())) {
+          slots_.resize(page_num + 1);
+        }
+        PageSlot &slot = slots_[page_num];
+        if (!slot.empty()) {
+          pending_extents_.emplace_back(slot.offset, align_up(slot.length));
+          pending_size_ += align_up(slot.length);
+        }
+        slot.offset = item.offset;
+        slot.length = item.length;
+        dirty_blocks_.insert(page_num / MAP_BLOCK_SLOTS);
+      }
+    }
+  }
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to write compressed pages. file=%s, page num=%zu, rc=%s", file_name_.c_str(), pages.size(), strrc(rc));
+  }
+
+  if (sync || pending_size_ >= MAX_PENDING_SIZE) {
+    RC sync_rc = this->sync();
+    if (OB_SUCC(rc)) {
+      rc = sync_rc;
+    }
+  }
+  return rc;
+}
+
+RC CompressedPageFile::write_map_blocks()
+{
+  vector<int>               blocks;
+  vector<PageSlot>          buffer;
+  {
+    lock_guard<mutex> guard(lock_);
+    blocks.assign(dirty_blocks_.begin(), dirty_blocks_.end());
+    dirty_blocks_.clear();
+    buffer.resize(blocks.size() * MAP_BLOCK_SLOTS);
+    for (size_t b = 0; b < blocks.size(); b++) {
+      const size_t start = static_cast<size_t>(blocks[b]) * MAP_BLOCK_SLOTS;
+      const size_t end   = min(start + MAP_BLOCK_SLOTS, slots_.size());
+      copy(slots_.begin() + start, slots_.begin() + end, buffer.begin() + b * MAP_BLOCK_SLOTS);
+    }
+  }
+
+  vector<IoRequest> requests;
+  requests.reserve(blocks.size());
+  for (size_t b = 0; b < blocks.size(); b++) {
+    requests.push_back(IoRequest::write(map_fd_, &buffer[b * MAP_BLOCK_SLOTS], MAP_BLOCK_SLOTS * sizeof(PageSlot),
+                                        static_cast<int64_t>(blocks[b]) * MAP_BLOCK_SLOTS * sizeof(PageSlot)));
+  }
+  RC rc = IoBackend::instance().submit(requests);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to write page map. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+    lock_guard<mutex> guard(lock_);
+    for (size_t b = 0; b < blocks.size(); b++) {
+      if (requests[b].error != 0) {
+        dirty_blocks_.insert(blocks[b]);
+      }
+    }
+  }
+  return rc;
+}
+
+RC CompressedPageFile::sync()
+{
+  // 映射指向的数据落盘之后才能写映射，否则映射可能先于数据写到磁盘上。映射落盘之后旧页面的空间才能重新使用
+  RC rc = IoBackend::instance().sync(data_fd_);
+  if (OB_SUCC(rc)) {
+    rc = write_map_blocks();
+  }
+  if (OB_SUCC(rc)) {
+    rc = IoBackend::instance().sync(map_fd_);
+  }
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to sync compressed file. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+    return rc;
+  }
+
+  lock_guard<mutex> guard(lock_);
+  for (const auto &[offset, size] : pending_extents_) {
+    free_extent(offset, size);
+  }
+  pending_extents_.clear();
+  pending_size_ = 0;
+  return RC::SUCCESS;
+}
+
+int64_t CompressedPageFile::stored_bytes()
+{
+  lock_guard<mutex> guard(lock_);
+  int64_t bytes = 0;
+  for (const PageSlot &slot : slots_) {
+    if (!slot.empty()) {
+      bytes += align_up(slot.length);
+    }
+  }
+  return bytes;
+}
+
+int64_t CompressedPageFile::alloc_extent(int64_t size)
+{
+  auto iter = free_by_size_.lower_bound({size, 0});
+  if (iter == free_by_size_.end()) {
+    const int64_t offset = file_end_;
+    file_end_ += size;
+    return offset;
+  }
+
+  const auto [free_size, offset] = *iter;
+  free_by_size_.erase(iter);
+  free_extents_.erase(offset);
+  if (free_size > size) {
+    free_extents_[offset + size] = free_size - size;
+    free_by_size_.emplace(free_size - size, offset + size);
+  }
+  return offset;
+}
+
+void CompressedPageFile::free_extent(int64_t offset, int64_t size)
+{
+  auto next = free_extents_.find(offset + size);
+  if (next != free_extents_.end()) {
+    size += next->second;
+    free_by_size_.erase({next->second, next->first});
+    free_extents_.erase(next);
+  }
+
+  auto prev = free_extents_.lower_bound(offset);
+  if (prev != free_extents_.begin()) {
+    --prev;
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      size += prev->second;
+      free_by_size_.erase({prev->second, prev->first});
+      free_extents_.erase(prev);
+    }
+  }
+
+  // 文件末尾的空闲空间直接还给文件末尾，下次扩展文件时覆盖
+  if (offset + size == file_end_) {
+    file_end_ = offset;
+    return;
+  }
+  free_extents_[offset] = size;
+  free_by_size_.emplace(size, offset);
+}
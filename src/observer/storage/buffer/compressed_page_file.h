@@ -0,0 +1,168 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/rc.h"
+#include "storage/buffer/page.h"
+#include "storage/buffer/page_codec.h"
+
+/**
+ * @brief 压缩的数据文件的文件头，放在文件的第一个扇区
+ * @ingroup BufferPool
+ * @details 普通的数据文件开头是第0个页面的页面号，也就是0，不会与 MAGIC 混淆
+ */
+struct CompressedFileHeader
+{
+  static constexpr char    MAGIC[8] = {'M', 'O', 'B', 'P', 'A', 'G', 'E', 'Z'};
+  static constexpr int32_t VERSION  = 1;
+
+  char    magic[8];
+  int32_t version;
+  char    codec[20];  ///< 压缩算法的名字，参考 PageCodec::create
+};
+
+/**
+ * @brief 页面映射表中的一项，记录一个页面在数据文件中的位置
+ * @ingroup BufferPool
+ */
+struct PageSlot
+{
+  int64_t offset = 0;  ///< 在数据文件中的偏移，按扇区对齐。0表示这个页面还没有写过
+  int32_t length = 0;  ///< 压缩后的长度，等于 BP_PAGE_SIZE 时表示没有压缩
+  int32_t reserved = 0;
+
+  bool empty() const { return offset == 0; }
+};
+
+/**
+ * @brief 压缩的页面文件
+ * @ingroup BufferPool
+ * @details 位于 DiskBufferPool 与磁盘文件之间，页面写磁盘之前压缩，读出来之后解压，内存中的页面格式不变。
+ * 数据文件中，文件头之后是压缩过的页面，每个页面占用整数个扇区，页面之间没有固定的顺序。
+ * 页面在数据文件中的位置记录在映射文件(数据文件名加上 .pmap)中，映射文件的第i项就是第i个页面的 PageSlot。
+ * 压缩后节省不了扇区的页面按原样保存。
+ *
+ * 页面每次写入都放到新分配的位置，不覆盖旧的数据，新的位置只记录在内存中的映射里，旧的位置先挂起。
+ * sync 时先把数据文件刷到磁盘，再写映射文件并刷盘，之后挂起的空间才能重新分配。
+ * 所以磁盘上的映射文件要么指向挂起的完整旧页面，要么指向已经落盘的新页面。系统崩溃时丢失的映射更新，
+ * 对应的页面修改由重做日志恢复。挂起的空间太多时写入也会自动 sync。
+ *
+ * 读取可以并发执行；写入和 sync 由调用者串行执行，DiskBufferPool 都在 lock_ 内调用。
+ * 同一个页面不会同时读写：只有不在内存中的页面才会读，只有在内存中的页面才会写。
+ * 为了简单，压缩的文件不使用 O_DIRECT。
+ */
+class CompressedPageFile
+{
+public:
+  static constexpr int SECTOR_SIZE        = 512;
+  static constexpr int MAP_BLOCK_SLOTS    = 4096 / sizeof(PageSlot);  ///< 映射文件按块写入，一块有多少项
+  static constexpr int MAX_PENDING_SIZE   = 4 * 1024 * 1024;          ///< 挂起的空间超过这么多字节时自动 sync
+
+public:
+  CompressedPageFile() = default;
+  ~CompressedPageFile();
+
+  /**
+   * @brief 创建一个压缩的数据文件和它的映射文件，写入第0个页面
+   * @param codec_name 压缩算法的名字，不能是 none
+   */
+  static RC create(const char *file_name, const char *codec_name, const Page &header_page);
+
+  /**
+   * @brief 文件是不是压缩的数据文件
+   */
+  static bool is_compressed(const char *file_name);
+
+  static std::string map_file_name(const char *file_name);
+
+  RC open(const char *file_name);
+
+  /**
+   * @brief 把还没有落盘的映射刷到磁盘，然后关闭文件
+   */
+  RC close();
+
+  int data_fd() const { return data_fd_; }
+  const char *codec_name() const { return codec_ == nullptr ? "none" : codec_->name(); }
+
+  RC read_page(PageNum page_num, Page &page);
+
+  /**
+   * @brief 批量读取页面，所有读请求一次提交给IO后端
+   * @param results 返回每个页面的结果
+   * @return 全部成功时返回SUCCESS，否则返回第一个失败的错误码
+   */
+  RC read_pages(const std::vector<PageNum> &page_nums, const std::vector<Page *> &pages, std::vector<RC> &results);
+
+  /**
+   * @brief 批量写入页面，页面号使用 Page::page_num
+   * @details 页面压缩之后分配新的空间，连续的空间合并成一个向量写请求，然后更新内存中的映射，
+   * 映射文件在 sync 时才写
+   * @param sync 是否在写完之后 sync
+   */
+  RC write_pages(const std::vector<const Page *> &pages, bool sync);
+
+  /**
+   * @brief 把数据文件和映射文件刷到磁盘上，然后释放挂起的空间
+   */
+  RC sync();
+
+  /**
+   * @brief 所有页面压缩后一共占用了多少字节，按扇区对齐。测试使用
+   */
+  int64_t stored_bytes();
+
+private:
+  static int64_t align_up(int64_t size) { return (size + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE; }
+
+  RC load_map();
+
+  /**
+   * @brief 分配一块空间，优先使用最合适的空闲空间，没有时扩展文件
+   */
+  int64_t alloc_extent(int64_t size);
+
+  /**
+   * @brief 空间放回空闲列表，与前后相邻的空闲空间合并
+   */
+  void free_extent(int64_t offset, int64_t size);
+
+  /**
+   * @brief 写入修改过的映射块
+   * @details 只能在映射指向的数据都已经落盘之后调用，参考 sync
+   */
+  RC write_map_blocks();
+
+private:
+  std::string                file_name_;
+  int                        data_fd_ = -1;
+  int                        map_fd_  = -1;
+  std::unique_ptr<PageCodec> codec_;
+
+  /// 保护下面的映射表和空间分配信息，读页面和写页面都会访问
+  std::mutex                 lock_;
+  std::vector<PageSlot>      slots_;
+  std::set<int>              dirty_blocks_;  ///< 修改过、还没有写入映射文件的块
+  int64_t                    file_end_ = SECTOR_SIZE;
+  std::map<int64_t, int64_t> free_extents_;  ///< 空闲空间，offset -> size
+  std::set<std::pair<int64_t, int64_t>> free_by_size_;  ///< 空闲空间按照 (size, offset) 排序，用来查找最合适的空间
+  std::vector<std::pair<int64_t, int64_t>> pending_extents_;  ///< 被覆盖的旧页面占用的空间，sync 之后才能重新分配
+  int64_t                    pending_size_ = 0;
+};
@@ -13,12 +13,17 @@ See the Mulan PSL v2 for more details. */
 //
 #include <errno.h>
 #include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <thread>
 
 #include "storage/buffer/disk_buffer_pool.h"
 #include "common/lang/mutex.h"
 #include "common/log/log.h"
 #include "common/os/os.h"
 #include "common/io/io.h"
+#include "storage/common/io_backend.h"
 
 using namespace common;
 using namespace std;
@@ -40,37 +45,232 @@ string BPFileHeader::to_string() const
 BPFrameManager::BPFrameManager(const char *name) : allocator_(name)
 {}
 
-RC BPFrameManager::init(int pool_num)
+RC BPFrameManager::init(int pool_num, int shard_num /* = DEFAULT_SHARD_NUM */, const char *replacer /* = lru */,
+                        FrameAllocator::HugePage huge_page /* = NONE */)
 {
-  int ret = allocator_.init(false, pool_num);
-  if (ret == 0) {
-    return RC::SUCCESS;
+  if (shard_num <= 0) {
+    shard_num = DEFAULT_SHARD_NUM;
+  }
+
+  RC rc = allocator_.init(pool_num * DEFAULT_ITEM_NUM_PER_POOL, huge_page);
+  if (OB_FAIL(rc)) {
+    return rc;
   }
-  return RC::NOMEM;
+
+  const int shard_capacity = std::max(allocator_.get_size() / shard_num, 1);
+  shards_.clear();
+  shards_.reserve(shard_num);
+  for (int i = 0; i < shard_num; i++) {
+    FrameShard *shard = new FrameShard;
+    shards_.emplace_back(shard);
+    shard->replacer.reset(FrameReplacer::create(replacer, shard_capacity));
+    if (shard->replacer == nullptr) {
+      LOG_ERROR("failed to create frame replacer. name=%s", replacer);
+      return RC::INVALID_ARGUMENT;
+    }
+  }
+
+  LOG_INFO("frame manager init done. frame num=%d, shard num=%d, replacer=%s",
+           allocator_.get_size(), shard_num, shards_.front()->replacer->name());
+  return RC::SUCCESS;
 }
 
 RC BPFrameManager::cleanup()
 {
-  if (frames_.count() > 0) {
+  if (frame_num() > 0) {
     return RC::INTERNAL;
   }
 
-  frames_.destroy();
+  for (auto &shard : shards_) {
+    shard->frames.clear();
+  }
   return RC::SUCCESS;
 }
 
-int BPFrameManager::purge_frames(int count, std::function<RC(Frame *frame)> purger)
+int BPFrameManager::free_frame_num()
 {
-  std::lock_guard<std::mutex> lock_guard(lock_);
+  return allocator_.get_free_num();
+}
 
-  std::vector<Frame *> frames_can_purge;
+int BPFrameManager::file_frame_num(int file_desc)
+{
+  return allocator_.file_frame_num(file_desc);
+}
+
+RC BPFrameManager::resize(int frame_num, std::function<RC(Frame *frame)> purger)
+{
+  RC rc = allocator_.resize(frame_num);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  const int shard_capacity = std::max(frame_num / static_cast<int>(shards_.size()), 1);
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock_guard(shard->lock);
+    shard->replacer->resize(shard_capacity);
+  }
+
+  // 缩小时淘汰停用的页帧，把内存还给操作系统。正在使用的页帧淘汰不掉，等它们以后被正常淘汰时再释放
+  std::function<bool(Frame *)> filter = [this](Frame *frame) { return allocator_.retired(frame); };
+  for (int i = 0; i < MAX_RESIZE_PURGE_ROUNDS; i++) {
+    const int retired_num = allocator_.retired_used_num();
+    if (retired_num == 0) {
+      break;
+    }
+
+    int freed_count = 0;
+    for (auto &shard : shards_) {
+      freed_count += purge_shard_frames(*shard, retired_num, &purger, &filter);
+    }
+    if (freed_count == 0) {
+      break;
+    }
+  }
+
+  LOG_INFO("resize frame manager done. frame num=%d, retired frames in use=%d",
+           allocator_.get_size(), allocator_.retired_used_num());
+  return RC::SUCCESS;
+}
+
+void BPFrameManager::find_hot_frames(std::vector<FrameId> &frame_ids)
+{
+  std::vector<std::pair<unsigned long, FrameId>> frames;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock_guard(shard->lock);
+    for (auto &item : shard->frames) {
+      frames.emplace_back(item.second->acc_time(), item.first);
+    }
+  }
+
+  std::stable_sort(frames.begin(), frames.end(), [](const auto &left, const auto &right) {
+    return left.first > right.first;
+  });
+  frame_ids.reserve(frame_ids.size() + frames.size());
+  for (auto &frame : frames) {
+    frame_ids.push_back(frame.second);
+  }
+}
+
+bool BPFrameManager::purge_untouched(int file_desc, PageNum page_num)
+{
+  FrameId frame_id(file_desc, page_num);
+  FrameShard &shard = shard_of(frame_id);
+
+  std::lock_guard<std::mutex> lock_guard(shard.lock);
+  auto iter = shard.frames.find(frame_id);
+  if (iter == shard.frames.end()) {
+    return false;
+  }
+
+  Frame *frame = iter->second;
+  if (!frame->can_purge() || frame->dirty() || frame->acc_time() != 0) {
+    return false;
+  }
+
+  frame->pin();
+  free_internal(shard, frame_id, frame, true /*evicted*/);
+  return true;
+}
+
+size_t BPFrameManager::frame_num() const
+{
+  size_t num = 0;
+  for (const auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock_guard(shard->lock);
+    num += shard->frames.size();
+  }
+  return num;
+}
+
+BPFrameManager::FrameShard &BPFrameManager::shard_of(const FrameId &frame_id)
+{
+  // hash 的高32位是文件描述符，低32位是页面编号，混合一下让同一个文件的连续页面分散到不同分片上
+  size_t hash = frame_id.hash();
+  hash ^= hash >> 32;
+  return *shards_[hash % shards_.size()];
+}
+
+int BPFrameManager::purge_file_frames(int file_desc, int count, std::function<RC(Frame *frame)> *purger)
+{
+  std::function<bool(Frame *)> filter = [file_desc](Frame *frame) { return frame->file_desc() == file_desc; };
+
+  const size_t shard_num = shards_.size();
+  const size_t start = purge_cursor_.fetch_add(1) % shard_num;
+
+  int freed_count = 0;
+  for (size_t i = 0; i < shard_num && freed_count < count; i++) {
+    FrameShard &shard = *shards_[(start + i) % shard_num];
+    freed_count += purge_shard_frames(shard, count - freed_count, purger, &filter);
+  }
+  LOG_DEBUG("purge file frames done. file_desc=%d, number=%d", file_desc, freed_count);
+  return freed_count;
+}
+
+int BPFrameManager::purge_frames(int count, std::function<RC(Frame *frame)> purger)
+{
   if (count <= 0) {
     count = 1;
   }
-  frames_can_purge.reserve(count);
 
-  auto purge_finder = [&frames_can_purge, count](const FrameId &frame_id, Frame *const frame) {
-    if (frame->can_purge()) {
+  const size_t shard_num = shards_.size();
+  const size_t start = purge_cursor_.fetch_add(1) % shard_num;
+
+  int freed_count = 0;
+  for (size_t i = 0; i < shard_num && freed_count < count; i++) {
+    FrameShard &shard = *shards_[(start + i) % shard_num];
+    freed_count += purge_shard_frames(shard, count - freed_count, &purger);
+  }
+  LOG_INFO("purge frame done. number=%d", freed_count);
+  return freed_count;
+}
+
+int BPFrameManager::purge_clean_frames(int count)
+{
+  const size_t shard_num = shards_.size();
+  const size_t start = purge_cursor_.fetch_add(1) % shard_num;
+
+  int freed_count = 0;
+  for (size_t i = 0; i < shard_num && freed_count < count; i++) {
+    FrameShard &shard = *shards_[(start + i) % shard_num];
+    freed_count += purge_shard_frames(shard, count - freed_count, nullptr);
+  }
+  LOG_DEBUG("purge clean frames done. number=%d", freed_count);
+  return freed_count;
+}
+
+void BPFrameManager::find_dirty_victims(int count, std::vector<FrameId> &frame_ids)
+{
+  const int shard_num = static_cast<int>(shards_.size());
+  const int count_per_shard = (count + shard_num - 1) / shard_num;
+
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock_guard(shard->lock);
+
+    int scanned = 0;
+    // 只是提前写回将来可能被淘汰的脏页，不能改变置换策略的状态
+    shard->replacer->foreach_candidate([&frame_ids, &scanned, count_per_shard](Frame *frame) {
+      if (frame->can_purge()) {
+        if (frame->dirty()) {
+          frame_ids.push_back(frame->frame_id());
+        }
+        scanned++;
+      }
+      return scanned < count_per_shard;
+    });
+  }
+}
+
+int BPFrameManager::purge_shard_frames(FrameShard &shard, int count, std::function<RC(Frame *frame)> *purger,
+                                       std::function<bool(Frame *frame)> *filter /* = nullptr */)
+{
+  std::lock_guard<std::mutex> lock_guard(shard.lock);
+
+  std::vector<Frame *> frames_can_purge;
+  frames_can_purge.reserve(std::min(static_cast<size_t>(count), shard.frames.size()));
+
+  const bool clean_only = (purger == nullptr);
+  auto purge_finder = [&frames_can_purge, count, clean_only, filter](Frame *frame) {
+    if (frame->can_purge() && !(clean_only && frame->dirty()) && (filter == nullptr || (*filter)(frame))) {
       frame->pin();
       frames_can_purge.push_back(frame);
       if (frames_can_purge.size() >= static_cast<size_t>(count)) {
@@ -80,16 +280,16 @@ int BPFrameManager::purge_frames(int count, std::function<RC(Frame *frame)> purg
     return true;  // true continue to look up
   };
 
-  frames_.foreach_reverse(purge_finder);
-  LOG_INFO("purge frames find %ld pages total", frames_can_purge.size());
+  shard.replacer->foreach_victim(purge_finder);
+  LOG_DEBUG("purge frames find %ld pages in shard", frames_can_purge.size());
 
-  /// 当前还在frameManager的锁内，而 purger 是一个非常耗时的操作
-  /// 他需要把脏页数据刷新到磁盘上去，所以这里会极大地降低并发度
+  /// 当前还在分片的锁内，而 purger 是一个非常耗时的操作
+  /// 他需要把脏页数据刷新到磁盘上去，所以这里会降低这个分片的并发度
   int freed_count = 0;
   for (Frame *frame : frames_can_purge) {
-    RC rc = purger(frame);
+    RC rc = clean_only ? RC::SUCCESS : (*purger)(frame);
     if (RC::SUCCESS == rc) {
-      free_internal(frame->frame_id(), frame);
+      free_internal(shard, frame->frame_id(), frame, true /*evicted*/);
       freed_count++;
     } else {
       frame->unpin();
@@ -97,23 +297,28 @@ int BPFrameManager::purge_frames(int count, std::function<RC(Frame *frame)> purg
                to_string(frame->frame_id()).c_str(), strrc(rc));
     }
   }
-  LOG_INFO("purge frame done. number=%d", freed_count);
   return freed_count;
 }
 
-Frame *BPFrameManager::get(int file_desc, PageNum page_num)
+Frame *BPFrameManager::get(int file_desc, PageNum page_num, bool touch /* = true */)
 {
   FrameId frame_id(file_desc, page_num);
-  std::lock_guard<std::mutex> lock_guard(lock_);
-  return get_internal(frame_id);
+  FrameShard &shard = shard_of(frame_id);
+  std::lock_guard<std::mutex> lock_guard(shard.lock);
+  return get_internal(shard, frame_id, touch);
 }
 
-Frame *BPFrameManager::get_internal(const FrameId &frame_id)
+Frame *BPFrameManager::get_internal(FrameShard &shard, const FrameId &frame_id, bool touch /* = true */)
 {
-  Frame *frame = nullptr;
-  (void)frames_.get(frame_id, frame);
-  if (frame != nullptr) {
-    frame->pin();
+  auto iter = shard.frames.find(frame_id);
+  if (iter == shard.frames.end()) {
+    return nullptr;
+  }
+
+  Frame *frame = iter->second;
+  frame->pin();
+  if (touch) {
+    shard.replacer->access(frame);
   }
   return frame;
 }
@@ -121,20 +326,51 @@ Frame *BPFrameManager::get_internal(const FrameId &frame_id)
 Frame *BPFrameManager::alloc(int file_desc, PageNum page_num)
 {
   FrameId frame_id(file_desc, page_num);
+  FrameShard &shard = shard_of(frame_id);
 
-  std::lock_guard<std::mutex> lock_guard(lock_);
-  Frame *frame = get_internal(frame_id);
+  std::lock_guard<std::mutex> lock_guard(shard.lock);
+  Frame *frame = get_internal(shard, frame_id);
   if (frame != nullptr) {
     return frame;
   }
 
-  frame = allocator_.alloc();
+  return alloc_internal(shard, frame_id, false /*loading*/);
+}
+
+Frame *BPFrameManager::get_or_alloc(int file_desc, PageNum page_num, bool &created)
+{
+  FrameId frame_id(file_desc, page_num);
+  FrameShard &shard = shard_of(frame_id);
+
+  created = false;
+  std::lock_guard<std::mutex> lock_guard(shard.lock);
+  Frame *frame = get_internal(shard, frame_id);
+  if (frame != nullptr) {
+    return frame;
+  }
+
+  // 放入页帧表和标记为正在加载要在同一个锁内完成，其它线程才不会拿到没有数据的页帧
+  frame = alloc_internal(shard, frame_id, true /*loading*/);
+  created = (frame != nullptr);
+  return frame;
+}
+
+Frame *BPFrameManager::alloc_internal(FrameShard &shard, const FrameId &frame_id, bool loading)
+{
+  Frame *frame = allocator_.alloc(frame_id.file_desc());
   if (frame != nullptr) {
     ASSERT(frame->pin_count() == 0, "got an invalid frame that pin count is not 0. frame=%s", 
            to_string(*frame).c_str());
-    frame->set_page_num(page_num);
+    frame->set_file_desc(frame_id.file_desc());
+    frame->set_page_num(frame_id.page_num());
     frame->pin();
-    frames_.put(frame_id, frame);
+    if (loading) {
+      frame->set_loading();
+    } else {
+      frame->finish_loading(true);
+    }
+    shard.frames.emplace(frame_id, frame);
+    shard.replacer->insert(frame);
   }
   return frame;
 }
@@ -142,38 +378,80 @@ Frame *BPFrameManager::alloc(int file_desc, PageNum page_num)
 RC BPFrameManager::free(int file_desc, PageNum page_num, Frame *frame)
 {
   FrameId frame_id(file_desc, page_num);
+  FrameShard &shard = shard_of(frame_id);
+
+  std::lock_guard<std::mutex> lock_guard(shard.lock);
+  return free_internal(shard, frame_id, frame, false /*evicted*/);
+}
+
+RC BPFrameManager::free_unpinned(int file_desc, PageNum page_num, Frame *frame)
+{
+  FrameId frame_id(file_desc, page_num);
+  FrameShard &shard = shard_of(frame_id);
 
-  std::lock_guard<std::mutex> lock_guard(lock_);
-  return free_internal(frame_id, frame);
+  std::lock_guard<std::mutex> lock_guard(shard.lock);
+  if (frame->pin_count() > 1) {
+    return RC::LOCKED_UNLOCK;
+  }
+  return free_internal(shard, frame_id, frame, false /*evicted*/);
 }
 
-RC BPFrameManager::free_internal(const FrameId &frame_id, Frame *frame)
+RC BPFrameManager::free_internal(FrameShard &shard, const FrameId &frame_id, Frame *frame, bool evicted)
 {
-  Frame *frame_source = nullptr;
-  [[maybe_unused]] bool found = frames_.get(frame_id, frame_source);
+  auto iter = shard.frames.find(frame_id);
+  [[maybe_unused]] bool found = iter != shard.frames.end();
+  [[maybe_unused]] Frame *frame_source = found ? iter->second : nullptr;
   ASSERT(found && frame == frame_source && frame->pin_count() == 1,
          "failed to free frame. found=%d, frameId=%s, frame_source=%p, frame=%p, pinCount=%d, lbt=%s",
          found, to_string(frame_id).c_str(), frame_source, frame, frame->pin_count(), lbt());
 
   frame->unpin();
-  frames_.remove(frame_id);
+  if (evicted) {
+    shard.replacer->evict(frame);
+  } else {
+    shard.replacer->remove(frame);
+  }
+  shard.frames.erase(iter);
   allocator_.free(frame);
   return RC::SUCCESS;
 }
 
-std::list<Frame *> BPFrameManager::find_list(int file_desc)
+RC BPFrameManager::free_failed(int file_desc, PageNum page_num, Frame *frame)
 {
-  std::lock_guard<std::mutex> lock_guard(lock_);
+  FrameId frame_id(file_desc, page_num);
+  FrameShard &shard = shard_of(frame_id);
+
+  {
+    std::lock_guard<std::mutex> lock_guard(shard.lock);
+    auto iter = shard.frames.find(frame_id);
+    ASSERT(iter != shard.frames.end() && iter->second == frame,
+           "failed to free frame. frameId=%s, frame=%p", to_string(frame_id).c_str(), frame);
+    shard.replacer->remove(frame);
+    shard.frames.erase(iter);
+  }
 
+  // 等待的线程看到加载失败后会马上unpin
+  while (frame->pin_count() > 1) {
+    std::this_thread::yield();
+  }
+  frame->unpin();
+  allocator_.free(frame);
+  return RC::SUCCESS;
+}
+
+std::list<Frame *> BPFrameManager::find_list(int file_desc)
+{
   std::list<Frame *> frames;
-  auto fetcher = [&frames, file_desc](const FrameId &frame_id, Frame *const frame) -> bool {
-    if (file_desc == frame_id.file_desc()) {
-      frame->pin();
-      frames.push_back(frame);
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock_guard(shard->lock);
+    for (auto &iter : shard->frames) {
+      if (file_desc == iter.first.file_desc()) {
+        Frame *frame = iter.second;
+        frame->pin();
+        frames.push_back(frame);
+      }
     }
-    return true;
-  };
-  frames_.foreach (fetcher);
+  }
   return frames;
 }
 
@@ -182,34 +460,100 @@ BufferPoolIterator::BufferPoolIterator()
 {}
 BufferPoolIterator::~BufferPoolIterator()
 {}
-RC BufferPoolIterator::init(DiskBufferPool &bp, PageNum start_page /* = 0 */)
+RC BufferPoolIterator::init(DiskBufferPool &bp, PageNum start_page /* = 0 */, PageNum end_page /* = BP_INVALID_PAGE_NUM */)
 {
-  bitmap_.init(bp.file_header_->bitmap, bp.file_header_->page_count);
+  buffer_pool_ = &bp;
   if (start_page <= 0) {
     current_page_num_ = 0;
   } else {
     current_page_num_ = start_page;
   }
+  end_page_num_ = end_page;
+  next_page_num_ = BP_INVALID_PAGE_NUM;
+  group_ = -1;
+  read_ahead_.init(bp);
   return RC::SUCCESS;
 }
 
 bool BufferPoolIterator::has_next()
 {
-  return bitmap_.next_setted_bit(current_page_num_ + 1) != -1;
+  if (next_page_num_ == BP_INVALID_PAGE_NUM) {
+    next_page_num_ = find_next_page();
+  }
+  return next_page_num_ != BP_INVALID_PAGE_NUM;
 }
 
 PageNum BufferPoolIterator::next()
 {
-  PageNum next_page = bitmap_.next_setted_bit(current_page_num_ + 1);
-  if (next_page != -1) {
+  PageNum next_page = next_page_num_;
+  if (next_page == BP_INVALID_PAGE_NUM) {
+    next_page = find_next_page();
+  }
+
+  next_page_num_ = BP_INVALID_PAGE_NUM;
+  if (next_page != BP_INVALID_PAGE_NUM) {
     current_page_num_ = next_page;
+    read_ahead_.access(next_page);
   }
   return next_page;
 }
 
+PageNum BufferPoolIterator::find_next_page()
+{
+  PageNum page_num = current_page_num_ + 1;
+  bool    fresh    = false;  // 缓存的位图是不是这次查找时刚复制的
+  while (end_page_num_ == BP_INVALID_PAGE_NUM || page_num < end_page_num_) {
+    const int group = DiskBufferPool::group_of(page_num);
+    if (group != group_) {
+      if (load_group(group) != RC::SUCCESS) {
+        return BP_INVALID_PAGE_NUM;
+      }
+      fresh = true;
+    }
+    if (group_page_num_ <= 0) {
+      return BP_INVALID_PAGE_NUM;
+    }
+
+    // 每个组的第一个页面是元数据，不返回给使用者
+    const PageNum  start = DiskBufferPool::group_start(group);
+    common::Bitmap bitmap(group_bitmap_.data(), group_page_num_);
+    const int      index = bitmap.next_setted_bit(std::max(page_num - start, 1));
+    if (index >= 0) {
+      page_num = start + index;
+      break;
+    }
+
+    if (group_page_num_ < DiskBufferPool::group_start(group + 1) - start) {
+      // 文件的最后一个组，复制位图之后文件可能又扩展了，重新复制一次
+      if (fresh) {
+        return BP_INVALID_PAGE_NUM;
+      }
+      group_ = -1;
+      continue;
+    }
+    page_num = DiskBufferPool::group_start(group + 1);
+    fresh    = false;
+  }
+
+  if (end_page_num_ != BP_INVALID_PAGE_NUM && page_num >= end_page_num_) {
+    return BP_INVALID_PAGE_NUM;
+  }
+  return page_num;
+}
+
+RC BufferPoolIterator::load_group(int group)
+{
+  RC rc = buffer_pool_->copy_group_bitmap(group, group_bitmap_, group_page_num_);
+  group_ = (rc == RC::SUCCESS) ? group : -1;
+  return rc;
+}
+
 RC BufferPoolIterator::reset()
 {
   current_page_num_ = 0;
+  next_page_num_ = BP_INVALID_PAGE_NUM;
+  group_ = -1;
+  read_ahead_.reset();
   return RC::SUCCESS;
 }
 
@@ -226,12 +570,34 @@ DiskBufferPool::~DiskBufferPool()
 
 RC DiskBufferPool::open_file(const char *file_name)
 {
-  int fd = open(file_name, O_RDWR);
+  int fd = -1;
+  if (CompressedPageFile::is_compressed(file_name)) {
+    // 压缩的文件由 CompressedPageFile 打开，页面都要经过它读写
+    compressed_file_ = std::make_unique<CompressedPageFile>();
+    RC rc = compressed_file_->open(file_name);
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("Failed to open compressed file %s. rc=%s", file_name, strrc(rc));
+      compressed_file_.reset();
+      return rc;
+    }
+    fd = compressed_file_->data_fd();
+  } else if (bp_manager_.direct_io()) {
+    // 页帧的内存是按页对齐的，读写也都是整个页面，满足 O_DIRECT 的要求。
+    // 有些文件系统(比如tmpfs)不支持 O_DIRECT，这时还是使用页缓存
+    fd = open(file_name, O_RDWR | O_DIRECT);
+    if (fd < 0 && errno == EINVAL) {
+      LOG_WARN("file system does not support O_DIRECT, open without it. file=%s", file_name);
+    }
+  }
+  if (fd < 0) {
+    fd = open(file_name, O_RDWR);
+  }
   if (fd < 0) {
     LOG_ERROR("Failed to open file %s, because %s.", file_name, strerror(errno));
     return RC::IOERR_ACCESS;
   }
-  LOG_INFO("Successfully open buffer pool file %s.", file_name);
+  LOG_INFO("Successfully open buffer pool file %s. direct io=%d, codec=%s",
+           file_name, (fcntl(fd, F_GETFL) & O_DIRECT) != 0, codec_name() == nullptr ? "none" : codec_name());
 
   file_name_ = file_name;
   file_desc_ = fd;
@@ -240,8 +606,7 @@ RC DiskBufferPool::open_file(const char *file_name)
   rc = allocate_frame(BP_HEADER_PAGE, &hdr_frame_);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("failed to allocate frame for header. file name %s", file_name_.c_str());
-    close(fd);
-    file_desc_ = -1;
+    close_data_file();
     return rc;
   }
 
@@ -251,13 +616,21 @@ RC DiskBufferPool::open_file(const char *file_name)
   if ((rc = load_page(BP_HEADER_PAGE, hdr_frame_)) != RC::SUCCESS) {
     LOG_ERROR("Failed to load first page of %s, due to %s.", file_name, strerror(errno));
     purge_frame(BP_HEADER_PAGE, hdr_frame_);
-    close(fd);
-    file_desc_ = -1;
+    close_data_file();
     return rc;
   }
 
   file_header_ = (BPFileHeader *)hdr_frame_->data();
 
+  if ((rc = load_groups()) != RC::SUCCESS) {
+    LOG_ERROR("Failed to load allocation groups of %s. rc=%s", file_name, strrc(rc));
+    hdr_frame_->unpin();
+    purge_all_pages();
+    close_data_file();
+    file_header_ = nullptr;
+    return rc;
+  }
+
   LOG_INFO("Successfully open %s. file_desc=%d, hdr_frame=%p, file header=%s",
            file_name, file_desc_, hdr_frame_, file_header_->to_string().c_str());
   return RC::SUCCESS;
@@ -270,6 +643,9 @@ RC DiskBufferPool::close_file()
     return rc;
   }
 
+  // 后台线程可能还在预读这个文件的页面
+  bp_manager_.read_ahead_worker().cancel(this);
+
   hdr_frame_->unpin();
 
   // TODO: 理论上是在回放时回滚未提交事务，但目前没有undo log，因此不下刷数据page，只通过redo log回放
@@ -280,86 +656,280 @@ RC DiskBufferPool::close_file()
   }
 
   disposed_pages_.clear();
+  disposed_page_num_.store(0);
+  group_allocated_pages_.clear();
+  free_groups_.clear();
 
-  if (close(file_desc_) < 0) {
-    LOG_ERROR("Failed to close fileId:%d, fileName:%s, error:%s", file_desc_, file_name_.c_str(), strerror(errno));
-    return RC::IOERR_CLOSE;
+  const int file_desc = file_desc_;
+  rc = close_data_file();
+  if (rc != RC::SUCCESS) {
+    return rc;
   }
-  LOG_INFO("Successfully close file %d:%s.", file_desc_, file_name_.c_str());
-  file_desc_ = -1;
+  LOG_INFO("Successfully close file %d:%s.", file_desc, file_name_.c_str());
 
   bp_manager_.close_file(file_name_.c_str());
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::get_this_page(PageNum page_num, Frame **frame)
+RC DiskBufferPool::close_data_file()
+{
+  RC rc = RC::SUCCESS;
+  if (compressed_file_ != nullptr) {
+    rc = compressed_file_->close();
+    compressed_file_.reset();
+  } else if (close(file_desc_) < 0) {
+    LOG_ERROR("Failed to close fileId:%d, fileName:%s, error:%s", file_desc_, file_name_.c_str(), strerror(errno));
+    rc = RC::IOERR_CLOSE;
+  }
+  file_desc_ = -1;
+  return rc;
+}
+
+RC DiskBufferPool::get_this_page(PageNum page_num, Frame **frame, bool touch /* = true */)
 {
   RC rc = RC::SUCCESS;
   *frame = nullptr;
 
-  Frame *used_match_frame = frame_manager_.get(file_desc_, page_num);
-  if (used_match_frame != nullptr) {
-    used_match_frame->access();
-    *frame = used_match_frame;
-    return RC::SUCCESS;
+  Frame *target_frame = frame_manager_.get(file_desc_, page_num, touch);
+  if (target_frame == nullptr) {
+    // Allocate one page and load the data into this page
+    bool created = false;
+    rc = allocate_frame(page_num, &target_frame, &created);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to alloc frame %s:%d, due to failed to alloc page.", file_name_.c_str(), page_num);
+      return rc;
+    }
+
+    if (created) {
+      // 当前线程负责加载数据，其它同时访问这个页面的线程会等待
+      rc = load_created_frame(page_num, target_frame);
+      if (rc != RC::SUCCESS) {
+        return rc;
+      }
+
+      if (touch) {
+        target_frame->access();
+      }
+      *frame = target_frame;
+      return RC::SUCCESS;
+    }
   }
 
-  std::scoped_lock lock_guard(lock_); // 直接加了一把大锁，其实可以根据访问的页面来细化提高并行度
+  if (!target_frame->wait_loaded()) {
+    LOG_WARN("Failed to get page %s:%d, because failed to load it", file_name_.c_str(), page_num);
+    target_frame->unpin();
+    return RC::IOERR_READ;
+  }
 
-  // Allocate one page and load the data into this page
-  Frame *allocated_frame = nullptr;
-  rc = allocate_frame(page_num, &allocated_frame);
-  if (rc != RC::SUCCESS) {
-    LOG_ERROR("Failed to alloc frame %s:%d, due to failed to alloc page.", file_name_.c_str(), page_num);
-    return rc;
+  if (touch) {
+    target_frame->access();
   }
+  *frame = target_frame;
+  return RC::SUCCESS;
+}
 
-  allocated_frame->set_file_desc(file_desc_);
-  // allocated_frame->pin(); // pined in manager::get
-  allocated_frame->access();
+void DiskBufferPool::purge_untouched_page(PageNum page_num)
+{
+  if (page_num == BP_HEADER_PAGE) {
+    return;
+  }
+  (void)frame_manager_.purge_untouched(file_desc_, page_num);
+}
 
-  if ((rc = load_page(page_num, allocated_frame)) != RC::SUCCESS) {
+RC DiskBufferPool::load_created_frame(PageNum page_num, Frame *frame)
+{
+  frame->set_file_desc(file_desc_);
+  RC rc = load_page(page_num, frame);
+  if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to load page %s:%d", file_name_.c_str(), page_num);
-    purge_frame(page_num, allocated_frame);
+    frame->finish_loading(false);
+    frame_manager_.free_failed(file_desc_, page_num, frame);
     return rc;
   }
 
-  *frame = allocated_frame;
+  frame->finish_loading(true);
   return RC::SUCCESS;
 }
 
+PageNum DiskBufferPool::read_ahead(PageNum start_page, int count)
+{
+  ReadAheadWorker &worker = bp_manager_.read_ahead_worker();
+  if (!worker.running() || count <= 0) {
+    return BP_INVALID_PAGE_NUM;
+  }
+
+  std::vector<PageNum> page_nums;
+  page_nums.reserve(count);
+  {
+    std::scoped_lock lock_guard(lock_);
+    for (PageNum page_num = next_allocated_page_internal(start_page);
+         page_num != BP_INVALID_PAGE_NUM && static_cast<int>(page_nums.size()) < count;
+         page_num = next_allocated_page_internal(page_num + 1)) {
+      page_nums.push_back(page_num);
+    }
+  }
+
+  if (page_nums.empty()) {
+    return BP_INVALID_PAGE_NUM;
+  }
+
+  worker.submit(this, page_nums);
+  return page_nums.back();
+}
+
+RC DiskBufferPool::prefetch_pages(const std::vector<PageNum> &page_nums)
+{
+  std::vector<Frame *>   frames;
+  std::vector<PageNum>   load_page_nums;
+  std::vector<IoRequest> requests;
+  frames.reserve(page_nums.size());
+  load_page_nums.reserve(page_nums.size());
+  requests.reserve(page_nums.size());
+
+  RC rc = RC::SUCCESS;
+  for (PageNum page_num : page_nums) {
+    Frame *frame = frame_manager_.get(file_desc_, page_num, false /*touch*/);
+    if (frame != nullptr) {
+      frame->unpin();
+      continue;
+    }
+
+    // 超过配额时只能淘汰自己的干净页面来腾出页帧
+    const int quota = frame_quota_.load();
+    if (quota > 0 && frame_manager_.file_frame_num(file_desc_) >= quota &&
+        frame_manager_.purge_file_frames(file_desc_, 1 /*count*/, nullptr /*purger*/) == 0) {
+      rc = RC::BUFFERPOOL_NOBUF;
+      break;
+    }
+
+    bool created = false;
+    frame = frame_manager_.get_or_alloc(file_desc_, page_num, created);
+    if (frame == nullptr && frame_manager_.purge_clean_frames(1 /*count*/) > 0) {
+      frame = frame_manager_.get_or_alloc(file_desc_, page_num, created);
+    }
+    if (frame == nullptr) {
+      rc = RC::BUFFERPOOL_NOBUF;
+      break;
+    }
+
+    if (!created) {
+      frame->unpin();
+      continue;
+    }
+
+    frame->set_file_desc(file_desc_);
+    frames.push_back(frame);
+    load_page_nums.push_back(page_num);
+  }
+
+  // 一次提交所有需要加载的页面
+  std::vector<RC> results(frames.size(), RC::SUCCESS);
+  if (compressed_file_ != nullptr) {
+    std::vector<Page *> pages;
+    pages.reserve(frames.size());
+    for (Frame *frame : frames) {
+      pages.push_back(&frame->page());
+    }
+    (void)compressed_file_->read_pages(load_page_nums, pages, results);
+  } else {
+    for (size_t i = 0; i < frames.size(); i++) {
+      requests.push_back(
+          IoRequest::read(file_desc_, &frames[i]->page(), BP_PAGE_SIZE, (int64_t)load_page_nums[i] * BP_PAGE_SIZE));
+    }
+    (void)IoBackend::instance().submit(requests);
+    for (size_t i = 0; i < requests.size(); i++) {
+      if (requests[i].error != 0) {
+        LOG_WARN("Failed to read ahead page %s:%d. error=%d", file_name_.c_str(), load_page_nums[i], requests[i].error);
+        results[i] = RC::IOERR_READ;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    Frame *frame = frames[i];
+    if (results[i] != RC::SUCCESS) {
+      frame->finish_loading(false);
+      frame_manager_.free_failed(file_desc_, load_page_nums[i], frame);
+      rc = RC::IOERR_READ;
+      continue;
+    }
+
+    frame->finish_loading(true);
+    frame->unpin();
+  }
+  return rc;
+}
+
+int DiskBufferPool::read_ahead_pages() const
+{
+  return bp_manager_.read_ahead_pages();
+}
+
 RC DiskBufferPool::allocate_page(Frame **frame)
 {
   RC rc = RC::SUCCESS;
 
   lock_.lock();
-  
-  int byte = 0, bit = 0;
-  if ((file_header_->allocated_pages) < (file_header_->page_count)) {
+
+  if (!free_groups_.empty()) {
     // There is one free page
-    for (int i = 0; i < file_header_->page_count; i++) {
-      byte = i / 8;
-      bit = i % 8;
-      if (((file_header_->bitmap[byte]) & (1 << bit)) == 0) {
-        (file_header_->allocated_pages)++;
-        file_header_->bitmap[byte] |= (1 << bit);
-        // TODO,  do we need clean the loaded page's data?
-        hdr_frame_->mark_dirty();
-
-        lock_.unlock();
-        return get_this_page(i, frame);
-      }
+    const int group = *free_groups_.begin();
+    Frame *group_frame = nullptr;
+    common::Bitmap bitmap;
+    rc = fetch_group(group, group_frame, bitmap);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to fetch allocation group. file=%s, group=%d, rc=%s", file_name_.c_str(), group, strrc(rc));
+      lock_.unlock();
+      return rc;
+    }
+
+    const int index = bitmap.next_unsetted_bit(1);
+    group_frame->unpin();
+    ASSERT(index > 0, "there should be a free page in group. file=%s, group=%d", file_name_.c_str(), group);
+
+    const PageNum page_num = group_start(group) + index;
+    set_page_allocated(page_num, true);
+
+    // 空闲页面上原来的数据已经没有用了，不需要从磁盘读取。
+    // 这个页面也可能从来没有写到过磁盘上(比如回放日志时跳过的页面)
+    Frame *allocated_frame = nullptr;
+    if ((rc = allocate_frame(page_num, &allocated_frame)) != RC::SUCCESS) {
+      LOG_ERROR("Failed to allocate frame %s, due to no free page.", file_name_.c_str());
+      set_page_allocated(page_num, false);
+      lock_.unlock();
+      return rc;
+    }
+
+    allocated_frame->set_file_desc(file_desc_);
+    allocated_frame->access();
+    allocated_frame->clear_page();
+    allocated_frame->set_page_num(page_num);
+    allocated_frame->mark_dirty();
+
+    lock_.unlock();
+    *frame = allocated_frame;
+    return RC::SUCCESS;
+  }
+
+  // 新的页面正好是一个新分配组的第一个页面时，先把组的第一个页面创建出来
+  PageNum page_num = file_header_->page_count;
+  if (page_num != BP_HEADER_PAGE && group_start(group_of(page_num)) == page_num) {
+    rc = create_group(group_of(page_num));
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("Failed to create allocation group. file=%s, group=%d, rc=%s",
+               file_name_.c_str(), group_of(page_num), strrc(rc));
+      lock_.unlock();
+      return rc;
     }
+    page_num = file_header_->page_count;
   }
 
-  if (file_header_->page_count >= BPFileHeader::MAX_PAGE_NUM) {
-    LOG_WARN("file buffer pool is full. page count %d, max page count %d",
-        file_header_->page_count, BPFileHeader::MAX_PAGE_NUM);
+  if (page_num >= std::numeric_limits<PageNum>::max() - 1) {
+    LOG_WARN("file buffer pool is full. page count %d", file_header_->page_count);
     lock_.unlock();
     return RC::BUFFERPOOL_NOBUF;
   }
 
-  PageNum page_num = file_header_->page_count;
   Frame *allocated_frame = nullptr;
   if ((rc = allocate_frame(page_num, &allocated_frame)) != RC::SUCCESS) {
     LOG_ERROR("Failed to allocate frame %s, due to no free page.", file_name_.c_str());
@@ -370,18 +940,13 @@ RC DiskBufferPool::allocate_page(Frame **frame)
   LOG_INFO("allocate new page. file=%s, pageNum=%d, pin=%d",
            file_name_.c_str(), page_num, allocated_frame->pin_count());
 
-  file_header_->allocated_pages++;
   file_header_->page_count++;
-
-  byte = page_num / 8;
-  bit = page_num % 8;
-  file_header_->bitmap[byte] |= (1 << bit);
-  hdr_frame_->mark_dirty();
+  set_page_allocated(page_num, true);
 
   allocated_frame->set_file_desc(file_desc_);
   allocated_frame->access();
   allocated_frame->clear_page();
-  allocated_frame->set_page_num(file_header_->page_count - 1);
+  allocated_frame->set_page_num(page_num);
 
   // Use flush operation to extension file
   if ((rc = flush_page_internal(*allocated_frame)) != RC::SUCCESS) {
@@ -399,150 +964,541 @@ RC DiskBufferPool::allocate_page(Frame **frame)
 RC DiskBufferPool::dispose_page(PageNum page_num)
 {
   std::scoped_lock lock_guard(lock_);
+  if (page_num == group_start(group_of(page_num))) {
+    LOG_WARN("cannot dispose the first page of allocation group. file=%s, pageNum=%d", file_name_.c_str(), page_num);
+    return RC::BUFFERPOOL_INVALID_PAGE_NUM;
+  }
+
   Frame *used_frame = frame_manager_.get(file_desc_, page_num);
-  if (used_frame != nullptr) {
-    LOG_WARN("the page try to dispose is in use. frame:%s", to_string(*used_frame).c_str());
-    frame_manager_.free(file_desc_, page_num, used_frame);
-  } else {
+  if (used_frame == nullptr) {
     LOG_WARN("failed to fetch the page while disposing it. pageNum=%d", page_num);
     return RC::NOTFOUND;
   }
 
-  hdr_frame_->mark_dirty();
-  file_header_->allocated_pages--;
-  char tmp = 1 << (page_num % 8);
-  file_header_->bitmap[page_num / 8] &= ~tmp;
-  return RC::SUCCESS;
+  return dispose_frame(page_num, used_frame);
+}
+
+RC DiskBufferPool::dispose_frame(PageNum page_num, Frame *frame)
+{
+  while (frame != nullptr) {
+    if (frame_manager_.free_unpinned(file_desc_, page_num, frame) == RC::SUCCESS) {
+      break;
+    }
+
+    LOG_DEBUG("the page try to dispose is in use, free it after unpinned. frame:%s", to_string(*frame).c_str());
+    disposed_pages_.insert(page_num);
+    disposed_page_num_.store(static_cast<int>(disposed_pages_.size()));
+    if (frame->unpin() > 0) {
+      return RC::SUCCESS;
+    }
+
+    // 其它线程在这期间都已经unpin，由当前线程释放。页帧也可能已经被淘汰
+    frame = frame_manager_.get(file_desc_, page_num);
+  }
+
+  disposed_pages_.erase(page_num);
+  disposed_page_num_.store(static_cast<int>(disposed_pages_.size()));
+  return set_page_allocated(page_num, false);
 }
 
 RC DiskBufferPool::unpin_page(Frame *frame)
 {
-  frame->unpin();
-  return RC::SUCCESS;
+  const PageNum page_num = frame->page_num();
+  if (frame->unpin() == 0 && disposed_page_num_.load() > 0) {
+    // 最后一个使用者负责释放之前没能释放的页面，参考 dispose_frame
+    std::scoped_lock lock_guard(lock_);
+    if (disposed_pages_.count(page_num) > 0) {
+      return dispose_frame(page_num, frame_manager_.get(file_desc_, page_num));
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::purge_frame(PageNum page_num, Frame *buf)
+{
+  if (buf->pin_count() != 1) {
+    LOG_INFO("Begin to free page %d of %d(file id), but it's pin count > 1:%d.",
+        buf->page_num(), buf->file_desc(), buf->pin_count());
+    return RC::LOCKED_UNLOCK;
+  }
+
+  if (buf->dirty()) {
+    RC rc = flush_page_internal(*buf);
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("Failed to flush page %d of %d(file desc) during purge page.", buf->page_num(), buf->file_desc());
+      return rc;
+    }
+  }
+
+  LOG_DEBUG("Successfully purge frame =%p, page %d of %d(file desc)", buf, buf->page_num(), buf->file_desc());
+  frame_manager_.free(file_desc_, page_num, buf);
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::purge_page(PageNum page_num)
+{
+  std::scoped_lock lock_guard(lock_);
+  Frame *used_frame = frame_manager_.get(file_desc_, page_num);
+  if (used_frame != nullptr) {
+    return purge_frame(page_num, used_frame);
+  }
+
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::purge_all_pages()
+{
+  std::list<Frame *> used = frame_manager_.find_list(file_desc_);
+
+  std::scoped_lock lock_guard(lock_);
+
+  // 先把可以淘汰的脏页一起写到磁盘，purge_frame 就不需要逐个刷盘了
+  std::vector<Frame *> dirty_frames;
+  for (Frame *frame : used) {
+    if (frame->pin_count() == 1 && frame->dirty()) {
+      dirty_frames.push_back(frame);
+    }
+  }
+  RC rc = write_dirty_frames(dirty_frames);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to write dirty pages before purge. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+  }
+
+  for (std::list<Frame *>::iterator it = used.begin(); it != used.end(); ++it) {
+    Frame *frame = *it;
+
+    purge_frame(frame->page_num(), frame);
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::check_all_pages_unpinned()
+{
+  std::list<Frame *> frames = frame_manager_.find_list(file_desc_);
+
+  std::scoped_lock lock_guard(lock_);
+  for (Frame *frame : frames) {
+    frame->unpin();
+    if (frame->page_num() == BP_HEADER_PAGE && frame->pin_count() > 1) {
+      LOG_WARN("This page has been pinned. file desc=%d, pageNum:%d, pin count=%d",
+          file_desc_, frame->page_num(), frame->pin_count());
+    } else if (frame->page_num() != BP_HEADER_PAGE && frame->pin_count() > 0) {
+      LOG_WARN("This page has been pinned. file desc=%d, pageNum:%d, pin count=%d",
+          file_desc_, frame->page_num(), frame->pin_count());
+    }
+  }
+  LOG_INFO("all pages have been checked of file desc %d", file_desc_);
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::flush_page(Frame &frame)
+{
+  std::scoped_lock lock_guard(lock_);
+  return flush_page_internal(frame);
+}
+
+RC DiskBufferPool::clean_page(PageNum page_num)
+{
+  std::unique_lock<common::Mutex> lock_guard(lock_, std::try_to_lock);
+  if (!lock_guard.owns_lock()) {
+    return RC::LOCKED_CONCURRENCY_CONFLICT;
+  }
+
+  if (file_desc_ < 0) {
+    return RC::SUCCESS;
+  }
+
+  Frame *frame = frame_manager_.get(file_desc_, page_num, false /*touch*/);
+  if (frame == nullptr) {
+    return RC::SUCCESS;
+  }
+
+  RC rc = RC::SUCCESS;
+  if (frame->dirty()) {
+    // 加读锁保证写到磁盘上的是一个完整的页面，正在被修改的页面留给下一轮处理
+    if (frame->try_read_latch()) {
+      rc = flush_page_internal(*frame);
+      frame->read_unlatch();
+    } else {
+      rc = RC::LOCKED_CONCURRENCY_CONFLICT;
+    }
+  }
+  frame->unpin();
+  return rc;
+}
+
+RC DiskBufferPool::flush_page_internal(Frame &frame)
+{
+  // The better way is use mmap the block into memory,
+  // so it is easier to flush data to file.
+
+  Page &page = frame.page();
+  if (compressed_file_ != nullptr) {
+    RC rc = compressed_file_->write_pages({&page}, false /*sync*/);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to flush compressed page %s:%d. rc=%s", file_name_.c_str(), page.page_num, strrc(rc));
+      return rc;
+    }
+    frame.clear_dirty();
+    return RC::SUCCESS;
+  }
+
+  int64_t offset = ((int64_t)page.page_num) * sizeof(Page);
+  IoRequest request = IoRequest::write(file_desc_, &page, sizeof(Page), offset);
+  if (IoBackend::instance().submit(&request, 1) != RC::SUCCESS) {
+    LOG_ERROR("Failed to flush page %lld of %d due to %s.", offset, file_desc_, strerror(request.error));
+    return RC::IOERR_WRITE;
+  }
+  frame.clear_dirty();
+  LOG_DEBUG("Flush block. file desc=%d, pageNum=%d, pin count=%d", file_desc_, page.page_num, frame.pin_count());
+
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::write_dirty_frames(std::vector<Frame *> &frames)
+{
+  if (frames.empty()) {
+    return RC::SUCCESS;
+  }
+
+  if (compressed_file_ != nullptr) {
+    // 压缩之后页面的位置由 CompressedPageFile 分配，它自己合并连续的写请求
+    std::vector<const Page *> pages;
+    pages.reserve(frames.size());
+    for (Frame *frame : frames) {
+      pages.push_back(&frame->page());
+    }
+    RC rc = compressed_file_->write_pages(pages, true /*sync*/);
+    if (rc == RC::SUCCESS) {
+      for (Frame *frame : frames) {
+        frame->clear_dirty();
+      }
+    }
+    return rc;
+  }
+
+  std::sort(frames.begin(), frames.end(), [](const Frame *left, const Frame *right) {
+    return left->page_num() < right->page_num();
+  });
+
+  // 页面号连续的页面在文件中也是连续的，合并成一个请求。iovec 数组不能再扩容，请求中保存的是它的地址
+  std::vector<struct iovec> iovecs;
+  std::vector<IoRequest>    requests;
+  std::vector<size_t>       request_starts;  ///< 每个请求的第一个页面在 frames 中的位置
+  iovecs.reserve(frames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    const size_t count = iovecs.size() - (request_starts.empty() ? 0 : request_starts.back());
+    if (i == 0 || frames[i]->page_num() != frames[i - 1]->page_num() + 1 || count >= static_cast<size_t>(MAX_WRITE_BATCH_PAGES)) {
+      request_starts.push_back(i);
+    }
+    iovecs.push_back({&frames[i]->page(), sizeof(Page)});
+  }
+  for (size_t r = 0; r < request_starts.size(); r++) {
+    const size_t start = request_starts[r];
+    const size_t end   = r + 1 < request_starts.size() ? request_starts[r + 1] : frames.size();
+    const int64_t offset = ((int64_t)frames[start]->page_num()) * sizeof(Page);
+    requests.push_back(IoRequest::writev(file_desc_, &iovecs[start], static_cast<int>(end - start), offset));
+  }
+
+  RC rc = IoBackend::instance().submit(requests);
+  for (size_t r = 0; r < request_starts.size(); r++) {
+    if (requests[r].error != 0) {
+      LOG_ERROR("Failed to write pages of %s, start page=%d, error=%s",
+                file_name_.c_str(), frames[request_starts[r]]->page_num(), strerror(requests[r].error));
+      continue;
+    }
+    const size_t end = r + 1 < request_starts.size() ? request_starts[r + 1] : frames.size();
+    for (size_t i = request_starts[r]; i < end; i++) {
+      frames[i]->clear_dirty();
+    }
+  }
+
+  RC sync_rc = IoBackend::instance().sync(file_desc_);
+  LOG_DEBUG("write dirty pages done. file=%s, page num=%zu, request num=%zu",
+            file_name_.c_str(), frames.size(), requests.size());
+  return OB_SUCC(rc) ? sync_rc : rc;
+}
+
+RC DiskBufferPool::flush_all_pages()
+{
+  // find_list 会 pin 住所有页帧，刷完之后要 unpin，否则这些页帧再也不能被淘汰
+  std::list<Frame *> used = frame_manager_.find_list(file_desc_);
+
+  std::vector<Frame *> dirty_frames;
+  for (Frame *frame : used) {
+    if (frame->dirty()) {
+      dirty_frames.push_back(frame);
+    }
+  }
+
+  // 所有脏页一次提交给IO后端
+  RC rc = RC::SUCCESS;
+  {
+    std::scoped_lock lock_guard(lock_);
+    rc = write_dirty_frames(dirty_frames);
+  }
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to flush all pages. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+  }
+
+  for (Frame *frame : used) {
+    frame->unpin();
+  }
+  return rc;
+}
+
+RC DiskBufferPool::recover_page(PageNum page_num)
+{
+  std::scoped_lock lock_guard(lock_);
+
+  // 回放日志时，页面可能在文件中还不存在，需要先把文件扩展到这个页面
+  RC rc = RC::SUCCESS;
+  while (file_header_->page_count <= page_num) {
+    const PageNum next_page = file_header_->page_count;
+    const int group = group_of(next_page);
+    if (next_page != BP_HEADER_PAGE && group_start(group) == next_page) {
+      rc = create_group(group);
+      if (rc != RC::SUCCESS) {
+        LOG_WARN("failed to create allocation group while recovering page. group=%d, rc=%s", group, strrc(rc));
+        return rc;
+      }
+    } else {
+      file_header_->page_count = std::min(page_num + 1, group_start(group + 1));
+      hdr_frame_->mark_dirty();
+      update_free_group(group);
+    }
+  }
+
+  Frame *group_frame = nullptr;
+  common::Bitmap bitmap;
+  rc = fetch_group(group_of(page_num), group_frame, bitmap);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  const bool allocated = bitmap.get_bit(page_num - group_start(group_of(page_num)));
+  group_frame->unpin();
+  if (!allocated) {
+    rc = set_page_allocated(page_num, true);
+  }
+  return rc;
+}
+
+PageNum DiskBufferPool::next_allocated_page(PageNum page_num)
+{
+  std::scoped_lock lock_guard(lock_);
+  return next_allocated_page_internal(page_num);
 }
 
-RC DiskBufferPool::purge_frame(PageNum page_num, Frame *buf)
+PageNum DiskBufferPool::next_allocated_page_internal(PageNum page_num)
 {
-  if (buf->pin_count() != 1) {
-    LOG_INFO("Begin to free page %d of %d(file id), but it's pin count > 1:%d.",
-        buf->page_num(), buf->file_desc(), buf->pin_count());
-    return RC::LOCKED_UNLOCK;
-  }
+  const int group_num = static_cast<int>(group_allocated_pages_.size());
+  for (int group = group_of(page_num); group < group_num; group++) {
+    const PageNum start = group_start(group);
 
-  if (buf->dirty()) {
-    RC rc = flush_page_internal(*buf);
+    Frame *group_frame = nullptr;
+    common::Bitmap bitmap;
+    RC rc = fetch_group(group, group_frame, bitmap);
     if (rc != RC::SUCCESS) {
-      LOG_WARN("Failed to flush page %d of %d(file desc) during purge page.", buf->page_num(), buf->file_desc());
-      return rc;
+      LOG_WARN("failed to fetch allocation group. file=%s, group=%d, rc=%s", file_name_.c_str(), group, strrc(rc));
+      return BP_INVALID_PAGE_NUM;
     }
-  }
 
-  LOG_DEBUG("Successfully purge frame =%p, page %d of %d(file desc)", buf, buf->page_num(), buf->file_desc());
-  frame_manager_.free(file_desc_, page_num, buf);
-  return RC::SUCCESS;
+    // 每个组的第一个页面是元数据，不返回给使用者
+    const int index = bitmap.next_setted_bit(std::max(page_num - start, 1));
+    group_frame->unpin();
+    if (index >= 0) {
+      return start + index;
+    }
+  }
+  return BP_INVALID_PAGE_NUM;
 }
 
-RC DiskBufferPool::purge_page(PageNum page_num)
+RC DiskBufferPool::copy_group_bitmap(int group, std::vector<char> &bitmap, int &page_num_in_group)
 {
   std::scoped_lock lock_guard(lock_);
-  Frame *used_frame = frame_manager_.get(file_desc_, page_num);
-  if (used_frame != nullptr) {
-    return purge_frame(page_num, used_frame);
+
+  page_num_in_group = 0;
+  bitmap.clear();
+  if (group >= static_cast<int>(group_allocated_pages_.size())) {
+    return RC::SUCCESS;
+  }
+
+  Frame         *group_frame = nullptr;
+  common::Bitmap group_bitmap;
+  RC rc = fetch_group(group, group_frame, group_bitmap);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to fetch allocation group. file=%s, group=%d, rc=%s", file_name_.c_str(), group, strrc(rc));
+    return rc;
   }
 
+  const PageNum start = group_start(group);
+  const char   *data  = (group == 0) ? file_header_->bitmap : ((BPGroupHeader *)group_frame->data())->bitmap;
+  page_num_in_group   = std::min(file_header_->page_count, group_start(group + 1)) - start;
+  bitmap.assign(data, data + (page_num_in_group + 7) / 8);
+  group_frame->unpin();
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::purge_all_pages()
+int DiskBufferPool::group_of(PageNum page_num)
 {
-  std::list<Frame *> used = frame_manager_.find_list(file_desc_);
-
-  std::scoped_lock lock_guard(lock_);
-  for (std::list<Frame *>::iterator it = used.begin(); it != used.end(); ++it) {
-    Frame *frame = *it;
+  if (page_num < BPFileHeader::GROUP_PAGE_NUM) {
+    return 0;
+  }
+  return (page_num - BPFileHeader::GROUP_PAGE_NUM) / BPGroupHeader::GROUP_PAGE_NUM + 1;
+}
 
-    purge_frame(frame->page_num(), frame);
+PageNum DiskBufferPool::group_start(int group)
+{
+  if (group == 0) {
+    return 0;
   }
-  return RC::SUCCESS;
+  const int64_t start = BPFileHeader::GROUP_PAGE_NUM + static_cast<int64_t>(group - 1) * BPGroupHeader::GROUP_PAGE_NUM;
+  return static_cast<PageNum>(std::min<int64_t>(start, std::numeric_limits<PageNum>::max()));
 }
 
-RC DiskBufferPool::check_all_pages_unpinned()
+RC DiskBufferPool::fetch_group(int group, Frame *&frame, common::Bitmap &bitmap)
 {
-  std::list<Frame *> frames = frame_manager_.find_list(file_desc_);
+  const PageNum start = group_start(group);
+  const int page_num_in_group = std::min(file_header_->page_count, group_start(group + 1)) - start;
+  if (group == 0) {
+    frame = hdr_frame_;
+    frame->pin();
+    bitmap.init(file_header_->bitmap, page_num_in_group);
+    return RC::SUCCESS;
+  }
 
-  std::scoped_lock lock_guard(lock_);
-  for (Frame *frame : frames) {
+  RC rc = get_this_page(start, &frame);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to fetch the first page of allocation group. file=%s, group=%d, rc=%s",
+             file_name_.c_str(), group, strrc(rc));
+    return rc;
+  }
+
+  BPGroupHeader *group_header = (BPGroupHeader *)frame->data();
+  if (group_header->group != group) {
+    LOG_ERROR("invalid allocation group page. file=%s, group=%d, group in page=%d",
+              file_name_.c_str(), group, group_header->group);
     frame->unpin();
-    if (frame->page_num() == BP_HEADER_PAGE && frame->pin_count() > 1) {
-      LOG_WARN("This page has been pinned. file desc=%d, pageNum:%d, pin count=%d",
-          file_desc_, frame->page_num(), frame->pin_count());
-    } else if (frame->page_num() != BP_HEADER_PAGE && frame->pin_count() > 0) {
-      LOG_WARN("This page has been pinned. file desc=%d, pageNum:%d, pin count=%d",
-          file_desc_, frame->page_num(), frame->pin_count());
-    }
+    frame = nullptr;
+    return RC::BUFFERPOOL_INVALID_PAGE_NUM;
   }
-  LOG_INFO("all pages have been checked of file desc %d", file_desc_);
+  bitmap.init(group_header->bitmap, page_num_in_group);
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::flush_page(Frame &frame)
-{
-  std::scoped_lock lock_guard(lock_);
-  return flush_page_internal(frame);
-}
-
-RC DiskBufferPool::flush_page_internal(Frame &frame)
+RC DiskBufferPool::create_group(int group)
 {
-  // The better way is use mmap the block into memory,
-  // so it is easier to flush data to file.
+  const PageNum page_num = group_start(group);
+  ASSERT(page_num == file_header_->page_count && group == static_cast<int>(group_allocated_pages_.size()),
+         "allocation group should be created at the end of file. group=%d, page num=%d, page count=%d",
+         group, page_num, file_header_->page_count);
 
-  Page &page = frame.page();
-  int64_t offset = ((int64_t)page.page_num) * sizeof(Page);
-  if (lseek(file_desc_, offset, SEEK_SET) == offset - 1) {
-    LOG_ERROR("Failed to flush page %lld of %d due to failed to seek %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_SEEK;
+  Frame *frame = nullptr;
+  RC rc = allocate_frame(page_num, &frame);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to allocate frame for allocation group. file=%s, group=%d, rc=%s",
+             file_name_.c_str(), group, strrc(rc));
+    return rc;
   }
 
-  if (writen(file_desc_, &page, sizeof(Page)) != 0) {
-    LOG_ERROR("Failed to flush page %lld of %d due to %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_WRITE;
+  frame->set_file_desc(file_desc_);
+  frame->access();
+  frame->clear_page();
+  frame->set_page_num(page_num);
+
+  BPGroupHeader *group_header = (BPGroupHeader *)frame->data();
+  group_header->group = group;
+  common::Bitmap bitmap(group_header->bitmap, BPGroupHeader::GROUP_PAGE_NUM);
+  bitmap.set_bit(0);
+
+  rc = flush_page_internal(*frame);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to write allocation group page. file=%s, group=%d, rc=%s", file_name_.c_str(), group, strrc(rc));
+    frame_manager_.free(file_desc_, page_num, frame);
+    return rc;
   }
-  frame.clear_dirty();
-  LOG_DEBUG("Flush block. file desc=%d, pageNum=%d, pin count=%d", file_desc_, page.page_num, frame.pin_count());
+  frame->unpin();
+
+  file_header_->page_count++;
+  file_header_->allocated_pages++;
+  hdr_frame_->mark_dirty();
+  group_allocated_pages_.push_back(1);
 
+  LOG_INFO("create allocation group. file=%s, group=%d, page num=%d", file_name_.c_str(), group, page_num);
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::flush_all_pages()
+RC DiskBufferPool::load_groups()
 {
-  std::list<Frame *> used = frame_manager_.find_list(file_desc_);
-  for (Frame *frame : used) {
-    RC rc = flush_page(*frame);
+  group_allocated_pages_.clear();
+  free_groups_.clear();
+
+  const int group_num = file_header_->page_count <= 0 ? 0 : group_of(file_header_->page_count - 1) + 1;
+  for (int group = 0; group < group_num; group++) {
+    Frame *group_frame = nullptr;
+    common::Bitmap bitmap;
+    RC rc = fetch_group(group, group_frame, bitmap);
     if (rc != RC::SUCCESS) {
-      LOG_WARN("failed to flush all pages");
       return rc;
     }
+
+    int32_t allocated = 0;
+    for (int index = bitmap.next_setted_bit(0); index >= 0; index = bitmap.next_setted_bit(index + 1)) {
+      allocated++;
+    }
+    group_frame->unpin();
+
+    group_allocated_pages_.push_back(allocated);
+    update_free_group(group);
   }
+
+  LOG_INFO("load allocation groups done. file=%s, group num=%d, free group num=%d",
+           file_name_.c_str(), group_num, static_cast<int>(free_groups_.size()));
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::recover_page(PageNum page_num)
+RC DiskBufferPool::set_page_allocated(PageNum page_num, bool allocated)
 {
-  int byte = 0, bit = 0;
-  byte = page_num / 8;
-  bit = page_num % 8;
+  const int group = group_of(page_num);
+  Frame *group_frame = nullptr;
+  common::Bitmap bitmap;
+  RC rc = fetch_group(group, group_frame, bitmap);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
 
-  std::scoped_lock lock_guard(lock_);
-  if (!(file_header_->bitmap[byte] & (1 << bit))) {
-    file_header_->bitmap[byte] |= (1 << bit);
-    file_header_->allocated_pages++;
-    file_header_->page_count++;
+  const int index = page_num - group_start(group);
+  if (bitmap.get_bit(index) != allocated) {
+    if (allocated) {
+      bitmap.set_bit(index);
+      group_allocated_pages_[group]++;
+      file_header_->allocated_pages++;
+    } else {
+      bitmap.clear_bit(index);
+      group_allocated_pages_[group]--;
+      file_header_->allocated_pages--;
+    }
+    group_frame->mark_dirty();
     hdr_frame_->mark_dirty();
   }
+  group_frame->unpin();
+
+  update_free_group(group);
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer)
+void DiskBufferPool::update_free_group(int group)
+{
+  const int page_num_in_group = std::min(file_header_->page_count, group_start(group + 1)) - group_start(group);
+  if (group_allocated_pages_[group] < page_num_in_group) {
+    free_groups_.insert(group);
+  } else {
+    free_groups_.erase(group);
+  }
+}
+
+RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer, bool *created /* = nullptr */)
 {
   auto purger = [this](Frame *frame) {
     if (!frame->dirty()) {
@@ -562,14 +1518,41 @@ RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer)
     return rc;
   };
 
+  // 超过配额时先淘汰自己的页面，自己的页面都在使用中时暂时超出配额
+  const int quota = frame_quota_.load();
+  if (quota > 0) {
+    const int over_num = frame_manager_.file_frame_num(file_desc_) - quota + 1;
+    if (over_num > 0) {
+      std::function<RC(Frame *)> file_purger = purger;
+      (void)frame_manager_.purge_file_frames(file_desc_, over_num, &file_purger);
+    }
+  }
+
+  PageCleaner &page_cleaner = bp_manager_.page_cleaner();
   while (true) {
-    Frame *frame = frame_manager_.alloc(file_desc_, page_num);
+    Frame *frame = nullptr;
+    if (created != nullptr) {
+      frame = frame_manager_.get_or_alloc(file_desc_, page_num, *created);
+    } else {
+      frame = frame_manager_.alloc(file_desc_, page_num);
+    }
     if (frame != nullptr) {
+      // 页面可能正在被其它线程(比如预读)加载，要等加载完成才能覆盖页面的内容
+      if (created == nullptr && !frame->wait_loaded()) {
+        frame->unpin();
+        continue;
+      }
+      page_cleaner.notify();
       *buffer = frame;
       return RC::SUCCESS;
     }
 
     LOG_TRACE("frames are all allocated, so we should purge some frames to get one free frame");
+    // 后台清理线程跟不上时，先尝试淘汰一个干净的页面，实在没有才在前台刷脏页
+    page_cleaner.notify();
+    if (frame_manager_.purge_clean_frames(1/*count*/) > 0) {
+      continue;
+    }
     (void)frame_manager_.purge_frames(1/*count*/, purger);
   }
   return RC::BUFFERPOOL_NOBUF;
@@ -577,11 +1560,22 @@ RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer)
 
 RC DiskBufferPool::check_page_num(PageNum page_num)
 {
-  if (page_num >= file_header_->page_count) {
+  if (page_num < 0 || page_num >= file_header_->page_count) {
     LOG_ERROR("Invalid pageNum:%d, file's name:%s", page_num, file_name_.c_str());
     return RC::BUFFERPOOL_INVALID_PAGE_NUM;
   }
-  if ((file_header_->bitmap[page_num / 8] & (1 << (page_num % 8))) == 0) {
+
+  const int group = group_of(page_num);
+  Frame *group_frame = nullptr;
+  common::Bitmap bitmap;
+  RC rc = fetch_group(group, group_frame, bitmap);
+  if (rc != RC::SUCCESS) {
+    return rc;
+  }
+
+  const bool allocated = bitmap.get_bit(page_num - group_start(group));
+  group_frame->unpin();
+  if (!allocated) {
     LOG_ERROR("Invalid pageNum:%d, file's name:%s", page_num, file_name_.c_str());
     return RC::BUFFERPOOL_INVALID_PAGE_NUM;
   }
@@ -590,19 +1584,23 @@ RC DiskBufferPool::check_page_num(PageNum page_num)
 
 RC DiskBufferPool::load_page(PageNum page_num, Frame *frame)
 {
-  int64_t offset = ((int64_t)page_num) * BP_PAGE_SIZE;
-  if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to load page %s:%d, due to failed to lseek:%s.", file_name_.c_str(), page_num, strerror(errno));
-
-    return RC::IOERR_SEEK;
+  if (compressed_file_ != nullptr) {
+    RC rc = compressed_file_->read_page(page_num, frame->page());
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to load compressed page %s:%d. rc=%s", file_name_.c_str(), page_num, strrc(rc));
+    }
+    return rc;
   }
 
-  Page &page = frame->page();
-  int ret = readn(file_desc_, &page, BP_PAGE_SIZE);
-  if (ret != 0) {
-    LOG_ERROR("Failed to load page %s, file_desc:%d, page num:%d, due to failed to read data:%s, ret=%d, page count=%d",
-              file_name_.c_str(), file_desc_, page_num, strerror(errno), ret, file_header_->allocated_pages);
-    return RC::IOERR_READ;
+  // 多个线程可能同时加载同一个文件的不同页面，所以不能使用 lseek + read
+  int64_t offset = ((int64_t)page_num) * BP_PAGE_SIZE;
+  IoRequest request = IoRequest::read(file_desc_, &frame->page(), BP_PAGE_SIZE, offset);
+  RC rc = IoBackend::instance().submit(&request, 1);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to load page %s, file_desc:%d, page num:%d, due to failed to read data:%s, error=%d",
+              file_name_.c_str(), file_desc_, page_num, request.error > 0 ? strerror(request.error) : "eof",
+              request.error);
+    return rc;
   }
   return RC::SUCCESS;
 }
@@ -612,19 +1610,58 @@ int DiskBufferPool::file_desc() const
   return file_desc_;
 }
 ////////////////////////////////////////////////////////////////////////////////
-BufferPoolManager::BufferPoolManager(int memory_size /* = 0 */)
+BufferPoolManager::BufferPoolManager(int64_t memory_size /* = 0 */)
+    : BufferPoolManager(BufferPoolParam{memory_size})
+{}
+
+BufferPoolManager::BufferPoolManager(const BufferPoolParam &param)
 {
+  int64_t memory_size = param.memory_size;
   if (memory_size <= 0) {
-    memory_size = MEM_POOL_ITEM_NUM * DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
+    memory_size = static_cast<int64_t>(MEM_POOL_ITEM_NUM) * DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
+  }
+  const int pool_num = std::max(pool_num_of(memory_size), 1);
+  FrameAllocator::HugePage huge_page = FrameAllocator::HugePage::NONE;
+  if (!FrameAllocator::huge_page_from_name(param.huge_page.c_str(), huge_page)) {
+    LOG_WARN("invalid huge page mode %s, use none", param.huge_page.c_str());
+  }
+  RC rc = frame_manager_.init(pool_num, param.shard_num, param.replacer.c_str(), huge_page);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("failed to init frame manager. replacer=%s, rc=%s", param.replacer.c_str(), strrc(rc));
+  }
+  direct_io_ = param.direct_io;
+  dump_file_ = param.dump_file;
+  cleaner_low_percent_  = param.cleaner_low_watermark;
+  cleaner_high_percent_ = param.cleaner_high_watermark;
+  LOG_INFO("buffer pool manager init with memory size %lld, page num: %d, pool num: %d, replacer: %s, direct io: %d",
+           (long long)memory_size, pool_num * DEFAULT_ITEM_NUM_PER_POOL, pool_num, param.replacer.c_str(), direct_io_);
+
+  if (cleaner_low_percent_ > 0) {
+    int low_watermark = 0;
+    int high_watermark = 0;
+    cleaner_watermarks(static_cast<int>(frame_manager_.total_frame_num()), low_watermark, high_watermark);
+    rc = page_cleaner_.start(low_watermark, high_watermark, param.cleaner_interval_ms);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to start page cleaner. rc=%s", strrc(rc));
+    }
+  }
+
+  if (param.read_ahead_pages > 0) {
+    read_ahead_pages_ = param.read_ahead_pages;
+    rc = read_ahead_worker_.start();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to start read ahead worker. rc=%s", strrc(rc));
+    }
   }
-  const int pool_num = std::max(memory_size / BP_PAGE_SIZE / DEFAULT_ITEM_NUM_PER_POOL, 1);
-  frame_manager_.init(pool_num);
-  LOG_INFO("buffer pool manager init with memory size %d, page num: %d, pool num: %d",
-           memory_size, pool_num * DEFAULT_ITEM_NUM_PER_POOL, pool_num);
 }
 
 BufferPoolManager::~BufferPoolManager()
 {
+  load_stopped_ = true;
+  wait_load_done();
+  page_cleaner_.stop();
+  read_ahead_worker_.stop();
+
   std::unordered_map<std::string, DiskBufferPool *> tmp_bps;
   tmp_bps.swap(buffer_pools_);
 
@@ -633,8 +1670,13 @@ BufferPoolManager::~BufferPoolManager()
   }
 }
 
-RC BufferPoolManager::create_file(const char *file_name)
+RC BufferPoolManager::create_file(const char *file_name, const char *codec /* = nullptr */)
 {
+  if (PageCodec::enabled(codec) && PageCodec::create(codec) == nullptr) {
+    LOG_WARN("invalid page codec. file=%s, codec=%s", file_name, codec);
+    return RC::INVALID_ARGUMENT;
+  }
+
   int fd = open(file_name, O_RDWR | O_CREAT | O_EXCL, S_IREAD | S_IWRITE);
   if (fd < 0) {
     LOG_ERROR("Failed to create %s, due to %s.", file_name, strerror(errno));
@@ -643,15 +1685,6 @@ RC BufferPoolManager::create_file(const char *file_name)
 
   close(fd);
 
-  /**
-   * Here don't care about the failure
-   */
-  fd = open(file_name, O_RDWR);
-  if (fd < 0) {
-    LOG_ERROR("Failed to open for readwrite %s, due to %s.", file_name, strerror(errno));
-    return RC::IOERR_ACCESS;
-  }
-
   Page page;
   memset(&page, 0, BP_PAGE_SIZE);
 
@@ -661,6 +1694,26 @@ RC BufferPoolManager::create_file(const char *file_name)
 
   char *bitmap = file_header->bitmap;
   bitmap[0] |= 0x01;
+
+  if (PageCodec::enabled(codec)) {
+    RC rc = CompressedPageFile::create(file_name, codec, page);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to create compressed file %s. codec=%s, rc=%s", file_name, codec, strrc(rc));
+      return rc;
+    }
+    LOG_INFO("Successfully create %s. codec=%s", file_name, codec);
+    return RC::SUCCESS;
+  }
+
+  /**
+   * Here don't care about the failure
+   */
+  fd = open(file_name, O_RDWR);
+  if (fd < 0) {
+    LOG_ERROR("Failed to open for readwrite %s, due to %s.", file_name, strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+
   if (lseek(fd, 0, SEEK_SET) == -1) {
     LOG_ERROR("Failed to seek file %s to position 0, due to %s .", file_name, strerror(errno));
     close(fd);
@@ -682,6 +1735,8 @@ RC BufferPoolManager::remove_file(const char *file_name)
 {
   RC rc = RC::SUCCESS;
   ::remove(file_name);
+  // 压缩的文件还有一个映射文件，普通文件没有
+  ::remove(CompressedPageFile::map_file_name(file_name).c_str());
   return rc;
 }
 
@@ -703,6 +1758,11 @@ RC BufferPoolManager::open_file(const char *_file_name, DiskBufferPool *&_bp)
     return rc;
   }
 
+  auto quota_iter = file_quotas_.find(file_name);
+  if (quota_iter != file_quotas_.end()) {
+    bp->set_frame_quota(quota_iter->second);
+  }
+
   buffer_pools_.insert(std::pair<std::string, DiskBufferPool *>(file_name, bp));
   fd_buffer_pools_.insert(std::pair<int, DiskBufferPool *>(bp->file_desc(), bp));
   LOG_DEBUG("insert buffer pool into fd buffer pools. fd=%d, bp=%p, lbt=%s", bp->file_desc(), bp, lbt());
@@ -744,6 +1804,248 @@ RC BufferPoolManager::close_file(const char *_file_name)
   return RC::SUCCESS;
 }
 
+RC BufferPoolManager::dump_pages(const char *dump_file /* = nullptr */)
+{
+  if (dump_file == nullptr) {
+    dump_file = dump_file_.c_str();
+  }
+  if (dump_file[0] == '\0') {
+    return RC::INVALID_ARGUMENT;
+  }
+
+  std::vector<FrameId> frame_ids;
+  frame_manager_.find_hot_frames(frame_ids);
+
+  // 文件名只记录一次，每个页面只记录文件的编号和页面号
+  std::vector<std::string> file_names;
+  std::vector<std::pair<int, PageNum>> pages;
+  {
+    std::scoped_lock lock_guard(lock_);
+    std::unordered_map<int, int> file_indexes;
+    for (const FrameId &frame_id : frame_ids) {
+      auto iter = fd_buffer_pools_.find(frame_id.file_desc());
+      if (iter == fd_buffer_pools_.end()) {
+        continue;
+      }
+      auto index_iter = file_indexes.find(frame_id.file_desc());
+      if (index_iter == file_indexes.end()) {
+        // 文件名一行一个，可以包含空格，但是不能包含换行
+        const std::string &file_name = iter->second->filename();
+        if (file_name.find('\n') != std::string::npos) {
+          continue;
+        }
+        index_iter = file_indexes.emplace(frame_id.file_desc(), static_cast<int>(file_names.size())).first;
+        file_names.push_back(file_name);
+      }
+      pages.emplace_back(index_iter->second, frame_id.page_num());
+    }
+  }
+
+  // 先写到临时文件再改名，中途失败也不会破坏之前的记录
+  const std::string tmp_file = std::string(dump_file) + ".tmp";
+  std::ofstream ofs(tmp_file, std::ios::out | std::ios::trunc);
+  if (!ofs) {
+    LOG_WARN("failed to open buffer pool dump file %s. error=%s", tmp_file.c_str(), strerror(errno));
+    return RC::IOERR_OPEN;
+  }
+  ofs << "files " << file_names.size() << "\n";
+  for (const std::string &file_name : file_names) {
+    ofs << file_name << "\n";
+  }
+  ofs << "pages " << pages.size() << "\n";
+  for (const auto &page : pages) {
+    ofs << page.first << " " << page.second << "\n";
+  }
+  ofs.close();
+  if (!ofs || ::rename(tmp_file.c_str(), dump_file) != 0) {
+    LOG_WARN("failed to write buffer pool dump file %s. error=%s", dump_file, strerror(errno));
+    ::remove(tmp_file.c_str());
+    return RC::IOERR_WRITE;
+  }
+
+  LOG_INFO("dump buffer pool pages to %s. file num=%d, page num=%d",
+           dump_file, static_cast<int>(file_names.size()), static_cast<int>(pages.size()));
+  return RC::SUCCESS;
+}
+
+RC BufferPoolManager::load_pages(const char *dump_file /* = nullptr */)
+{
+  if (dump_file == nullptr) {
+    dump_file = dump_file_.c_str();
+  }
+  if (dump_file[0] == '\0') {
+    return RC::INVALID_ARGUMENT;
+  }
+
+  std::ifstream ifs(dump_file);
+  if (!ifs) {
+    LOG_INFO("no buffer pool dump file %s, skip loading", dump_file);
+    return RC::FILE_NOT_EXIST;
+  }
+
+  std::string tag;
+  int file_num = 0;
+  int page_num = 0;
+  std::vector<std::string> file_names;
+  std::vector<std::pair<std::string, PageNum>> pages;
+  if (!(ifs >> tag >> file_num) || tag != "files" || file_num < 0) {
+    LOG_WARN("invalid buffer pool dump file %s", dump_file);
+    return RC::INVALID_ARGUMENT;
+  }
+  // 文件名一行一个，可能包含空格，按行读取
+  ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  file_names.resize(file_num);
+  for (std::string &file_name : file_names) {
+    if (!std::getline(ifs, file_name) || file_name.empty()) {
+      LOG_WARN("invalid buffer pool dump file %s", dump_file);
+      return RC::INVALID_ARGUMENT;
+    }
+  }
+  if (!(ifs >> tag >> page_num) || tag != "pages" || page_num < 0) {
+    LOG_WARN("invalid buffer pool dump file %s", dump_file);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  // 只加载页帧能放得下的部分，记录中越靠前的页面越热
+  const int max_page_num = static_cast<int>(frame_manager_.total_frame_num());
+  int file_index = 0;
+  PageNum page = BP_INVALID_PAGE_NUM;
+  for (int i = 0; i < page_num && static_cast<int>(pages.size()) < max_page_num; i++) {
+    if (!(ifs >> file_index >> page) || file_index < 0 || file_index >= file_num) {
+      LOG_WARN("invalid buffer pool dump file %s. line=%d", dump_file, i);
+      break;
+    }
+    pages.emplace_back(file_names[file_index], page);
+  }
+  LOG_INFO("load buffer pool pages from %s. page num=%d", dump_file, static_cast<int>(pages.size()));
+
+  wait_load_done();
+  load_stopped_ = false;
+#ifdef CONCURRENCY
+  load_thread_ = std::thread(&BufferPoolManager::load_pages_internal, this, std::move(pages));
+#else
+  // 没有开启并发模式时，各种锁都是空操作，不能在后台线程中加载
+  load_pages_internal(std::move(pages));
+#endif
+  return RC::SUCCESS;
+}
+
+void BufferPoolManager::load_pages_internal(std::vector<std::pair<std::string, PageNum>> pages)
+{
+  // 每次取一段最热的页面，按照文件和页面号排序之后分批读取，让磁盘上的访问尽量连续
+  const size_t chunk_size = ReadAheadWorker::MAX_BATCH_PAGES * 8;
+
+  int loaded_num = 0;
+  std::vector<PageNum> batch;
+  for (size_t start = 0; start < pages.size() && !load_stopped_; start += chunk_size) {
+    const size_t end = std::min(start + chunk_size, pages.size());
+    std::sort(pages.begin() + start, pages.begin() + end);
+
+    for (size_t i = start; i < end && !load_stopped_;) {
+      if (frame_manager_.free_frame_num() <= 0) {
+        LOG_INFO("no free frames, stop loading buffer pool pages. loaded num=%d", loaded_num);
+        return;
+      }
+
+      const std::string &file_name = pages[i].first;
+      batch.clear();
+      while (i < end && pages[i].first == file_name && static_cast<int>(batch.size()) < ReadAheadWorker::MAX_BATCH_PAGES) {
+        batch.push_back(pages[i].second);
+        i++;
+      }
+
+      // 加着锁读取，这期间文件不会被关闭
+      std::scoped_lock lock_guard(lock_);
+      auto iter = buffer_pools_.find(file_name);
+      if (iter == buffer_pools_.end()) {
+        continue;
+      }
+      RC rc = iter->second->prefetch_pages(batch);
+      if (OB_FAIL(rc)) {
+        LOG_TRACE("failed to load some buffer pool pages. file=%s, rc=%s", file_name.c_str(), strrc(rc));
+      }
+      loaded_num += static_cast<int>(batch.size());
+    }
+  }
+  LOG_INFO("load buffer pool pages done. page num=%d", loaded_num);
+}
+
+void BufferPoolManager::wait_load_done()
+{
+  if (load_thread_.joinable()) {
+    load_thread_.join();
+  }
+}
+
+void BufferPoolManager::cleaner_watermarks(int frame_num, int &low_watermark, int &high_watermark) const
+{
+  low_watermark  = std::max(frame_num * cleaner_low_percent_ / 100, 1);
+  high_watermark = std::max(frame_num * cleaner_high_percent_ / 100, low_watermark);
+}
+
+int BufferPoolManager::pool_num_of(int64_t memory_size)
+{
+  // 页帧个数用 int 表示，超过的部分忽略
+  const int64_t pool_num = memory_size / BP_PAGE_SIZE / DEFAULT_ITEM_NUM_PER_POOL;
+  return static_cast<int>(std::min<int64_t>(pool_num, std::numeric_limits<int>::max() / DEFAULT_ITEM_NUM_PER_POOL));
+}
+
+RC BufferPoolManager::resize(int64_t memory_size)
+{
+  const int pool_num = pool_num_of(memory_size);
+  if (pool_num <= 0) {
+    LOG_WARN("buffer pool memory size is too small. memory size=%lld, min=%d",
+             (long long)memory_size, DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  std::lock_guard<std::mutex> guard(resize_lock_);
+  const int old_frame_num = static_cast<int>(frame_manager_.total_frame_num());
+  const int frame_num     = pool_num * DEFAULT_ITEM_NUM_PER_POOL;
+  if (frame_num == old_frame_num) {
+    return RC::SUCCESS;
+  }
+
+  auto purger = [this](Frame *frame) { return frame->dirty() ? flush_page(*frame) : RC::SUCCESS; };
+  RC rc = frame_manager_.resize(frame_num, purger);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to resize buffer pool. frame num %d -> %d, rc=%s", old_frame_num, frame_num, strrc(rc));
+    return rc;
+  }
+
+  if (cleaner_low_percent_ > 0) {
+    int low_watermark = 0;
+    int high_watermark = 0;
+    cleaner_watermarks(frame_num, low_watermark, high_watermark);
+    page_cleaner_.set_watermarks(low_watermark, high_watermark);
+  }
+  LOG_INFO("resize buffer pool done. frame num %d -> %d, memory size=%lld",
+           old_frame_num, frame_num, (long long)memory_size);
+  return RC::SUCCESS;
+}
+
+RC BufferPoolManager::set_frame_quota(const char *file_name, int frame_num)
+{
+  if (frame_num < 0) {
+    LOG_WARN("invalid frame quota. file=%s, frame num=%d", file_name, frame_num);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  std::scoped_lock lock_guard(lock_);
+  if (frame_num == 0) {
+    file_quotas_.erase(file_name);
+  } else {
+    file_quotas_[file_name] = frame_num;
+  }
+
+  auto iter = buffer_pools_.find(file_name);
+  if (iter != buffer_pools_.end()) {
+    iter->second->set_frame_quota(frame_num);
+  }
+  LOG_INFO("set frame quota. file=%s, frame num=%d", file_name, frame_num);
+  return RC::SUCCESS;
+}
+
 RC BufferPoolManager::flush_page(Frame &frame)
 {
   int fd = frame.file_desc();
@@ -759,6 +2061,18 @@ RC BufferPoolManager::flush_page(Frame &frame)
   return bp->flush_page(frame);
 }
 
+RC BufferPoolManager::clean_page(const FrameId &frame_id)
+{
+  std::scoped_lock lock_guard(lock_);
+  auto iter = fd_buffer_pools_.find(frame_id.file_desc());
+  if (iter == fd_buffer_pools_.end()) {
+    return RC::SUCCESS;  // 文件已经关闭了
+  }
+
+  DiskBufferPool *bp = iter->second;
+  return bp->clean_page(frame_id.page_num());
+}
+
 static BufferPoolManager *default_bpm = nullptr;
 void BufferPoolManager::set_instance(BufferPoolManager *bpm)
 {
@@ -24,15 +24,25 @@ See the Mulan PSL v2 for more details. */
 #include <mutex>
 #include <unordered_map>
 #include <functional>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <set>
 
 #include "common/rc.h"
 #include "common/types.h"
 #include "common/lang/mutex.h"
 #include "common/mm/mem_pool.h"
-#include "common/lang/lru_cache.h"
 #include "common/lang/bitmap.h"
 #include "storage/buffer/page.h"
+#include "storage/buffer/compressed_page_file.h"
 #include "storage/buffer/frame.h"
+#include "storage/buffer/frame_allocator.h"
+#include "storage/buffer/frame_replacer.h"
+#include "storage/buffer/page_cleaner.h"
+#include "storage/buffer/read_ahead.h"
+#include "storage/common/io_backend.h"
 
 class BufferPoolManager;
 class DiskBufferPool;
@@ -45,30 +55,43 @@ class DiskBufferPool;
 #define BP_FILE_SUB_HDR_SIZE (sizeof(BPFileSubHeader))
 
 /**
- * @brief BufferPool的文件第一个页面，存放一些元数据信息，包括了后面每页的分配信息。
+ * @brief BufferPool的文件第一个页面，存放一些元数据信息，包括了页面的分配信息。
  * @ingroup BufferPool
- * @details
- * @code
- * TODO 1. 当前的做法，只能分配比较少的页面，你可以扩展一下，支持更多的页面或无限多的页面吗？
- *         可以参考Linux ext(n)和Windows NTFS等文件系统
- *      2. 当前使用bitmap存放页面分配情况，但是这种方法在页面非常多的时候，查找空闲页面的
- *         效率非常低，你有办法优化吗？
- * @endcode
+ * @details 文件中的页面按照顺序划分成多个分配组(allocation group)，每个组的第一个页面存放
+ * 这个组内页面的分配位图。第0组的第一个页面就是当前页面，所以这里的位图只管理第0组的页面，
+ * 其它组的第一个页面是 BPGroupHeader。
+ * 这样单个文件的页面个数不再受一个页面位图大小的限制，只有一个组时文件格式也与旧版本一致。
+ *
+ * 每个组已经分配了多少个页面、哪些组还有空闲页面，在打开文件时统计出来放在内存中，
+ * 分配页面时直接找到一个有空闲页面的组，只需要在这个组的位图中查找，不需要扫描所有页面。
  */
 struct BPFileHeader 
 {
-  int32_t page_count;       //! 当前文件一共有多少个页面
-  int32_t allocated_pages;  //! 已经分配了多少个页面
-  char bitmap[0];           //! 页面分配位图, 第0个页面(就是当前页面)，总是1
+  int32_t page_count;       //! 当前文件一共有多少个页面，包括各个组的第一个页面
+  int32_t allocated_pages;  //! 已经分配了多少个页面，包括各个组的第一个页面
+  char bitmap[0];           //! 第0组的页面分配位图, 第0个页面(就是当前页面)，总是1
 
   /**
-   * 能够分配的最大的页面个数，即bitmap的字节数 乘以8
+   * 第0组的页面个数，即bitmap的字节数 乘以8
    */
-  static const int MAX_PAGE_NUM = (BP_PAGE_DATA_SIZE - sizeof(page_count) - sizeof(allocated_pages)) * 8;
+  static constexpr int GROUP_PAGE_NUM = (BP_PAGE_DATA_SIZE - sizeof(page_count) - sizeof(allocated_pages)) * 8;
 
   std::string to_string() const;
 };
 
+/**
+ * @brief 分配组(第0组除外)的第一个页面，存放这个组内页面的分配位图
+ * @ingroup BufferPool
+ * @details 位图的第0位就是当前页面，总是1
+ */
+struct BPGroupHeader
+{
+  int32_t group;    //! 组的编号，用于校验
+  char bitmap[0];   //! 组内页面的分配位图
+
+  static constexpr int GROUP_PAGE_NUM = (BP_PAGE_DATA_SIZE - sizeof(group)) * 8;
+};
+
 /**
  * @brief 管理页面Frame
  * @ingroup BufferPool
@@ -76,13 +99,31 @@ struct BPFileHeader
  * 当内存中的页帧不够用时，需要从内存中淘汰一些页帧，以便为新的页帧腾出空间。
  * 这个管理器负责为所有的BufferPool提供页帧管理服务，也就是所有的BufferPool磁盘文件
  * 在访问时都使用这个管理器映射到内存。
+ *
+ * 所有页面的访问都要经过这里，如果只用一把锁保护整个页帧表，并发访问时这把锁就是最大的瓶颈。
+ * 所以这里将页帧表按照FrameId的哈希值拆分成多个分片(shard)，每个分片有自己的锁和置换策略，
+ * 访问不同分片上的页面不会互相阻塞。页帧由 FrameAllocator 统一分配，页面数据按页对齐，可以使用大页。
+ * 置换策略可以参考 FrameReplacer。
  */
 class BPFrameManager 
 {
+public:
+  static constexpr int DEFAULT_SHARD_NUM = 16;
+  static constexpr int MAX_RESIZE_PURGE_ROUNDS = 4;  ///< 缩小时最多尝试几轮淘汰停用的页帧
+
 public:
   BPFrameManager(const char *tag);
 
-  RC init(int pool_num);
+  /**
+   * @brief 初始化
+   * 
+   * @param pool_num  内存池的个数，每个内存池包含 DEFAULT_ITEM_NUM_PER_POOL 个页帧
+   * @param shard_num 页帧表拆分成多少个分片
+   * @param replacer  页面置换策略的名字，参考 FrameReplacer::create
+   * @param huge_page 页面数据是否使用大页，参考 FrameAllocator
+   */
+  RC init(int pool_num, int shard_num = DEFAULT_SHARD_NUM, const char *replacer = FrameReplacer::DEFAULT_NAME,
+          FrameAllocator::HugePage huge_page = FrameAllocator::HugePage::NONE);
   RC cleanup();
 
   /**
@@ -90,9 +131,10 @@ public:
    * 
    * @param file_desc 文件描述符，也可以当做buffer pool文件的标识
    * @param page_num  页面号
+   * @param touch     是否算作一次访问。后台刷脏页等内部操作不应该影响置换策略的顺序
    * @return Frame* 页帧指针
    */
-  Frame *get(int file_desc, PageNum page_num);
+  Frame *get(int file_desc, PageNum page_num, bool touch = true);
 
   /**
    * @brief 列出所有指定文件的页面
@@ -111,25 +153,96 @@ public:
    */
   Frame *alloc(int file_desc, PageNum page_num);
 
+  /**
+   * @brief 获取指定的页面，如果页面不在内存中就分配一个新的页帧并标记为正在加载
+   *
+   * @param created 返回true表示页帧是新分配的，调用者需要负责加载数据并调用 Frame::finish_loading
+   * @return Frame* 页帧指针，没有空闲页帧时返回nullptr
+   */
+  Frame *get_or_alloc(int file_desc, PageNum page_num, bool &created);
+
   /**
    * 尽管frame中已经包含了file_desc和page_num，但是依然要求
    * 传入，因为frame可能忘记初始化或者没有初始化
    */
   RC free(int file_desc, PageNum page_num, Frame *frame);
 
+  /**
+   * @brief 没有其它线程pin住页帧时释放它
+   * @details 调用者需要已经pin住这个页帧。pin只会在页帧表的锁内增加，所以检查和释放之间不会有新的使用者
+   * @return 其它线程还pin着页帧时返回 LOCKED_UNLOCK，调用者的pin不变
+   */
+  RC free_unpinned(int file_desc, PageNum page_num, Frame *frame);
+
+  /**
+   * @brief 释放一个加载失败的页帧
+   * @details 其它线程可能正在等待这个页帧加载完成，先把它从页帧表中删除，
+   * 等这些线程都放弃(unpin)之后再释放
+   */
+  RC free_failed(int file_desc, PageNum page_num, Frame *frame);
+
   /**
    * 如果不能从空闲链表中分配新的页面，就使用这个接口，
    * 尝试从pin count=0的页面中淘汰一些
+   * @details 每次从不同的分片开始查找，避免总是淘汰同一个分片上的页面
    * @param count 想要purge多少个页面
    * @param purger 需要在释放frame之前，对页面做些什么操作。当前是刷新脏数据到磁盘
    * @return 返回本次清理了多少个页面
    */
   int purge_frames(int count, std::function<RC(Frame *frame)> purger);
 
-  size_t frame_num() const
-  {
-    return frames_.count();
-  }
+  /**
+   * @brief 只淘汰干净的页面，不需要做任何IO
+   * @return 返回本次清理了多少个页面
+   */
+  int purge_clean_frames(int count);
+
+  /**
+   * @brief 只淘汰指定文件的页面，用来实现每个文件的页帧配额
+   * @param purger 为空时只淘汰干净的页面
+   * @return 返回本次清理了多少个页面
+   */
+  int purge_file_frames(int file_desc, int count, std::function<RC(Frame *frame)> *purger);
+
+  /**
+   * @brief 按照淘汰顺序查找即将被淘汰的脏页
+   * @details 每个分片最多查看 count/分片数 个可以淘汰的页面，记录其中的脏页。
+   * 不会pin住这些页面，调用者刷盘时需要重新获取。
+   * @param count     最多查看多少个可以淘汰的页面
+   * @param frame_ids 找到的脏页
+   */
+  void find_dirty_victims(int count, std::vector<FrameId> &frame_ids);
+
+  /**
+   * @brief 列出所有在内存中的页面，按照最近一次访问的时间从新到旧排列
+   */
+  void find_hot_frames(std::vector<FrameId> &frame_ids);
+
+  /**
+   * @brief 页面没有被使用、不是脏页、加载之后也没有被访问过(Frame::acc_time为0)时，把它淘汰掉
+   * @details 大表扫描使用页帧环时使用，参考 BufferRing
+   * @return 是否淘汰了这个页面
+   */
+  bool purge_untouched(int file_desc, PageNum page_num);
+
+  size_t frame_num() const;
+
+  /**
+   * @brief 还没有分配出去的页帧个数
+   */
+  int free_frame_num();
+
+  /**
+   * @brief 某个文件占用了多少个页帧
+   */
+  int file_frame_num(int file_desc);
+
+  /**
+   * @brief 在线调整页帧的个数
+   * @details 扩大时马上可以使用新的页帧。缩小时会淘汰停用的页帧，脏页使用 purger 刷盘，
+   * 正在使用的页帧会在以后被正常淘汰时释放。参考 FrameAllocator::resize
+   */
+  RC resize(int frame_num, std::function<RC(Frame *frame)> purger);
 
   /**
    * 测试使用。返回已经从内存申请的个数
@@ -139,9 +252,15 @@ public:
     return allocator_.get_size();
   }
 
-private:
-  Frame *get_internal(const FrameId &frame_id);
-  RC     free_internal(const FrameId &frame_id, Frame *frame);
+  size_t shard_num() const
+  {
+    return shards_.size();
+  }
+
+  const FrameAllocator &allocator() const
+  {
+    return allocator_;
+  }
 
 private:
   class BPFrameIdHasher {
@@ -152,17 +271,45 @@ private:
     }
   };
 
-  using FrameLruCache = common::LruCache<FrameId, Frame *, BPFrameIdHasher>;
-  using FrameAllocator = common::MemPoolSimple<Frame>;
+  using FrameMap = std::unordered_map<FrameId, Frame *, BPFrameIdHasher>;
+
+  /**
+   * @brief 页帧表的一个分片
+   * @details 分片内的页帧由分片自己的锁保护，淘汰页面时也只在分片内按照置换策略查找
+   */
+  struct FrameShard
+  {
+    std::mutex                     lock;
+    FrameMap                       frames;
+    std::unique_ptr<FrameReplacer> replacer;
+  };
+
+private:
+  FrameShard &shard_of(const FrameId &frame_id);
+
+  Frame *get_internal(FrameShard &shard, const FrameId &frame_id, bool touch = true);
+  Frame *alloc_internal(FrameShard &shard, const FrameId &frame_id, bool loading);
+  /// @param evicted 是否因为内存不够淘汰页帧，否则是显式释放(删除页面、关闭文件)
+  RC     free_internal(FrameShard &shard, const FrameId &frame_id, Frame *frame, bool evicted);
+  /**
+   * @param purger 为空时只淘汰干净的页面
+   * @param filter 不为空时只淘汰满足条件的页面
+   */
+  int    purge_shard_frames(FrameShard &shard, int count, std::function<RC(Frame *frame)> *purger,
+                            std::function<bool(Frame *frame)> *filter = nullptr);
 
-  std::mutex lock_;
-  FrameLruCache  frames_;
+private:
+  std::vector<std::unique_ptr<FrameShard>> shards_;
+  std::atomic<size_t> purge_cursor_{0};  ///< 下次淘汰页面时从哪个分片开始
   FrameAllocator allocator_;
 };
 
 /**
  * @brief 用于遍历BufferPool中的所有页面
  * @ingroup BufferPool
+ * @details 可以只遍历一个范围内的页面，并行扫描时每个工作线程用它遍历分到的一段页面。
+ * 迭代器缓存当前分配组的位图，组内查找下一个页面时不需要加锁，只有进入新的组时才会加锁复制位图。
+ * 所以遍历开始之后在当前组内新分配的页面可能遍历不到，文件末尾新扩展的页面还是能遍历到。
  */
 class BufferPoolIterator
 {
@@ -170,14 +317,29 @@ public:
   BufferPoolIterator();
   ~BufferPoolIterator();
 
-  RC init(DiskBufferPool &bp, PageNum start_page = 0);
+  /**
+   * @brief 遍历页面号大于 start_page 并且小于 end_page 的已分配页面
+   * @param end_page 为 BP_INVALID_PAGE_NUM 时遍历到文件末尾
+   */
+  RC init(DiskBufferPool &bp, PageNum start_page = 0, PageNum end_page = BP_INVALID_PAGE_NUM);
   bool has_next();
   PageNum next();
   RC reset();
 
 private:
-  common::Bitmap bitmap_;
+  PageNum find_next_page();
+  RC      load_group(int group);
+
+private:
+  DiskBufferPool *buffer_pool_ = nullptr;
   PageNum current_page_num_ = -1;
+  PageNum end_page_num_ = BP_INVALID_PAGE_NUM;   ///< 遍历到这个页面之前为止，BP_INVALID_PAGE_NUM 表示没有限制
+  PageNum next_page_num_ = BP_INVALID_PAGE_NUM;  ///< has_next 找到的下一个页面，避免重复查找
+  ReadAhead read_ahead_;                         ///< 顺序遍历时预读后面的页面
+
+  int               group_ = -1;           ///< 缓存的是哪个分配组的位图，-1表示没有缓存
+  int               group_page_num_ = 0;   ///< 缓存的位图有多少位，0表示文件中没有这个组
+  std::vector<char> group_bitmap_;         ///< 分配组位图的拷贝
 };
 
 /**
@@ -186,6 +348,9 @@ private:
  */
 class DiskBufferPool 
 {
+public:
+  static constexpr int MAX_WRITE_BATCH_PAGES = 64;  ///< 批量刷脏页时，一次 pwritev 最多写多少个连续的页面
+
 public:
   DiskBufferPool(BufferPoolManager &bp_manager, BPFrameManager &frame_manager);
   ~DiskBufferPool();
@@ -207,8 +372,11 @@ public:
 
   /**
    * 根据文件ID和页号获取指定页面到缓冲区，返回页面句柄指针。
+   * @details 不需要加文件锁。多个线程同时访问同一个不在内存中的页面时，只有一个线程会读磁盘，
+   * 其它线程等待它加载完成，参考 Frame::wait_loaded
+   * @param touch 是否算作一次访问。大表扫描时不算，参考 BufferRing
    */
-  RC get_this_page(PageNum page_num, Frame **frame);
+  RC get_this_page(PageNum page_num, Frame **frame, bool touch = true);
 
   /**
    * 在指定文件中分配一个新的页面，并将其放入缓冲区，返回页面句柄指针。
@@ -247,14 +415,46 @@ public:
   RC check_all_pages_unpinned();
 
   int file_desc() const;
+  const std::string &filename() const { return file_name_; }
+
+  /**
+   * @brief 页面压缩算法的名字，没有压缩时返回nullptr，参考 CompressedPageFile
+   */
+  const char *codec_name() const { return compressed_file_ == nullptr ? nullptr : compressed_file_->codec_name(); }
+
+  /**
+   * @brief 缓冲池一共有多少个页帧，所有文件共用
+   */
+  size_t total_frame_num() const { return frame_manager_.total_frame_num(); }
+
+  /**
+   * @brief 淘汰一个扫描时加载进来、之后没有被访问过的页面，参考 BufferRing
+   */
+  void purge_untouched_page(PageNum page_num);
+
+  /**
+   * @brief 设置这个文件最多可以占用多少个页帧，0表示不限制
+   * @details 超过配额时给这个文件分配页帧会先淘汰它自己的页面，避免一个大表把其它表的页面都挤出缓冲池。
+   * 自己的页面都在使用中时会暂时超出配额
+   */
+  void set_frame_quota(int frame_num) { frame_quota_ = frame_num; }
+  int  frame_quota() const { return frame_quota_.load(); }
 
   /**
    * 如果页面是脏的，就将数据刷新到磁盘
    */
   RC flush_page(Frame &frame);
 
+  /**
+   * @brief 后台清理线程使用，如果页面还在内存中并且是脏的，就刷新到磁盘
+   * @details 不会等待任何锁，拿不到锁时返回 LOCKED_CONCURRENCY_CONFLICT，
+   * 避免与前台线程互相等待
+   */
+  RC clean_page(PageNum page_num);
+
   /**
    * 刷新所有页面到磁盘，即使pin count不是0
+   * @details 脏页按照页面号排序，连续的页面合并成一次 pwritev，最后对文件做一次 fsync
    */
   RC flush_all_pages();
 
@@ -263,8 +463,56 @@ public:
    */
   RC recover_page(PageNum page_num);
 
+  /**
+   * @brief 查找从 page_num 开始(包含)的第一个已经分配的页面，会跳过各个组的第一个页面
+   * @return 没有时返回 BP_INVALID_PAGE_NUM
+   */
+  PageNum next_allocated_page(PageNum page_num);
+
+  /**
+   * @brief 复制分配组的位图，遍历页面时在组内查找不需要每次都加锁
+   * @param page_num_in_group 这个组已经扩展到文件中的页面个数，即位图的有效位数。文件中没有这个组时为0
+   */
+  RC copy_group_bitmap(int group, std::vector<char> &bitmap, int &page_num_in_group);
+
+  int32_t page_count() const { return file_header_->page_count; }
+  int32_t allocated_pages() const { return file_header_->allocated_pages; }
+
+  /**
+   * @brief 提交预读请求，由后台线程把从 start_page 开始的 count 个已经分配的页面加载到内存中
+   * @return 提交的最后一个页面，没有提交任何页面时返回 BP_INVALID_PAGE_NUM
+   */
+  PageNum read_ahead(PageNum start_page, int count);
+
+  /**
+   * @brief 后台预读线程使用，把页面加载到内存中，但不会 pin 住
+   * @details 已经在内存中的页面会跳过，需要加载的页面一次提交给IO后端。
+   * 为了预读而去刷脏页并不划算，所以只会淘汰干净的页面，没有可用的页帧时返回 BUFFERPOOL_NOBUF
+   */
+  RC prefetch_pages(const std::vector<PageNum> &page_nums);
+
+  /**
+   * @brief 顺序扫描时每次预读多少个页面
+   */
+  int read_ahead_pages() const;
+
+  /**
+   * @brief 页面所在的分配组
+   */
+  static int group_of(PageNum page_num);
+
+  /**
+   * @brief 分配组的第一个页面的编号
+   */
+  static PageNum group_start(int group);
+
 protected:
-  RC allocate_frame(PageNum page_num, Frame **buf);
+  /**
+   * @brief 分配一个页帧，页帧不够用时淘汰一些页面
+   * @param created 为空时总是分配一个已经加载完成状态的页帧，用于新页面；
+   * 否则在页面已经在内存中时直接返回，页帧是新分配的时候设置为true，需要调用者加载数据
+   */
+  RC allocate_frame(PageNum page_num, Frame **buf, bool *created = nullptr);
 
   /**
    * 刷新指定页面到磁盘(flush)，并且释放关联的Frame
@@ -277,11 +525,69 @@ protected:
    */
   RC load_page(PageNum page_num, Frame *frame);
 
+  /**
+   * @brief 给新分配的正在加载状态的页帧加载数据，并唤醒等待的线程
+   * @details 加载失败时会释放这个页帧
+   */
+  RC load_created_frame(PageNum page_num, Frame *frame);
+
   /**
    * 如果页面是脏的，就将数据刷新到磁盘
    */
   RC flush_page_internal(Frame &frame);
 
+  /**
+   * @brief 关闭数据文件，压缩的文件会先把页面映射刷到磁盘
+   */
+  RC close_data_file();
+
+  /**
+   * @brief 批量把脏页写到磁盘，写成功的页面清除脏标记，最后做一次 fsync
+   * @details 页面按照页面号排序，连续的页面合并成一个向量写请求，所有请求一次提交给IO后端。
+   * 需要在 lock_ 内调用
+   */
+  RC write_dirty_frames(std::vector<Frame *> &frames);
+
+  /**
+   * @brief 获取分配组的位图
+   * @details 位图的大小是这个组已经扩展到文件中的页面个数。返回的页帧已经pin住，用完需要unpin
+   */
+  RC fetch_group(int group, Frame *&frame, common::Bitmap &bitmap);
+
+  /**
+   * @brief 同 next_allocated_page，需要在 lock_ 内调用
+   */
+  PageNum next_allocated_page_internal(PageNum page_num);
+
+  /**
+   * @brief 在文件末尾创建一个新的分配组，即写入这个组的第一个页面
+   */
+  RC create_group(int group);
+
+  /**
+   * @brief 打开文件时统计每个组分配了多少个页面
+   */
+  RC load_groups();
+
+  /**
+   * @brief 修改页面的分配状态，同时更新文件头和内存中的统计信息
+   */
+  RC set_page_allocated(PageNum page_num, bool allocated);
+
+  /**
+   * @brief 释放页面的页帧，并将页面设置为未分配状态，需要在 lock_ 内调用
+   * @details 其它线程可能还pin着这个页面，比如乐观查找B+树时正在等待页面的锁。这时释放页帧，
+   * 它们就会访问已经被复用的页帧。所以页面先记录在 disposed_pages_ 中并保持已分配的状态，
+   * 由最后一个调用 unpin_page 的线程释放
+   * @param frame 调用者pin住的页帧，为空表示页面已经不在内存中
+   */
+  RC dispose_frame(PageNum page_num, Frame *frame);
+
+  /**
+   * @brief 组内还有没有分配的页面时放到 free_groups_ 中
+   */
+  void update_free_group(int group);
+
 private:
   BufferPoolManager &  bp_manager_;
   BPFrameManager &     frame_manager_;
@@ -290,13 +596,44 @@ private:
   int                  file_desc_ = -1;
   Frame *              hdr_frame_ = nullptr;
   BPFileHeader *       file_header_ = nullptr;
-  std::set<PageNum>    disposed_pages_;
+  std::set<PageNum>    disposed_pages_;          ///< 已经释放但还有线程pin住的页面，参考 dispose_frame
+  std::atomic<int>     disposed_page_num_{0};    ///< disposed_pages_ 的大小，unpin_page 不加锁就可以判断
+
+  std::vector<int32_t> group_allocated_pages_;  ///< 每个分配组已经分配了多少个页面
+  std::set<int>        free_groups_;            ///< 还有空闲页面的分配组
+  std::atomic<int>     frame_quota_{0};         ///< 最多可以占用多少个页帧，0表示不限制
+  std::unique_ptr<CompressedPageFile> compressed_file_;  ///< 压缩的文件通过它读写页面，普通文件为空
 
   common::Mutex        lock_;
 private:
   friend class BufferPoolIterator;
 };
 
+/**
+ * @brief BufferPool的配置参数
+ * @ingroup BufferPool
+ * @details 可以在配置文件的 [BufferPool] 段中设置，可以参考 etc/observer.ini
+ */
+struct BufferPoolParam
+{
+  int64_t     memory_size = 0;                                  ///< 页帧使用的内存大小，单位字节。0表示使用默认值
+  int         shard_num   = BPFrameManager::DEFAULT_SHARD_NUM;  ///< 页帧表分片的个数
+  std::string replacer    = FrameReplacer::DEFAULT_NAME;        ///< 页面置换策略
+
+  int cleaner_low_watermark  = 5;    ///< 空闲页帧低于总数的这个百分比时开始后台清理，0表示不启动后台清理
+  int cleaner_high_watermark = 10;   ///< 后台清理到空闲页帧达到总数的这个百分比为止
+  int cleaner_interval_ms    = 100;  ///< 后台清理线程定期检查的时间间隔
+
+  int read_ahead_pages = 32;  ///< 顺序扫描时每次预读多少个页面，0表示不预读
+
+  std::string io_backend = IoBackend::DEFAULT_NAME;  ///< 数据文件和日志文件使用的IO后端，进程内全局使用一个
+
+  bool        direct_io = false;   ///< 数据文件和索引文件是否使用 O_DIRECT 打开，绕过操作系统的页缓存
+  std::string huge_page = "none";  ///< 页帧内存是否使用大页，参考 FrameAllocator::huge_page_from_name
+
+  std::string dump_file;  ///< 关闭时记录内存中的页面，启动时重新加载，参考 BufferPoolManager::dump_pages。为空表示不记录
+};
+
 /**
  * @brief BufferPool的管理类
  * @ingroup BufferPool
@@ -304,24 +641,104 @@ private:
 class BufferPoolManager 
 {
 public:
-  BufferPoolManager(int memory_size = 0);
+  BufferPoolManager(int64_t memory_size = 0);
+  BufferPoolManager(const BufferPoolParam &param);
   ~BufferPoolManager();
 
-  RC create_file(const char *file_name);
+  /**
+   * @brief 创建一个分页文件
+   * @param codec 页面压缩算法的名字，为空或者 none 时不压缩，参考 PageCodec::create
+   */
+  RC create_file(const char *file_name, const char *codec = nullptr);
   RC remove_file(const char *file_name);
   RC open_file(const char *file_name, DiskBufferPool *&bp);
   RC close_file(const char *file_name);
 
   RC flush_page(Frame &frame);
 
+  /**
+   * @brief 后台清理线程使用，参考 DiskBufferPool::clean_page
+   */
+  RC clean_page(const FrameId &frame_id);
+
+  PageCleaner &page_cleaner() { return page_cleaner_; }
+  ReadAheadWorker &read_ahead_worker() { return read_ahead_worker_; }
+  int read_ahead_pages() const { return read_ahead_pages_; }
+  bool direct_io() const { return direct_io_; }
+
+  /**
+   * @brief 在线调整缓冲池的内存大小
+   * @details 页帧个数按照 DEFAULT_ITEM_NUM_PER_POOL 向下取整。缩小时停用的页帧中的脏页会先刷盘，
+   * 正在使用的页帧要等到以后被淘汰时才会释放内存。后台清理线程的水位线按照新的页帧个数重新计算
+   * @param memory_size 新的内存大小，单位字节
+   */
+  RC resize(int64_t memory_size);
+
+  /**
+   * @brief 缓冲池当前的内存大小，单位字节
+   */
+  int64_t memory_size() const { return static_cast<int64_t>(frame_manager_.total_frame_num()) * BP_PAGE_SIZE; }
+
+  /**
+   * @brief 设置某个文件最多可以占用多少个页帧，0表示不限制
+   * @details 文件还没有打开时会记录下来，打开时生效。参考 DiskBufferPool::set_frame_quota
+   */
+  RC set_frame_quota(const char *file_name, int frame_num);
+
+  /**
+   * @brief 把内存中有哪些页面记录到文件中，最近访问过的页面在前面
+   * @details 只记录文件名和页面号，不记录页面的内容。重启之后使用 load_pages 把这些页面重新加载到内存中，
+   * 避免重启后很长时间都在使用冷的缓冲池。关闭时会自动调用，也可以随时调用。
+   * @param dump_file 记录的文件，为空时使用 BufferPoolParam::dump_file
+   */
+  RC dump_pages(const char *dump_file = nullptr);
+
+  /**
+   * @brief 按照 dump_pages 记录的顺序加载页面
+   * @details 开启 CONCURRENCY 时在后台线程中分批加载，不阻塞启动，否则加载完之后再返回。
+   * 只会加载已经打开的文件中的页面，空闲的页帧用完时就停止，不会淘汰已经加载的页面。
+   * @param dump_file 记录的文件，为空时使用 BufferPoolParam::dump_file
+   */
+  RC load_pages(const char *dump_file = nullptr);
+
+  /**
+   * @brief 等待 load_pages 加载完成，测试使用
+   */
+  void wait_load_done();
+
 public:
   static void set_instance(BufferPoolManager *bpm); // TODO 优化全局变量的表示方法
   static BufferPoolManager &instance();
 
+private:
+  void load_pages_internal(std::vector<std::pair<std::string, PageNum>> pages);
+
+  /**
+   * @brief 内存大小对应多少个页帧池
+   */
+  static int pool_num_of(int64_t memory_size);
+
+  /**
+   * @brief 根据页帧个数计算后台清理线程的水位线
+   */
+  void cleaner_watermarks(int frame_num, int &low_watermark, int &high_watermark) const;
+
 private:
   BPFrameManager frame_manager_{"BufPool"};
+  PageCleaner    page_cleaner_{*this, frame_manager_};
+  ReadAheadWorker read_ahead_worker_;
+  int            read_ahead_pages_ = 0;
+  bool           direct_io_ = false;
+  std::string    dump_file_;
+  int            cleaner_low_percent_  = 0;  ///< 参考 BufferPoolParam::cleaner_low_watermark
+  int            cleaner_high_percent_ = 0;
+  std::mutex     resize_lock_;
+
+  std::thread       load_thread_;  ///< 后台加载 dump 文件中的页面
+  std::atomic<bool> load_stopped_{false};
 
   common::Mutex  lock_;
   std::unordered_map<std::string, DiskBufferPool *> buffer_pools_;
   std::unordered_map<int, DiskBufferPool *> fd_buffer_pools_;
+  std::unordered_map<std::string, int> file_quotas_;  ///< 每个文件的页帧配额
 };
@@ -84,21 +84,25 @@ void Frame::write_latch(intptr_t xid)
     ASSERT(pin_count_.load() > 0,
            "frame lock. write lock failed while pin count is invalid. "
            "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-           this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+           this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
 
     ASSERT(read_lockers_.find(xid) == read_lockers_.end(),
            "frame lock write while holding the read lock."
            "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-           this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+           this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
   }
 
   lock_.lock();
   write_locker_ = xid;
-  write_recursive_count_++;
+  if (write_recursive_count_++ == 0) {
+    // 版本号变成奇数之后才能修改页面，乐观读的线程看到奇数或者版本号变化时会放弃读到的数据
+    version_.store(version_.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+  }
 
   LOG_DEBUG("frame write lock success."
             "this=%p, pin=%d, pageNum=%d, write locker=%lx(recursive=%d), fd=%d, xid=%lx, lbt=%s",
-            this, pin_count_.load(), page_.page_num, write_locker_, write_recursive_count_, file_desc_, xid, common::lbt());
+            this, pin_count_.load(), page_->page_num, write_locker_, write_recursive_count_, file_desc_, xid, common::lbt());
 }
 
 void Frame::write_unlatch()
@@ -114,18 +118,19 @@ void Frame::write_unlatch(intptr_t xid)
   ASSERT(pin_count_.load() > 0, 
         "frame lock. write unlock failed while pin count is invalid."
         "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-         this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+         this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
 
   ASSERT(write_locker_ == xid,
          "frame unlock write while not the owner."
          "write_locker=%lx, this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-         write_locker_, this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+         write_locker_, this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
 
   LOG_DEBUG("frame write unlock success. this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-            this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+            this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
 
   if (--write_recursive_count_ == 0) {
     write_locker_ = 0;
+    version_.store(version_.load(memory_order_relaxed) + 1, memory_order_release);
   }
   debug_lock_.unlock();
   
@@ -143,12 +148,12 @@ void Frame::read_latch(intptr_t xid)
     std::scoped_lock debug_lock(debug_lock_);
     ASSERT(pin_count_ > 0, "frame lock. read lock failed while pin count is invalid."
            "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-           this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+           this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
 
     ASSERT(xid != write_locker_,
            "frame lock read while holding the write lock."
            "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-           this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+           this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
   }
 
   lock_.lock_shared();
@@ -158,7 +163,7 @@ void Frame::read_latch(intptr_t xid)
     int recursive_count = ++read_lockers_[xid];
     LOG_DEBUG("frame read lock success."
               "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, recursive=%d, lbt=%s",
-              this, pin_count_.load(), page_.page_num, file_desc_, xid, recursive_count, common::lbt());
+              this, pin_count_.load(), page_->page_num, file_desc_, xid, recursive_count, common::lbt());
   }
 }
 
@@ -169,12 +174,12 @@ bool Frame::try_read_latch()
     std::scoped_lock debug_lock(debug_lock_);
     ASSERT(pin_count_ > 0, "frame try lock. read lock failed while pin count is invalid."
            "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-           this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+           this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
 
     ASSERT(xid != write_locker_,
            "frame try to lock read while holding the write lock."
            "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-           this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+           this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
   }
 
   bool ret = lock_.try_lock_shared();
@@ -183,7 +188,7 @@ bool Frame::try_read_latch()
     int recursive_count = ++read_lockers_[xid];
     LOG_DEBUG("frame read lock success."
               "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, recursive=%d, lbt=%s",
-              this, pin_count_.load(), page_.page_num, file_desc_, xid, recursive_count, common::lbt());
+              this, pin_count_.load(), page_->page_num, file_desc_, xid, recursive_count, common::lbt());
     debug_lock_.unlock();
   }
 
@@ -202,7 +207,7 @@ void Frame::read_unlatch(intptr_t xid)
     ASSERT(pin_count_.load() > 0,
             "frame lock. read unlock failed while pin count is invalid."
             "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-           this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+           this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
 
 #if DEBUG
     auto read_lock_iter = read_lockers_.find(xid);
@@ -210,7 +215,7 @@ void Frame::read_unlatch(intptr_t xid)
     ASSERT(recursive_count > 0,
            "frame unlock while not holding read lock."
            "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, recursive=%d, lbt=%s",
-           this, pin_count_.load(), page_.page_num, file_desc_, xid, recursive_count, common::lbt());
+           this, pin_count_.load(), page_->page_num, file_desc_, xid, recursive_count, common::lbt());
 
     if (1 == recursive_count) {
       read_lockers_.erase(xid);
@@ -222,11 +227,24 @@ void Frame::read_unlatch(intptr_t xid)
 
   LOG_DEBUG("frame read unlock success."
             "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-            this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+            this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
 
   lock_.unlock_shared();
 }
 
+bool Frame::read_version(uint64_t &version) const
+{
+  version = version_.load(memory_order_acquire);
+  return (version & 1) == 0;
+}
+
+bool Frame::validate_version(uint64_t version) const
+{
+  // 保证读取页面数据在重新读取版本号之前完成
+  atomic_thread_fence(memory_order_acquire);
+  return version_.load(memory_order_relaxed) == version;
+}
+
 void Frame::pin()
 {
   std::scoped_lock debug_lock(debug_lock_);
@@ -237,7 +255,7 @@ void Frame::pin()
   LOG_DEBUG("after frame pin. "
             "this=%p, write locker=%lx, read locker has xid %d? pin=%d, fd=%d, pageNum=%d, xid=%lx, lbt=%s",
             this, write_locker_, read_lockers_.find(xid) != read_lockers_.end(), 
-            pin_count, file_desc_, page_.page_num, xid, common::lbt());
+            pin_count, file_desc_, page_->page_num, xid, common::lbt());
 }
 
 int Frame::unpin()
@@ -247,7 +265,7 @@ int Frame::unpin()
   ASSERT(pin_count_.load() > 0,
          "try to unpin a frame that pin count <= 0."
          "this=%p, pin=%d, pageNum=%d, fd=%d, xid=%lx, lbt=%s",
-         this, pin_count_.load(), page_.page_num, file_desc_, xid, common::lbt());
+         this, pin_count_.load(), page_->page_num, file_desc_, xid, common::lbt());
   
   std::scoped_lock debug_lock(debug_lock_);
 
@@ -256,15 +274,15 @@ int Frame::unpin()
   LOG_DEBUG("after frame unpin. "
             "this=%p, write locker=%lx, read locker has xid? %d, pin=%d, fd=%d, pageNum=%d, xid=%lx, lbt=%s",
             this, write_locker_, read_lockers_.find(xid) != read_lockers_.end(), 
-            pin_count, file_desc_, page_.page_num, xid, common::lbt());
+            pin_count, file_desc_, page_->page_num, xid, common::lbt());
   
   if (0 == pin_count) {
     ASSERT(write_locker_ == 0,
            "frame unpin to 0 failed while someone hold the write lock. write locker=%lx, pageNum=%d, fd=%d, xid=%lx",
-           write_locker_, page_.page_num, file_desc_, xid);
+           write_locker_, page_->page_num, file_desc_, xid);
     ASSERT(read_lockers_.empty(),
            "frame unpin to 0 failed while someone hold the read locks. reader num=%d, pageNum=%d, fd=%d, xid=%lx",
-           read_lockers_.size(), page_.page_num, file_desc_, xid);
+           read_lockers_.size(), page_->page_num, file_desc_, xid);
   }
   return pin_count;
 }
@@ -277,6 +295,34 @@ unsigned long current_time()
   return tp.tv_sec * 1000 * 1000 * 1000UL + tp.tv_nsec;
 }
 
+enum FrameLoadState
+{
+  FRAME_LOADED = 0,
+  FRAME_LOADING,
+  FRAME_LOAD_FAILED,
+};
+
+void Frame::set_loading()
+{
+  load_state_.store(FRAME_LOADING);
+}
+
+void Frame::finish_loading(bool success)
+{
+  load_state_.store(success ? FRAME_LOADED : FRAME_LOAD_FAILED);
+  load_state_.notify_all();
+}
+
+bool Frame::wait_loaded()
+{
+  int state = load_state_.load();
+  while (state == FRAME_LOADING) {
+    load_state_.wait(state);
+    state = load_state_.load();
+  }
+  return state == FRAME_LOADED;
+}
+
 void Frame::access()
 {
   acc_time_ = current_time();
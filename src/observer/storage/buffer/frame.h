@@ -20,6 +20,7 @@ See the Mulan PSL v2 for more details. */
 #include <mutex>
 #include <set>
 #include <atomic>
+#include <memory>
 
 #include "storage/buffer/page.h"
 #include "common/log/log.h"
@@ -46,6 +47,25 @@ private:
   PageNum page_num_;
 };
 
+class Frame;
+
+/**
+ * @brief 页面置换策略记录在页帧上的信息
+ * @ingroup BufferPool
+ * @details 由 FrameReplacer 维护，各个策略只使用自己关心的字段。放在页帧中，
+ * 置换策略就不需要再用额外的哈希表来查找页帧对应的信息。
+ */
+struct FrameReplacerHook
+{
+  Frame   *prev        = nullptr;  ///< 链表类策略(LRU/LRU-K/2Q)的前驱
+  Frame   *next        = nullptr;  ///< 链表类策略(LRU/LRU-K/2Q)的后继
+  int      queue       = 0;        ///< 2Q：页帧当前在哪个队列中
+  int      slot        = -1;       ///< CLOCK：页帧在时钟上的槽位
+  bool     referenced  = false;    ///< CLOCK：访问位
+  uint64_t last_access = 0;        ///< LRU-K：最近一次访问的逻辑时间
+  uint64_t kth_access  = 0;        ///< LRU-K：倒数第K次访问的逻辑时间，0表示访问次数还不够K次
+};
+
 /**
  * @brief 页帧
  * @ingroup BufferPool
@@ -57,41 +77,52 @@ private:
  * 
  * 为了防止在使用过程中页面被淘汰，这里使用了pin count，当页面被使用时，pin count会增加，
  * 当页面不再使用时，pin count会减少。当pin count为0时，页面可以被淘汰。
+ *
+ * 页面数据不放在页帧对象内部。缓冲池中的页帧由 FrameAllocator 创建，页面数据位于一块按页对齐的内存中，
+ * 这样才能使用 O_DIRECT 直接读写磁盘；单独创建的页帧(比如测试中)自己申请页面内存。
  */
 class Frame
 {
 public:
+  Frame() : own_page_(new Page), page_(own_page_.get()) {}
+  explicit Frame(Page *page) : page_(page) {}
+  Frame(const Frame &) = delete;
+  Frame &operator=(const Frame &) = delete;
+
   ~Frame()
   {
     // LOG_DEBUG("deallocate frame. this=%p, lbt=%s", this, common::lbt());
   }
 
   /**
-   * @brief reinit 和 reset 在 MemPoolSimple 中使用
-   * @details 在 MemPoolSimple 分配和释放一个Frame对象时，不会调用构造函数和析构函数，
+   * @brief reinit 和 reset 在 FrameAllocator 中使用
+   * @details 在 FrameAllocator 分配和释放一个Frame对象时，不会调用构造函数和析构函数，
    * 而是调用reinit和reset。
    */
   void reinit()
-  {}
+  {
+    acc_time_ = 0;
+  }
   void reset()
   {}
   
   void clear_page()
   {
-    memset(&page_, 0, sizeof(page_));
+    memset(page_, 0, sizeof(Page));
   }
 
   int     file_desc() const { return file_desc_; }
   void    set_file_desc(int fd) { file_desc_ = fd; }
-  Page &  page() { return page_; }
-  PageNum page_num() const { return page_.page_num; }
-  void    set_page_num(PageNum page_num) { page_.page_num = page_num; }
-  FrameId frame_id() const { return FrameId(file_desc_, page_.page_num); }
-  LSN     lsn() const { return page_.lsn; }
-  void    set_lsn(LSN lsn) { page_.lsn = lsn; }
+  Page &  page() { return *page_; }
+  PageNum page_num() const { return page_->page_num; }
+  void    set_page_num(PageNum page_num) { page_->page_num = page_num; }
+  FrameId frame_id() const { return FrameId(file_desc_, page_->page_num); }
+  LSN     lsn() const { return page_->lsn; }
+  void    set_lsn(LSN lsn) { page_->lsn = lsn; }
 
   /// 刷新访问时间 TODO touch is better?
   void access();
+  unsigned long acc_time() const { return acc_time_; }
 
   /**
    * @brief 标记指定页面为“脏”页。如果修改了页面的内容，则应调用此函数，
@@ -101,7 +132,7 @@ public:
   void clear_dirty() { dirty_ = false; }
   bool dirty() const { return dirty_; }
 
-  char *data() { return page_.data; }
+  char *data() { return page_->data; }
 
   bool can_purge() { return pin_count_.load() == 0; }
 
@@ -118,6 +149,25 @@ public:
   int  unpin();
   int  pin_count() const { return pin_count_.load(); }
 
+  /**
+   * @brief 标记页面数据正在从磁盘加载
+   * @details 页面不在内存中时，第一个访问的线程分配页帧并放入页帧表，然后负责从磁盘加载数据。
+   * 加载期间其它线程也能从页帧表中拿到这个页帧，它们只需要等待加载完成，
+   * 不需要再读一遍磁盘，也不需要加文件级别的锁。
+   */
+  void set_loading();
+
+  /**
+   * @brief 加载完成，唤醒等待的线程
+   */
+  void finish_loading(bool success);
+
+  /**
+   * @brief 等待页面加载完成
+   * @return 加载失败时返回false
+   */
+  bool wait_loaded();
+
   void write_latch();
   void write_latch(intptr_t xid);
 
@@ -131,12 +181,18 @@ public:
   void read_unlatch();
   void read_unlatch(intptr_t xid);
 
-  void set_text() {
-    if_text_ = true;
-  }
-  bool get_text() {
-    return if_text_;
-  }
+  /**
+   * @brief 乐观读：不加读锁读取页面，读完之后校验版本号
+   * @details 每次加写锁和释放写锁时版本号都会加1，版本号是奇数表示有线程正在修改页面。
+   * 读之前调用 read_version 记录版本号，读完之后调用 validate_version，版本号没有变化才说明读到的数据是一致的。
+   * 乐观读不会修改页帧上的任何数据，多个线程同时读取热点页面(比如B+树的根节点)时不会互相争抢缓存行。
+   * 读到的数据可能是不一致的，校验通过之前只能用来做不会越界的计算。调用者仍然需要pin住页面。
+   * @return 页面正在被修改时返回false
+   */
+  bool read_version(uint64_t &version) const;
+  bool validate_version(uint64_t version) const;
+
+  FrameReplacerHook &replacer_hook() { return replacer_hook_; }
 
   friend std::string to_string(const Frame &frame);
 
@@ -145,10 +201,13 @@ private:
 
   bool              dirty_     = false;
   std::atomic<int>  pin_count_{0};
+  std::atomic<int>  load_state_{0};
+  std::atomic<uint64_t> version_{0};  ///< 乐观读使用的版本号，参考 read_version
   unsigned long     acc_time_  = 0;
   int               file_desc_ = -1;
-  Page              page_;
-  bool              if_text_ = false;
+  std::unique_ptr<Page> own_page_;  ///< 单独创建的页帧自己持有页面内存
+  Page             *page_ = nullptr;
+  FrameReplacerHook replacer_hook_;
 
   /// 在非并发编译时，加锁解锁动作将什么都不做
   common::RecursiveSharedMutex     lock_;
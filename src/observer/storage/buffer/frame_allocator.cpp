@@ -0,0 +1,304 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <new>
+
+#include "storage/buffer/frame_allocator.h"
+#include "common/log/log.h"
+
+using namespace std;
+
+FrameAllocator::FrameAllocator(const char *tag) : tag_(tag)
+{}
+
+FrameAllocator::~FrameAllocator()
+{
+  destroy();
+}
+
+RC FrameAllocator::init(int frame_num, HugePage huge_page /* = HugePage::NONE */)
+{
+  if (!chunks_.empty()) {
+    LOG_WARN("frame allocator has been initialized. tag=%s", tag_.c_str());
+    return RC::INTERNAL;
+  }
+  if (frame_num <= 0) {
+    LOG_ERROR("invalid frame num %d. tag=%s", frame_num, tag_.c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  huge_page_ = huge_page;
+  std::lock_guard<std::mutex> guard(mutex_);
+  RC rc = add_chunk(frame_num);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  capacity_ = frame_num;
+  LOG_INFO("frame allocator init done. tag=%s, frame num=%d, huge page=%s",
+           tag_.c_str(), frame_num, huge_page_name(huge_page_));
+  return RC::SUCCESS;
+}
+
+RC FrameAllocator::add_chunk(int frame_num)
+{
+  // mmap 返回的内存按照系统页对齐，页面大小也是系统页的整数倍，每个页面都满足 O_DIRECT 的对齐要求
+  Chunk chunk;
+  const size_t data_size = static_cast<size_t>(frame_num) * sizeof(Page);
+  chunk.arena_size = data_size;
+  if (huge_page_ != HugePage::NONE) {
+    chunk.arena_size = (data_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+
+  void *memory = MAP_FAILED;
+  if (huge_page_ == HugePage::EXPLICIT) {
+    memory = mmap(nullptr, chunk.arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory == MAP_FAILED) {
+      LOG_WARN("failed to allocate explicit huge pages, use normal pages instead. size=%zu, error=%s",
+               chunk.arena_size, strerror(errno));
+      huge_page_ = HugePage::NONE;
+    }
+  }
+  if (memory == MAP_FAILED) {
+    memory = mmap(nullptr, chunk.arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  if (memory == MAP_FAILED) {
+    LOG_ERROR("failed to allocate memory for frames. size=%zu, error=%s", chunk.arena_size, strerror(errno));
+    return RC::NOMEM;
+  }
+  chunk.arena = static_cast<char *>(memory);
+
+  if (huge_page_ == HugePage::TRANSPARENT && madvise(chunk.arena, chunk.arena_size, MADV_HUGEPAGE) != 0) {
+    LOG_WARN("failed to enable transparent huge pages, use normal pages instead. error=%s", strerror(errno));
+    huge_page_ = HugePage::NONE;
+  }
+
+  chunk.frames = static_cast<Frame *>(::operator new(sizeof(Frame) * frame_num, nothrow));
+  if (chunk.frames == nullptr) {
+    LOG_ERROR("failed to allocate frames. frame num=%d", frame_num);
+    munmap(chunk.arena, chunk.arena_size);
+    return RC::NOMEM;
+  }
+
+  Page *pages     = reinterpret_cast<Page *>(chunk.arena);
+  chunk.frame_num = frame_num;
+  chunk.start     = total_num_;
+  for (int i = 0; i < frame_num; i++) {
+    new (chunk.frames + i) Frame(pages + i);
+  }
+  chunks_.push_back(chunk);
+  total_num_ += frame_num;
+  owners_.resize(total_num_, -1);
+
+  // 倒序放入，先分配出去的是地址低的页帧
+  for (int i = frame_num - 1; i >= 0; i--) {
+    free_frames_.push_back(chunk.frames + i);
+  }
+
+  LOG_INFO("allocate a chunk of frames. tag=%s, frame num=%d, memory size=%zu, total frame num=%d",
+           tag_.c_str(), frame_num, chunk.arena_size, total_num_);
+  return RC::SUCCESS;
+}
+
+RC FrameAllocator::resize(int frame_num)
+{
+  if (frame_num <= 0) {
+    LOG_ERROR("invalid frame num %d. tag=%s", frame_num, tag_.c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  const int old_capacity = capacity_.load();
+  if (frame_num > old_capacity) {
+    // 先重新启用停用的页帧，这些页帧已经在内存块中了
+    const int reuse_end = std::min(frame_num, total_num_);
+    for (int i = reuse_end - 1; i >= old_capacity; i--) {
+      if (owners_[i] == -1) {
+        free_frames_.push_back(frame_at(i));
+      }
+    }
+    if (frame_num > total_num_) {
+      capacity_ = total_num_;
+      RC rc = add_chunk(frame_num - total_num_);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+  } else if (frame_num < old_capacity) {
+    // 停用编号大的页帧。空闲的从空闲链表中拿掉，马上归还内存
+    auto iter = std::remove_if(free_frames_.begin(), free_frames_.end(), [this, frame_num](Frame *frame) {
+      if (index_of(frame) < frame_num) {
+        return false;
+      }
+      release_memory(frame);
+      return true;
+    });
+    free_frames_.erase(iter, free_frames_.end());
+  }
+  capacity_ = frame_num;
+
+  LOG_INFO("resize frame allocator. tag=%s, capacity %d -> %d, total frame num=%d",
+           tag_.c_str(), old_capacity, frame_num, total_num_);
+  return RC::SUCCESS;
+}
+
+void FrameAllocator::destroy()
+{
+  for (Chunk &chunk : chunks_) {
+    for (int i = 0; i < chunk.frame_num; i++) {
+      chunk.frames[i].~Frame();
+    }
+    ::operator delete(chunk.frames);
+    munmap(chunk.arena, chunk.arena_size);
+  }
+  chunks_.clear();
+  total_num_ = 0;
+  capacity_  = 0;
+  used_num_  = 0;
+  free_frames_.clear();
+  owners_.clear();
+  file_frames_.clear();
+}
+
+int FrameAllocator::index_of(const Frame *frame) const
+{
+  for (const Chunk &chunk : chunks_) {
+    if (frame >= chunk.frames && frame < chunk.frames + chunk.frame_num) {
+      return chunk.start + static_cast<int>(frame - chunk.frames);
+    }
+  }
+  return -1;
+}
+
+Frame *FrameAllocator::frame_at(int index)
+{
+  for (Chunk &chunk : chunks_) {
+    if (index >= chunk.start && index < chunk.start + chunk.frame_num) {
+      return chunk.frames + (index - chunk.start);
+    }
+  }
+  return nullptr;
+}
+
+void FrameAllocator::release_memory(Frame *frame)
+{
+  // 页帧停用后不再需要页面的内容，内存还给操作系统，重新启用时会得到全是0的页面
+  (void)madvise(&frame->page(), sizeof(Page), MADV_DONTNEED);
+}
+
+Frame *FrameAllocator::alloc(int file_desc)
+{
+  lock_guard<mutex> guard(mutex_);
+  if (free_frames_.empty()) {
+    return nullptr;
+  }
+
+  Frame *frame = free_frames_.back();
+  free_frames_.pop_back();
+  owners_[index_of(frame)] = file_desc;
+  used_num_++;
+  file_frames_[file_desc]++;
+  frame->reinit();
+  return frame;
+}
+
+void FrameAllocator::free(Frame *frame)
+{
+  lock_guard<mutex> guard(mutex_);
+  const int index = index_of(frame);
+  if (index < 0) {
+    LOG_PANIC("free a frame not allocated from here. tag=%s, frame=%p", tag_.c_str(), frame);
+    return;
+  }
+  if (owners_[index] == -1) {
+    LOG_WARN("frame is freed twice. tag=%s, frame=%p", tag_.c_str(), frame);
+    return;
+  }
+
+  frame->reset();
+  auto iter = file_frames_.find(owners_[index]);
+  if (--iter->second == 0) {
+    file_frames_.erase(iter);
+  }
+  owners_[index] = -1;
+  used_num_--;
+
+  if (index < capacity_.load()) {
+    free_frames_.push_back(frame);
+  } else {
+    release_memory(frame);
+  }
+}
+
+int FrameAllocator::get_used_num()
+{
+  lock_guard<mutex> guard(mutex_);
+  return used_num_;
+}
+
+int FrameAllocator::get_free_num()
+{
+  lock_guard<mutex> guard(mutex_);
+  return static_cast<int>(free_frames_.size());
+}
+
+int FrameAllocator::file_frame_num(int file_desc)
+{
+  lock_guard<mutex> guard(mutex_);
+  auto iter = file_frames_.find(file_desc);
+  return iter == file_frames_.end() ? 0 : iter->second;
+}
+
+bool FrameAllocator::retired(const Frame *frame)
+{
+  lock_guard<mutex> guard(mutex_);
+  return index_of(frame) >= capacity_.load();
+}
+
+int FrameAllocator::retired_used_num()
+{
+  lock_guard<mutex> guard(mutex_);
+  int count = 0;
+  for (int i = capacity_.load(); i < total_num_; i++) {
+    if (owners_[i] != -1) {
+      count++;
+    }
+  }
+  return count;
+}
+
+bool FrameAllocator::huge_page_from_name(const char *name, HugePage &huge_page)
+{
+  if (0 == strcasecmp(name, "none")) {
+    huge_page = HugePage::NONE;
+  } else if (0 == strcasecmp(name, "transparent")) {
+    huge_page = HugePage::TRANSPARENT;
+  } else if (0 == strcasecmp(name, "explicit")) {
+    huge_page = HugePage::EXPLICIT;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char *FrameAllocator::huge_page_name(HugePage huge_page)
+{
+  switch (huge_page) {
+    case HugePage::NONE: return "none";
+    case HugePage::TRANSPARENT: return "transparent";
+    case HugePage::EXPLICIT: return "explicit";
+  }
+  return "unknown";
+}
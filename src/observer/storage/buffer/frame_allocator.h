@@ -0,0 +1,142 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/rc.h"
+#include "storage/buffer/frame.h"
+
+/**
+ * @brief 页帧分配器
+ * @ingroup BufferPool
+ * @details 页面数据放在连续的、按页对齐的内存块(arena)中，每个页帧指向其中的一个页面，
+ * 所以可以直接用页帧的内存做 O_DIRECT 读写。初始化时申请一块内存，运行时扩大缓冲池会再申请新的内存块。
+ * arena 可以使用大页，页帧很多时能明显减少TLB缺失：
+ * - none：普通的内存页；
+ * - transparent：通过 madvise 建议内核使用透明大页，内核不支持时和 none 一样；
+ * - explicit：使用预留的大页(MAP_HUGETLB，参考 /proc/sys/vm/nr_hugepages)，预留的大页不够时退化成 none。
+ *
+ * 所有页帧按照申请的顺序编号，编号小于容量的页帧可以分配。缩小容量时编号大的页帧被停用，
+ * 停用的页帧释放后不再分配，并把它的内存还给操作系统。
+ * 分配器还记录了每个文件占用了多少个页帧，用来实现每个文件的页帧配额。
+ */
+class FrameAllocator
+{
+public:
+  enum class HugePage
+  {
+    NONE,
+    TRANSPARENT,
+    EXPLICIT,
+  };
+
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+public:
+  FrameAllocator(const char *tag);
+  ~FrameAllocator();
+
+  /**
+   * @brief 申请 frame_num 个页帧的内存
+   * @param huge_page 是否使用大页
+   */
+  RC init(int frame_num, HugePage huge_page = HugePage::NONE);
+
+  /**
+   * @brief 调整可以分配的页帧个数
+   * @details 扩大时先重新启用之前停用的页帧，不够时再申请一块新的内存。
+   * 缩小时停用编号最大的那些页帧，空闲的马上归还内存，正在使用的要等释放之后。
+   * 调用者需要负责淘汰停用的页帧，参考 retired。
+   */
+  RC resize(int frame_num);
+
+  /**
+   * @brief 为某个文件分配一个页帧，没有空闲的页帧时返回nullptr
+   */
+  Frame *alloc(int file_desc);
+  void   free(Frame *frame);
+
+  /**
+   * @brief 可以分配的页帧个数，也就是容量
+   */
+  int get_size() const { return capacity_.load(); }
+  int get_used_num();
+  int get_free_num();
+
+  /**
+   * @brief 某个文件占用了多少个页帧
+   */
+  int file_frame_num(int file_desc);
+
+  /**
+   * @brief 页帧已经停用，但是还在使用中，需要淘汰掉
+   */
+  bool retired(const Frame *frame);
+
+  /**
+   * @brief 有多少个停用的页帧还在使用中
+   */
+  int retired_used_num();
+
+  /**
+   * @brief 实际使用的大页模式。申请大页失败时会退化成 NONE
+   */
+  HugePage huge_page() const { return huge_page_; }
+
+  /**
+   * @brief 第一块内存的起始地址，测试使用
+   */
+  const char *arena() const { return chunks_.empty() ? nullptr : chunks_.front().arena; }
+
+public:
+  /**
+   * @brief 根据名字解析大页模式，不区分大小写。名字不合法时返回false
+   */
+  static bool        huge_page_from_name(const char *name, HugePage &huge_page);
+  static const char *huge_page_name(HugePage huge_page);
+
+private:
+  /**
+   * @brief 一块连续的内存，以及指向其中页面的页帧
+   */
+  struct Chunk
+  {
+    char  *arena      = nullptr;
+    size_t arena_size = 0;
+    Frame *frames     = nullptr;
+    int    frame_num  = 0;
+    int    start      = 0;  ///< 第一个页帧的编号
+  };
+
+  RC     add_chunk(int frame_num);
+  int    index_of(const Frame *frame) const;
+  Frame *frame_at(int index);
+  void   release_memory(Frame *frame);
+  void   destroy();
+
+private:
+  std::string          tag_;
+  std::mutex           mutex_;
+  HugePage             huge_page_ = HugePage::NONE;
+  std::vector<Chunk>   chunks_;
+  int                  total_num_ = 0;  ///< 所有内存块中的页帧个数，包括停用的
+  std::atomic<int>     capacity_{0};
+  std::vector<Frame *> free_frames_;
+  std::vector<int>     owners_;  ///< 每个页帧属于哪个文件，-1表示空闲
+  int                  used_num_ = 0;
+  std::unordered_map<int, int> file_frames_;  ///< 每个文件占用的页帧个数
+};
@@ -0,0 +1,338 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <strings.h>
+#include <algorithm>
+
+#include "storage/buffer/frame_replacer.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+
+using namespace std;
+
+const char *FrameReplacer::DEFAULT_NAME = "lru";
+
+FrameReplacer *FrameReplacer::create(const char *name, int capacity)
+{
+  if (common::is_blank(name) || 0 == strcasecmp(name, "lru")) {
+    return new LruFrameReplacer();
+  }
+
+  if (0 == strcasecmp(name, "clock")) {
+    return new ClockFrameReplacer();
+  }
+
+  if (0 == strcasecmp(name, "lru-k") || 0 == strcasecmp(name, "lru-2")) {
+    return new LruKFrameReplacer();
+  }
+
+  if (0 == strcasecmp(name, "2q")) {
+    return new TwoQueueFrameReplacer(capacity);
+  }
+
+  LOG_ERROR("unknown frame replacer name. name=%s", name);
+  return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void FrameList::push_front(Frame *frame)
+{
+  FrameReplacerHook &hook = frame->replacer_hook();
+  hook.prev = nullptr;
+  hook.next = front_;
+  if (front_ != nullptr) {
+    front_->replacer_hook().prev = frame;
+  } else {
+    tail_ = frame;
+  }
+  front_ = frame;
+  size_++;
+}
+
+void FrameList::remove(Frame *frame)
+{
+  FrameReplacerHook &hook = frame->replacer_hook();
+  if (hook.prev != nullptr) {
+    hook.prev->replacer_hook().next = hook.next;
+  } else {
+    front_ = hook.next;
+  }
+
+  if (hook.next != nullptr) {
+    hook.next->replacer_hook().prev = hook.prev;
+  } else {
+    tail_ = hook.prev;
+  }
+
+  hook.prev = nullptr;
+  hook.next = nullptr;
+  size_--;
+}
+
+void FrameList::move_to_front(Frame *frame)
+{
+  if (front_ == frame) {
+    return;
+  }
+  remove(frame);
+  push_front(frame);
+}
+
+bool FrameList::foreach_reverse(std::function<bool(Frame *)> &func)
+{
+  for (Frame *frame = tail_; frame != nullptr;) {
+    Frame *prev = frame->replacer_hook().prev;
+    if (!func(frame)) {
+      return false;
+    }
+    frame = prev;
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LruFrameReplacer::insert(Frame *frame)
+{
+  list_.push_front(frame);
+}
+
+void LruFrameReplacer::access(Frame *frame)
+{
+  list_.move_to_front(frame);
+}
+
+void LruFrameReplacer::remove(Frame *frame)
+{
+  list_.remove(frame);
+}
+
+void LruFrameReplacer::foreach_victim(std::function<bool(Frame *)> func)
+{
+  list_.foreach_reverse(func);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ClockFrameReplacer::insert(Frame *frame)
+{
+  FrameReplacerHook &hook = frame->replacer_hook();
+  if (!free_slots_.empty()) {
+    hook.slot = free_slots_.back();
+    free_slots_.pop_back();
+    slots_[hook.slot] = frame;
+  } else {
+    hook.slot = static_cast<int>(slots_.size());
+    slots_.push_back(frame);
+  }
+  hook.referenced = true;
+  size_++;
+}
+
+void ClockFrameReplacer::access(Frame *frame)
+{
+  frame->replacer_hook().referenced = true;
+}
+
+void ClockFrameReplacer::remove(Frame *frame)
+{
+  FrameReplacerHook &hook = frame->replacer_hook();
+  ASSERT(hook.slot >= 0 && hook.slot < static_cast<int>(slots_.size()) && slots_[hook.slot] == frame,
+         "invalid clock slot. slot=%d, frame=%s", hook.slot, to_string(*frame).c_str());
+  slots_[hook.slot] = nullptr;
+  free_slots_.push_back(hook.slot);
+  hook.slot = -1;
+  size_--;
+}
+
+void ClockFrameReplacer::foreach_victim(std::function<bool(Frame *)> func)
+{
+  const size_t slot_num = slots_.size();
+  if (slot_num == 0) {
+    return;
+  }
+
+  // 转两圈，第一圈清除访问位，第二圈一定能看到所有访问位为0的页帧
+  for (size_t step = 0; step < slot_num * 2; step++) {
+    Frame *frame = slots_[hand_];
+    hand_ = (hand_ + 1) % slot_num;
+    if (frame == nullptr) {
+      continue;
+    }
+
+    FrameReplacerHook &hook = frame->replacer_hook();
+    if (hook.referenced) {
+      hook.referenced = false;
+      continue;
+    }
+
+    if (!func(frame)) {
+      break;
+    }
+  }
+}
+
+void ClockFrameReplacer::foreach_candidate(std::function<bool(Frame *)> func)
+{
+  const size_t slot_num = slots_.size();
+  if (slot_num == 0) {
+    return;
+  }
+
+  // 与 foreach_victim 的顺序一致：先是访问位为0的页帧，再是转过一圈之后访问位被清除的页帧。
+  // 只读取访问位，不移动时钟指针
+  for (int round = 0; round < 2; round++) {
+    const bool referenced = (round == 1);
+    for (size_t step = 0; step < slot_num; step++) {
+      Frame *frame = slots_[(hand_ + step) % slot_num];
+      if (frame == nullptr || frame->replacer_hook().referenced != referenced) {
+        continue;
+      }
+      if (!func(frame)) {
+        return;
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LruKFrameReplacer::insert(Frame *frame)
+{
+  FrameReplacerHook &hook = frame->replacer_hook();
+  hook.last_access = ++current_time_;
+  hook.kth_access  = 0;
+  history_list_.push_front(frame);
+}
+
+void LruKFrameReplacer::access(Frame *frame)
+{
+  FrameReplacerHook &hook = frame->replacer_hook();
+  if (hook.kth_access == 0) {
+    history_list_.remove(frame);
+  } else {
+    cache_frames_.erase(hook.kth_access);
+  }
+
+  hook.kth_access  = hook.last_access;
+  hook.last_access = ++current_time_;
+  cache_frames_.emplace(hook.kth_access, frame);
+}
+
+void LruKFrameReplacer::remove(Frame *frame)
+{
+  FrameReplacerHook &hook = frame->replacer_hook();
+  if (hook.kth_access == 0) {
+    history_list_.remove(frame);
+  } else {
+    cache_frames_.erase(hook.kth_access);
+  }
+  hook.kth_access  = 0;
+  hook.last_access = 0;
+}
+
+void LruKFrameReplacer::foreach_victim(std::function<bool(Frame *)> func)
+{
+  // 访问次数不足K次的页帧，倒数第K次访问的距离是无穷大，最先淘汰
+  if (!history_list_.foreach_reverse(func)) {
+    return;
+  }
+
+  for (auto &iter : cache_frames_) {
+    if (!func(iter.second)) {
+      return;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+enum TwoQueueType
+{
+  TWO_QUEUE_NONE = 0,
+  TWO_QUEUE_A1IN,
+  TWO_QUEUE_AM,
+};
+
+TwoQueueFrameReplacer::TwoQueueFrameReplacer(int capacity)
+{
+  resize(capacity);
+}
+
+void TwoQueueFrameReplacer::resize(int capacity)
+{
+  // 论文中推荐 A1in 占 25%，A1out 记录 50% 个数的页面编号
+  // A1out 变小时多出来的编号在下次插入时淘汰
+  a1in_capacity_  = std::max(capacity / 4, 1);
+  a1out_capacity_ = std::max(capacity / 2, 1);
+}
+
+void TwoQueueFrameReplacer::insert(Frame *frame)
+{
+  FrameReplacerHook &hook = frame->replacer_hook();
+
+  auto iter = a1out_index_.find(frame->frame_id());
+  if (iter != a1out_index_.end()) {
+    a1out_.erase(iter->second);
+    a1out_index_.erase(iter);
+
+    hook.queue = TWO_QUEUE_AM;
+    am_.push_front(frame);
+  } else {
+    hook.queue = TWO_QUEUE_A1IN;
+    a1in_.push_front(frame);
+  }
+}
+
+void TwoQueueFrameReplacer::access(Frame *frame)
+{
+  if (frame->replacer_hook().queue == TWO_QUEUE_AM) {
+    am_.move_to_front(frame);
+  }
+}
+
+void TwoQueueFrameReplacer::remove(Frame *frame)
+{
+  FrameReplacerHook &hook = frame->replacer_hook();
+  if (hook.queue == TWO_QUEUE_AM) {
+    am_.remove(frame);
+  } else {
+    a1in_.remove(frame);
+  }
+  hook.queue = TWO_QUEUE_NONE;
+}
+
+void TwoQueueFrameReplacer::evict(Frame *frame)
+{
+  const bool in_a1in = (frame->replacer_hook().queue != TWO_QUEUE_AM);
+  remove(frame);
+  if (!in_a1in) {
+    return;
+  }
+
+  FrameId frame_id = frame->frame_id();
+  if (a1out_index_.find(frame_id) == a1out_index_.end()) {
+    a1out_.push_front(frame_id);
+    a1out_index_.emplace(frame_id, a1out_.begin());
+    while (a1out_.size() > a1out_capacity_) {
+      a1out_index_.erase(a1out_.back());
+      a1out_.pop_back();
+    }
+  }
+}
+
+void TwoQueueFrameReplacer::foreach_victim(std::function<bool(Frame *)> func)
+{
+  if (a1in_.size() > a1in_capacity_) {
+    if (a1in_.foreach_reverse(func)) {
+      am_.foreach_reverse(func);
+    }
+  } else {
+    if (am_.foreach_reverse(func)) {
+      a1in_.foreach_reverse(func);
+    }
+  }
+}
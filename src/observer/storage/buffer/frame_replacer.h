@@ -0,0 +1,226 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "storage/buffer/frame.h"
+
+/**
+ * @brief 页面置换策略
+ * @ingroup BufferPool
+ * @details 页帧表的每个分片都有一个置换策略对象，记录页帧的访问情况，在内存不够用时
+ * 决定先淘汰哪些页帧。置换策略本身不加锁，由调用者(BPFrameManager)使用分片的锁保护。
+ * 置换策略只给出淘汰的顺序，某个页帧能不能淘汰(比如是否还被pin住)由调用者判断。
+ *
+ * 当前支持这几种策略，可以在配置文件中指定：
+ * - lru：最近最少使用。每次命中都要把页帧移动到链表头部
+ * - clock：时钟算法。命中时只设置访问位，不需要移动任何数据
+ * - lru-k：LRU-2。按照倒数第2次访问的时间淘汰，只访问过一次的页面(比如全表扫描)会优先淘汰
+ * - 2q：新页面先放在FIFO队列中，再次访问才进入主LRU队列，同样可以抵御扫描
+ */
+class FrameReplacer
+{
+public:
+  virtual ~FrameReplacer() = default;
+
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief 一个页帧放入页帧表
+   */
+  virtual void insert(Frame *frame) = 0;
+
+  /**
+   * @brief 访问页帧表中已有的页帧
+   */
+  virtual void access(Frame *frame) = 0;
+
+  /**
+   * @brief 从页帧表中删除一个页帧
+   * @details 页面被删除、文件关闭等显式释放页帧的情况，不是因为内存不够被淘汰
+   */
+  virtual void remove(Frame *frame) = 0;
+
+  /**
+   * @brief 页帧因为内存不够被淘汰，从页帧表中删除
+   * @details 有些策略会记住被淘汰的页面，参考 TwoQueueFrameReplacer
+   */
+  virtual void evict(Frame *frame) { remove(frame); }
+
+  /**
+   * @brief 按照淘汰的优先顺序遍历页帧，用来挑选要淘汰的页帧
+   * @details 遍历过程中不能调用insert/access/remove。有些策略会在遍历时更新状态，比如时钟算法清除访问位
+   * @param func 返回false时停止遍历
+   */
+  virtual void foreach_victim(std::function<bool(Frame *)> func) = 0;
+
+  /**
+   * @brief 按照淘汰的优先顺序遍历页帧，但是不改变置换策略的任何状态
+   * @details 后台刷脏页时只是提前把将来可能淘汰的页面写回，不能像真正的淘汰一样让页面老化
+   */
+  virtual void foreach_candidate(std::function<bool(Frame *)> func) { foreach_victim(func); }
+
+  /**
+   * @brief 当前管理的页帧个数
+   */
+  virtual size_t size() const = 0;
+
+  /**
+   * @brief 缓冲池调整大小之后，更新预期管理的页帧个数，参考 create
+   */
+  virtual void resize(int capacity) {}
+
+public:
+  static const char *DEFAULT_NAME;
+
+  /**
+   * @brief 根据名字创建置换策略
+   *
+   * @param name     策略名字，为空时使用默认的LRU
+   * @param capacity 预期最多管理多少个页帧，有些策略会根据这个值调整各个队列的大小
+   * @return 名字不认识时返回nullptr
+   */
+  static FrameReplacer *create(const char *name, int capacity);
+};
+
+/**
+ * @brief 通过 FrameReplacerHook 串起来的页帧双向链表
+ * @ingroup BufferPool
+ * @details 头部是最新放入的页帧，尾部是最早放入的页帧
+ */
+class FrameList
+{
+public:
+  void   push_front(Frame *frame);
+  void   remove(Frame *frame);
+  void   move_to_front(Frame *frame);
+  Frame *front() const { return front_; }
+  Frame *tail() const { return tail_; }
+  size_t size() const { return size_; }
+
+  /**
+   * @brief 从尾部(最旧的)开始遍历
+   * @return 遍历被中途停止时返回false
+   */
+  bool foreach_reverse(std::function<bool(Frame *)> &func);
+
+private:
+  Frame *front_ = nullptr;
+  Frame *tail_  = nullptr;
+  size_t size_  = 0;
+};
+
+/**
+ * @brief 最近最少使用
+ * @ingroup BufferPool
+ */
+class LruFrameReplacer : public FrameReplacer
+{
+public:
+  const char *name() const override { return "lru"; }
+  void        insert(Frame *frame) override;
+  void        access(Frame *frame) override;
+  void        remove(Frame *frame) override;
+  void        foreach_victim(std::function<bool(Frame *)> func) override;
+  size_t      size() const override { return list_.size(); }
+
+private:
+  FrameList list_;
+};
+
+/**
+ * @brief 时钟算法
+ * @ingroup BufferPool
+ * @details 页帧放在一个环形数组中，命中时设置访问位。淘汰时时钟指针转动，
+ * 遇到访问位为1的页帧就清除访问位跳过，遇到访问位为0的页帧就淘汰。
+ */
+class ClockFrameReplacer : public FrameReplacer
+{
+public:
+  const char *name() const override { return "clock"; }
+  void        insert(Frame *frame) override;
+  void        access(Frame *frame) override;
+  void        remove(Frame *frame) override;
+  void        foreach_victim(std::function<bool(Frame *)> func) override;
+  void        foreach_candidate(std::function<bool(Frame *)> func) override;
+  size_t      size() const override { return size_; }
+
+private:
+  std::vector<Frame *> slots_;
+  std::vector<int>     free_slots_;
+  size_t               hand_ = 0;
+  size_t               size_ = 0;
+};
+
+/**
+ * @brief LRU-K，这里K=2
+ * @ingroup BufferPool
+ * @details 访问次数不足K次的页帧放在历史链表中按照最近访问时间排序，总是先淘汰。
+ * 访问次数达到K次的页帧按照倒数第K次访问时间排序，时间越早越先淘汰。
+ */
+class LruKFrameReplacer : public FrameReplacer
+{
+public:
+  const char *name() const override { return "lru-k"; }
+  void        insert(Frame *frame) override;
+  void        access(Frame *frame) override;
+  void        remove(Frame *frame) override;
+  void        foreach_victim(std::function<bool(Frame *)> func) override;
+  size_t      size() const override { return history_list_.size() + cache_frames_.size(); }
+
+private:
+  uint64_t                   current_time_ = 0;  ///< 逻辑时间，每次访问加1
+  FrameList                  history_list_;      ///< 访问次数不足K次的页帧
+  std::map<uint64_t, Frame *> cache_frames_;     ///< 按照倒数第K次访问时间排序的页帧
+};
+
+/**
+ * @brief 2Q 算法
+ * @ingroup BufferPool
+ * @details 新页面放入 A1in(FIFO)，A1in 中的页面被淘汰时把页面编号记录到 A1out 中，显式释放的页面不记录。
+ * 如果页面再次被加载时编号还在 A1out 中，说明它不是只访问一次的页面，直接放入 Am(LRU)。
+ * A1in 中的页面命中时不做任何事情。
+ */
+class TwoQueueFrameReplacer : public FrameReplacer
+{
+public:
+  explicit TwoQueueFrameReplacer(int capacity);
+
+  const char *name() const override { return "2q"; }
+  void        insert(Frame *frame) override;
+  void        access(Frame *frame) override;
+  void        remove(Frame *frame) override;
+  void        evict(Frame *frame) override;
+  void        foreach_victim(std::function<bool(Frame *)> func) override;
+  size_t      size() const override { return a1in_.size() + am_.size(); }
+  void        resize(int capacity) override;
+
+private:
+  class FrameIdHasher
+  {
+  public:
+    size_t operator()(const FrameId &frame_id) const { return frame_id.hash(); }
+  };
+
+  size_t    a1in_capacity_;   ///< A1in 超过这个大小时，优先从 A1in 中淘汰
+  size_t    a1out_capacity_;  ///< A1out 最多记录多少个页面编号
+  FrameList a1in_;
+  FrameList am_;
+
+  std::list<FrameId> a1out_;
+  std::unordered_map<FrameId, std::list<FrameId>::iterator, FrameIdHasher> a1out_index_;
+};
@@ -0,0 +1,151 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <chrono>
+#include <vector>
+
+#include "storage/buffer/page_cleaner.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "common/log/log.h"
+
+using namespace std;
+
+PageCleaner::PageCleaner(BufferPoolManager &bp_manager, BPFrameManager &frame_manager)
+    : bp_manager_(bp_manager), frame_manager_(frame_manager)
+{}
+
+PageCleaner::~PageCleaner()
+{
+  stop();
+}
+
+RC PageCleaner::start(int low_watermark, int high_watermark, int interval_ms)
+{
+  if (running_) {
+    LOG_WARN("page cleaner is already running");
+    return RC::INTERNAL;
+  }
+
+  if (low_watermark <= 0 || high_watermark < low_watermark) {
+    LOG_WARN("invalid page cleaner watermark. low=%d, high=%d", low_watermark, high_watermark);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  low_watermark_  = low_watermark;
+  high_watermark_ = high_watermark;
+  interval_ms_    = interval_ms > 0 ? interval_ms : 100;
+
+#ifndef CONCURRENCY
+  // 没有开启并发模式时，各种锁都是空操作，不能启动后台线程
+  LOG_INFO("page cleaner thread is disabled because CONCURRENCY is off");
+  return RC::SUCCESS;
+#endif
+
+  running_ = true;
+  thread_  = thread(&PageCleaner::thread_func, this);
+  LOG_INFO("page cleaner started. low watermark=%d, high watermark=%d, interval=%dms",
+           low_watermark_.load(), high_watermark_.load(), interval_ms_);
+  return RC::SUCCESS;
+}
+
+void PageCleaner::set_watermarks(int low_watermark, int high_watermark)
+{
+  if (low_watermark <= 0 || high_watermark < low_watermark) {
+    LOG_WARN("invalid page cleaner watermark. low=%d, high=%d", low_watermark, high_watermark);
+    return;
+  }
+
+  low_watermark_  = low_watermark;
+  high_watermark_ = high_watermark;
+  LOG_INFO("page cleaner watermarks changed. low watermark=%d, high watermark=%d", low_watermark, high_watermark);
+}
+
+void PageCleaner::stop()
+{
+  {
+    lock_guard<mutex> guard(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  cond_.notify_all();
+
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  LOG_INFO("page cleaner stopped");
+}
+
+void PageCleaner::notify()
+{
+  if (!running_ || frame_manager_.free_frame_num() >= low_watermark_) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> guard(mutex_);
+    wakeup_ = true;
+  }
+  cond_.notify_one();
+}
+
+void PageCleaner::thread_func()
+{
+  LOG_INFO("page cleaner thread started");
+
+  unique_lock<mutex> lock(mutex_);
+  while (running_) {
+    cond_.wait_for(lock, chrono::milliseconds(interval_ms_), [this]() { return !running_ || wakeup_; });
+    wakeup_ = false;
+    if (!running_) {
+      break;
+    }
+
+    lock.unlock();
+    clean_once();
+    lock.lock();
+  }
+
+  LOG_INFO("page cleaner thread exit");
+}
+
+int PageCleaner::clean_once(bool force /* = false */)
+{
+  const int free_num = frame_manager_.free_frame_num();
+  if (!force && free_num >= low_watermark_) {
+    return 0;
+  }
+
+  const int count = high_watermark_ - free_num;
+  if (count <= 0) {
+    return 0;
+  }
+
+  // 先把淘汰顺序上靠前的脏页刷到磁盘，刷盘时不持有页帧表的锁
+  vector<FrameId> dirty_frames;
+  frame_manager_.find_dirty_victims(count, dirty_frames);
+
+  int flushed_num = 0;
+  for (const FrameId &frame_id : dirty_frames) {
+    RC rc = bp_manager_.clean_page(frame_id);
+    if (OB_SUCC(rc)) {
+      flushed_num++;
+    } else {
+      LOG_TRACE("failed to clean page. frame id=%s, rc=%s", to_string(frame_id).c_str(), strrc(rc));
+    }
+  }
+
+  // 再释放干净的页面。刷盘之后又被修改过的页面会跳过，留给下一轮处理
+  const int freed_num = frame_manager_.purge_clean_frames(count);
+  LOG_DEBUG("page cleaner done one round. free frames=%d, flushed=%d, freed=%d",
+            free_num, flushed_num, freed_num);
+  return freed_num;
+}
@@ -0,0 +1,91 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "common/rc.h"
+
+class BufferPoolManager;
+class BPFrameManager;
+
+/**
+ * @brief 后台刷脏页的线程
+ * @ingroup BufferPool
+ * @details 页帧都用完时，前台线程需要淘汰一些页面才能加载新页面，如果淘汰的页面是脏的，
+ * 就要先同步写到磁盘上，这会让一个普通的读请求也要等待写IO。
+ * 后台清理线程按照置换策略给出的淘汰顺序，提前把即将被淘汰的脏页刷到磁盘，再把这些干净的页面
+ * 释放掉，让空闲页帧的个数保持在低水位和高水位之间：
+ * - 空闲页帧少于低水位时，前台线程会唤醒清理线程，清理线程也会定期醒来检查；
+ * - 每次清理一直释放到空闲页帧达到高水位。
+ * 这样前台分配页帧时基本上都能直接拿到空闲页帧，即使没有空闲页帧，也有很大概率淘汰一个干净的页面，
+ * 不需要做IO。
+ * 只有在编译时开启了 CONCURRENCY 才会启动后台线程。
+ */
+class PageCleaner
+{
+public:
+  PageCleaner(BufferPoolManager &bp_manager, BPFrameManager &frame_manager);
+  ~PageCleaner();
+
+  /**
+   * @brief 设置水位线并启动后台线程
+   *
+   * @param low_watermark  空闲页帧的个数低于这个值时开始清理
+   * @param high_watermark 每次清理到空闲页帧的个数达到这个值为止
+   * @param interval_ms    后台线程定期检查的时间间隔
+   */
+  RC start(int low_watermark, int high_watermark, int interval_ms);
+  void stop();
+
+  bool running() const { return running_; }
+
+  /**
+   * @brief 前台线程分配页帧后调用，空闲页帧低于低水位时唤醒后台线程
+   */
+  void notify();
+
+  /**
+   * @brief 执行一轮清理
+   * @details 后台线程会调用这个函数，测试时也可以直接调用
+   * @param force 即使空闲页帧没有低于低水位也执行清理
+   * @return 本轮释放了多少个页帧
+   */
+  int clean_once(bool force = false);
+
+  int low_watermark() const { return low_watermark_; }
+  int high_watermark() const { return high_watermark_; }
+
+  /**
+   * @brief 缓冲池调整大小之后重新设置水位线
+   */
+  void set_watermarks(int low_watermark, int high_watermark);
+
+private:
+  void thread_func();
+
+private:
+  BufferPoolManager &bp_manager_;
+  BPFrameManager    &frame_manager_;
+
+  std::atomic<int> low_watermark_{0};
+  std::atomic<int> high_watermark_{0};
+  int interval_ms_    = 100;
+
+  std::atomic<bool>       running_{false};
+  bool                    wakeup_ = false;
+  std::mutex              mutex_;
+  std::condition_variable cond_;
+  std::thread             thread_;
+};
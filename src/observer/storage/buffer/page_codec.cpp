@@ -0,0 +1,232 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "storage/buffer/page_codec.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+
+using namespace std;
+
+unique_ptr<PageCodec> PageCodec::create(const char *name)
+{
+  if (!enabled(name)) {
+    return nullptr;
+  }
+
+  if (0 == strcasecmp(name, "lz")) {
+    return make_unique<LzPageCodec>();
+  }
+
+  LOG_ERROR("unknown page codec name. name=%s", name);
+  return nullptr;
+}
+
+bool PageCodec::enabled(const char *name)
+{
+  return !common::is_blank(name) && 0 != strcasecmp(name, "none");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+inline uint32_t load32(const char *p)
+{
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t hash32(uint32_t value)
+{
+  return (value * 2654435761U) >> (32 - LzPageCodec::HASH_BITS);
+}
+
+/**
+ * @brief 写入超过15的那部分长度，每个字节最多255
+ */
+inline bool write_length(char *&op, const char *op_end, int length)
+{
+  while (length >= 255) {
+    if (op >= op_end) {
+      return false;
+    }
+    *op++ = static_cast<char>(255);
+    length -= 255;
+  }
+  if (op >= op_end) {
+    return false;
+  }
+  *op++ = static_cast<char>(length);
+  return true;
+}
+
+inline bool read_length(const char *&ip, const char *ip_end, int &length)
+{
+  uint8_t byte = 0;
+  do {
+    if (ip >= ip_end) {
+      return false;
+    }
+    byte = static_cast<uint8_t>(*ip++);
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * @brief 输出一个序列。match_length 为0时表示最后一个只有字面量的序列
+ */
+bool write_sequence(char *&op, const char *op_end, const char *literal, int literal_length, int offset, int match_length)
+{
+  if (op >= op_end) {
+    return false;
+  }
+
+  char *token = op++;
+  const int literal_code = literal_length < 15 ? literal_length : 15;
+  int match_code = 0;
+  if (match_length > 0) {
+    const int code = match_length - LzPageCodec::MIN_MATCH;
+    match_code = code < 15 ? code : 15;
+  }
+  *token = static_cast<char>((literal_code << 4) | match_code);
+
+  if (literal_code == 15 && !write_length(op, op_end, literal_length - 15)) {
+    return false;
+  }
+  if (op_end - op < literal_length) {
+    return false;
+  }
+  memcpy(op, literal, literal_length);
+  op += literal_length;
+
+  if (match_length == 0) {
+    return true;
+  }
+
+  if (op_end - op < 2) {
+    return false;
+  }
+  *op++ = static_cast<char>(offset & 0xFF);
+  *op++ = static_cast<char>((offset >> 8) & 0xFF);
+  if (match_code == 15 && !write_length(op, op_end, match_length - LzPageCodec::MIN_MATCH - 15)) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int LzPageCodec::compress(const char *src, int src_len, char *dst, int dst_capacity) const
+{
+  if (src_len < 0 || src_len > MAX_INPUT_SIZE) {
+    LOG_WARN("invalid input length for lz codec. length=%d", src_len);
+    return 0;
+  }
+
+  // 哈希表中保存的是位置加1，0表示没有
+  uint16_t table[1 << HASH_BITS];
+  memset(table, 0, sizeof(table));
+
+  const char *op_end  = dst + dst_capacity;
+  char       *op      = dst;
+  int         anchor  = 0;  // 还没有输出的字面量的起始位置
+  int         pos     = 0;
+  const int   mflimit = src_len - MIN_MATCH;
+
+  while (pos <= mflimit) {
+    const uint32_t sequence = load32(src + pos);
+    const uint32_t hash     = hash32(sequence);
+    const int      ref      = static_cast<int>(table[hash]) - 1;
+    table[hash]             = static_cast<uint16_t>(pos + 1);
+
+    if (ref < 0 || load32(src + ref) != sequence) {
+      pos++;
+      continue;
+    }
+
+    int match_length = MIN_MATCH;
+    while (pos + match_length < src_len && src[ref + match_length] == src[pos + match_length]) {
+      match_length++;
+    }
+
+    if (!write_sequence(op, op_end, src + anchor, pos - anchor, pos - ref, match_length)) {
+      return 0;
+    }
+    pos += match_length;
+    anchor = pos;
+  }
+
+  if (!write_sequence(op, op_end, src + anchor, src_len - anchor, 0, 0)) {
+    return 0;
+  }
+  return static_cast<int>(op - dst);
+}
+
+RC LzPageCodec::decompress(const char *src, int src_len, char *dst, int dst_len) const
+{
+  const char *ip     = src;
+  const char *ip_end = src + src_len;
+  char       *op     = dst;
+  char       *op_end = dst + dst_len;
+
+  while (ip < ip_end) {
+    const uint8_t token = static_cast<uint8_t>(*ip++);
+
+    int literal_length = token >> 4;
+    if (literal_length == 15 && !read_length(ip, ip_end, literal_length)) {
+      break;
+    }
+    if (ip_end - ip < literal_length || op_end - op < literal_length) {
+      break;
+    }
+    memcpy(op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+
+    if (ip == ip_end) {
+      // 最后一个序列只有字面量
+      if (op == op_end) {
+        return RC::SUCCESS;
+      }
+      break;
+    }
+
+    if (ip_end - ip < 2) {
+      break;
+    }
+    const int offset = static_cast<uint8_t>(ip[0]) | (static_cast<uint8_t>(ip[1]) << 8);
+    ip += 2;
+
+    int match_length = token & 0x0F;
+    if (match_length == 15 && !read_length(ip, ip_end, match_length)) {
+      break;
+    }
+    match_length += MIN_MATCH;
+
+    if (offset == 0 || offset > op - dst || op_end - op < match_length) {
+      break;
+    }
+    // 匹配的区域可能与输出重叠，只能逐个字节复制
+    const char *match = op - offset;
+    for (int i = 0; i < match_length; i++) {
+      op[i] = match[i];
+    }
+    op += match_length;
+  }
+
+  LOG_WARN("corrupted lz data. input length=%d, expected output length=%d, output length=%d",
+           src_len, dst_len, static_cast<int>(op - dst));
+  return RC::IOERR_READ;
+}
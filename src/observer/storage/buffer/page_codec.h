@@ -0,0 +1,78 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <memory>
+
+#include "common/rc.h"
+
+/**
+ * @brief 页面压缩算法
+ * @ingroup BufferPool
+ * @details 压缩的数据文件在写磁盘之前压缩页面，读出来之后再解压，内存中的页面格式不变，参考 CompressedPageFile。
+ * 通过名字创建，目前只有内置的 lz。"none" 或者空字符串表示不压缩。
+ */
+class PageCodec
+{
+public:
+  static constexpr const char *DEFAULT_NAME = "lz";
+
+public:
+  virtual ~PageCodec() = default;
+
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief 压缩数据
+   * @param dst_capacity 输出缓冲区的大小
+   * @return 压缩后的长度。输出缓冲区放不下时返回0，这时应该保存原始数据
+   */
+  virtual int compress(const char *src, int src_len, char *dst, int dst_capacity) const = 0;
+
+  /**
+   * @brief 解压数据
+   * @param dst_len 原始数据的长度，解压出来的长度必须与它相同，否则认为数据已经损坏
+   */
+  virtual RC decompress(const char *src, int src_len, char *dst, int dst_len) const = 0;
+
+public:
+  /**
+   * @brief 根据名字创建压缩算法，不区分大小写。名字不合法或者表示不压缩时返回nullptr
+   */
+  static std::unique_ptr<PageCodec> create(const char *name);
+
+  /**
+   * @brief 名字是否表示需要压缩
+   */
+  static bool enabled(const char *name);
+};
+
+/**
+ * @brief 内置的 LZ77 类压缩算法
+ * @ingroup BufferPool
+ * @details 编码格式与 LZ4 的 block 格式类似：每个序列由一个标记字节开始，高4位是字面量的长度，低4位是匹配长度减4，
+ * 长度达到15时后面用若干个字节继续累加，直到某个字节不是255。然后是字面量和2字节(小端)的匹配距离。
+ * 最后一个序列只有字面量。
+ * 使用一个哈希表查找4字节的重复串，只做贪心匹配，速度优先。
+ * 页面中大量的填充字节和重复的定长字段都能很好地压缩。输入的长度不能超过64KB。
+ */
+class LzPageCodec : public PageCodec
+{
+public:
+  static constexpr int MAX_INPUT_SIZE = 65535;
+  static constexpr int MIN_MATCH      = 4;
+  static constexpr int HASH_BITS      = 12;
+
+public:
+  const char *name() const override { return "lz"; }
+  int         compress(const char *src, int src_len, char *dst, int dst_capacity) const override;
+  RC          decompress(const char *src, int src_len, char *dst, int dst_len) const override;
+};
@@ -0,0 +1,179 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <algorithm>
+
+#include "storage/buffer/read_ahead.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "common/log/log.h"
+
+using namespace std;
+
+ReadAheadWorker::~ReadAheadWorker()
+{
+  stop();
+}
+
+RC ReadAheadWorker::start()
+{
+  if (running_) {
+    LOG_WARN("read ahead worker is already running");
+    return RC::INTERNAL;
+  }
+
+#ifndef CONCURRENCY
+  // 没有开启并发模式时，各种锁都是空操作，不能启动后台线程
+  LOG_INFO("read ahead thread is disabled because CONCURRENCY is off");
+  return RC::SUCCESS;
+#endif
+
+  running_ = true;
+  thread_  = thread(&ReadAheadWorker::thread_func, this);
+  LOG_INFO("read ahead worker started");
+  return RC::SUCCESS;
+}
+
+void ReadAheadWorker::stop()
+{
+  {
+    lock_guard<mutex> guard(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+    requests_.clear();
+  }
+  cond_.notify_all();
+
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  idle_cond_.notify_all();
+  LOG_INFO("read ahead worker stopped");
+}
+
+void ReadAheadWorker::submit(DiskBufferPool *buffer_pool, const vector<PageNum> &page_nums)
+{
+  if (!running_ || page_nums.empty()) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> guard(mutex_);
+    for (PageNum page_num : page_nums) {
+      if (requests_.size() >= MAX_PENDING_PAGES) {
+        LOG_TRACE("too many pending read ahead pages, drop the others");
+        break;
+      }
+      requests_.push_back(Request{buffer_pool, page_num});
+    }
+  }
+  cond_.notify_one();
+}
+
+void ReadAheadWorker::cancel(DiskBufferPool *buffer_pool)
+{
+  unique_lock<mutex> lock(mutex_);
+  auto iter = remove_if(requests_.begin(), requests_.end(), [buffer_pool](const Request &request) {
+    return request.buffer_pool == buffer_pool;
+  });
+  requests_.erase(iter, requests_.end());
+
+  idle_cond_.wait(lock, [this, buffer_pool]() { return working_buffer_pool_ != buffer_pool; });
+}
+
+void ReadAheadWorker::wait_idle()
+{
+  unique_lock<mutex> lock(mutex_);
+  idle_cond_.wait(lock, [this]() { return !running_ || (requests_.empty() && working_buffer_pool_ == nullptr); });
+}
+
+void ReadAheadWorker::thread_func()
+{
+  LOG_INFO("read ahead thread started");
+
+  vector<PageNum>    page_nums;
+  unique_lock<mutex> lock(mutex_);
+  while (running_) {
+    cond_.wait(lock, [this]() { return !running_ || !requests_.empty(); });
+    if (!running_) {
+      break;
+    }
+
+    // 同一个文件的连续请求一起交给 DiskBufferPool，可以一次提交多个IO
+    DiskBufferPool *buffer_pool = requests_.front().buffer_pool;
+    page_nums.clear();
+    while (!requests_.empty() && requests_.front().buffer_pool == buffer_pool &&
+           static_cast<int>(page_nums.size()) < MAX_BATCH_PAGES) {
+      page_nums.push_back(requests_.front().page_num);
+      requests_.pop_front();
+    }
+    working_buffer_pool_ = buffer_pool;
+    lock.unlock();
+
+    RC rc = buffer_pool->prefetch_pages(page_nums);
+    if (OB_FAIL(rc)) {
+      LOG_TRACE("failed to read ahead pages. first page num=%d, count=%d, rc=%s",
+                page_nums.front(), static_cast<int>(page_nums.size()), strrc(rc));
+    }
+
+    lock.lock();
+    working_buffer_pool_ = nullptr;
+    idle_cond_.notify_all();
+  }
+
+  LOG_INFO("read ahead thread exit");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ReadAhead::init(DiskBufferPool &buffer_pool)
+{
+  buffer_pool_ = &buffer_pool;
+  window_      = buffer_pool.read_ahead_pages();
+  reset();
+}
+
+void ReadAhead::reset()
+{
+  sequential_count_ = 0;
+  last_page_num_    = BP_INVALID_PAGE_NUM;
+  read_ahead_end_   = BP_INVALID_PAGE_NUM;
+}
+
+void ReadAhead::access(PageNum page_num)
+{
+  if (nullptr == buffer_pool_ || window_ <= 0 || page_num == BP_INVALID_PAGE_NUM) {
+    return;
+  }
+
+  // 中间有一些没有分配的页面也算顺序访问
+  if (last_page_num_ != BP_INVALID_PAGE_NUM && page_num > last_page_num_ && page_num - last_page_num_ <= window_) {
+    sequential_count_++;
+  } else {
+    sequential_count_ = 0;
+    read_ahead_end_   = BP_INVALID_PAGE_NUM;
+  }
+  last_page_num_ = page_num;
+
+  if (sequential_count_ < SEQUENTIAL_THRESHOLD) {
+    return;
+  }
+
+  // 已经预读但还没有访问的页面不到半个窗口时，才预读下一批
+  if (read_ahead_end_ != BP_INVALID_PAGE_NUM && read_ahead_end_ - page_num >= window_ / 2) {
+    return;
+  }
+
+  const PageNum start_page = max(page_num, read_ahead_end_) + 1;
+  const PageNum end_page   = buffer_pool_->read_ahead(start_page, window_);
+  if (end_page != BP_INVALID_PAGE_NUM) {
+    read_ahead_end_ = end_page;
+  }
+}
@@ -0,0 +1,112 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/rc.h"
+#include "common/types.h"
+#include "storage/buffer/page.h"
+
+class DiskBufferPool;
+
+/**
+ * @brief 执行预读请求的后台线程
+ * @ingroup BufferPool
+ * @details 扫描线程发现自己在顺序访问页面时，把后面的页面提交到这里，由后台线程提前加载到页帧中，
+ * 扫描线程真正访问到这些页面时就不需要再等待磁盘IO。
+ * 预读只是一个优化，队列满了、页帧不够或者加载失败时都直接放弃。
+ * 只有在编译时开启了 CONCURRENCY 才会启动后台线程，否则所有请求都会被丢弃。
+ */
+class ReadAheadWorker
+{
+public:
+  static constexpr int MAX_PENDING_PAGES = 1024;  ///< 队列中最多有多少个等待预读的页面
+  static constexpr int MAX_BATCH_PAGES   = 32;    ///< 一次最多加载多少个页面
+
+public:
+  ReadAheadWorker() = default;
+  ~ReadAheadWorker();
+
+  RC   start();
+  void stop();
+
+  bool running() const { return running_; }
+
+  /**
+   * @brief 提交一批需要预读的页面
+   */
+  void submit(DiskBufferPool *buffer_pool, const std::vector<PageNum> &page_nums);
+
+  /**
+   * @brief 丢弃某个文件还没有执行的预读请求，并等待这个文件正在执行的请求结束
+   * @details 关闭文件之前需要调用，后台线程不会再访问这个 DiskBufferPool
+   */
+  void cancel(DiskBufferPool *buffer_pool);
+
+  /**
+   * @brief 等待队列中的请求都执行完，测试使用
+   */
+  void wait_idle();
+
+private:
+  void thread_func();
+
+private:
+  struct Request
+  {
+    DiskBufferPool *buffer_pool;
+    PageNum         page_num;
+  };
+
+  std::atomic<bool>       running_{false};
+  std::mutex              mutex_;
+  std::condition_variable cond_;       ///< 有新的请求或者需要退出时通知后台线程
+  std::condition_variable idle_cond_;  ///< 一个请求执行完时通知等待的线程
+  std::deque<Request>     requests_;
+  DiskBufferPool         *working_buffer_pool_ = nullptr;  ///< 后台线程正在预读的文件
+  std::thread             thread_;
+};
+
+/**
+ * @brief 检测顺序访问并触发预读
+ * @ingroup BufferPool
+ * @details 每个扫描器(比如 BufferPoolIterator、B+树的扫描器)持有一个，每访问一个页面就调用一次 access。
+ * 连续几次都向后访问附近的页面时，认为是在顺序扫描，就预读后面已经分配的K个页面；
+ * 扫描快要用完已经预读的页面时，再预读下一批。访问的页面往回跳或者跳得很远时，重新开始检测。
+ * K 由 BufferPoolParam::read_ahead_pages 配置，为0时不预读。
+ */
+class ReadAhead
+{
+public:
+  static constexpr int SEQUENTIAL_THRESHOLD = 2;  ///< 连续多少次顺序访问后开始预读
+
+public:
+  void init(DiskBufferPool &buffer_pool);
+  void reset();
+
+  /**
+   * @brief 扫描器访问了一个页面
+   */
+  void access(PageNum page_num);
+
+private:
+  DiskBufferPool *buffer_pool_      = nullptr;
+  int             window_           = 0;  ///< 每次预读多少个页面
+  int             sequential_count_ = 0;
+  PageNum         last_page_num_    = BP_INVALID_PAGE_NUM;
+  PageNum         read_ahead_end_   = BP_INVALID_PAGE_NUM;  ///< 已经提交预读的最后一个页面
+};
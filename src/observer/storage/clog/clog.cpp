@@ -20,6 +20,7 @@ See the Mulan PSL v2 for more details. */
 #include "common/global_context.h"
 #include "storage/trx/trx.h"
 #include "common/io/io.h"
+#include "storage/common/io_backend.h"
 
 using namespace std;
 using namespace common;
@@ -226,41 +227,53 @@ RC CLogBuffer::flush_buffer(CLogFile &log_file)
 {
   RC rc = RC::SUCCESS;
   int count = 0;
+
+  vector<unique_ptr<CLogRecord>> log_records;
+  vector<struct iovec> iovs;
   while (!log_records_.empty()) {
+    // log buffer 需要支持并发，所以要考虑加锁
+    // 从队列中一次取出一批日志记录，一起交给IO后端按照顺序写入到文件中
     lock_.lock();
-    if (log_records_.empty()) {
-      lock_.unlock();
-      return RC::SUCCESS;
+    while (!log_records_.empty() && log_records.size() < FLUSH_BATCH_SIZE) {
+      log_records.push_back(std::move(log_records_.front()));
+      log_records_.pop_front();
     }
+    lock_.unlock();
 
-    // log buffer 需要支持并发，所以要考虑加锁
-    // 从队列中取出日志记录然后写入到文件中
-    unique_ptr<CLogRecord> log_record = std::move(log_records_.front());
-    log_records_.pop_front();
+    if (log_records.empty()) {
+      break;
+    }
+
+    iovs.clear();
+    for (const unique_ptr<CLogRecord> &log_record : log_records) {
+      collect_log_record(log_record.get(), iovs);
+    }
 
-    rc = write_log_record(log_file, log_record.get());
+    rc = log_file.write(iovs);
     // 当前无法处理日志写不完整的情况，所以直接粗暴退出
-    ASSERT(rc == RC::SUCCESS, "failed to write log record. log_record=%s, rc=%s",
-           log_record->to_string().c_str(), strrc(rc));
+    ASSERT(rc == RC::SUCCESS, "failed to write log records. first log_record=%s, count=%d, rc=%s",
+           log_records.front()->to_string().c_str(), static_cast<int>(log_records.size()), strrc(rc));
 
-    lock_.unlock();
-    total_size_ -= log_record->logrec_len();
-    count++;
+    for (const unique_ptr<CLogRecord> &log_record : log_records) {
+      total_size_ -= log_record->logrec_len();
+    }
+    count += static_cast<int>(log_records.size());
+    log_records.clear();
   }
 
   LOG_INFO("flush log buffer done. write log record number=%d", count);
   return log_file.sync();
 }
 
-RC CLogBuffer::write_log_record(CLogFile &log_file, CLogRecord *log_record)
+void CLogBuffer::collect_log_record(CLogRecord *log_record, vector<struct iovec> &iovs)
 {
   // TODO 看起来每种类型的日志自己实现 serialize 接口更好一点
+  auto append = [&iovs](const void *data, int len) {
+    iovs.push_back(iovec{const_cast<void *>(data), static_cast<size_t>(len)});
+  };
+
   const CLogRecordHeader &header = log_record->header();
-  RC rc = log_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
-  if (rc != RC::SUCCESS) {
-    LOG_WARN("failed to write log record header. size=%d, rc=%s", sizeof(header), strrc(rc));
-    return rc;
-  }
+  append(&header, sizeof(header));
 
   switch (log_record->log_type()) {
     case CLogType::MTR_BEGIN:
@@ -269,26 +282,16 @@ RC CLogBuffer::write_log_record(CLogFile &log_file, CLogRecord *log_record)
     } break;
 
     case CLogType::MTR_COMMIT: {
-      rc = log_file.write(reinterpret_cast<const char *>(&log_record->commit_record()), 
-                          log_record->header().logrec_len_);
+      append(&log_record->commit_record(), log_record->header().logrec_len_);
     } break;
 
     default: {
-      rc = log_file.write(reinterpret_cast<const char *>(&log_record->data_record()), CLogRecordData::HEADER_SIZE);
-      if (OB_FAIL(rc)) {
-        LOG_WARN("failed to write data record header. size=%d, rc=%s", CLogRecordData::HEADER_SIZE, strrc(rc));
-        return rc;
-      }
-
-      rc = log_file.write(log_record->data_record().data_, log_record->data_record().data_len_);
-      if (OB_FAIL(rc)) {
-        LOG_WARN("failed to write log data. size=%d, rc=%s", log_record->data_record().data_len_, strrc(rc));
-        return rc;
+      append(&log_record->data_record(), CLogRecordData::HEADER_SIZE);
+      if (log_record->data_record().data_len_ > 0) {
+        append(log_record->data_record().data_, log_record->data_record().data_len_);
       }
     } break;
   }
-
-  return rc;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -322,12 +325,26 @@ CLogFile::~CLogFile()
 
 RC CLogFile::write(const char *data, int len)
 {
-  int ret = writen(fd_, data, len);
-  if (0 != ret) {
-    LOG_WARN("failed to write data to file. filename=%s, data len=%d, error=%s", filename_.c_str(), len, strerror(ret));
-    return RC::IOERR_WRITE;
+  // 日志文件是以 O_APPEND 方式打开的，不指定偏移量，追加到文件末尾
+  IoRequest request = IoRequest::write(fd_, data, len, -1 /*offset*/);
+  RC rc = IoBackend::instance().submit(&request, 1);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to write data to file. filename=%s, data len=%d, error=%s",
+             filename_.c_str(), len, strerror(request.error));
   }
-  return RC::SUCCESS;
+  return rc;
+}
+
+RC CLogFile::write(const vector<struct iovec> &iovs)
+{
+  // 一次 writev 追加到文件末尾，不需要把每一块拆成单独的请求再串起来
+  IoRequest request = IoRequest::writev(fd_, iovs.data(), static_cast<int>(iovs.size()), -1 /*offset*/);
+  RC rc = IoBackend::instance().submit(&request, 1);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to write data to file. filename=%s, piece num=%d, error=%s",
+             filename_.c_str(), static_cast<int>(iovs.size()), strerror(request.error));
+  }
+  return rc;
 }
 
 RC CLogFile::read(char *data, int len)
@@ -487,7 +504,19 @@ RC CLogManager::append_log(CLogRecord *log_record)
   if (nullptr == log_record) {
     return RC::INVALID_ARGUMENT;
   }
-  return log_buffer_->append_log_record(log_record);
+
+  RC rc = log_buffer_->append_log_record(log_record);
+  if (rc == RC::LOGBUF_FULL) {
+    rc = sync();
+    if (OB_SUCC(rc)) {
+      rc = log_buffer_->append_log_record(log_record);
+    }
+  }
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to append log record. log_record={%s}, rc=%s", log_record->to_string().c_str(), strrc(rc));
+    delete log_record;
+  }
+  return rc;
 }
 
 RC CLogManager::sync()
@@ -22,6 +22,8 @@ See the Mulan PSL v2 for more details. */
 #include <deque>
 #include <memory>
 #include <string>
+#include <vector>
+#include <sys/uio.h>
 
 #include "storage/record/record.h"
 #include "storage/persist/persist.h"
@@ -56,7 +58,8 @@ class Db;
   DEFINE_CLOG_TYPE(MTR_ROLLBACK)      \
   DEFINE_CLOG_TYPE(INSERT)            \
   DEFINE_CLOG_TYPE(UPDATE)            \
-  DEFINE_CLOG_TYPE(DELETE)
+  DEFINE_CLOG_TYPE(DELETE)            \
+  DEFINE_CLOG_TYPE(INSERT_BATCH)
 
 enum class CLogType 
 { 
@@ -122,6 +125,8 @@ struct CLogRecordCommitData
  * @brief 有具体数据修改的事务日志数据
  * @ingroup CLog
  * @details 这里记录的都是操作的记录，比如插入、删除一条数据。
+ * INSERT_BATCH 日志一次记录同一张表上插入的多条数据，rid_ 是第一条记录的位置，
+ * data_ 中依次存放每条记录的 RID 和完整的记录内容，每条记录的长度就是表的记录长度。
  */
 struct CLogRecordData
 {
@@ -256,12 +261,15 @@ public:
 
 private:
   /**
-   * @brief 将日志记录写入到日志文件中
+   * @brief 把日志记录需要写入的各段数据放到 iovs 中
    * 
-   * @param log_file 日志文件，概念上来讲不一定是某个特定的文件
    * @param log_record 要写入的日志记录
+   * @param iovs       日志记录的数据，写完之前 log_record 不能释放
    */
-  RC write_log_record(CLogFile &log_file, CLogRecord *log_record);
+  void collect_log_record(CLogRecord *log_record, std::vector<struct iovec> &iovs);
+
+private:
+  static constexpr size_t FLUSH_BATCH_SIZE = 64;  ///< 一次最多写入多少条日志记录
 
 private:
   common::Mutex lock_;  ///< 加锁支持多线程并发写入
@@ -297,6 +305,12 @@ public:
    */
   RC write(const char *data, int len);
 
+  /**
+   * @brief 按照顺序写入多段数据，作为一个向量写请求提交给IO后端
+   * @details 段数不能超过 IOV_MAX。每条日志最多3段，FLUSH_BATCH_SIZE 条日志远小于这个限制
+   */
+  RC write(const std::vector<struct iovec> &iovs);
+
   /**
    * @brief 读取指定长度的数据。全部读取成功返回成功，否则返回失败
    * @details 与 write 有类似的问题。如果读取到了文件尾，会标记eof，可以通过eof()函数来判断。
@@ -402,6 +416,7 @@ public:
 
   /**
    * @brief 也可以调用这个函数直接增加一条日志
+   * @details 日志缓冲区满了时先把缓冲区中的日志写到文件中再重试。失败时日志记录会被释放
    */
   RC append_log(CLogRecord *log_record);
 
@@ -0,0 +1,430 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <algorithm>
+
+#include "storage/common/io_backend.h"
+#include "common/log/log.h"
+
+using namespace std;
+
+static SyncIoBackend default_io_backend;
+static IoBackend    *io_backend_instance = nullptr;
+
+void IoBackend::set_instance(IoBackend *backend)
+{
+  io_backend_instance = backend;
+}
+
+IoBackend &IoBackend::instance()
+{
+  return io_backend_instance != nullptr ? *io_backend_instance : default_io_backend;
+}
+
+unique_ptr<IoBackend> IoBackend::create(const char *name)
+{
+  if (0 == strcasecmp(name, "sync")) {
+    return make_unique<SyncIoBackend>();
+  }
+
+  if (0 == strcasecmp(name, "io_uring")) {
+    auto backend = make_unique<IoUringBackend>();
+    RC rc = backend->init();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("io_uring is not available, use sync io instead. rc=%s", strrc(rc));
+      return make_unique<SyncIoBackend>();
+    }
+    return backend;
+  }
+
+  LOG_WARN("unknown io backend: %s", name);
+  return nullptr;
+}
+
+RC IoBackend::read(int fd, void *buf, int size, int64_t offset)
+{
+  IoRequest request = IoRequest::read(fd, buf, size, offset);
+  return submit(&request, 1);
+}
+
+RC IoBackend::write(int fd, const void *buf, int size, int64_t offset)
+{
+  IoRequest request = IoRequest::write(fd, buf, size, offset);
+  return submit(&request, 1);
+}
+
+RC IoBackend::sync(int fd)
+{
+  int ret = 0;
+  do {
+    ret = ::fsync(fd);
+  } while (ret < 0 && errno == EINTR);
+
+  if (ret < 0) {
+    LOG_ERROR("failed to sync file. fd=%d, error=%s", fd, strerror(errno));
+    return RC::IOERR_SYNC;
+  }
+  return RC::SUCCESS;
+}
+
+/**
+ * @brief 向量请求中还没有完成的部分
+ */
+static void remaining_iov(const IoRequest &request, vector<struct iovec> &iov)
+{
+  iov.clear();
+  size_t skip = request.done;
+  for (int i = 0; i < request.iov_count; i++) {
+    const struct iovec &item = request.iov[i];
+    if (skip >= item.iov_len) {
+      skip -= item.iov_len;
+      continue;
+    }
+    iov.push_back({static_cast<char *>(item.iov_base) + skip, item.iov_len - skip});
+    skip = 0;
+  }
+}
+
+/// 连续多少次 EINTR/EAGAIN 没有任何进展之后放弃
+static constexpr int MAX_IO_RETRY = 16;
+
+void IoBackend::complete_sync(IoRequest &request)
+{
+  vector<struct iovec> iov;
+  int                  retry = 0;
+  while (request.error == 0 && request.done < request.size) {
+    char   *buf  = request.buf + request.done;
+    size_t  size = request.size - request.done;
+    ssize_t ret  = 0;
+    if (request.iov != nullptr) {
+      remaining_iov(request, iov);
+      const int iov_count = std::min(static_cast<int>(iov.size()), IOV_MAX);
+      if (request.offset < 0) {
+        ret = request.type == IoRequest::Type::READ ? ::readv(request.fd, iov.data(), iov_count)
+                                                    : ::writev(request.fd, iov.data(), iov_count);
+      } else {
+        ret = request.type == IoRequest::Type::READ
+                  ? ::preadv(request.fd, iov.data(), iov_count, request.offset + request.done)
+                  : ::pwritev(request.fd, iov.data(), iov_count, request.offset + request.done);
+      }
+    } else if (request.type == IoRequest::Type::READ) {
+      ret = request.offset < 0 ? ::read(request.fd, buf, size)
+                               : ::pread(request.fd, buf, size, request.offset + request.done);
+    } else {
+      ret = request.offset < 0 ? ::write(request.fd, buf, size)
+                               : ::pwrite(request.fd, buf, size, request.offset + request.done);
+    }
+
+    if (ret > 0) {
+      request.done += ret;
+      retry = 0;
+    } else if (ret == 0) {
+      // 读到0字节是文件尾，写入0字节不会再有进展
+      request.error = request.type == IoRequest::Type::READ ? -1 : EIO;
+    } else if ((errno != EINTR && errno != EAGAIN) || ++retry > MAX_IO_RETRY) {
+      request.error = errno;
+    }
+  }
+}
+
+RC IoBackend::result_of(const IoRequest *requests, int count)
+{
+  for (int i = 0; i < count; i++) {
+    if (requests[i].error != 0) {
+      return requests[i].type == IoRequest::Type::READ ? RC::IOERR_READ : RC::IOERR_WRITE;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RC SyncIoBackend::submit(IoRequest *requests, int count)
+{
+  for (int i = 0; i < count; i++) {
+    complete_sync(requests[i]);
+  }
+  return result_of(requests, count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @brief 一个 io_uring 实例
+ * @details 提交队列和完成队列都是与内核共享的内存，参考 io_uring_setup(2)
+ */
+class IoUring
+{
+public:
+  ~IoUring();
+
+  RC init(unsigned entries);
+
+  bool try_lock()
+  {
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+    if (broken_) {
+      mutex_.unlock();
+      return false;
+    }
+    return true;
+  }
+  void unlock() { mutex_.unlock(); }
+
+  unsigned entries() const { return sq_entries_; }
+
+  /**
+   * @brief 提交一批请求并等待全部完成，个数不能超过队列的大小
+   * @details 内核没有完成的部分留在请求中，由调用者处理
+   */
+  RC run(IoRequest *requests, int count);
+
+private:
+  int        ring_fd_    = -1;
+  unsigned   sq_entries_ = 0;
+  bool       broken_     = false;  ///< 与内核交互出错后不再使用
+  std::mutex mutex_;
+
+  void  *sq_ptr_    = nullptr;
+  size_t sq_size_   = 0;
+  void  *cq_ptr_    = nullptr;
+  size_t cq_size_   = 0;
+  void  *sqes_ptr_  = nullptr;
+  size_t sqes_size_ = 0;
+
+  unsigned            *sq_head_  = nullptr;
+  unsigned            *sq_tail_  = nullptr;
+  unsigned            *sq_mask_  = nullptr;
+  unsigned            *sq_array_ = nullptr;
+  struct io_uring_sqe *sqes_     = nullptr;
+  unsigned            *cq_head_  = nullptr;
+  unsigned            *cq_tail_  = nullptr;
+  unsigned            *cq_mask_  = nullptr;
+  struct io_uring_cqe *cqes_     = nullptr;
+
+  std::vector<struct iovec> iovecs_;
+  std::vector<bool>         reaped_;  ///< 当前这批请求中哪些已经拿到了内核返回的结果
+};
+
+IoUring::~IoUring()
+{
+  if (sqes_ptr_ != nullptr) {
+    munmap(sqes_ptr_, sqes_size_);
+  }
+  if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+    munmap(cq_ptr_, cq_size_);
+  }
+  if (sq_ptr_ != nullptr) {
+    munmap(sq_ptr_, sq_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+RC IoUring::init(unsigned entries)
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (ring_fd_ < 0) {
+    LOG_WARN("failed to setup io_uring. error=%s", strerror(errno));
+    return RC::IOERR_OPEN;
+  }
+
+  sq_entries_ = params.sq_entries;
+  sq_size_    = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_size_    = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+  }
+
+  sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ptr_ == MAP_FAILED) {
+    sq_ptr_ = nullptr;
+    LOG_WARN("failed to mmap io_uring submission queue. error=%s", strerror(errno));
+    return RC::NOMEM;
+  }
+
+  if (single_mmap) {
+    cq_ptr_ = sq_ptr_;
+  } else {
+    cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      cq_ptr_ = nullptr;
+      LOG_WARN("failed to mmap io_uring completion queue. error=%s", strerror(errno));
+      return RC::NOMEM;
+    }
+  }
+
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ptr_  = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes_ptr_ == MAP_FAILED) {
+    sqes_ptr_ = nullptr;
+    LOG_WARN("failed to mmap io_uring submission entries. error=%s", strerror(errno));
+    return RC::NOMEM;
+  }
+
+  char *sq = static_cast<char *>(sq_ptr_);
+  char *cq = static_cast<char *>(cq_ptr_);
+  sq_head_  = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_  = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  sqes_     = static_cast<struct io_uring_sqe *>(sqes_ptr_);
+  cq_head_  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_  = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_     = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+  iovecs_.resize(sq_entries_);
+  reaped_.resize(sq_entries_);
+  return RC::SUCCESS;
+}
+
+RC IoUring::run(IoRequest *requests, int count)
+{
+  ASSERT(count <= static_cast<int>(sq_entries_), "too many io requests. count=%d, entries=%u", count, sq_entries_);
+
+  unsigned tail = *sq_tail_;
+  for (int i = 0; i < count; i++) {
+    IoRequest &request = requests[i];
+
+    // 向量请求直接使用调用者的 iovec。内核没做完的部分由 complete_sync 处理，所以这里总是从头开始
+    ASSERT(request.iov == nullptr || request.done == 0, "vectored io request has been partially done");
+    reaped_[i] = false;
+    struct iovec &iov = iovecs_[i];
+    iov.iov_base      = request.buf + request.done;
+    iov.iov_len       = request.size - request.done;
+
+    const unsigned index = tail & *sq_mask_;
+    struct io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = request.type == IoRequest::Type::READ ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->fd        = request.fd;
+    sqe->addr      = reinterpret_cast<uint64_t>(request.iov != nullptr ? request.iov : &iov);
+    sqe->len       = request.iov != nullptr ? request.iov_count : 1;
+    sqe->off       = request.offset < 0 ? static_cast<uint64_t>(-1) : static_cast<uint64_t>(request.offset + request.done);
+    sqe->user_data = static_cast<uint64_t>(i);
+
+    // 使用文件当前位置的请求要按照顺序执行，把它们串起来
+    if (request.offset < 0) {
+      for (int j = i + 1; j < count; j++) {
+        if (requests[j].offset < 0) {
+          sqe->flags |= IOSQE_IO_LINK;
+          break;
+        }
+      }
+    }
+
+    sq_array_[index] = index;
+    tail++;
+  }
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+  const unsigned first = *sq_tail_;
+  int completed = 0;
+  while (completed < count) {
+    const unsigned to_submit = tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    const int ret = static_cast<int>(
+        syscall(__NR_io_uring_enter, ring_fd_, to_submit, 1 /*min_complete*/, IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      // 已经提交给内核的请求还会执行完，这里没法再等待，只能把这个 ring 当作坏掉了
+      const int error = errno;
+      LOG_ERROR("failed to enter io_uring. error=%s", strerror(error));
+      broken_ = true;
+
+      // 内核已经取走但是没有返回结果的请求，不知道有没有执行，不能交给 complete_sync 重做，
+      // 否则追加写可能会写两次。内核还没有取走的请求不会再执行，可以重做
+      const int submitted = static_cast<int>(__atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) - first);
+      for (int i = 0; i < submitted && i < count; i++) {
+        if (!reaped_[i] && requests[i].error == 0) {
+          requests[i].error = error;
+        }
+      }
+      return RC::IOERR_ACCESS;
+    }
+
+    unsigned head = *cq_head_;
+    while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      const struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+      IoRequest &request = requests[cqe->user_data];
+      reaped_[cqe->user_data] = true;
+      if (cqe->res > 0) {
+        request.done += cqe->res;
+      } else if (cqe->res == 0 && request.type == IoRequest::Type::READ) {
+        request.error = -1;  // end of file
+      } else if (cqe->res < 0 && cqe->res != -ECANCELED && cqe->res != -EAGAIN && cqe->res != -EINTR) {
+        request.error = -cqe->res;
+      }
+      completed++;
+      head++;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+  return RC::SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+IoUringBackend::IoUringBackend() = default;
+IoUringBackend::~IoUringBackend() = default;
+
+RC IoUringBackend::init(int ring_num /* = DEFAULT_RING_NUM */, int queue_depth /* = DEFAULT_QUEUE_DEPTH */)
+{
+  for (int i = 0; i < ring_num; i++) {
+    auto ring = make_unique<IoUring>();
+    RC rc = ring->init(queue_depth);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    rings_.push_back(std::move(ring));
+  }
+  LOG_INFO("io_uring backend inited. ring num=%d, queue depth=%d", ring_num, queue_depth);
+  return RC::SUCCESS;
+}
+
+RC IoUringBackend::submit(IoRequest *requests, int count)
+{
+  IoUring *ring = nullptr;
+  for (auto &candidate : rings_) {
+    if (candidate->try_lock()) {
+      ring = candidate.get();
+      break;
+    }
+  }
+
+  if (ring != nullptr) {
+    const int batch_size = static_cast<int>(ring->entries());
+    RC rc = RC::SUCCESS;
+    for (int start = 0; start < count && OB_SUCC(rc); start += batch_size) {
+      rc = ring->run(requests + start, std::min(batch_size, count - start));
+    }
+    ring->unlock();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("io_uring failed, the remaining requests will be done by sync io. rc=%s", strrc(rc));
+    }
+  }
+
+  // 没有空闲的 ring，或者内核没有做完的部分(比如短读短写、链上前面的请求失败被取消)，同步完成
+  for (int i = 0; i < count; i++) {
+    complete_sync(requests[i]);
+  }
+  return result_of(requests, count);
+}
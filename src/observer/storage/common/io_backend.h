@@ -0,0 +1,166 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/uio.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/rc.h"
+
+/**
+ * @defgroup IoBackend
+ * @brief 数据文件和日志文件的IO接口
+ * @details 缓冲池加载、刷新页面和日志写入都通过这里访问文件。
+ * 所有接口都是批量的：调用者一次提交一批请求，等待它们全部完成。同步实现逐个执行，
+ * io_uring 实现一次把整批请求交给内核，一个线程就可以同时有几十个IO在执行。
+ */
+
+/**
+ * @brief 一个读写请求
+ * @ingroup IoBackend
+ */
+struct IoRequest
+{
+  enum class Type
+  {
+    READ,
+    WRITE,
+  };
+
+  Type    type   = Type::READ;
+  int     fd     = -1;
+  char   *buf    = nullptr;
+  int     size   = 0;
+  int64_t offset = -1;  ///< 小于0表示使用文件当前位置，比如追加日志。同一批中这样的请求会按照顺序执行
+
+  int done  = 0;  ///< 已经完成的字节数
+  int error = 0;  ///< 0表示成功，-1表示读到了文件尾，其它是errno
+
+  /// 不为空时是向量IO，一次读写多块不连续的内存，不使用buf，size是所有块的总长度。
+  /// iov 要一直有效到请求完成，块的个数不能超过 IOV_MAX
+  const struct iovec *iov       = nullptr;
+  int                 iov_count = 0;
+
+  static IoRequest read(int fd, void *buf, int size, int64_t offset)
+  {
+    return IoRequest{Type::READ, fd, static_cast<char *>(buf), size, offset};
+  }
+  static IoRequest write(int fd, const void *buf, int size, int64_t offset)
+  {
+    return IoRequest{Type::WRITE, fd, static_cast<char *>(const_cast<void *>(buf)), size, offset};
+  }
+  static IoRequest writev(int fd, const struct iovec *iov, int iov_count, int64_t offset)
+  {
+    int size = 0;
+    for (int i = 0; i < iov_count; i++) {
+      size += static_cast<int>(iov[i].iov_len);
+    }
+    return IoRequest{Type::WRITE, fd, nullptr, size, offset, 0, 0, iov, iov_count};
+  }
+};
+
+/**
+ * @brief IO后端
+ * @ingroup IoBackend
+ * @details 通过名字创建，目前有 sync 和 io_uring 两种。io_uring 在当前系统上不可用时会使用 sync。
+ * 进程内使用一个全局的实例，可以在配置文件 [BufferPool] 段的 IoBackend 中指定，没有设置时使用 sync。
+ */
+class IoBackend
+{
+public:
+  static constexpr const char *DEFAULT_NAME = "sync";
+
+public:
+  virtual ~IoBackend() = default;
+
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief 提交一批请求，等待全部完成
+   * @details 每个请求的结果记录在 IoRequest::error 中。一个请求失败不影响其它请求
+   * @return 全部成功时返回SUCCESS，否则返回第一个失败的请求对应的错误码
+   */
+  virtual RC submit(IoRequest *requests, int count) = 0;
+
+  RC submit(std::vector<IoRequest> &requests) { return submit(requests.data(), static_cast<int>(requests.size())); }
+
+  RC read(int fd, void *buf, int size, int64_t offset);
+  RC write(int fd, const void *buf, int size, int64_t offset);
+
+  /**
+   * @brief 把文件已经写入的数据刷到磁盘上(fsync)
+   */
+  RC sync(int fd);
+
+public:
+  /**
+   * @brief 根据名字创建IO后端，名字不合法时返回nullptr
+   */
+  static std::unique_ptr<IoBackend> create(const char *name);
+
+  static void       set_instance(IoBackend *backend);
+  static IoBackend &instance();
+
+protected:
+  /**
+   * @brief 用同步的方式完成请求中剩余的部分
+   * @details 已经失败的请求不再执行。写入0字节，或者连续多次 EINTR/EAGAIN 没有任何进展时，认为请求失败
+   */
+  static void complete_sync(IoRequest &request);
+
+  /**
+   * @brief 汇总一批请求的结果
+   */
+  static RC result_of(const IoRequest *requests, int count);
+};
+
+/**
+ * @brief 同步IO，使用 pread/pwrite
+ * @ingroup IoBackend
+ */
+class SyncIoBackend : public IoBackend
+{
+public:
+  const char *name() const override { return "sync"; }
+  RC          submit(IoRequest *requests, int count) override;
+};
+
+class IoUring;
+
+/**
+ * @brief 基于 io_uring 的IO
+ * @ingroup IoBackend
+ * @details 直接使用系统调用，不依赖 liburing。一个 ring 不能同时给多个线程使用，
+ * 所以准备了几个 ring，提交时找一个空闲的，都在使用时就同步执行，不会等待其它线程的IO。
+ * 内核短读短写、或者请求被取消时，剩余的部分也会同步执行。
+ * 与内核交互出错时，已经提交给内核但是没有拿到结果的请求可能还会执行，不能再重做，直接当作失败。
+ */
+class IoUringBackend : public IoBackend
+{
+public:
+  static constexpr int DEFAULT_RING_NUM    = 4;
+  static constexpr int DEFAULT_QUEUE_DEPTH = 64;
+
+public:
+  IoUringBackend();
+  ~IoUringBackend() override;
+
+  RC init(int ring_num = DEFAULT_RING_NUM, int queue_depth = DEFAULT_QUEUE_DEPTH);
+
+  const char *name() const override { return "io_uring"; }
+  RC          submit(IoRequest *requests, int count) override;
+
+private:
+  std::vector<std::unique_ptr<IoUring>> rings_;
+};
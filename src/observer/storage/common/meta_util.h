@@ -19,9 +19,11 @@ static constexpr const char *TABLE_META_SUFFIX = ".table";
 static constexpr const char *TABLE_META_FILE_PATTERN = ".*\\.table$";
 static constexpr const char *TABLE_DATA_SUFFIX = ".data";
 static constexpr const char *TABLE_INDEX_SUFFIX = ".index";
+static constexpr const char *TABLE_TEXT_SUFFIX = ".text";
 static constexpr const char *VIEW_META_SUFFIX = "__view.table";
 
 std::string table_meta_file(const char *base_dir, const char *table_name);
 std::string table_data_file(const char *base_dir, const char *table_name);
+std::string table_text_file(const char *base_dir, const char *table_name);
 std::string table_index_file(const char *base_dir, const char *table_name, const char *index_name);
 std::string view_meta_file(const char *base_dir, const char *table_name);
@@ -83,7 +83,8 @@ RC Db::init(const char *name, const char *dbpath)
 }
 
 RC Db::create_table(const char *table_name, int attribute_count, 
-  const AttrInfoSqlNode *attributes, std::vector<std::vector<Value>> *values_list)
+  const AttrInfoSqlNode *attributes, std::vector<std::vector<Value>> *values_list, const char *compression /* = nullptr */,
+  const char *record_format /* = nullptr */)
 {
   RC rc = RC::SUCCESS;
   // check table_name
@@ -94,9 +95,10 @@ RC Db::create_table(const char *table_name, int attribute_count,
 
   // 文件路径可以移到Table模块
   std::string table_file_path = table_meta_file(path_.c_str(), table_name);
-  Table *table = new PhysicalTable();
+  PhysicalTable *table = new PhysicalTable();
   int32_t table_id = next_table_id_++;
-  rc = table->create(table_id, table_file_path.c_str(), table_name, path_.c_str(), attribute_count, attributes);
+  rc = table->create(table_id, table_file_path.c_str(), table_name, path_.c_str(), attribute_count, attributes,
+      compression, record_format);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to create table %s.", table_name);
     delete table;
@@ -46,7 +46,13 @@ public:
    */
   RC init(const char *name, const char *dbpath);
 
-  RC create_table(const char *table_name, int attribute_count, const AttrInfoSqlNode *attributes, std::vector<std::vector<Value>> *values_list);
+  /**
+   * @param compression   表的页面压缩算法，为空时不压缩，参考 PageCodec::create
+   * @param record_format 表的记录存放格式，为空时使用定长格式，参考 RecordFormat
+   */
+  RC create_table(const char *table_name, int attribute_count, const AttrInfoSqlNode *attributes,
+                  std::vector<std::vector<Value>> *values_list, const char *compression = nullptr,
+                  const char *record_format = nullptr);
   RC create_view(std::string view_name, std::vector<AttrInfoSqlNode> attrs, SelectSqlNode *select);
   RC drop_table(const char *table_name);
   RC show_index(const char *table_name, TableMeta &table_meta);
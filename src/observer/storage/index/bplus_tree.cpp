@@ -18,7 +18,6 @@ See the Mulan PSL v2 for more details. */
 #include "storage/buffer/disk_buffer_pool.h"
 #include "common/log/log.h"
 #include "sql/parser/parse_defs.h"
-#include "common/lang/lower_bound.h"
 
 using namespace std;
 using namespace common;
@@ -171,11 +170,7 @@ char *LeafIndexNodeHandler::value_at(int index)
 
 int LeafIndexNodeHandler::lookup(const KeyComparator &comparator, const char *key, bool *found /* = nullptr */) const
 {
-  const int                    size = this->size();
-  common::BinaryIterator<char> iter_begin(item_size(), __key_at(0));
-  common::BinaryIterator<char> iter_end(item_size(), __key_at(size));
-  common::BinaryIterator<char> iter = lower_bound(iter_begin, iter_end, key, comparator, found);
-  return iter - iter_begin;
+  return comparator.lower_bound(__key_at(0), item_size(), this->size(), key, found);
 }
 
 void LeafIndexNodeHandler::insert(int index, const char *key, const char *value)
@@ -390,6 +385,13 @@ void InternalIndexNodeHandler::insert(const char *key, PageNum page_num, const K
   increase_size(1);
 }
 
+void InternalIndexNodeHandler::append_child(const char *key, PageNum page_num)
+{
+  memcpy(__key_at(size()), key, key_size());
+  memcpy(__value_at(size()), &page_num, value_size());
+  increase_size(1);
+}
+
 RC InternalIndexNodeHandler::move_half_to(InternalIndexNodeHandler &other, DiskBufferPool *bp)
 {
   const int size       = this->size();
@@ -423,10 +425,7 @@ int InternalIndexNodeHandler::lookup(const KeyComparator &comparator, const char
     return 0;
   }
 
-  common::BinaryIterator<char> iter_begin(item_size(), __key_at(1));
-  common::BinaryIterator<char> iter_end(item_size(), __key_at(size));
-  common::BinaryIterator<char> iter = lower_bound(iter_begin, iter_end, key, comparator, found);
-  int                          ret  = static_cast<int>(iter - iter_begin) + 1;
+  int ret = comparator.lower_bound(__key_at(1), item_size(), size - 1, key, found) + 1;
   if (insert_position) {
     *insert_position = ret;
   }
@@ -687,10 +686,10 @@ RC BplusTreeHandler::sync()
 }
 
 RC BplusTreeHandler::create(const char *file_name, std::vector<AttrType> attr_type, std::vector<int> attr_length,
-    int internal_max_size /* = -1*/, int leaf_max_size /* = -1 */)
+    int internal_max_size /* = -1*/, int leaf_max_size /* = -1 */, const char *codec /* = nullptr */)
 {
   BufferPoolManager &bpm = BufferPoolManager::instance();
-  RC                 rc  = bpm.create_file(file_name);
+  RC                 rc  = bpm.create_file(file_name, codec);
   if (rc != RC::SUCCESS) {
     LOG_WARN("Failed to create file. file name=%s, rc=%d:%s", file_name, rc, strrc(rc));
     return rc;
@@ -1079,6 +1078,27 @@ RC BplusTreeHandler::left_most_page(LatchMemo &latch_memo, Frame *&frame)
 RC BplusTreeHandler::find_leaf_internal(LatchMemo &latch_memo, BplusTreeOperationType op,
     const std::function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame)
 {
+  // 先尝试乐观的方式查找，有并发修改时重新开始，重试几次都失败后再逐层加锁
+  if (latch_memo.memo_point() == 0) {
+    for (int i = 0; i < MAX_OPTIMISTIC_RETRY; i++) {
+      RC rc = optimistic_find_leaf(latch_memo, op, child_page_getter, frame);
+      if (rc == RC::SUCCESS && op != BplusTreeOperationType::READ) {
+        // 修改操作只锁住了叶子节点，叶子节点需要分裂或合并时要从根节点开始加锁
+        IndexNodeHandler leaf_node(file_header_, frame);
+        if (leaf_node.is_safe(op, leaf_node.parent_page_num() == BP_INVALID_PAGE_NUM)) {
+          return rc;
+        }
+        latch_memo.release_to(latch_memo.memo_point());
+        break;
+      }
+
+      if (rc != RC::LOCKED_CONCURRENCY_CONFLICT) {
+        return rc;
+      }
+      latch_memo.release_to(latch_memo.memo_point());
+    }
+  }
+
   // root locked
   if (op != BplusTreeOperationType::READ) {
     latch_memo.xlatch(&root_lock_);
@@ -1112,6 +1132,71 @@ RC BplusTreeHandler::find_leaf_internal(LatchMemo &latch_memo, BplusTreeOperatio
   return RC::SUCCESS;
 }
 
+RC BplusTreeHandler::optimistic_find_leaf(LatchMemo &latch_memo, BplusTreeOperationType op,
+    const std::function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame)
+{
+  // 根节点的页面编号在 root_lock_ 的保护下读取，拿到根节点的版本号之后就可以释放
+  latch_memo.slatch(&root_lock_);
+  if (is_empty()) {
+    return RC::EMPTY;
+  }
+
+  int memo_point = latch_memo.memo_point();
+  RC  rc         = latch_memo.get_page(file_header_.root_page, frame);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to fetch root page. page id=%d, rc=%s", file_header_.root_page, strrc(rc));
+    return rc;
+  }
+
+  Frame   *parent         = nullptr;
+  uint64_t parent_version = 0;
+  while (true) {
+    IndexNode *node = (IndexNode *)frame->data();
+    if (op != BplusTreeOperationType::READ && node->is_leaf) {
+      // 叶子节点可能正在被其它线程修改，版本号是奇数，这时不放弃，直接等待写锁。
+      // 拿到写锁之后父节点的版本号仍然没有变化，说明叶子节点没有分裂或合并，还是要找的节点。
+      // 叶子节点就是根节点时还持有 root_lock_，根节点不会变化
+      latch_memo.xlatch(frame);
+      if (parent != nullptr && !parent->validate_version(parent_version)) {
+        return RC::LOCKED_CONCURRENCY_CONFLICT;
+      }
+      latch_memo.release_to(memo_point);
+      return RC::SUCCESS;
+    }
+
+    // 父节点没有变化，说明当前节点就是要找的节点，并且读取版本号之前没有分裂或合并
+    uint64_t version = 0;
+    if (!frame->read_version(version) || (parent != nullptr && !parent->validate_version(parent_version))) {
+      return RC::LOCKED_CONCURRENCY_CONFLICT;
+    }
+    latch_memo.release_to(memo_point);
+
+    if (node->is_leaf) {
+      latch_memo.slatch(frame);
+      return frame->validate_version(version) ? RC::SUCCESS : RC::LOCKED_CONCURRENCY_CONFLICT;
+    }
+
+    // 读到的数据可能是正在修改中的，size 不合法时不能再用来查找
+    InternalIndexNodeHandler internal_node(file_header_, frame);
+    if (internal_node.size() <= 0 || internal_node.size() > internal_node.max_size()) {
+      return RC::LOCKED_CONCURRENCY_CONFLICT;
+    }
+    const PageNum next_page_id = child_page_getter(internal_node);
+    if (!frame->validate_version(version)) {
+      return RC::LOCKED_CONCURRENCY_CONFLICT;
+    }
+
+    parent         = frame;
+    parent_version = version;
+    memo_point     = latch_memo.memo_point();
+    rc             = latch_memo.get_page(next_page_id, frame);
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("Failed to load page page_num:%d. rc=%s", next_page_id, strrc(rc));
+      return rc;
+    }
+  }
+}
+
 RC BplusTreeHandler::crabing_protocal_fetch_page(
     LatchMemo &latch_memo, BplusTreeOperationType op, PageNum page_num, bool is_root_node, Frame *&frame)
 {
@@ -1697,11 +1782,14 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
 
   inited_        = true;
   first_emitted_ = false;
+  read_ahead_.init(*tree_handler_.disk_buffer_pool_);
+
+  const auto &attr_comparator = tree_handler_.key_comparator_.attr_comparator();
+  const int   attr_length     = attr_comparator.attr_length();
 
   // 校验输入的键值是否是合法范围
   if (left_user_key && right_user_key) {
-    const auto &attr_comparator = tree_handler_.key_comparator_.attr_comparator();
-    const int   result          = attr_comparator(left_user_key, right_user_key);
+    const int result = attr_comparator(left_user_key, right_user_key);
     if (result > 0 ||  // left < right
                        // left == right but is (left,right)/[left,right) or (left,right]
         (result == 0 && (left_inclusive == false || right_inclusive == false))) {
@@ -1711,7 +1799,10 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
 
   if (nullptr == left_user_key) {
     rc = tree_handler_.left_most_page(latch_memo_, current_frame_);
-    if (rc != RC::SUCCESS) {
+    if (rc == RC::EMPTY) {
+      current_frame_ = nullptr;
+      return RC::SUCCESS;
+    } else if (rc != RC::SUCCESS) {
       LOG_WARN("failed to find left most page. rc=%s", strrc(rc));
       return rc;
     }
@@ -1721,8 +1812,9 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
 
     char *fixed_left_key = const_cast<char *>(left_user_key);
 
+    // 已经是完整长度的键值(比如多字段索引的键值)不需要调整
     for (AttrType type : tree_handler_.file_header_.attr_type) {
-      if (type == CHARS) {
+      if (type == CHARS && left_len != attr_length) {
         bool should_inclusive_after_fix = false;
         rc = fix_user_key(fixed_left_key, left_len, true /*greater*/, &fixed_left_key, &should_inclusive_after_fix);
         if (rc != RC::SUCCESS) {
@@ -1791,7 +1883,7 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
     char *fixed_right_key          = const_cast<char *>(right_user_key);
     bool  should_include_after_fix = false;
     for (AttrType type : tree_handler_.file_header_.attr_type) {
-      if (type == CHARS) {
+      if (type == CHARS && right_len != attr_length) {
         rc = fix_user_key(
             fixed_right_key, right_len, false /*want_greater*/, &fixed_right_key, &should_include_after_fix);
         if (rc != RC::SUCCESS) {
@@ -1818,6 +1910,8 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
 
   if (touch_end()) {
     current_frame_ = nullptr;
+  } else {
+    read_ahead_.access(current_frame_->page_num());
   }
 
   return RC::SUCCESS;
@@ -1871,6 +1965,8 @@ RC BplusTreeScanner::next_entry(RID &rid)
     return RC::RECORD_EOF;
   }
 
+  read_ahead_.access(next_page_num);
+
   const int memo_point = latch_memo_.memo_point();
   rc                   = latch_memo_.get_page(next_page_num, current_frame_);
   if (rc != RC::SUCCESS) {
@@ -1908,8 +2004,8 @@ RC BplusTreeScanner::fix_user_key(
   }
 
   // 这里很粗暴，变长字段才需要做调整，其它默认都不需要做调整
-  for (AttrType type : tree_handler_.file_header_.attr_type) {
-    assert(type == CHARS);
+  for (int i = 0; i < tree_handler_.file_header_.attr_num; i++) {
+    assert(tree_handler_.file_header_.attr_type[i] == CHARS);
   }
   assert(strlen(user_key) >= static_cast<size_t>(key_len));
 
@@ -27,6 +27,7 @@ See the Mulan PSL v2 for more details. */
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/trx/latch_memo.h"
 #include "sql/parser/parse_defs.h"
+#include "common/defs.h"
 #include "common/lang/comparator.h"
 #include "common/log/log.h"
 
@@ -48,6 +49,20 @@ enum class BplusTreeOperationType
 };
 
 
+/**
+ * @brief 常见的键值组成
+ * @ingroup BPlusTree
+ * @details 打开B+树时根据字段确定，比较时直接使用对应的比较函数，不用每次都遍历字段、判断字段类型
+ */
+enum class KeyShape
+{
+  GENERIC,  ///< 其它情况，逐个字段比较
+  INT,      ///< 单个 INTS 字段
+  FLOAT,    ///< 单个 FLOATS 字段
+  CHARS,    ///< 单个定长 CHARS 字段
+  INT_INT,  ///< 两个 INTS 字段
+};
+
 /**
  * @brief 属性比较(BplusTree)
  * @ingroup BPlusTree
@@ -59,15 +74,74 @@ public:
   {
     attr_type_ = type;
     attr_length_ = length;
+    total_attr_length_ = std::accumulate(attr_length_.begin(), attr_length_.end(), 0);
+
+    shape_ = KeyShape::GENERIC;
+    if (attr_type_.size() == 1 && attr_type_[0] == INTS && attr_length_[0] == sizeof(int32_t)) {
+      shape_ = KeyShape::INT;
+    } else if (attr_type_.size() == 1 && attr_type_[0] == FLOATS && attr_length_[0] == sizeof(float)) {
+      shape_ = KeyShape::FLOAT;
+    } else if (attr_type_.size() == 1 && attr_type_[0] == CHARS) {
+      shape_ = KeyShape::CHARS;
+    } else if (attr_type_.size() == 2 && attr_type_[0] == INTS && attr_type_[1] == INTS &&
+               attr_length_[0] == sizeof(int32_t) && attr_length_[1] == sizeof(int32_t)) {
+      shape_ = KeyShape::INT_INT;
+    }
   }
 
   int attr_length() const
   {
-    int total_attr_length = std::accumulate(attr_length_.begin(), attr_length_.end(), 0);
-    return total_attr_length;
+    return total_attr_length_;
   }
 
+  KeyShape shape() const { return shape_; }
+
   int operator()(const char *v1, const char *v2) const
+  {
+    switch (shape_) {
+      case KeyShape::INT: return compare<KeyShape::INT>(v1, v2);
+      case KeyShape::FLOAT: return compare<KeyShape::FLOAT>(v1, v2);
+      case KeyShape::CHARS: return compare<KeyShape::CHARS>(v1, v2);
+      case KeyShape::INT_INT: return compare<KeyShape::INT_INT>(v1, v2);
+      default: return compare<KeyShape::GENERIC>(v1, v2);
+    }
+  }
+
+  /**
+   * @brief 按照指定的键值组成比较，shape 必须与 shape() 一致
+   * @details 结果与 common::compare_int 等函数相同，已经建好的B+树中键值的顺序不会变化
+   */
+  template <KeyShape shape>
+  int compare(const char *v1, const char *v2) const
+  {
+    if constexpr (shape == KeyShape::INT) {
+      return compare_int32(v1, v2);
+    } else if constexpr (shape == KeyShape::FLOAT) {
+      float f1, f2;
+      memcpy(&f1, v1, sizeof(f1));
+      memcpy(&f2, v2, sizeof(f2));
+      const float cmp = f1 - f2;
+      return (cmp > EPSILON) - (cmp < -EPSILON);
+    } else if constexpr (shape == KeyShape::CHARS) {
+      return strncmp(v1, v2, total_attr_length_);
+    } else if constexpr (shape == KeyShape::INT_INT) {
+      const int result = compare_int32(v1, v2);
+      return result != 0 ? result : compare_int32(v1 + sizeof(int32_t), v2 + sizeof(int32_t));
+    } else {
+      return compare_generic(v1, v2);
+    }
+  }
+
+private:
+  static int compare_int32(const char *v1, const char *v2)
+  {
+    int32_t i1, i2;
+    memcpy(&i1, v1, sizeof(i1));
+    memcpy(&i2, v2, sizeof(i2));
+    return (i1 > i2) - (i1 < i2);
+  }
+
+  int compare_generic(const char *v1, const char *v2) const
   {
       const char *curr_v1 = v1;
       const char *curr_v2 = v2;
@@ -101,10 +175,11 @@ public:
       return 0;
   }
 
-
 private:
   std::vector<AttrType> attr_type_;
   std::vector<int> attr_length_;
+  int total_attr_length_ = 0;
+  KeyShape shape_ = KeyShape::GENERIC;
 };
 
 /**
@@ -139,12 +214,72 @@ public:
     return RID::compare(rid1, rid2);
   }
 
+  /**
+   * @brief 在节点中查找第一个不小于 key 的键值
+   * @details 按照键值组成选择特化的查找函数，整个查找过程中只判断一次键值类型。
+   * 查找使用无分支的二分查找，每一步只根据比较结果选择下一个区间的起点，编译器会生成条件传送指令，
+   * 不会因为比较结果无法预测而频繁地清空流水线
+   * @param first     第一个键值
+   * @param item_size 相邻两个键值之间的距离
+   * @param count     键值的个数
+   * @param found     如果给定，返回是否有相等的键值
+   * @return 键值的下标，所有键值都比 key 小时返回 count
+   */
+  int lower_bound(const char *first, int item_size, int count, const char *key, bool *found = nullptr) const
+  {
+    switch (attr_comparator_.shape()) {
+      case KeyShape::INT: return search<KeyShape::INT>(first, item_size, count, key, found);
+      case KeyShape::FLOAT: return search<KeyShape::FLOAT>(first, item_size, count, key, found);
+      case KeyShape::CHARS: return search<KeyShape::CHARS>(first, item_size, count, key, found);
+      case KeyShape::INT_INT: return search<KeyShape::INT_INT>(first, item_size, count, key, found);
+      default: return search<KeyShape::GENERIC>(first, item_size, count, key, found);
+    }
+  }
+
   void set_unique(){ unique = true; }
   void recover_unique(){ unique = false; }
 
+private:
+  template <KeyShape shape>
+  int compare(const char *v1, const char *v2) const
+  {
+    const int result = attr_comparator_.compare<shape>(v1, v2);
+    if (result != 0 || unique) {
+      return result;
+    }
+
+    RID rid1, rid2;
+    memcpy(&rid1, v1 + attr_comparator_.attr_length(), sizeof(rid1));
+    memcpy(&rid2, v2 + attr_comparator_.attr_length(), sizeof(rid2));
+    return (rid1.page_num != rid2.page_num) ? (rid1.page_num > rid2.page_num ? 1 : -1)
+                                            : (rid1.slot_num > rid2.slot_num) - (rid1.slot_num < rid2.slot_num);
+  }
+
+  template <KeyShape shape>
+  int search(const char *first, int item_size, int count, const char *key, bool *found) const
+  {
+    const char *base = first;
+    int         n    = count;
+    while (n > 1) {
+      const int half = n / 2;
+      base = (compare<shape>(base + half * item_size, key) < 0) ? base + half * item_size : base;
+      n -= half;
+    }
+
+    int index = static_cast<int>((base - first) / item_size);
+    if (count > 0 && compare<shape>(base, key) < 0) {
+      index++;
+    }
+
+    if (found != nullptr) {
+      *found = index < count && compare<shape>(first + index * item_size, key) == 0;
+    }
+    return index;
+  }
+
 private:
   AttrComparator attr_comparator_;
-  bool unique;
+  bool unique = false;
 };
 
 /**
@@ -453,6 +588,13 @@ public:
   void create_new_root(PageNum first_page_num, const char *key, PageNum page_num);
 
   void insert(const char *key, PageNum page_num, const KeyComparator &comparator);
+
+  /**
+   * @brief 在最后追加一个子节点，批量构建时使用
+   * @details 不会修改子节点中记录的父节点。
+   * 第一个子节点的键值查找时不会使用，但与分裂出来的节点一样保存子树中最小的键值，合并和重新分配节点时会用到
+   */
+  void append_child(const char *key, PageNum page_num);
   RC move_half_to(LeafIndexNodeHandler &other, DiskBufferPool *bp);
   char *key_at(int index);
   PageNum value_at(int index);
@@ -513,12 +655,14 @@ public:
   /**
    * 此函数创建一个名为fileName的索引。
    * attrType描述被索引属性的类型，attrLength描述被索引属性的长度
+   * codec是索引文件的页面压缩算法，为空时不压缩
    */
   RC create(const char *file_name, 
             std::vector<AttrType> attr_type, 
             std::vector<int> attr_length, 
             int internal_max_size = -1, 
-            int leaf_max_size = -1);
+            int leaf_max_size = -1,
+            const char *codec = nullptr);
 
   /**
    * 打开名为fileName的索引文件。
@@ -551,6 +695,8 @@ public:
 
   RC is_unique_index(const char *user_key, const RID *rid);
 
+  const KeyComparator &key_comparator() const { return key_comparator_; }
+
   /**
    * 获取指定值的record
    * @param key_len user_key的长度
@@ -585,6 +731,8 @@ private:
   bool validate_node_recursive(LatchMemo &latch_memo, Frame *frame);
 
 protected:
+  static constexpr int MAX_OPTIMISTIC_RETRY = 3;  ///< 乐观查找遇到并发修改时最多重试几次
+
   RC find_leaf(LatchMemo &latch_memo, BplusTreeOperationType op, const char *key, Frame *&frame);
   RC left_most_page(LatchMemo &latch_memo, Frame *&frame);
   RC find_leaf_internal(LatchMemo &latch_memo, BplusTreeOperationType op, 
@@ -593,6 +741,18 @@ protected:
   RC crabing_protocal_fetch_page(LatchMemo &latch_memo, BplusTreeOperationType op, PageNum page_num, bool is_root_page,
                                  Frame *&frame);
 
+  /**
+   * @brief 使用乐观读的方式查找叶子节点(optimistic lock coupling)
+   * @details 内部节点不加读锁，读取子节点编号之后校验页帧的版本号(参考 Frame::read_version)，
+   * 下一层节点的版本号也要在父节点校验通过之后读取，这样才能发现并发的分裂和合并。
+   * 只有叶子节点加锁：只读操作加读锁，修改操作加写锁。修改操作不读取叶子节点的版本号，而是直接等待写锁，
+   * 拿到写锁之后再校验父节点的版本号，这样叶子节点正在被其它线程修改时也不需要重新开始。
+   * 修改操作只能修改这一个叶子节点，叶子节点会分裂或合并时需要调用者改用逐层加锁的方式。
+   * @return 有并发修改时返回 LOCKED_CONCURRENCY_CONFLICT，调用者需要释放 latch_memo 中的资源，重试或者改用加锁的方式查找
+   */
+  RC optimistic_find_leaf(LatchMemo &latch_memo, BplusTreeOperationType op,
+                          const std::function<PageNum(InternalIndexNodeHandler &)> &child_page_getter, Frame *&frame);
+
   RC insert_into_parent(LatchMemo &latch_memo, PageNum parent_page, Frame *left_frame, const char *pkey, 
                         Frame &right_frame);
 
@@ -636,6 +796,7 @@ protected:
 
 private:
   friend class BplusTreeScanner;
+  friend class BplusTreeBulkLoader;
   friend class BplusTreeTester;
 };
 
@@ -679,6 +840,7 @@ private:
   BplusTreeHandler &tree_handler_;
 
   LatchMemo latch_memo_;
+  ReadAhead read_ahead_;  ///< 叶子节点按照页面顺序存放时，预读后面的叶子节点
 
   /// 使用左右叶子节点和位置来表示扫描的起始位置和终止位置
   /// 起始位置和终止位置都是有效的数据
@@ -0,0 +1,381 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <queue>
+
+#include "storage/index/bplus_tree_bulk_loader.h"
+#include "common/log/log.h"
+#include "storage/common/io_backend.h"
+
+using namespace std;
+
+/// 读写临时文件时每次IO的大小
+static constexpr int RUN_IO_SIZE = 256 * 1024;
+
+/**
+ * @brief 按顺序读取临时文件中的一段有序键值
+ */
+class BplusTreeBulkLoader::RunReader
+{
+public:
+  RunReader(int fd, const Run &run, int key_length, int batch_num)
+      : fd_(fd), run_(run), key_length_(key_length), batch_num_(batch_num)
+  {
+    buffer_.resize(static_cast<size_t>(key_length) * batch_num);
+  }
+
+  RC init() { return load(); }
+
+  bool        valid() const { return pos_ < buffered_; }
+  const char *key() const { return buffer_.data() + static_cast<size_t>(pos_) * key_length_; }
+
+  RC next()
+  {
+    pos_++;
+    if (pos_ >= buffered_ && read_ < run_.count) {
+      return load();
+    }
+    return RC::SUCCESS;
+  }
+
+private:
+  RC load()
+  {
+    const int num = static_cast<int>(min<int64_t>(batch_num_, run_.count - read_));
+    RC rc = IoBackend::instance().read(fd_, buffer_.data(), num * key_length_, run_.offset + read_ * key_length_);
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("failed to read sorted keys. rc=%s", strrc(rc));
+      return rc;
+    }
+    read_ += num;
+    buffered_ = num;
+    pos_      = 0;
+    return RC::SUCCESS;
+  }
+
+private:
+  int          fd_;
+  Run          run_;
+  int          key_length_;
+  int          batch_num_;
+  vector<char> buffer_;
+  int64_t      read_     = 0;
+  int          buffered_ = 0;
+  int          pos_      = 0;
+};
+
+BplusTreeBulkLoader::BplusTreeBulkLoader(
+    BplusTreeHandler &tree_handler, int fill_factor /* = DEFAULT_FILL_FACTOR */,
+    size_t memory_limit /* = DEFAULT_MEMORY_LIMIT */)
+    : tree_handler_(tree_handler),
+      fill_factor_(min(max(fill_factor, 50), 100)),
+      memory_limit_(memory_limit),
+      key_length_(tree_handler.file_header_.key_length)
+{}
+
+BplusTreeBulkLoader::~BplusTreeBulkLoader()
+{
+  release_levels();
+  if (run_fd_ >= 0) {
+    ::close(run_fd_);
+    run_fd_ = -1;
+  }
+}
+
+RC BplusTreeBulkLoader::add(const char *user_key, const RID &rid)
+{
+  const size_t buffered_num = buffer_.size() / key_length_;
+  if (buffered_num > 0 && (buffered_num + 1) * (key_length_ + sizeof(const char *)) > memory_limit_) {
+    RC rc = spill();
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+
+  const int user_key_length = key_length_ - static_cast<int>(sizeof(RID));
+  buffer_.insert(buffer_.end(), user_key, user_key + user_key_length);
+  buffer_.insert(buffer_.end(), reinterpret_cast<const char *>(&rid), reinterpret_cast<const char *>(&rid) + sizeof(RID));
+  total_++;
+  return RC::SUCCESS;
+}
+
+void BplusTreeBulkLoader::sort_buffer()
+{
+  const size_t num = buffer_.size() / key_length_;
+  sorted_.resize(num);
+  for (size_t i = 0; i < num; i++) {
+    sorted_[i] = buffer_.data() + i * key_length_;
+  }
+
+  const KeyComparator &comparator = tree_handler_.key_comparator_;
+  sort(sorted_.begin(), sorted_.end(), [&comparator](const char *left, const char *right) {
+    return comparator(left, right) < 0;
+  });
+}
+
+RC BplusTreeBulkLoader::spill()
+{
+  if (run_fd_ < 0) {
+    // 临时文件打开之后就删除，关闭时系统会回收空间
+    run_file_name_ = tree_handler_.disk_buffer_pool_->filename() + ".sort";
+    run_fd_        = ::open(run_file_name_.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IREAD | S_IWRITE);
+    if (run_fd_ < 0) {
+      LOG_ERROR("failed to create sort file. file=%s, errmsg=%s", run_file_name_.c_str(), strerror(errno));
+      return RC::IOERR_OPEN;
+    }
+    ::unlink(run_file_name_.c_str());
+  }
+
+  sort_buffer();
+
+  Run run;
+  run.offset = run_file_size_;
+  run.count  = static_cast<int64_t>(sorted_.size());
+
+  // 按照排好的顺序拷贝到写缓冲中，攒够一次IO的大小再写
+  const int    batch_num = max(1, RUN_IO_SIZE / key_length_);
+  vector<char> out(static_cast<size_t>(batch_num) * key_length_);
+  int          out_num = 0;
+  for (size_t i = 0; i <= sorted_.size(); i++) {
+    if (out_num == batch_num || (i == sorted_.size() && out_num > 0)) {
+      RC rc = IoBackend::instance().write(run_fd_, out.data(), out_num * key_length_, run_file_size_);
+      if (rc != RC::SUCCESS) {
+        LOG_WARN("failed to write sorted keys. file=%s, rc=%s", run_file_name_.c_str(), strrc(rc));
+        return rc;
+      }
+      run_file_size_ += static_cast<int64_t>(out_num) * key_length_;
+      out_num = 0;
+    }
+    if (i < sorted_.size()) {
+      memcpy(out.data() + static_cast<size_t>(out_num) * key_length_, sorted_[i], key_length_);
+      out_num++;
+    }
+  }
+
+  runs_.push_back(run);
+  buffer_.clear();
+  sorted_.clear();
+  LOG_TRACE("spilled sorted keys. run=%d, count=%ld", static_cast<int>(runs_.size()), run.count);
+  return RC::SUCCESS;
+}
+
+RC BplusTreeBulkLoader::merge_runs()
+{
+  // 每段一个读缓冲，总共不超过 memory_limit
+  const size_t run_memory = min<size_t>(memory_limit_ / runs_.size(), RUN_IO_SIZE);
+  const int    batch_num  = max(1, static_cast<int>(run_memory / key_length_));
+
+  vector<unique_ptr<RunReader>> readers;
+  for (const Run &run : runs_) {
+    readers.emplace_back(new RunReader(run_fd_, run, key_length_, batch_num));
+    RC rc = readers.back()->init();
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+
+  const KeyComparator &comparator = tree_handler_.key_comparator_;
+  auto greater = [&comparator](RunReader *left, RunReader *right) {
+    return comparator(left->key(), right->key()) > 0;
+  };
+  priority_queue<RunReader *, vector<RunReader *>, decltype(greater)> heap(greater);
+  for (unique_ptr<RunReader> &reader : readers) {
+    heap.push(reader.get());
+  }
+
+  const int rid_offset = key_length_ - static_cast<int>(sizeof(RID));
+  while (!heap.empty()) {
+    RunReader *reader = heap.top();
+    heap.pop();
+
+    RC rc = append(0, reader->key(), reader->key() + rid_offset);
+    if (rc == RC::SUCCESS) {
+      rc = reader->next();
+    }
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+    if (reader->valid()) {
+      heap.push(reader);
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC BplusTreeBulkLoader::finish()
+{
+  if (!tree_handler_.is_empty()) {
+    LOG_WARN("cannot bulk load into a non-empty tree. root page=%d", tree_handler_.file_header_.root_page);
+    return RC::INTERNAL;
+  }
+  if (total_ == 0) {
+    return RC::SUCCESS;
+  }
+
+  plan_levels();
+
+  RC rc = RC::SUCCESS;
+  if (runs_.empty()) {
+    sort_buffer();
+    const int rid_offset = key_length_ - static_cast<int>(sizeof(RID));
+    for (size_t i = 0; rc == RC::SUCCESS && i < sorted_.size(); i++) {
+      rc = append(0, sorted_[i], sorted_[i] + rid_offset);
+    }
+  } else {
+    if (!buffer_.empty()) {
+      rc = spill();
+    }
+    if (rc == RC::SUCCESS) {
+      rc = merge_runs();
+    }
+  }
+
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to bulk load keys. rc=%s", strrc(rc));
+    release_levels();
+    return rc;
+  }
+
+  rc = finish_levels();
+  LOG_INFO("bulk loaded bplus tree. keys=%ld, levels=%d, leafs=%d, runs=%d, fill factor=%d%%, rc=%s",
+           total_, static_cast<int>(levels_.size()), levels_.front().node_count, static_cast<int>(runs_.size()),
+           fill_factor_, strrc(rc));
+  return rc;
+}
+
+void BplusTreeBulkLoader::plan_levels()
+{
+  const IndexFileHeader &header = tree_handler_.file_header_;
+
+  levels_.clear();
+  int64_t item_num = total_;
+  bool    leaf     = true;
+  do {
+    // 与 IndexNodeHandler::min_size 相同，节点的数据不能少于一半，否则删除数据时马上就要合并
+    const int max_size = leaf ? header.leaf_max_size : header.internal_max_size;
+    const int min_size = max_size - max_size / 2;
+    const int capacity = max(min_size, max_size * fill_factor_ / 100);
+
+    // 平均分配之后每个节点的数据可能会少于 min_size，这时减少节点的个数，只要不超过 max_size
+    int64_t node_num = (item_num + capacity - 1) / capacity;
+    while (node_num > 1 && item_num / node_num < min_size &&
+           (item_num + node_num - 2) / (node_num - 1) <= max_size) {
+      node_num--;
+    }
+
+    Level level;
+    level.node_count = static_cast<int>(node_num);
+    level.base_size  = static_cast<int>(item_num / node_num);
+    level.extra_num  = static_cast<int>(item_num % node_num);
+    levels_.push_back(level);
+
+    item_num = node_num;
+    leaf     = false;
+  } while (item_num > 1);
+}
+
+RC BplusTreeBulkLoader::append(int level, const char *key, const char *value)
+{
+  Level &current = levels_[level];
+  if (current.frame == nullptr || current.node_size == current.base_size + (current.node_index < current.extra_num)) {
+    RC rc = open_node(level, key);
+    if (rc != RC::SUCCESS) {
+      return rc;
+    }
+  }
+
+  if (level == 0) {
+    LeafIndexNodeHandler leaf_node(tree_handler_.file_header_, current.frame);
+    leaf_node.insert(current.node_size, key, value);
+  } else {
+    InternalIndexNodeHandler internal_node(tree_handler_.file_header_, current.frame);
+    internal_node.append_child(key, *reinterpret_cast<const PageNum *>(value));
+  }
+  current.node_size++;
+  return RC::SUCCESS;
+}
+
+RC BplusTreeBulkLoader::open_node(int level, const char *first_key)
+{
+  const IndexFileHeader &header           = tree_handler_.file_header_;
+  DiskBufferPool        *disk_buffer_pool = tree_handler_.disk_buffer_pool_;
+
+  Frame *frame = nullptr;
+  RC     rc    = disk_buffer_pool->allocate_page(&frame);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to allocate index page. level=%d, rc=%s", level, strrc(rc));
+    return rc;
+  }
+
+  if (level == 0) {
+    LeafIndexNodeHandler leaf_node(header, frame);
+    leaf_node.init_empty();
+  } else {
+    InternalIndexNodeHandler internal_node(header, frame);
+    internal_node.init_empty();
+  }
+
+  // 新节点的第一个键值就是它在父节点中的键值
+  if (level + 1 < static_cast<int>(levels_.size())) {
+    PageNum page_num = frame->page_num();
+    rc = append(level + 1, first_key, reinterpret_cast<const char *>(&page_num));
+    if (rc != RC::SUCCESS) {
+      frame->mark_dirty();
+      disk_buffer_pool->unpin_page(frame);
+      return rc;
+    }
+
+    IndexNodeHandler node(header, frame);
+    node.set_parent_page_num(levels_[level + 1].frame->page_num());
+  }
+
+  Level &current = levels_[level];
+  if (current.frame != nullptr) {
+    if (level == 0) {
+      LeafIndexNodeHandler prev_node(header, current.frame);
+      prev_node.set_next_page(frame->page_num());
+    }
+    current.frame->mark_dirty();
+    disk_buffer_pool->unpin_page(current.frame);
+  }
+
+  current.frame     = frame;
+  current.node_size = 0;
+  current.node_index++;
+  return RC::SUCCESS;
+}
+
+RC BplusTreeBulkLoader::finish_levels()
+{
+  const PageNum root_page_num = levels_.back().frame->page_num();
+  release_levels();
+
+  tree_handler_.root_lock_.lock();
+  tree_handler_.update_root_page_num_locked(root_page_num);
+  tree_handler_.root_lock_.unlock();
+  return RC::SUCCESS;
+}
+
+void BplusTreeBulkLoader::release_levels()
+{
+  for (Level &level : levels_) {
+    if (level.frame != nullptr) {
+      level.frame->mark_dirty();
+      tree_handler_.disk_buffer_pool_->unpin_page(level.frame);
+      level.frame = nullptr;
+    }
+  }
+}
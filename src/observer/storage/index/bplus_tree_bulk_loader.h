@@ -0,0 +1,114 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "storage/index/bplus_tree.h"
+
+/**
+ * @brief 在空的B+树上批量导入数据
+ * @ingroup BPlusTree
+ * @details 创建索引时表中已经有数据了。逐条插入时每条数据都要从根节点开始查找叶子节点，
+ * 叶子节点满了就分裂，分裂出来的节点都只有一半的数据。
+ * 批量导入先把所有的键值排好序，然后从左到右依次填充叶子节点，每个页面只写一次。
+ * 每一层保留一个正在填充的节点，新的节点一分配就把它的第一个键值追加到上一层的节点中，
+ * 所以整个过程中每层只固定一个页面，父节点也是在创建子节点时就确定的。
+ *
+ * 节点按照 fill_factor 填充，给以后的插入留下空间。知道总数之后，同一层的数据平均分到各个节点上，
+ * 避免最后一个节点只有很少的数据。
+ *
+ * 键值占用的内存超过 memory_limit 时，把已经收集的键值排好序写到临时文件中，
+ * 最后对这些有序的段做多路归并。
+ */
+class BplusTreeBulkLoader
+{
+public:
+  static constexpr int    DEFAULT_FILL_FACTOR  = 90;                 ///< 百分比
+  static constexpr size_t DEFAULT_MEMORY_LIMIT = 64 * 1024 * 1024;  ///< 排序使用的内存
+  static constexpr size_t MIN_MEMORY_LIMIT     = 1024 * 1024;       ///< 配置项允许的最小值，太小时每个键值都会成为一段
+
+  /**
+   * @param fill_factor  节点的填充比例，百分比，取值范围是 [50, 100]
+   * @param memory_limit 排序时在内存中最多保存的键值占用的空间
+   */
+  BplusTreeBulkLoader(BplusTreeHandler &tree_handler, int fill_factor = DEFAULT_FILL_FACTOR,
+      size_t memory_limit = DEFAULT_MEMORY_LIMIT);
+  ~BplusTreeBulkLoader();
+
+  /**
+   * @brief 添加一个键值，可以是任意顺序
+   * @note 这里假设user_key的内存大小与attr_length 一致
+   */
+  RC add(const char *user_key, const RID &rid);
+
+  /**
+   * @brief 排序并构建B+树。B+树必须是空的
+   */
+  RC finish();
+
+  int64_t count() const { return total_; }
+
+private:
+  /**
+   * @brief 临时文件中一段有序的键值
+   */
+  struct Run
+  {
+    int64_t offset = 0;  ///< 在临时文件中的偏移
+    int64_t count  = 0;
+  };
+
+  class RunReader;
+
+  /**
+   * @brief 正在构建的一层节点
+   */
+  struct Level
+  {
+    int    node_count = 0;  ///< 这一层的节点总数
+    int    base_size  = 0;  ///< 每个节点至少有这么多数据，前 extra_num 个节点多一个
+    int    extra_num  = 0;
+    int    node_index = -1;  ///< 当前节点是这一层的第几个节点
+    int    node_size  = 0;   ///< 当前节点已经填充的数据个数
+    Frame *frame      = nullptr;
+  };
+
+  void sort_buffer();
+  RC   spill();
+  RC   merge_runs();
+
+  void plan_levels();
+  RC   append(int level, const char *key, const char *value);
+  RC   open_node(int level, const char *first_key);
+  RC   finish_levels();
+  void release_levels();
+
+private:
+  BplusTreeHandler &tree_handler_;
+  int               fill_factor_;
+  size_t            memory_limit_;
+  int               key_length_ = 0;  ///< 包括RID的完整键值长度
+  int64_t           total_      = 0;
+
+  std::vector<char>         buffer_;  ///< 还没有写到临时文件中的键值
+  std::vector<const char *> sorted_;  ///< buffer_ 中的键值排序后的顺序
+
+  std::string      run_file_name_;
+  int              run_fd_ = -1;
+  int64_t          run_file_size_ = 0;
+  std::vector<Run> runs_;
+
+  std::vector<Level> levels_;  ///< 下标为0的是叶子节点
+};
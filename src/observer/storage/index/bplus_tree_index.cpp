@@ -12,12 +12,17 @@ See the Mulan PSL v2 for more details. */
 // Created by wangyunlai.wyl on 2021/5/19.
 //
 
+#include <string.h>
+#include <algorithm>
+
 #include "storage/index/bplus_tree_index.h"
+#include "storage/index/bplus_tree_bulk_loader.h"
 #include "common/log/log.h"
 
 BplusTreeIndex::~BplusTreeIndex() noexcept { close(); }
 
-RC BplusTreeIndex::create(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_meta)
+RC BplusTreeIndex::create(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_meta,
+                          const char *codec /* = nullptr */)
 {
   if (inited_) {
     LOG_WARN("Failed to create index due to the index has been created before. file_name:%s, index:%s, field:%s",
@@ -36,7 +41,7 @@ RC BplusTreeIndex::create(const char *file_name, const IndexMeta &index_meta, co
     len.push_back(f_m.len());
   }
 
-  RC rc = index_handler_.create(file_name, type, len);
+  RC rc = index_handler_.create(file_name, type, len, -1 /*internal_max_size*/, -1 /*leaf_max_size*/, codec);
   if (RC::SUCCESS != rc) {
     LOG_WARN("Failed to create index_handler, file_name:%s, index:%s, field:%s, rc:%s",
         file_name,
@@ -123,14 +128,70 @@ RC BplusTreeIndex::insert_entry(const char *record, const RID *rid)
   return index_handler_.insert_entry(rel.c_str(), rid);
 }
 
-RC BplusTreeIndex::insert_entry_first(const char *record, const RID *rid)
+RC BplusTreeIndex::insert_entries(const char *const *records, const RID *rids, int count)
 {
-  std::string rel;
-  for (FieldMeta f_m : field_meta_) {
-    const char *fieldData = record + f_m.offset();
-    rel += std::string(fieldData, f_m.len());
+  int key_length = 0;
+  for (const FieldMeta &f_m : field_meta_) {
+    key_length += f_m.len();
   }
-  return index_handler_.insert_entry(rel.c_str(), rid);
+
+  std::string keys(static_cast<size_t>(key_length) * count, '\0');
+  for (int i = 0; i < count; i++) {
+    char *key = &keys[static_cast<size_t>(key_length) * i];
+    for (const FieldMeta &f_m : field_meta_) {
+      memcpy(key, records[i] + f_m.offset(), f_m.len());
+      key += f_m.len();
+    }
+  }
+
+  std::vector<int> order(count);
+  for (int i = 0; i < count; i++) {
+    order[i] = i;
+  }
+
+  const AttrComparator &comparator = index_handler_.key_comparator().attr_comparator();
+  std::sort(order.begin(), order.end(), [&](int left, int right) {
+    int result = comparator(&keys[static_cast<size_t>(key_length) * left], &keys[static_cast<size_t>(key_length) * right]);
+    if (result != 0) {
+      return result < 0;
+    }
+    return RID::compare(&rids[left], &rids[right]) < 0;
+  });
+
+  std::vector<const char *> sorted_records(count);
+  std::vector<RID>          sorted_rids(count);
+  for (int i = 0; i < count; i++) {
+    sorted_records[i] = records[order[i]];
+    sorted_rids[i]    = rids[order[i]];
+  }
+  return Index::insert_entries(sorted_records.data(), sorted_rids.data(), count);
+}
+
+RC BplusTreeIndex::bulk_load(RecordFileScanner &scanner, int fill_factor, size_t memory_limit)
+{
+  BplusTreeBulkLoader loader(index_handler_, fill_factor, memory_limit);
+
+  std::string key;
+  Record      record;
+  while (scanner.has_next()) {
+    RC rc = scanner.next(record);
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("failed to scan records while loading index. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+      return rc;
+    }
+
+    key.clear();
+    for (const FieldMeta &f_m : field_meta_) {
+      key.append(record.data() + f_m.offset(), f_m.len());
+    }
+    rc = loader.add(key.data(), record.rid());
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("failed to add key while loading index. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+      return rc;
+    }
+  }
+
+  return loader.finish();
 }
 
 RC BplusTreeIndex::delete_entry(const char *record, const RID *rid)
@@ -27,15 +27,32 @@ public:
   BplusTreeIndex() = default;
   virtual ~BplusTreeIndex() noexcept;
 
-  RC create(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_meta);
+  /**
+   * @param codec 索引文件的页面压缩算法，为空时不压缩
+   */
+  RC create(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_meta,
+            const char *codec = nullptr);
   RC open(const char *file_name, const IndexMeta &index_meta, const std::vector<FieldMeta> &field_meta);
   RC close();
 
   RC unique_check(const char *record, const RID *rid) override;
   RC insert_entry(const char *record, const RID *rid) override;
-  RC insert_entry_first(const char *record, const RID *rid) override;
   RC delete_entry(const char *record, const RID *rid) override;
 
+  /**
+   * @brief 按照键值从小到大的顺序插入
+   * @details 相邻的键值大多落在同一个或者相邻的叶子节点上，访问的页面更集中
+   */
+  RC insert_entries(const char *const *records, const RID *rids, int count) override;
+
+  /**
+   * @brief 把扫描到的所有记录批量导入到刚创建的空索引中
+   * @details 先对键值排序，再自底向上构建B+树，参考 BplusTreeBulkLoader
+   * @param fill_factor  节点的填充比例，百分比
+   * @param memory_limit 排序时使用的内存，超过时使用临时文件做外部排序
+   */
+  RC bulk_load(RecordFileScanner &scanner, int fill_factor, size_t memory_limit);
+
   /**
    * 扫描指定范围的数据
    */
@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "storage/index/index.h"
+#include "common/log/log.h"
 
 RC Index::init(const IndexMeta &index_meta, const std::vector<FieldMeta> &field_meta)
 {
@@ -20,3 +21,21 @@ RC Index::init(const IndexMeta &index_meta, const std::vector<FieldMeta> &field_
   field_meta_ = field_meta;
   return RC::SUCCESS;
 }
+
+RC Index::insert_entries(const char *const *records, const RID *rids, int count)
+{
+  for (int i = 0; i < count; i++) {
+    RC rc = insert_entry(records[i], &rids[i]);
+    if (OB_FAIL(rc)) {
+      for (int j = 0; j < i; j++) {
+        RC rc2 = delete_entry(records[j], &rids[j]);
+        if (OB_FAIL(rc2)) {
+          LOG_WARN("failed to rollback index entry. index=%s, rid=%s, rc=%s",
+                   index_meta_.name(), rids[j].to_string().c_str(), strrc(rc2));
+        }
+      }
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
@@ -76,7 +76,14 @@ public:
 
   virtual RC unique_check(const char *record, const RID *rid) = 0;
 
-  virtual RC insert_entry_first(const char *record, const RID *rid) = 0;
+  /**
+   * @brief 批量插入数据
+   * @details 默认按顺序逐条插入。任何一条插入失败时，会删除这次已经插入的数据
+   * @param records 每条记录的内容
+   * @param rids    每条记录的位置
+   * @param count   记录的条数
+   */
+  virtual RC insert_entries(const char *const *records, const RID *rids, int count);
 
   /**
    * @brief 创建一个索引数据的扫描器
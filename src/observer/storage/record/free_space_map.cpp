@@ -0,0 +1,167 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "storage/record/free_space_map.h"
+#include "common/log/log.h"
+#include "storage/common/io_backend.h"
+
+using namespace std;
+
+static_assert(sizeof(FreeSpaceMapHeader) <= FreeSpaceMap::HEADER_SIZE, "header should fit in the header area");
+
+namespace {
+
+inline int bitmap_bytes(int32_t page_count) { return (page_count + 7) / 8; }
+
+}  // namespace
+
+FreeSpaceMap::~FreeSpaceMap()
+{
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+string FreeSpaceMap::map_file_name(const char *data_file)
+{
+  return string(data_file) + ".fsm";
+}
+
+RC FreeSpaceMap::open(const char *file_name, int32_t page_count, int32_t allocated_pages, bool &loaded)
+{
+  loaded = false;
+  if (fd_ >= 0) {
+    LOG_WARN("free space map has been opened. file=%s", file_name_.c_str());
+    return RC::RECORD_OPENNED;
+  }
+
+  int fd = ::open(file_name, O_RDWR | O_CREAT, S_IREAD | S_IWRITE);
+  if (fd < 0) {
+    LOG_ERROR("Failed to open free space map %s, due to %s.", file_name, strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+
+  bitmap_.clear();
+  struct stat st;
+  const int   bytes = bitmap_bytes(page_count);
+  if (fstat(fd, &st) == 0 && st.st_size >= HEADER_SIZE + bytes) {
+    FreeSpaceMapHeader header;
+    RC rc = IoBackend::instance().read(fd, &header, sizeof(header), 0);
+    if (OB_SUCC(rc) && 0 == memcmp(header.magic, FreeSpaceMapHeader::MAGIC, sizeof(header.magic)) &&
+        header.version == FreeSpaceMapHeader::VERSION && header.clean != 0 && header.page_count == page_count &&
+        header.allocated_pages == allocated_pages) {
+      bitmap_.resize(bytes);
+      rc     = IoBackend::instance().read(fd, bitmap_.data(), bytes, HEADER_SIZE);
+      loaded = OB_SUCC(rc);
+    }
+  }
+  if (!loaded) {
+    LOG_INFO("free space map is not usable, it will be rebuilt. file=%s", file_name);
+    bitmap_.clear();
+  }
+
+  fd_        = fd;
+  file_name_ = file_name;
+
+  // 先把文件标记为没有正常关闭，崩溃之后就不会再使用旧的映射
+  RC rc = write_header(false /*clean*/, page_count, allocated_pages);
+  if (OB_SUCC(rc)) {
+    rc = IoBackend::instance().sync(fd_);
+  }
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to mark free space map as in use. file=%s, rc=%s", file_name, strrc(rc));
+    ::close(fd_);
+    fd_     = -1;
+    loaded  = false;
+    bitmap_.clear();
+    return rc;
+  }
+  return RC::SUCCESS;
+}
+
+RC FreeSpaceMap::close(int32_t page_count, int32_t allocated_pages)
+{
+  if (fd_ < 0) {
+    return RC::SUCCESS;
+  }
+
+  // 映射先落盘，然后才能标记为正常关闭
+  bitmap_.resize(bitmap_bytes(page_count), 0);
+  RC rc = IoBackend::instance().write(fd_, bitmap_.data(), static_cast<int>(bitmap_.size()), HEADER_SIZE);
+  if (OB_SUCC(rc)) {
+    rc = IoBackend::instance().sync(fd_);
+  }
+  if (OB_SUCC(rc)) {
+    rc = write_header(true /*clean*/, page_count, allocated_pages);
+  }
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to write free space map, it will be rebuilt next time. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+  }
+
+  ::close(fd_);
+  fd_ = -1;
+  bitmap_.clear();
+  return rc;
+}
+
+void FreeSpaceMap::set_free(PageNum page_num, bool free)
+{
+  if (fd_ < 0 || page_num < 0) {
+    return;
+  }
+
+  const size_t index = page_num / 8;
+  if (index >= bitmap_.size()) {
+    if (!free) {
+      return;
+    }
+    bitmap_.resize(index + 1, 0);
+  }
+
+  const char mask = static_cast<char>(1 << (page_num % 8));
+  if (free) {
+    bitmap_[index] |= mask;
+  } else {
+    bitmap_[index] &= ~mask;
+  }
+}
+
+void FreeSpaceMap::for_each_free_page(const function<void(PageNum)> &visitor) const
+{
+  for (size_t i = 0; i < bitmap_.size(); i++) {
+    if (bitmap_[i] == 0) {
+      continue;
+    }
+    for (int bit = 0; bit < 8; bit++) {
+      if (bitmap_[i] & (1 << bit)) {
+        visitor(static_cast<PageNum>(i * 8 + bit));
+      }
+    }
+  }
+}
+
+RC FreeSpaceMap::write_header(bool clean, int32_t page_count, int32_t allocated_pages)
+{
+  FreeSpaceMapHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, FreeSpaceMapHeader::MAGIC, sizeof(header.magic));
+  header.version         = FreeSpaceMapHeader::VERSION;
+  header.clean           = clean ? 1 : 0;
+  header.page_count      = page_count;
+  header.allocated_pages = allocated_pages;
+  return IoBackend::instance().write(fd_, &header, sizeof(header), 0);
+}
@@ -0,0 +1,88 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "common/rc.h"
+#include "storage/buffer/page.h"
+
+/**
+ * @brief 空闲空间映射文件的文件头
+ * @ingroup RecordManager
+ */
+struct FreeSpaceMapHeader
+{
+  static constexpr char    MAGIC[8] = {'M', 'O', 'B', 'F', 'S', 'M', 'A', 'P'};
+  static constexpr int32_t VERSION  = 1;
+
+  char    magic[8];
+  int32_t version;
+  int32_t clean;            ///< 上次是否正常关闭。打开时先清零，关闭时写完映射之后再置1
+  int32_t page_count;       ///< 关闭时数据文件的页面数
+  int32_t allocated_pages;  ///< 关闭时数据文件中分配了多少个页面
+};
+
+/**
+ * @brief 记录文件的空闲空间映射
+ * @ingroup RecordManager
+ * @details 每个数据文件有一个映射文件(数据文件名加上 .fsm)，文件头之后是一个位图，第i位表示第i个页面是否还能插入记录。
+ * RecordFileHandler 打开时读取位图就能知道哪些页面有空闲空间，不需要加载数据文件的每个页面，
+ * 插入和删除记录时由 RecordFileHandler 同步修改内存中的位图，关闭时写回文件。
+ *
+ * 映射只是一个提示：标记为空闲的页面插入之前还会检查，满了就跳过。
+ * 打开时文件头会先标记为没有正常关闭并落盘，所以系统崩溃之后，或者映射与数据文件的页面数对不上时，
+ * 映射都不会被使用，RecordFileHandler 会退回到扫描整个数据文件，再重建映射。
+ */
+class FreeSpaceMap
+{
+public:
+  static constexpr int HEADER_SIZE = 512;  ///< 位图从这个偏移开始
+
+public:
+  FreeSpaceMap() = default;
+  ~FreeSpaceMap();
+
+  static std::string map_file_name(const char *data_file);
+
+  /**
+   * @brief 打开映射文件，不存在时创建
+   * @param page_count      数据文件当前的页面数
+   * @param allocated_pages 数据文件当前分配的页面数
+   * @param[out] loaded     映射是否可用。不可用时位图是空的，需要调用者扫描数据文件之后通过 set_free 重建
+   */
+  RC open(const char *file_name, int32_t page_count, int32_t allocated_pages, bool &loaded);
+
+  /**
+   * @brief 写回位图，标记为正常关闭，然后关闭文件
+   */
+  RC close(int32_t page_count, int32_t allocated_pages);
+
+  bool is_open() const { return fd_ >= 0; }
+
+  void set_free(PageNum page_num, bool free);
+
+  /**
+   * @brief 按页面号从小到大访问所有标记为空闲的页面
+   */
+  void for_each_free_page(const std::function<void(PageNum)> &visitor) const;
+
+private:
+  RC write_header(bool clean, int32_t page_count, int32_t allocated_pages);
+
+private:
+  std::string       file_name_;
+  int               fd_ = -1;
+  std::vector<char> bitmap_;
+};
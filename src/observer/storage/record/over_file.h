@@ -1,4 +0,0 @@
-#include <map>
-#include "record.h"
-
-extern std::map<PageNum, int> overflow_pages;
\ No newline at end of file
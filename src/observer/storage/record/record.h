@@ -39,11 +39,6 @@ struct RID
   PageNum page_num;  // record's page number
   SlotNum slot_num;  // record's slot number
 
-  RID    *next_RID = nullptr;
-  bool    init = false;
-  size_t  over_len;
-  size_t  text_value = 0;
-
   RID() = default;
   RID(const PageNum _page_num, const SlotNum _slot_num) : page_num(_page_num), slot_num(_slot_num) {}
 
@@ -68,18 +63,6 @@ struct RID
     }
   }
 
-  bool set_overflow_rid(RID *rid) {
-    if (rid == nullptr) {
-      return false;
-    }
-    next_RID = rid;
-    return true;
-  }
-
-  RID *get_overflow_rid() {
-    return next_RID;
-  }
-
   /**
    * 返回一个不可能出现的最小的RID
    * 虽然page num 0和slot num 0都是合法的，但是page num 0通常用于存放meta数据，所以对数据部分来说都是
@@ -115,10 +98,8 @@ public:
   ~Record()
   {
     if (owner_ && data_ != nullptr) {
-      if (!if_text_){
-        free(data_);
-        data_ = nullptr;
-      }
+      free(data_);
+      data_ = nullptr;
     }
   }
 
@@ -172,18 +153,6 @@ public:
   void reset_owner() {
     owner_ = false;
   }
-  void set_if_text() {
-    if_text_ =true;
-  }
-  bool get_if_text() const{
-    return if_text_;
-  }
-  void add_offset_text(int v) {
-    offset_text.push_back(v);
-  }
-  std::vector<size_t> get_offset_text() const {
-    return offset_text;
-  }
 
   void set_rid(const RID &rid) { this->rid_ = rid; }
   void set_rid(const PageNum page_num, const SlotNum slot_num)
@@ -207,6 +176,4 @@ private:
   char *data_  = nullptr;
   int   len_   = 0;       /// 如果不是record自己来管理内存，这个字段可能是无效的
   bool  owner_ = false;   /// 表示当前是否由record来管理内存
-  bool  if_text_ =false;
-  std::vector<size_t> offset_text;
 };
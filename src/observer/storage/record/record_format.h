@@ -0,0 +1,52 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <strings.h>
+
+#include "common/lang/string.h"
+
+/**
+ * @brief 记录在页面上的存放格式，每张表创建时选定
+ * @ingroup RecordManager
+ * @details 不管使用哪种格式，记录在内存中都是定长的，字段通过 FieldMeta::offset 访问。
+ * 格式也会记录在每个页面的页头中，参考 PageHeader。
+ */
+enum class RecordFormat
+{
+  FIXED   = 0,  ///< 定长记录，页面上是记录分配位图和一个个定长的槽位
+  SLOTTED = 1,  ///< 变长记录，页面上是槽位目录，记录编码之后从页面末尾往前存放
+};
+
+inline const char *record_format_name(RecordFormat format)
+{
+  switch (format) {
+    case RecordFormat::FIXED: return "fixed";
+    case RecordFormat::SLOTTED: return "slotted";
+  }
+  return "unknown";
+}
+
+/**
+ * @brief 根据名字获取记录格式，不区分大小写。空字符串表示 fixed
+ * @return 名字不合法时返回false
+ */
+inline bool record_format_from_name(const char *name, RecordFormat &format)
+{
+  if (common::is_blank(name) || 0 == strcasecmp(name, "fixed")) {
+    format = RecordFormat::FIXED;
+  } else if (0 == strcasecmp(name, "slotted")) {
+    format = RecordFormat::SLOTTED;
+  } else {
+    return false;
+  }
+  return true;
+}
@@ -11,6 +11,8 @@ See the Mulan PSL v2 for more details. */
 //
 // Created by Meiyi & Longda on 2021/4/13.
 //
+#include <algorithm>
+
 #include "storage/record/record_manager.h"
 #include "common/log/log.h"
 #include "common/lang/bitmap.h"
@@ -50,6 +52,105 @@ int page_record_capacity(int page_size, int record_size)
  */
 int page_bitmap_size(int record_capacity) { return (record_capacity + 7) / 8; }
 
+/**
+ * 变长页面上记录的编码格式：由若干段组成，每段以一个控制字节开始。
+ * 控制字节小于 0x80 时，后面跟着 c+1 个原样保存的字节；否则表示 c-0x80+1 个0。
+ * 只有连续4个以上的0(或者记录末尾的0)才压缩，短的0串当作原样保存的字节，这样整数字段在原地更新时编码长度变化不大。
+ */
+namespace {
+
+constexpr int     MAX_SEGMENT_LENGTH = 128;
+constexpr int     MIN_ZERO_RUN       = 4;
+constexpr uint8_t ZERO_RUN_FLAG      = 0x80;
+
+/**
+ * @brief 编码后最大的长度
+ */
+int max_encoded_length(int record_size) { return record_size + (record_size + MAX_SEGMENT_LENGTH - 1) / MAX_SEGMENT_LENGTH + 1; }
+
+/**
+ * @brief 编码一条记录，out 为nullptr时只计算长度
+ */
+int encode_record(const char *data, int record_size, char *out)
+{
+  int length = 0;
+  auto put_literal = [&](int start, int end) {
+    while (start < end) {
+      const int segment = std::min(end - start, MAX_SEGMENT_LENGTH);
+      if (out != nullptr) {
+        out[length] = static_cast<char>(segment - 1);
+        memcpy(out + length + 1, data + start, segment);
+      }
+      length += segment + 1;
+      start += segment;
+    }
+  };
+  auto put_zero_run = [&](int run) {
+    while (run > 0) {
+      const int segment = std::min(run, MAX_SEGMENT_LENGTH);
+      if (out != nullptr) {
+        out[length] = static_cast<char>(ZERO_RUN_FLAG | (segment - 1));
+      }
+      length += 1;
+      run -= segment;
+    }
+  };
+
+  int literal_start = 0;
+  int pos           = 0;
+  while (pos < record_size) {
+    if (data[pos] != 0) {
+      pos++;
+      continue;
+    }
+
+    int run_end = pos;
+    while (run_end < record_size && data[run_end] == 0) {
+      run_end++;
+    }
+    if (run_end - pos >= MIN_ZERO_RUN || run_end == record_size) {
+      put_literal(literal_start, pos);
+      put_zero_run(run_end - pos);
+      literal_start = run_end;
+    }
+    pos = run_end;
+  }
+  put_literal(literal_start, record_size);
+  return length;
+}
+
+RC decode_record(const char *in, int length, char *data, int record_size)
+{
+  int ip = 0;
+  int op = 0;
+  while (ip < length) {
+    const uint8_t control = static_cast<uint8_t>(in[ip++]);
+    const int     segment = (control & ~ZERO_RUN_FLAG) + 1;
+    if (op + segment > record_size) {
+      break;
+    }
+
+    if (control & ZERO_RUN_FLAG) {
+      memset(data + op, 0, segment);
+    } else {
+      if (ip + segment > length) {
+        break;
+      }
+      memcpy(data + op, in + ip, segment);
+      ip += segment;
+    }
+    op += segment;
+  }
+
+  if (ip != length || op != record_size) {
+    LOG_ERROR("corrupted slotted record. length=%d, record size=%d, decoded=%d", length, record_size, op);
+    return RC::IOERR_READ;
+  }
+  return RC::SUCCESS;
+}
+
+}  // namespace
+
 ////////////////////////////////////////////////////////////////////////////////
 RecordPageIterator::RecordPageIterator() {}
 RecordPageIterator::~RecordPageIterator() {}
@@ -58,8 +159,13 @@ void RecordPageIterator::init(RecordPageHandler &record_page_handler, SlotNum st
 {
   record_page_handler_ = &record_page_handler;
   page_num_            = record_page_handler.get_page_num();
-  bitmap_.init(record_page_handler.bitmap_, record_page_handler.page_header_->record_capacity);
-  next_slot_num_ = bitmap_.next_setted_bit(start_slot_num);
+  slotted_             = record_page_handler.slotted();
+  if (slotted_) {
+    next_slot_num_ = record_page_handler.next_slotted_record(start_slot_num);
+  } else {
+    bitmap_.init(record_page_handler.bitmap_, record_page_handler.page_header_->record_capacity);
+    next_slot_num_ = bitmap_.next_setted_bit(start_slot_num);
+  }
 }
 
 bool RecordPageIterator::has_next() { return -1 != next_slot_num_; }
@@ -67,19 +173,29 @@ bool RecordPageIterator::has_next() { return -1 != next_slot_num_; }
 RC RecordPageIterator::next(Record &record)
 {
   record.set_rid(page_num_, next_slot_num_);
-  record.set_data(record_page_handler_->get_record_data(record.rid().slot_num));
+  if (next_slot_num_ < 0) {
+    return RC::RECORD_EOF;
+  }
+
+  char *data = record_page_handler_->record_data(next_slot_num_);
+  if (data == nullptr) {
+    return RC::IOERR_READ;
+  }
+  record.set_data(data, record_page_handler_->page_header_->record_real_size);
 
-  if (next_slot_num_ >= 0) {
+  if (slotted_) {
+    next_slot_num_ = record_page_handler_->next_slotted_record(next_slot_num_ + 1);
+  } else {
     next_slot_num_ = bitmap_.next_setted_bit(next_slot_num_ + 1);
   }
-  return record.rid().slot_num != -1 ? RC::SUCCESS : RC::RECORD_EOF;
+  return RC::SUCCESS;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 RecordPageHandler::~RecordPageHandler() { cleanup(); }
 
-RC RecordPageHandler::init(DiskBufferPool &buffer_pool, PageNum page_num, bool readonly)
+RC RecordPageHandler::init(DiskBufferPool &buffer_pool, PageNum page_num, bool readonly, BufferRing *ring /* = nullptr */)
 {
   if (disk_buffer_pool_ != nullptr) {
     if (frame_->page_num() == page_num) {
@@ -91,25 +207,75 @@ RC RecordPageHandler::init(DiskBufferPool &buffer_pool, PageNum page_num, bool r
   }
 
   RC ret = RC::SUCCESS;
-  if ((ret = buffer_pool.get_this_page(page_num, &frame_)) != RC::SUCCESS) {
+  ret = (ring != nullptr) ? ring->get_this_page(page_num, &frame_) : buffer_pool.get_this_page(page_num, &frame_);
+  if (ret != RC::SUCCESS) {
     LOG_ERROR("Failed to get page handle from disk buffer pool. ret=%d:%s", ret, strrc(ret));
     return ret;
   }
 
-  char *data = frame_->data();
-
   if (readonly) {
     frame_->read_latch();
   } else {
     frame_->write_latch();
   }
+  latched_ = true;
+  setup_page(buffer_pool, frame_->data(), readonly);
+
+  LOG_TRACE("Successfully init page_num %d.", page_num);
+  return ret;
+}
+
+RC RecordPageHandler::init_snapshot(DiskBufferPool &buffer_pool, PageNum page_num, BufferRing *ring /* = nullptr */)
+{
+  if (disk_buffer_pool_ != nullptr) {
+    cleanup();
+  }
+
+  RC ret = (ring != nullptr) ? ring->get_this_page(page_num, &frame_) : buffer_pool.get_this_page(page_num, &frame_);
+  if (ret != RC::SUCCESS) {
+    LOG_ERROR("Failed to get page handle from disk buffer pool. ret=%d:%s", ret, strrc(ret));
+    return ret;
+  }
+
+  char *data = frame_->data();
+  latched_   = false;
+#ifdef CONCURRENCY
+  snapshot_index_ ^= 1;
+  std::unique_ptr<Page> &snapshot = snapshots_[snapshot_index_];
+  if (snapshot == nullptr) {
+    snapshot.reset(new Page);
+  }
+
+  bool copied = false;
+  for (int i = 0; i < MAX_SNAPSHOT_RETRY && !copied; i++) {
+    uint64_t version = 0;
+    if (frame_->read_version(version)) {
+      memcpy(snapshot.get(), &frame_->page(), sizeof(Page));
+      copied = frame_->validate_version(version);
+    }
+  }
+
+  if (copied) {
+    data = snapshot->data;
+  } else {
+    frame_->read_latch();
+    latched_ = true;
+  }
+#endif
+
+  setup_page(buffer_pool, data, true /*readonly*/);
+  LOG_TRACE("Successfully init page_num %d with snapshot. latched=%d", page_num, latched_);
+  return ret;
+}
+
+void RecordPageHandler::setup_page(DiskBufferPool &buffer_pool, char *data, bool readonly)
+{
   disk_buffer_pool_ = &buffer_pool;
   readonly_         = readonly;
+  data_             = data;
   page_header_      = (PageHeader *)(data);
   bitmap_           = data + PAGE_HEADER_SIZE;
-  
-  LOG_TRACE("Successfully init page_num %d.", page_num);
-  return ret;
+  decoded_index_ ^= 1;
 }
 
 RC RecordPageHandler::recover_init(DiskBufferPool &buffer_pool, PageNum page_num)
@@ -125,13 +291,9 @@ RC RecordPageHandler::recover_init(DiskBufferPool &buffer_pool, PageNum page_num
     return ret;
   }
 
-  char *data = frame_->data();
-
   frame_->write_latch();
-  disk_buffer_pool_ = &buffer_pool;
-  readonly_         = false;
-  page_header_      = (PageHeader *)(data);
-  bitmap_           = data + PAGE_HEADER_SIZE;
+  latched_ = true;
+  setup_page(buffer_pool, frame_->data(), false /*readonly*/);
 
   buffer_pool.recover_page(page_num);
 
@@ -139,25 +301,42 @@ RC RecordPageHandler::recover_init(DiskBufferPool &buffer_pool, PageNum page_num
   return ret;
 }
 
-RC RecordPageHandler::init_empty_page(DiskBufferPool &buffer_pool, PageNum page_num, int record_size)
+RC RecordPageHandler::init_empty_page(
+    DiskBufferPool &buffer_pool, PageNum page_num, int record_size, RecordFormat format /* = RecordFormat::FIXED */)
 {
+  if (format == RecordFormat::SLOTTED &&
+      PAGE_HEADER_SIZE + sizeof(RecordDirectoryEntry) + max_encoded_length(record_size) + SLOTTED_RESERVE > BP_PAGE_DATA_SIZE) {
+    LOG_ERROR("Record is too large for slotted page. record_size=%d", record_size);
+    return RC::INVALID_ARGUMENT;
+  }
+
   RC ret = init(buffer_pool, page_num, false /*readonly*/);
   if (ret != RC::SUCCESS) {
     LOG_ERROR("Failed to init empty page page_num:record_size %d:%d.", page_num, record_size);
     return ret;
   }
 
-  page_header_->record_num          = 0;
-  page_header_->record_real_size    = record_size;
-  page_header_->record_size         = align8(record_size);
-  page_header_->record_capacity     = page_record_capacity(BP_PAGE_DATA_SIZE, page_header_->record_size);
-  page_header_->first_record_offset = align8(PAGE_HEADER_SIZE + page_bitmap_size(page_header_->record_capacity));
-  this->fix_record_capacity();
-  ASSERT(page_header_->first_record_offset + 
-         page_header_->record_capacity * page_header_->record_size <= BP_PAGE_DATA_SIZE, "Record overflow the page size");
-
-  bitmap_ = frame_->data() + PAGE_HEADER_SIZE;
-  memset(bitmap_, 0, page_bitmap_size(page_header_->record_capacity));
+  page_header_->record_num       = 0;
+  page_header_->record_real_size = record_size;
+  page_header_->format           = static_cast<int32_t>(format);
+  if (format == RecordFormat::SLOTTED) {
+    // 槽位目录是空的，整个页面除了页头都是空闲的
+    page_header_->record_size         = 0;
+    page_header_->record_capacity     = 0;
+    page_header_->first_record_offset = BP_PAGE_DATA_SIZE;
+    page_header_->free_size           = BP_PAGE_DATA_SIZE - PAGE_HEADER_SIZE;
+  } else {
+    page_header_->record_size         = align8(record_size);
+    page_header_->record_capacity     = page_record_capacity(BP_PAGE_DATA_SIZE, page_header_->record_size);
+    page_header_->first_record_offset = align8(PAGE_HEADER_SIZE + page_bitmap_size(page_header_->record_capacity));
+    page_header_->free_size           = 0;
+    this->fix_record_capacity();
+    ASSERT(page_header_->first_record_offset + 
+           page_header_->record_capacity * page_header_->record_size <= BP_PAGE_DATA_SIZE, "Record overflow the page size");
+
+    bitmap_ = frame_->data() + PAGE_HEADER_SIZE;
+    memset(bitmap_, 0, page_bitmap_size(page_header_->record_capacity));
+  }
 
   if ((ret = buffer_pool.flush_page(*frame_)) != RC::SUCCESS) {
     LOG_ERROR("Failed to flush page header %d:%d.", buffer_pool.file_desc(), page_num);
@@ -170,11 +349,13 @@ RC RecordPageHandler::init_empty_page(DiskBufferPool &buffer_pool, PageNum page_
 RC RecordPageHandler::cleanup()
 {
   if (disk_buffer_pool_ != nullptr) {
-    if (readonly_) {
+    // 使用页面拷贝时没有加锁
+    if (latched_ && readonly_) {
       frame_->read_unlatch();
-    } else {
+    } else if (latched_) {
       frame_->write_unlatch();
     }
+    latched_ = false;
     disk_buffer_pool_->unpin_page(frame_);
     disk_buffer_pool_ = nullptr;
   }
@@ -184,6 +365,10 @@ RC RecordPageHandler::cleanup()
 
 RC RecordPageHandler::update_record(const char *data, const RID *rid) {
   ASSERT(readonly_ == false, "cannot update record into page while the page is readonly");
+  if (slotted()) {
+    return update_slotted_record(data, rid->slot_num, false /*use_reserve*/);
+  }
+
   if (rid->slot_num >= page_header_->record_capacity) {
     LOG_ERROR("Invalid slot_num %d, exceed page's record capacity, page_num %d.", rid->slot_num, frame_->page_num());
     return RC::INVALID_ARGUMENT;
@@ -202,39 +387,24 @@ RC RecordPageHandler::update_record(const char *data, const RID *rid) {
   }
 }
 
-RC RecordPageHandler::insert_record(const char *data, RID *rid)
+RC RecordPageHandler::write_back_record(const Record &record)
 {
-  ASSERT(readonly_ == false, "cannot insert record into page while the page is readonly");
-
-  if (page_header_->record_num == page_header_->record_capacity) {
-    LOG_WARN("Page is full, page_num %d:%d.", disk_buffer_pool_->file_desc(), frame_->page_num());
-    return RC::RECORD_NOMEM;
+  ASSERT(readonly_ == false, "cannot write record back into page while the page is readonly");
+  if (slotted()) {
+    return update_slotted_record(record.data(), record.rid().slot_num, true /*use_reserve*/);
   }
 
-  // 找到空闲位置
-  Bitmap bitmap(bitmap_, page_header_->record_capacity);
-  int    index = bitmap.next_unsetted_bit(0);
-  bitmap.set_bit(index);
-  page_header_->record_num++;
-
-  // assert index < page_header_->record_capacity
-  char *record_data = get_record_data(index);
-  memcpy(record_data, data, page_header_->record_real_size);
-
+  // 记录直接指向页面中的数据
   frame_->mark_dirty();
-
-  if (rid) {
-    rid->page_num = get_page_num();
-    rid->slot_num = index;
-  }
-
-  // LOG_TRACE("Insert record. rid page_num=%d, slot num=%d", get_page_num(), index);
   return RC::SUCCESS;
 }
 
-RC RecordPageHandler::insert_text_record(const char *data, size_t len, RID *rid)
+RC RecordPageHandler::insert_record(const char *data, RID *rid)
 {
   ASSERT(readonly_ == false, "cannot insert record into page while the page is readonly");
+  if (slotted()) {
+    return insert_slotted_record(data, rid);
+  }
 
   if (page_header_->record_num == page_header_->record_capacity) {
     LOG_WARN("Page is full, page_num %d:%d.", disk_buffer_pool_->file_desc(), frame_->page_num());
@@ -249,15 +419,13 @@ RC RecordPageHandler::insert_text_record(const char *data, size_t len, RID *rid)
 
   // assert index < page_header_->record_capacity
   char *record_data = get_record_data(index);
-  memcpy(record_data, data, len);
+  memcpy(record_data, data, page_header_->record_real_size);
 
   frame_->mark_dirty();
 
   if (rid) {
     rid->page_num = get_page_num();
     rid->slot_num = index;
-    rid->init     = true;
-    rid->over_len = len;
   }
 
   // LOG_TRACE("Insert record. rid page_num=%d, slot num=%d", get_page_num(), index);
@@ -266,6 +434,41 @@ RC RecordPageHandler::insert_text_record(const char *data, size_t len, RID *rid)
 
 RC RecordPageHandler::recover_insert_record(const char *data, const RID &rid)
 {
+  if (slotted()) {
+    // 槽位上已经有记录时直接覆盖，否则扩展槽位目录，在指定的槽位上插入
+    if (rid.slot_num < page_header_->record_capacity && directory_entry(rid.slot_num)->offset != 0) {
+      return update_slotted_record(data, rid.slot_num, true /*use_reserve*/);
+    }
+
+    const int length = encode_record(data, page_header_->record_real_size, nullptr);
+    const int new_slots = std::max(rid.slot_num + 1 - page_header_->record_capacity, 0);
+    const int need = length + new_slots * static_cast<int>(sizeof(RecordDirectoryEntry));
+    if (page_header_->free_size < need) {
+      LOG_WARN("no space to recover record. rid=%s, free size=%d, need=%d",
+               rid.to_string().c_str(), page_header_->free_size, need);
+      return RC::RECORD_NOMEM;
+    }
+    if (page_header_->first_record_offset - directory_end() < need) {
+      compact();
+    }
+    for (int i = 0; i < new_slots; i++) {
+      RecordDirectoryEntry *entry = directory_entry(page_header_->record_capacity++);
+      entry->offset = 0;
+      entry->length = 0;
+    }
+
+    page_header_->first_record_offset -= length;
+    page_header_->free_size -= need;
+    page_header_->record_num++;
+    encode_record(data, page_header_->record_real_size, data_ + page_header_->first_record_offset);
+
+    RecordDirectoryEntry *entry = directory_entry(rid.slot_num);
+    entry->offset = static_cast<uint16_t>(page_header_->first_record_offset);
+    entry->length = static_cast<uint16_t>(length);
+    frame_->mark_dirty();
+    return RC::SUCCESS;
+  }
+
   if (rid.slot_num >= page_header_->record_capacity) {
     LOG_WARN("slot_num illegal, slot_num(%d) > record_capacity(%d).", rid.slot_num, page_header_->record_capacity);
     return RC::RECORD_INVALID_RID;
@@ -290,6 +493,9 @@ RC RecordPageHandler::recover_insert_record(const char *data, const RID &rid)
 RC RecordPageHandler::delete_record(const RID *rid)
 {
   ASSERT(readonly_ == false, "cannot delete record from page while the page is readonly");
+  if (slotted()) {
+    return delete_slotted_record(rid);
+  }
 
   if (rid->slot_num >= page_header_->record_capacity) {
     LOG_ERROR("Invalid slot_num %d, exceed page's record capacity, page_num %d.", rid->slot_num, frame_->page_num());
@@ -320,17 +526,230 @@ RC RecordPageHandler::get_record(const RID *rid, Record *rec)
     return RC::RECORD_INVALID_RID;
   }
 
-  Bitmap bitmap(bitmap_, page_header_->record_capacity);
-  if (!bitmap.get_bit(rid->slot_num)) {
+  if (slotted() ? directory_entry(rid->slot_num)->offset == 0
+                : !Bitmap(bitmap_, page_header_->record_capacity).get_bit(rid->slot_num)) {
     LOG_ERROR("Invalid slot_num:%d, slot is empty, page_num %d.", rid->slot_num, frame_->page_num());
     return RC::RECORD_NOT_EXIST;
   }
 
+  char *data = record_data(rid->slot_num);
+  if (data == nullptr) {
+    return RC::IOERR_READ;
+  }
   rec->set_rid(*rid);
-  rec->set_data(get_record_data(rid->slot_num), page_header_->record_real_size);
+  rec->set_data(data, page_header_->record_real_size);
   return RC::SUCCESS;
 }
 
+char *RecordPageHandler::record_data(SlotNum slot_num)
+{
+  if (!slotted()) {
+    return get_record_data(slot_num);
+  }
+
+  const RecordDirectoryEntry *entry = directory_entry(slot_num);
+  if (entry->offset == 0) {
+    return nullptr;
+  }
+
+  // 插入记录之后槽位可能比初始化时多，缓存不够时再扩大。扩大缓存会让之前解码的记录失效
+  const int         record_size = page_header_->record_real_size;
+  std::vector<char> &buffer     = decoded_[decoded_index_];
+  const size_t      need        = static_cast<size_t>(page_header_->record_capacity) * record_size;
+  if (buffer.size() < need) {
+    buffer.resize(need);
+  }
+
+  char *data = buffer.data() + static_cast<size_t>(slot_num) * record_size;
+  RC rc = decode_record(data_ + entry->offset, entry->length, data, record_size);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("failed to decode record. page_num=%d, slot_num=%d", get_page_num(), slot_num);
+    return nullptr;
+  }
+  return data;
+}
+
+SlotNum RecordPageHandler::next_slotted_record(SlotNum start_slot_num)
+{
+  for (SlotNum slot_num = start_slot_num; slot_num < page_header_->record_capacity; slot_num++) {
+    if (directory_entry(slot_num)->offset != 0) {
+      return slot_num;
+    }
+  }
+  return -1;
+}
+
+int RecordPageHandler::slotted_record_length(const char *data, int record_size)
+{
+  return encode_record(data, record_size, nullptr);
+}
+
+RC RecordPageHandler::insert_slotted_record(const char *data, RID *rid)
+{
+  const int record_size = page_header_->record_real_size;
+  const int length      = encode_record(data, record_size, nullptr);
+  if (!can_insert(length)) {
+    LOG_WARN("Page is full, page_num %d:%d.", disk_buffer_pool_->file_desc(), frame_->page_num());
+    return RC::RECORD_NOMEM;
+  }
+
+  // 优先使用空的槽位，没有时在槽位目录后面增加一项
+  SlotNum slot_num = 0;
+  for (; slot_num < page_header_->record_capacity; slot_num++) {
+    if (directory_entry(slot_num)->offset == 0) {
+      break;
+    }
+  }
+  const bool new_slot = (slot_num == page_header_->record_capacity);
+  const int  need     = length + (new_slot ? static_cast<int>(sizeof(RecordDirectoryEntry)) : 0);
+  if (page_header_->first_record_offset - directory_end() < need) {
+    compact();
+  }
+  if (new_slot) {
+    page_header_->record_capacity++;
+  }
+
+  page_header_->first_record_offset -= length;
+  page_header_->free_size -= need;
+  page_header_->record_num++;
+  encode_record(data, record_size, data_ + page_header_->first_record_offset);
+
+  RecordDirectoryEntry *entry = directory_entry(slot_num);
+  entry->offset = static_cast<uint16_t>(page_header_->first_record_offset);
+  entry->length = static_cast<uint16_t>(length);
+
+  frame_->mark_dirty();
+
+  if (rid) {
+    rid->page_num = get_page_num();
+    rid->slot_num = slot_num;
+  }
+  return RC::SUCCESS;
+}
+
+RC RecordPageHandler::delete_slotted_record(const RID *rid)
+{
+  if (rid->slot_num >= page_header_->record_capacity || directory_entry(rid->slot_num)->offset == 0) {
+    LOG_DEBUG("Invalid slot_num %d, slot is empty, page_num %d.", rid->slot_num, frame_->page_num());
+    return RC::RECORD_NOT_EXIST;
+  }
+
+  RecordDirectoryEntry *entry = directory_entry(rid->slot_num);
+  if (entry->offset == page_header_->first_record_offset) {
+    page_header_->first_record_offset += entry->length;
+  }
+  page_header_->free_size += entry->length;
+  page_header_->record_num--;
+  entry->offset = 0;
+  entry->length = 0;
+
+  // 槽位目录末尾的空槽位可以去掉，前面的空槽位留给之后插入的记录
+  while (page_header_->record_capacity > 0 && directory_entry(page_header_->record_capacity - 1)->offset == 0) {
+    page_header_->record_capacity--;
+    page_header_->free_size += sizeof(RecordDirectoryEntry);
+  }
+
+  compact_if_fragmented();
+  frame_->mark_dirty();
+
+  if (page_header_->record_num == 0) {
+    cleanup();
+  }
+  return RC::SUCCESS;
+}
+
+RC RecordPageHandler::update_slotted_record(const char *data, SlotNum slot_num, bool use_reserve)
+{
+  if (slot_num >= page_header_->record_capacity || directory_entry(slot_num)->offset == 0) {
+    LOG_DEBUG("Invalid slot_num %d, slot is empty, page_num %d.", slot_num, frame_->page_num());
+    return RC::RECORD_NOT_EXIST;
+  }
+
+  char encoded[BP_PAGE_DATA_SIZE];
+  const int length = encode_record(data, page_header_->record_real_size, encoded);
+
+  RecordDirectoryEntry *entry = directory_entry(slot_num);
+  if (length == entry->length && 0 == memcmp(encoded, data_ + entry->offset, length)) {
+    return RC::SUCCESS;
+  }
+
+  if (length <= entry->length) {
+    // 原地更新，多出来的空间变成碎片
+    memcpy(data_ + entry->offset, encoded, length);
+    page_header_->free_size += entry->length - length;
+    entry->length = static_cast<uint16_t>(length);
+    compact_if_fragmented();
+    frame_->mark_dirty();
+    return RC::SUCCESS;
+  }
+
+  // 变长了。不能使用预留空间时，要给页面上的其它记录留出预留空间
+  const int reserve = use_reserve ? 0 : (page_header_->record_num - 1) * SLOTTED_RESERVE;
+  if (page_header_->free_size - (length - entry->length) < reserve) {
+    LOG_TRACE("no space to update record in place. page_num=%d, slot_num=%d, length=%d->%d",
+              get_page_num(), slot_num, entry->length, length);
+    return RC::RECORD_NOMEM;
+  }
+
+  // 先释放旧的空间，空间不够时整理页面，再把记录放到记录区的最前面
+  if (entry->offset == page_header_->first_record_offset) {
+    page_header_->first_record_offset += entry->length;
+  }
+  page_header_->free_size += entry->length;
+  entry->offset = 0;
+  entry->length = 0;
+  if (page_header_->first_record_offset - directory_end() < length) {
+    compact();
+  }
+
+  page_header_->first_record_offset -= length;
+  page_header_->free_size -= length;
+  memcpy(data_ + page_header_->first_record_offset, encoded, length);
+  entry->offset = static_cast<uint16_t>(page_header_->first_record_offset);
+  entry->length = static_cast<uint16_t>(length);
+  frame_->mark_dirty();
+  return RC::SUCCESS;
+}
+
+void RecordPageHandler::compact()
+{
+  std::vector<SlotNum> slots;
+  slots.reserve(page_header_->record_num);
+  for (SlotNum slot_num = 0; slot_num < page_header_->record_capacity; slot_num++) {
+    if (directory_entry(slot_num)->offset != 0) {
+      slots.push_back(slot_num);
+    }
+  }
+
+  // 从页面末尾的记录开始往后移动，记录只会往高地址移动，不会覆盖还没有移动的记录
+  std::sort(slots.begin(), slots.end(), [this](SlotNum left, SlotNum right) {
+    return directory_entry(left)->offset > directory_entry(right)->offset;
+  });
+
+  int end = BP_PAGE_DATA_SIZE;
+  for (SlotNum slot_num : slots) {
+    RecordDirectoryEntry *entry = directory_entry(slot_num);
+    end -= entry->length;
+    if (end != entry->offset) {
+      memmove(data_ + end, data_ + entry->offset, entry->length);
+      entry->offset = static_cast<uint16_t>(end);
+    }
+  }
+  page_header_->first_record_offset = end;
+  ASSERT(page_header_->first_record_offset - directory_end() == page_header_->free_size,
+         "free size mismatch after compaction. free size=%d, contiguous=%d",
+         page_header_->free_size, page_header_->first_record_offset - directory_end());
+  frame_->mark_dirty();
+}
+
+void RecordPageHandler::compact_if_fragmented()
+{
+  const int fragmented_size = page_header_->free_size - (page_header_->first_record_offset - directory_end());
+  if (fragmented_size > BP_PAGE_DATA_SIZE / 4) {
+    compact();
+  }
+}
+
 PageNum RecordPageHandler::get_page_num() const
 {
   if (nullptr == page_header_) {
@@ -339,13 +758,32 @@ PageNum RecordPageHandler::get_page_num() const
   return frame_->page_num();
 }
 
-bool RecordPageHandler::is_full() const { return page_header_->record_num >= page_header_->record_capacity; }
+bool RecordPageHandler::is_full() const
+{
+  if (slotted()) {
+    // 连最短的记录(一个字节)都放不下了
+    return !can_insert(1);
+  }
+  return page_header_->record_num >= page_header_->record_capacity;
+}
+
+bool RecordPageHandler::can_insert(int length) const
+{
+  if (!slotted()) {
+    return page_header_->record_num < page_header_->record_capacity;
+  }
+
+  // 槽位目录可能需要增加一项，还要给包括新记录在内的每条记录都留出预留空间
+  const int need = length + static_cast<int>(sizeof(RecordDirectoryEntry)) + (page_header_->record_num + 1) * SLOTTED_RESERVE;
+  return page_header_->free_size >= need;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
 RecordFileHandler::~RecordFileHandler() { this->close(); }
 
-RC RecordFileHandler::init(DiskBufferPool *buffer_pool)
+RC RecordFileHandler::init(DiskBufferPool *buffer_pool, RecordFormat format /* = RecordFormat::FIXED */,
+                           const std::vector<ZoneColumn> &zone_columns /* = {} */)
 {
   if (disk_buffer_pool_ != nullptr) {
     LOG_ERROR("record file handler has been openned.");
@@ -353,21 +791,72 @@ RC RecordFileHandler::init(DiskBufferPool *buffer_pool)
   }
 
   disk_buffer_pool_ = buffer_pool;
+  format_           = format;
+
+  // 映射不可用(比如上次没有正常关闭)时才扫描整个文件
+  const std::string map_file = FreeSpaceMap::map_file_name(buffer_pool->filename().c_str());
+  bool loaded = false;
+  RC rc = free_space_map_.open(map_file.c_str(), buffer_pool->page_count(), buffer_pool->allocated_pages(), loaded);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to open free space map, record file will be scanned every time. file=%s, rc=%s",
+             map_file.c_str(), strrc(rc));
+  }
+
+  if (loaded) {
+    load_free_pages();
+  } else {
+    rc = init_free_pages();
+  }
 
-  RC rc = init_free_pages();
+  const std::string zone_file = ZoneMap::map_file_name(buffer_pool->filename().c_str());
+  loaded = false;
+  rc = zone_map_.open(zone_file.c_str(), zone_columns, buffer_pool->page_count(), loaded);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to open zone map, pages will not be skipped while scanning. file=%s, rc=%s",
+             zone_file.c_str(), strrc(rc));
+  } else if (zone_map_.is_open() && !loaded) {
+    rc = init_zone_map();
+  }
 
-  LOG_INFO("open record file handle done. rc=%s", strrc(rc));
+  LOG_INFO("open record file handle done. format=%s, rc=%s", record_format_name(format_), strrc(rc));
   return RC::SUCCESS;
 }
 
 void RecordFileHandler::close()
 {
   if (disk_buffer_pool_ != nullptr) {
+    free_space_map_.close(disk_buffer_pool_->page_count(), disk_buffer_pool_->allocated_pages());
+    zone_map_.close(disk_buffer_pool_->page_count());
     free_pages_.clear();
     disk_buffer_pool_ = nullptr;
   }
 }
 
+void RecordFileHandler::load_free_pages()
+{
+  // 映射只是提示，已经释放的页面不要
+  free_space_map_.for_each_free_page([this](PageNum page_num) {
+    if (page_num < disk_buffer_pool_->page_count() && disk_buffer_pool_->next_allocated_page(page_num) == page_num) {
+      free_pages_.insert(page_num);
+    } else {
+      free_space_map_.set_free(page_num, false);
+    }
+  });
+  LOG_INFO("record file handler load free pages done. free page num=%d", free_pages_.size());
+}
+
+void RecordFileHandler::add_free_page(PageNum page_num)
+{
+  free_pages_.insert(page_num);
+  free_space_map_.set_free(page_num, true);
+}
+
+std::unordered_set<PageNum>::iterator RecordFileHandler::remove_free_page(std::unordered_set<PageNum>::iterator iter)
+{
+  free_space_map_.set_free(*iter, false);
+  return free_pages_.erase(iter);
+}
+
 RC RecordFileHandler::init_free_pages()
 {
   // 遍历当前文件上所有页面，找到没有满的页面
@@ -391,7 +880,7 @@ RC RecordFileHandler::init_free_pages()
     }
 
     if (!record_page_handler.is_full()) {
-      free_pages_.insert(current_page_num);
+      add_free_page(current_page_num);
     }
     record_page_handler.cleanup();
   }
@@ -399,93 +888,118 @@ RC RecordFileHandler::init_free_pages()
   return rc;
 }
 
-RC RecordFileHandler::insert_text_record(const char *data, size_t record_size, RID *rid)
+RC RecordFileHandler::init_zone_map()
 {
-  RC ret = RC::SUCCESS;
-
-  RecordPageHandler record_page_handler;
-  bool              page_found       = false;
-  PageNum           current_page_num = 0;
-
-  // 当前要访问free_pages对象，所以需要加锁。在非并发编译模式下，不需要考虑这个锁
-  lock_.lock();
-
-    // 当前要访问free_pages对象，所以需要加锁。在非并发编译模式下，不需要考虑这个锁
-  lock_.lock();
+  // 与 init_free_pages 一样只在初始化时调用，不需要加锁
+  RC rc = RC::SUCCESS;
 
-  // 找到没有填满的页面
-  while (!free_pages_.empty()) {
-    current_page_num = *free_pages_.begin();
+  BufferPoolIterator bp_iterator;
+  bp_iterator.init(*disk_buffer_pool_);
+  RecordPageHandler  record_page_handler;
+  RecordPageIterator record_page_iterator;
+  Record             record;
+  while (OB_SUCC(rc) && bp_iterator.has_next()) {
+    const PageNum page_num = bp_iterator.next();
 
-    ret = record_page_handler.init(*disk_buffer_pool_, current_page_num, false /*readonly*/);
-    if (ret != RC::SUCCESS) {
-      lock_.unlock();
-      LOG_WARN("failed to init record page handler. page num=%d, rc=%d:%s", current_page_num, ret, strrc(ret));
-      return ret;
+    rc = record_page_handler.init(*disk_buffer_pool_, page_num, true /*readonly*/);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to init record page handler. page num=%d, rc=%s", page_num, strrc(rc));
+      break;
     }
 
-    if (!record_page_handler.is_full() && record_page_handler.if_text()) {
-      page_found = true;
-      record_page_handler.cleanup();
-      free_pages_.erase(free_pages_.begin());
-      break;
+    zone_map_.reset_page(page_num);
+    record_page_iterator.init(record_page_handler);
+    while (OB_SUCC(rc) && record_page_iterator.has_next()) {
+      rc = record_page_iterator.next(record);
+      if (OB_SUCC(rc)) {
+        zone_map_.update(page_num, record.data());
+      }
+    }
+    if (OB_FAIL(rc)) {
+      zone_map_.forget_page(page_num);
     }
     record_page_handler.cleanup();
-    free_pages_.erase(free_pages_.begin());
   }
-  lock_.unlock();  // 如果找到了一个有效的页面，那么此时已经拿到了页面的写锁
+  LOG_INFO("record file handler init zone map done. rc=%s", strrc(rc));
+  return rc;
+}
 
-  // 找不到就分配一个新的页面
-  if (!page_found) {
-    Frame *frame = nullptr;
-    if ((ret = disk_buffer_pool_->allocate_page(&frame)) != RC::SUCCESS) {
-        LOG_ERROR("Failed to allocate page while inserting record. ret:%d", ret);
-        return ret;
-    }
+int RecordFileHandler::page_count() const { return disk_buffer_pool_->page_count(); }
+
+RC RecordFileHandler::insert_record(const char *data, int record_size, RID *rid)
+{
+  // 变长记录要看页面上还有没有足够的空间放下这条记录。定长页面不关心记录的长度
+  const int length = (format_ == RecordFormat::SLOTTED) ? RecordPageHandler::slotted_record_length(data, record_size) : 0;
+
+  RecordPageHandler record_page_handler;
+  RC ret = open_page_for_insert(length, record_size, record_page_handler);
+  if (OB_FAIL(ret)) {
+    return ret;
+  }
 
-    current_page_num = frame->page_num();
+  // 先扩大区间再写入记录，并发的扫描不会因为区间过小跳过这条记录
+  zone_map_.update(record_page_handler.get_page_num(), data);
 
-    ret = record_page_handler.init_empty_page(*disk_buffer_pool_, current_page_num, record_size);
-    if (ret != RC::SUCCESS) {
-        frame->unpin();
-        LOG_ERROR("Failed to init empty page. ret:%d", ret);
-        // this is for allocate_page
-        return ret;
+  // 找到空闲位置
+  return record_page_handler.insert_record(data, rid);
+}
+
+RC RecordFileHandler::insert_records(const char *const *datas, int count, int record_size, RID *rids)
+{
+  RC                ret = RC::SUCCESS;
+  RecordPageHandler record_page_handler;
+  int               index = 0;
+  while (OB_SUCC(ret) && index < count) {
+    int length = (format_ == RecordFormat::SLOTTED) ? RecordPageHandler::slotted_record_length(datas[index], record_size) : 0;
+
+    ret = open_page_for_insert(length, record_size, record_page_handler);
+    if (OB_FAIL(ret)) {
+      LOG_WARN("failed to find a page to insert records. inserted=%d, count=%d, rc=%s", index, count, strrc(ret));
+      break;
     }
 
-      // frame 在allocate_page的时候，是有一个pin的，在init_empty_page时又会增加一个，所以这里手动释放一个
-    frame->unpin();
+    // 页面的写锁只拿一次，尽量把后续的记录都放到这个页面上
+    do {
+      zone_map_.update(record_page_handler.get_page_num(), datas[index]);
+      ret = record_page_handler.insert_record(datas[index], &rids[index]);
+      if (OB_FAIL(ret)) {
+        LOG_WARN("failed to insert record. inserted=%d, count=%d, rc=%s", index, count, strrc(ret));
+        break;
+      }
+
+      index++;
+      if (index < count && format_ == RecordFormat::SLOTTED) {
+        length = RecordPageHandler::slotted_record_length(datas[index], record_size);
+      }
+    } while (index < count && record_page_handler.can_insert(length));
 
-      // 这里的加锁顺序看起来与上面是相反的，但是不会出现死锁
-      // 上面的逻辑是先加lock锁，然后加页面写锁，这里是先加上
-      // 了页面写锁，然后加lock的锁，但是不会引起死锁。
-      // 为什么？
-    lock_.lock();
-    free_pages_.insert(current_page_num);
-    lock_.unlock();
+    record_page_handler.cleanup();
+  }
 
-    // 找到空闲位置
-    free_pages_.erase(free_pages_.begin());
-    frame->set_text();
+  if (OB_FAIL(ret)) {
+    for (int i = 0; i < index; i++) {
+      RC rc2 = delete_record(&rids[i]);
+      if (OB_FAIL(rc2)) {
+        LOG_WARN("failed to rollback inserted record. rid=%s, rc=%s", rids[i].to_string().c_str(), strrc(rc2));
+      }
+    }
   }
-  RC rc = record_page_handler.insert_text_record(data, record_size, rid);
-  return rc;
+  return ret;
 }
 
-RC RecordFileHandler::insert_record(const char *data, int record_size, RID *rid)
+RC RecordFileHandler::open_page_for_insert(int length, int record_size, RecordPageHandler &record_page_handler)
 {
-  RC ret = RC::SUCCESS;
-
-  RecordPageHandler record_page_handler;
-  bool              page_found       = false;
-  PageNum           current_page_num = 0;
+  RC      ret              = RC::SUCCESS;
+  bool    page_found       = false;
+  PageNum current_page_num = 0;
 
   // 当前要访问free_pages对象，所以需要加锁。在非并发编译模式下，不需要考虑这个锁
   lock_.lock();
 
-  // 找到没有填满的页面
-  while (!free_pages_.empty()) {
-    current_page_num = *free_pages_.begin();
+  // 找到放得下这条记录的页面。满了的页面从 free_pages_ 中去掉，还没满的留给更短的记录
+  auto iter = free_pages_.begin();
+  while (iter != free_pages_.end()) {
+    current_page_num = *iter;
 
     ret = record_page_handler.init(*disk_buffer_pool_, current_page_num, false /*readonly*/);
     if (ret != RC::SUCCESS) {
@@ -494,47 +1008,48 @@ RC RecordFileHandler::insert_record(const char *data, int record_size, RID *rid)
       return ret;
     }
 
-    if (!record_page_handler.is_full()) {
+    if (record_page_handler.can_insert(length)) {
       page_found = true;
       break;
     }
+    iter = record_page_handler.is_full() ? remove_free_page(iter) : std::next(iter);
     record_page_handler.cleanup();
-    free_pages_.erase(free_pages_.begin());
   }
   lock_.unlock();  // 如果找到了一个有效的页面，那么此时已经拿到了页面的写锁
 
-  // 找不到就分配一个新的页面
-  if (!page_found) {
-    Frame *frame = nullptr;
-    if ((ret = disk_buffer_pool_->allocate_page(&frame)) != RC::SUCCESS) {
-      LOG_ERROR("Failed to allocate page while inserting record. ret:%d", ret);
-      return ret;
-    }
+  if (page_found) {
+    return RC::SUCCESS;
+  }
 
-    current_page_num = frame->page_num();
+  // 找不到就分配一个新的页面
+  Frame *frame = nullptr;
+  if ((ret = disk_buffer_pool_->allocate_page(&frame)) != RC::SUCCESS) {
+    LOG_ERROR("Failed to allocate page while inserting record. ret:%d", ret);
+    return ret;
+  }
 
-    ret = record_page_handler.init_empty_page(*disk_buffer_pool_, current_page_num, record_size);
-    if (ret != RC::SUCCESS) {
-      frame->unpin();
-      LOG_ERROR("Failed to init empty page. ret:%d", ret);
-      // this is for allocate_page
-      return ret;
-    }
+  current_page_num = frame->page_num();
 
-    // frame 在allocate_page的时候，是有一个pin的，在init_empty_page时又会增加一个，所以这里手动释放一个
+  ret = record_page_handler.init_empty_page(*disk_buffer_pool_, current_page_num, record_size, format_);
+  if (ret != RC::SUCCESS) {
     frame->unpin();
-
-    // 这里的加锁顺序看起来与上面是相反的，但是不会出现死锁
-    // 上面的逻辑是先加lock锁，然后加页面写锁，这里是先加上
-    // 了页面写锁，然后加lock的锁，但是不会引起死锁。
-    // 为什么？
-    lock_.lock();
-    free_pages_.insert(current_page_num);
-    lock_.unlock();
+    LOG_ERROR("Failed to init empty page. ret:%d", ret);
+    // this is for allocate_page
+    return ret;
   }
 
-  // 找到空闲位置
-  return record_page_handler.insert_record(data, rid);
+  // frame 在allocate_page的时候，是有一个pin的，在init_empty_page时又会增加一个，所以这里手动释放一个
+  frame->unpin();
+  zone_map_.reset_page(current_page_num);
+
+  // 这里的加锁顺序看起来与上面是相反的，但是不会出现死锁
+  // 上面的逻辑是先加lock锁，然后加页面写锁，这里是先加上
+  // 了页面写锁，然后加lock的锁，但是不会引起死锁。
+  // 为什么？
+  lock_.lock();
+  add_free_page(current_page_num);
+  lock_.unlock();
+  return RC::SUCCESS;
 }
 
 RC RecordFileHandler::recover_insert_record(const char *data, int record_size, const RID &rid)
@@ -549,6 +1064,7 @@ RC RecordFileHandler::recover_insert_record(const char *data, int record_size, c
     return ret;
   }
 
+  zone_map_.update(rid.page_num, data);
   return record_page_handler.recover_insert_record(data, rid);
 }
 
@@ -556,10 +1072,6 @@ RC RecordFileHandler::delete_record(const RID *rid)
 {
   RC rc = RC::SUCCESS;
 
-  if (rid->next_RID != nullptr) {
-    rc = delete_record(rid->next_RID);
-  }
-
   RecordPageHandler page_handler;
   if ((rc = page_handler.init(*disk_buffer_pool_, rid->page_num, false /*readonly*/)) != RC::SUCCESS) {
     LOG_ERROR("Failed to init record page handler.page number=%d. rc=%s", rid->page_num, strrc(rc));
@@ -575,22 +1087,46 @@ RC RecordFileHandler::delete_record(const RID *rid)
     // 因为这里已经释放了页面锁，并发时，其它线程可能又把该页面填满了，那就不应该再放入 free_pages_
     // 中。但是这里可以不关心，因为在查找空闲页面时，会自动过滤掉已经满的页面
     lock_.lock();
-    free_pages_.insert(rid->page_num);
+    add_free_page(rid->page_num);
     LOG_TRACE("add free page %d to free page list", rid->page_num);
     lock_.unlock();
   }
   return rc;
 }
 
-RC RecordFileHandler::update_record(const char *data, int record_size, const RID *rid) {
+RC RecordFileHandler::update_record(const char *data, int record_size, RID *rid) {
   RC rc = RC::SUCCESS;
   RecordPageHandler page_handler;
   if ((rc = page_handler.init(*disk_buffer_pool_, rid->page_num, false /*readonly*/)) != RC::SUCCESS) {
     LOG_ERROR("Failed to init record page handler.page number=%d. rc=%s", rid->page_num, strrc(rc));
     return rc;
   }
+  zone_map_.update(rid->page_num, data);
   rc = page_handler.update_record(data, rid);
-  return rc;
+  page_handler.cleanup();
+  if (rc != RC::RECORD_NOMEM) {
+    return rc;
+  }
+
+  // 变长记录在原来的页面放不下了，先插入到其它页面，再删除原来的记录
+  RID new_rid;
+  rc = insert_record(data, record_size, &new_rid);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to move record to another page. rid=%s, rc=%s", rid->to_string().c_str(), strrc(rc));
+    return rc;
+  }
+
+  RID old_rid(rid->page_num, rid->slot_num);
+  rc = delete_record(&old_rid);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to delete moved record. rid=%s, rc=%s", old_rid.to_string().c_str(), strrc(rc));
+    return rc;
+  }
+
+  LOG_TRACE("move record to another page. rid=%s -> %s", old_rid.to_string().c_str(), new_rid.to_string().c_str());
+  rid->page_num = new_rid.page_num;
+  rid->slot_num = new_rid.slot_num;
+  return RC::SUCCESS;
 }
 
 RC RecordFileHandler::get_record(RecordPageHandler &page_handler, const RID *rid, bool readonly, Record *rec)
@@ -627,6 +1163,13 @@ RC RecordFileHandler::visit_record(const RID &rid, bool readonly, std::function<
   }
 
   visitor(record);
+  if (!readonly) {
+    zone_map_.update(rid.page_num, record.data());
+    rc = page_handler.write_back_record(record);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to write record back. rid=%s, rc=%s", rid.to_string().c_str(), strrc(rc));
+    }
+  }
   return rc;
 }
 
@@ -634,8 +1177,9 @@ RC RecordFileHandler::visit_record(const RID &rid, bool readonly, std::function<
 
 RecordFileScanner::~RecordFileScanner() { close_scan(); }
 
-RC RecordFileScanner::open_scan(
-    Table *table, DiskBufferPool &buffer_pool, Trx *trx, bool readonly, ConditionFilter *condition_filter)
+RC RecordFileScanner::open_scan(Table *table, DiskBufferPool &buffer_pool, Trx *trx, bool readonly,
+                                ConditionFilter *condition_filter, PageNum start_page /* = 0 */,
+                                PageNum end_page /* = BP_INVALID_PAGE_NUM */)
 {
   close_scan();
 
@@ -644,11 +1188,15 @@ RC RecordFileScanner::open_scan(
   trx_              = trx;
   readonly_         = readonly;
 
-  RC rc = bp_iterator_.init(buffer_pool);
+  RC rc = bp_iterator_.init(buffer_pool, start_page, end_page);
   if (rc != RC::SUCCESS) {
     LOG_WARN("failed to init bp iterator. rc=%d:%s", rc, strrc(rc));
     return rc;
   }
+  // 修改数据的扫描会产生脏页，不能使用页帧环
+  if (readonly_) {
+    buffer_ring_.init(buffer_pool);
+  }
   condition_filter_ = condition_filter;
 
   rc = fetch_next_record();
@@ -658,6 +1206,15 @@ RC RecordFileScanner::open_scan(
   return rc;
 }
 
+/**
+ * @brief 记录下推的比较条件，fetch_next_record 根据区间摘要跳过不可能有满足条件记录的页面
+ */
+void RecordFileScanner::set_zone_conditions(const ZoneMap *zone_map, std::vector<ZoneCondition> conditions)
+{
+  zone_map_        = zone_map;
+  zone_conditions_ = std::move(conditions);
+}
+
 /**
  * @brief 从当前位置开始找到下一条有效的记录
  *
@@ -667,7 +1224,7 @@ RC RecordFileScanner::open_scan(
 RC RecordFileScanner::fetch_next_record()
 {
   RC rc = RC::SUCCESS;
-  if (record_page_iterator_.is_valid() && !if_text()) {
+  if (record_page_iterator_.is_valid()) {
     // 当前页面还是有效的，尝试看一下是否有有效记录
     rc = fetch_next_record_in_page();
     if (rc == RC::SUCCESS || rc != RC::RECORD_EOF) {
@@ -681,9 +1238,15 @@ RC RecordFileScanner::fetch_next_record()
   // 上个页面遍历完了，或者还没有开始遍历某个页面，那么就从一个新的页面开始遍历查找
   while (bp_iterator_.has_next()) {
     PageNum page_num = bp_iterator_.next();
+    // 区间摘要说明这个页面上没有满足条件的记录，不需要读取页面
+    if (zone_map_ != nullptr && !zone_map_->may_match(page_num, zone_conditions_)) {
+      continue;
+    }
+
     record_page_handler_.cleanup();
-    rc = record_page_handler_.init(*disk_buffer_pool_, page_num, readonly_);
-    if (record_page_handler_.if_text()) continue;
+    // 只读扫描使用页面的拷贝，不需要在遍历页面期间一直加着读锁
+    rc = readonly_ ? record_page_handler_.init_snapshot(*disk_buffer_pool_, page_num, &buffer_ring_)
+                   : record_page_handler_.init(*disk_buffer_pool_, page_num, false /*readonly*/);
     if (OB_FAIL(rc)) {
       LOG_WARN("failed to init record page handler. page_num=%d, rc=%s", page_num, strrc(rc));
       return rc;
@@ -755,6 +1318,7 @@ RC RecordFileScanner::close_scan()
   }
 
   record_page_handler_.cleanup();
+  buffer_ring_.reset();
 
   return RC::SUCCESS;
 }
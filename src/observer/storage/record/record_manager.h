@@ -16,9 +16,14 @@ See the Mulan PSL v2 for more details. */
 
 #include <sstream>
 #include <limits>
+#include <unordered_set>
 #include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/buffer_ring.h"
 #include "storage/trx/latch_memo.h"
 #include "storage/record/record.h"
+#include "storage/record/record_format.h"
+#include "storage/record/free_space_map.h"
+#include "storage/record/zone_map.h"
 #include "common/lang/bitmap.h"
 
 class ConditionFilter;
@@ -39,11 +44,10 @@ class Table;
  *
  * 对单个页面来说，最开始是一个页头，然后接着就是一行行记录（会对齐）。
  * 如何标识一个记录，或者定位一个记录？
- * 使用RID，即record identifier。使用 page num 表示所在的页面，slot num 表示当前在页面中的位置。因为这里的
- * 记录都是定长的，所以根据slot num 可以直接计算出记录的起始位置。
- * 问题1：那么如果记录不是定长的，还能使用 slot num 吗？
- * 问题2：如何更有效地存放不定长数据呢？
- * 问题3：如果一个页面不能存放一个记录，那么怎么组织记录存放效果更好呢？
+ * 使用RID，即record identifier。使用 page num 表示所在的页面，slot num 表示当前在页面中的位置。定长格式
+ * 的页面中记录都是定长的，所以根据slot num 可以直接计算出记录的起始位置。变长格式的页面通过槽位目录
+ * 找到记录，记录在页面中移动时 slot num 不变，参考 RecordFormat。
+ * 问题：如果一个页面不能存放一个记录，那么怎么组织记录存放效果更好呢？
  *
  * 按照上面的描述，这里提供了几个类，分别是：
  * - RecordFileHandler：管理整个文件/表的记录增删改查
@@ -54,26 +58,31 @@ class Table;
  */
 
 /**
- * @brief 数据文件，按照页面来组织，每一页都存放一些记录/数据行
+ * @brief 变长记录页面中槽位目录的一项
  * @ingroup RecordManager
- * @details 每一页都有一个这样的页头，虽然看起来浪费，但是现在就简单的这么做
- * 从这个页头描述的信息来看，当前仅支持定长行/记录。如果要支持变长记录，
- * 或者超长（超出一页）的记录，这么做是不合适的。
  */
-
-struct RecordDirectoryEntry {
-  RID location;
-
+struct RecordDirectoryEntry
+{
+  uint16_t offset;  ///< 编码后的记录在页面中的偏移，0表示这个槽位是空的
+  uint16_t length;  ///< 编码后的记录长度
 };
 
+/**
+ * @brief 数据文件，按照页面来组织，每一页都存放一些记录/数据行
+ * @ingroup RecordManager
+ * @details 每一页都有一个这样的页头，虽然看起来浪费，但是现在就简单的这么做
+ * 页面有定长和变长两种格式，参考 RecordFormat，有些字段在两种格式中的含义不同。
+ * 超长（超出一页）的记录还不支持。
+ */
 struct PageHeader
 {
   int32_t record_num;           ///< 当前页面记录的个数
-  int32_t record_real_size;     ///< 每条记录的实际大小
-  int32_t record_size;          ///< 每条记录占用实际空间大小(可能对齐)
-  int32_t record_capacity;      ///< 最大记录个数
-  int32_t first_record_offset;  ///< 第一条记录的偏移量
-  std::map<SlotNum,int> text_length;  ///< 变长数据的长度
+  int32_t record_real_size;     ///< 每条记录的实际大小。变长页面中是解码后的大小
+  int32_t record_size;          ///< 每条记录占用实际空间大小(可能对齐)。变长页面不使用
+  int32_t record_capacity;      ///< 最大记录个数。变长页面中是槽位目录的项数
+  int32_t first_record_offset;  ///< 第一条记录的偏移量。变长页面中是记录区的起始位置
+  int32_t format;               ///< 页面格式，参考 RecordFormat
+  int32_t free_size;            ///< 变长页面中空闲的字节数，包括删除和更新记录留下的碎片
 };
 
 /**
@@ -115,18 +124,29 @@ private:
   RecordPageHandler *record_page_handler_ = nullptr;
   PageNum            page_num_            = BP_INVALID_PAGE_NUM;
   common::Bitmap     bitmap_;             ///< bitmap 的相关信息可以参考 RecordPageHandler 的说明
+  bool               slotted_ = false;    ///< 是不是变长页面，变长页面遍历槽位目录
   SlotNum            next_slot_num_ = 0;  ///< 当前遍历到了哪一个slot
 };
 
 /**
  * @brief 负责处理一个页面中各种操作，比如插入记录、删除记录或者查找记录
  * @ingroup RecordManager
- * @details 当前定长记录模式下每个页面的组织大概是这样的：
+ * @details 定长记录格式下每个页面的组织大概是这样的：
  * @code
  * | PageHeader | record allocate bitmap |
  * |------------|------------------------|
  * | record1 | record2 | ..... | recordN |
  * @endcode
+ * 变长记录格式下，页头后面是槽位目录，每个槽位记录编码后的记录的位置和长度，记录从页面末尾往前存放：
+ * @code
+ * | PageHeader | entry1 | entry2 | ... | entryN | --> free space <-- |
+ * |---------------------------------------------|------------------|
+ * |          | recordN | ... | record2 | record1 |
+ * @endcode
+ * 记录编码时把连续的0压缩掉，定长的字符串字段后面的填充就不占空间了，编码格式参考 record_manager.cpp。
+ * 删除和更新记录会在记录区留下碎片，碎片太多或者插入时连续的空间不够用，就整理页面，把记录都移到页面末尾。
+ * 为了让记录在原地更新时稍微变长一点也放得下，插入时会为每条记录预留几个字节。
+ * 读取变长记录时，记录解码到 RecordPageHandler 的缓存中，记录数据指向这个缓存。
  */
 class RecordPageHandler
 {
@@ -140,8 +160,17 @@ public:
    * @param buffer_pool 关联某个文件时，都通过buffer pool来做读写文件
    * @param page_num    当前处理哪个页面
    * @param readonly    是否只读。在访问页面时，需要对页面加锁
+   * @param ring        扫描大表时通过页帧环访问页面，参考 BufferRing
    */
-  RC init(DiskBufferPool &buffer_pool, PageNum page_num, bool readonly);
+  RC init(DiskBufferPool &buffer_pool, PageNum page_num, bool readonly, BufferRing *ring = nullptr);
+
+  /**
+   * @brief 只读遍历页面时使用，不加读锁，而是把页面复制一份
+   * @details 使用乐观读(参考 Frame::read_version)复制页面，页面正在被修改时重试几次，还不行就退化成加读锁。
+   * 记录数据指向复制出来的页面，看不到之后的修改。页面在 cleanup 之前一直是pin住的。
+   * 没有开启 CONCURRENCY 时读锁什么都不做，就直接使用页帧中的数据，不复制。
+   */
+  RC init_snapshot(DiskBufferPool &buffer_pool, PageNum page_num, BufferRing *ring = nullptr);
 
   /**
    * @brief 数据库恢复时，与普通的运行场景有所不同，不做任何并发操作，也不需要加锁
@@ -157,8 +186,10 @@ public:
    * @param buffer_pool 关联某个文件时，都通过buffer pool来做读写文件
    * @param page_num    当前处理哪个页面
    * @param record_size 每个记录的大小
+   * @param format      页面上记录的存放格式
    */
-  RC init_empty_page(DiskBufferPool &buffer_pool, PageNum page_num, int record_size);
+  RC init_empty_page(DiskBufferPool &buffer_pool, PageNum page_num, int record_size,
+                     RecordFormat format = RecordFormat::FIXED);
 
   /**
    * @brief 操作结束后做的清理工作，比如释放页面、解锁
@@ -173,8 +204,18 @@ public:
    */
   RC insert_record(const char *data, RID *rid);
 
+  /**
+   * @brief 更新指定的记录
+   * @details 变长记录变长之后当前页面放不下时返回 RECORD_NOMEM，需要调用者把记录搬到其它页面
+   */
   RC update_record(const char *data, const RID *rid);
-  RC insert_text_record(const char *data, size_t len, RID *rid);
+
+  /**
+   * @brief 把 get_record 获取的记录修改之后写回页面
+   * @details 定长页面中记录就指向页面，只需要标记脏页。变长页面中记录是解码出来的拷贝，需要重新编码写回去，
+   * 这时可以使用为记录变长预留的空间
+   */
+  RC write_back_record(const Record &record);
 
   /**
    * @brief 数据库恢复时，在指定位置插入数据
@@ -209,10 +250,17 @@ public:
    */
   bool is_full() const;
 
-  
-  bool if_text() const {
-    return frame_->get_text();
-  }
+  /**
+   * @brief 当前页面能不能插入一条编码后长度为 length 的记录。定长页面不关心 length
+   */
+  bool can_insert(int length) const;
+
+  bool slotted() const { return page_header_->format == static_cast<int32_t>(RecordFormat::SLOTTED); }
+
+  /**
+   * @brief 变长页面上记录编码后的长度
+   */
+  static int slotted_record_length(const char *data, int record_size);
 
 protected:
   /**
@@ -237,15 +285,75 @@ protected:
    */
   char *get_record_data(SlotNum slot_num)
   {
-    return frame_->data() + page_header_->first_record_offset + (page_header_->record_size * slot_num);
+    return data_ + page_header_->first_record_offset + (page_header_->record_size * slot_num);
   }
 
+  /**
+   * @brief 获取页帧之后设置页面数据相关的指针
+   */
+  void setup_page(DiskBufferPool &buffer_pool, char *data, bool readonly);
+
+  /**
+   * @brief 获取指定槽位的记录数据，变长页面中是解码后的数据
+   * @return 槽位上没有记录或者数据已经损坏时返回nullptr
+   */
+  char *record_data(SlotNum slot_num);
+
+  RecordDirectoryEntry *directory_entry(SlotNum slot_num)
+  {
+    return reinterpret_cast<RecordDirectoryEntry *>(data_ + sizeof(PageHeader)) + slot_num;
+  }
+
+  /**
+   * @brief 槽位目录的结束位置
+   */
+  int directory_end() const
+  {
+    return static_cast<int>(sizeof(PageHeader) + page_header_->record_capacity * sizeof(RecordDirectoryEntry));
+  }
+
+  /**
+   * @brief 变长页面中从 start_slot_num 开始的下一个有记录的槽位，没有时返回-1
+   */
+  SlotNum next_slotted_record(SlotNum start_slot_num);
+
+  RC insert_slotted_record(const char *data, RID *rid);
+  RC delete_slotted_record(const RID *rid);
+
+  /**
+   * @param use_reserve 是否可以使用为其它记录变长预留的空间
+   */
+  RC update_slotted_record(const char *data, SlotNum slot_num, bool use_reserve);
+
+  /**
+   * @brief 把变长页面中的记录都移动到页面末尾，碎片合并到槽位目录与记录区之间
+   */
+  void compact();
+
+  /**
+   * @brief 碎片太多时整理页面
+   */
+  void compact_if_fragmented();
+
 protected:
+  static constexpr int MAX_SNAPSHOT_RETRY = 3;  ///< 复制页面时最多重试几次
+  static constexpr int SLOTTED_RESERVE    = 8;  ///< 变长页面为每条记录预留的空间，参考 write_back_record
+
   DiskBufferPool *disk_buffer_pool_ = nullptr;  ///< 当前操作的buffer pool(文件)
   Frame          *frame_            = nullptr;  ///< 当前操作页面关联的frame(frame的更多概念可以参考buffer pool和frame)
   bool            readonly_         = false;    ///< 当前的操作是否都是只读的
   PageHeader     *page_header_      = nullptr;  ///< 当前页面上页面头
   char           *bitmap_           = nullptr;  ///< 当前页面上record分配状态信息bitmap内存起始位置
+  char           *data_             = nullptr;  ///< 页面数据，使用页面拷贝时指向拷贝
+  bool            latched_          = false;    ///< 是否对页帧加了锁，使用页面拷贝时不加锁
+  /// 页面的拷贝，参考 init_snapshot。扫描时会提前读取下一个页面，所以两个拷贝轮流使用，换页之后上一个页面的记录还能访问
+  std::unique_ptr<Page> snapshots_[2];
+  int                   snapshot_index_ = 0;
+
+  /// 变长记录解码后的缓存，每个槽位占 record_real_size 字节。
+  /// 扫描时会提前读取一条记录，所以两个缓存轮流使用，换页之后上一个页面的记录还能访问
+  std::vector<char> decoded_[2];
+  int               decoded_index_ = 0;
 
 private:
   friend class RecordPageIterator;
@@ -254,7 +362,9 @@ private:
 /**
  * @brief 管理整个文件中记录的增删改查
  * @ingroup RecordManager
- * @details 整个文件的组织格式请参考该文件中最前面的注释
+ * @details 整个文件的组织格式请参考该文件中最前面的注释。
+ * 哪些页面还有空闲空间保存在 FreeSpaceMap 中，打开文件时不需要访问每个页面。
+ * 每个页面上数值和日期字段的区间保存在 ZoneMap 中，扫描时用来跳过页面
  */
 class RecordFileHandler
 {
@@ -262,15 +372,15 @@ public:
   RecordFileHandler() = default;
   ~RecordFileHandler();
 
-
-  std::map<PageNum, int> overflow_pages;
-
   /**
    * @brief 初始化
    *
    * @param buffer_pool 当前操作的是哪个文件
+   * @param format      新分配的页面使用的记录格式，已有的页面按照页头中记录的格式访问
+   * @param zone_columns 需要记录区间摘要的字段，为空时不维护摘要
    */
-  RC init(DiskBufferPool *buffer_pool);
+  RC init(DiskBufferPool *buffer_pool, RecordFormat format = RecordFormat::FIXED,
+          const std::vector<ZoneColumn> &zone_columns = {});
 
   /**
    * @brief 关闭，做一些资源清理的工作
@@ -287,10 +397,11 @@ public:
 
   /**
    * @brief 从指定文件中更新指定槽位的记录
+   * @details 变长记录变长之后原来的页面放不下时，会把记录搬到其它页面，通过rid返回新的位置
    * @param data        纪录内容
-   * @param rid 待更新记录的标识符
+   * @param rid[in/out] 待更新记录的标识符
    */
-  RC update_record(const char *data, int record_size, const RID *rid);
+  RC update_record(const char *data, int record_size, RID *rid);
 
   /**
    * @brief 插入一个新的记录到指定文件中，并返回该记录的标识符
@@ -301,7 +412,16 @@ public:
    */
   RC insert_record(const char *data, int record_size, RID *rid);
 
-  RC insert_text_record(const char *data, size_t record_size, RID *rid);
+  /**
+   * @brief 批量插入记录
+   * @details 找到一个有空闲空间的页面之后，只加一次页面写锁，连续插入后面的记录直到页面放不下为止，
+   * 不需要每条记录都查找一次 free_pages_。中途失败时会删除已经插入的记录
+   * @param datas       每条记录的内容
+   * @param count       记录的条数
+   * @param record_size 记录大小
+   * @param rids        返回每条记录的标识符，至少要有count个元素
+   */
+  RC insert_records(const char *const *datas, int count, int record_size, RID *rids);
 
    /**
    * @brief 数据库恢复时，在指定文件指定位置插入数据
@@ -333,15 +453,51 @@ public:
    */
   RC visit_record(const RID &rid, bool readonly, std::function<void(Record &)> visitor);
 
+  RecordFormat record_format() const { return format_; }
+
+  /**
+   * @brief 数据文件的页面数，包括文件头页面和已经释放的页面
+   */
+  int page_count() const;
+
+  const ZoneMap &zone_map() const { return zone_map_; }
+
 private:
   /**
-   * @brief 初始化当前没有填满记录的页面，初始化free_pages_成员
+   * @brief 遍历所有页面，找到没有填满记录的页面，初始化free_pages_成员并重建空闲空间映射
+   * @details 空闲空间映射不可用时才会使用
    */
   RC init_free_pages();
 
+  /**
+   * @brief 遍历所有记录，重建区间摘要
+   * @details 摘要不可用时才会使用
+   */
+  RC init_zone_map();
+
+  /**
+   * @brief 找到一个放得下编码后长度为 length 的记录的页面，找不到就分配一个新页面
+   * @details 返回时 record_page_handler 已经拿到了页面的写锁
+   */
+  RC open_page_for_insert(int length, int record_size, RecordPageHandler &record_page_handler);
+
+  /**
+   * @brief 从空闲空间映射中加载free_pages_
+   */
+  void load_free_pages();
+
+  /**
+   * @brief 修改free_pages_，同时修改空闲空间映射。调用者需要加 lock_
+   */
+  void add_free_page(PageNum page_num);
+  std::unordered_set<PageNum>::iterator remove_free_page(std::unordered_set<PageNum>::iterator iter);
+
 private:
   DiskBufferPool             *disk_buffer_pool_ = nullptr;
   std::unordered_set<PageNum> free_pages_;  ///< 没有填充满的页面集合
+  FreeSpaceMap                free_space_map_;  ///< free_pages_ 的持久化版本
+  ZoneMap                     zone_map_;        ///< 每个页面的区间摘要
+  RecordFormat                format_ = RecordFormat::FIXED;
   common::Mutex               lock_;        ///< 当编译时增加-DCONCURRENCY=ON 选项时，才会真正的支持并发
 };
 
@@ -364,8 +520,17 @@ public:
    * @param readonly         当前是否只读操作。访问数据时，需要对页面加锁。比如
    *                         删除时也需要遍历找到数据，然后删除，这时就需要加写锁
    * @param condition_filter 做一些初步过滤操作
+   * @param start_page       只遍历页面号大于 start_page 的页面
+   * @param end_page         只遍历页面号小于 end_page 的页面，BP_INVALID_PAGE_NUM 表示遍历到文件末尾
    */
-  RC open_scan(Table *table, DiskBufferPool &buffer_pool, Trx *trx, bool readonly, ConditionFilter *condition_filter);
+  RC open_scan(Table *table, DiskBufferPool &buffer_pool, Trx *trx, bool readonly, ConditionFilter *condition_filter,
+               PageNum start_page = 0, PageNum end_page = BP_INVALID_PAGE_NUM);
+
+  /**
+   * @brief 设置下推的比较条件，区间摘要说明页面上没有满足所有条件的记录时，直接跳过这个页面
+   * @details 需要在 open_scan 之前设置。跳过页面只是优化，返回的记录仍然需要调用者过滤
+   */
+  void set_zone_conditions(const ZoneMap *zone_map, std::vector<ZoneCondition> conditions);
 
   /**
    * @brief 关闭一个文件扫描，释放相应的资源
@@ -398,10 +563,6 @@ private:
    */
   RC fetch_next_record_in_page();
 
-  bool if_text() {
-    return record_page_handler_.if_text();
-  }
-
 private:
   // TODO 对于一个纯粹的record遍历器来说，不应该关心表和事务
   Table             *table_            = nullptr;  ///< 当前遍历的是哪张表。这个字段仅供事务函数使用，如果设计合适，可以去掉
@@ -410,7 +571,10 @@ private:
   bool               readonly_         = false;    ///< 遍历出来的数据，是否可能对它做修改
 
   BufferPoolIterator bp_iterator_;                 ///< 遍历buffer pool的所有页面
+  BufferRing         buffer_ring_;                 ///< 只读扫描大表时使用，避免把缓冲池中的热点页面淘汰掉
   ConditionFilter   *condition_filter_ = nullptr;  ///< 过滤record
+  const ZoneMap     *zone_map_         = nullptr;  ///< 用来跳过页面的区间摘要
+  std::vector<ZoneCondition> zone_conditions_;     ///< 下推的比较条件
   RecordPageHandler  record_page_handler_;         ///< 处理文件某页面的记录
   RecordPageIterator record_page_iterator_;        ///< 遍历某个页面上的所有record
   Record             next_record_;                 ///< 获取的记录放在这里缓存起来
@@ -0,0 +1,165 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <string.h>
+
+#include "storage/record/text_file_handler.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "common/log/log.h"
+
+using namespace std;
+
+RC TextFileHandler::init(DiskBufferPool *buffer_pool)
+{
+  if (disk_buffer_pool_ != nullptr) {
+    LOG_ERROR("text file handler has been inited");
+    return RC::RECORD_OPENNED;
+  }
+
+  if (buffer_pool == nullptr) {
+    LOG_ERROR("invalid argument. buffer pool is null");
+    return RC::INVALID_ARGUMENT;
+  }
+
+  disk_buffer_pool_ = buffer_pool;
+  return RC::SUCCESS;
+}
+
+void TextFileHandler::close() { disk_buffer_pool_ = nullptr; }
+
+RC TextFileHandler::insert_text(const char *data, int length, TextRef &ref)
+{
+  ref.first_page = BP_INVALID_PAGE_NUM;
+  ref.length     = 0;
+  if (length < 0) {
+    return RC::INVALID_ARGUMENT;
+  }
+
+  RC      rc        = RC::SUCCESS;
+  PageNum next_page = BP_INVALID_PAGE_NUM;
+  int     end       = length;
+  while (end > 0) {
+    const int chunk_length = (end % PAGE_DATA_SIZE == 0) ? PAGE_DATA_SIZE : end % PAGE_DATA_SIZE;
+    const int start        = end - chunk_length;
+
+    Frame *frame = nullptr;
+    rc           = disk_buffer_pool_->allocate_page(&frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to allocate text page. rc=%s", strrc(rc));
+      break;
+    }
+
+    frame->write_latch();
+    char           *page_data = frame->data();
+    TextPageHeader *header    = reinterpret_cast<TextPageHeader *>(page_data);
+    header->next_page         = next_page;
+    header->length            = chunk_length;
+    memcpy(page_data + sizeof(TextPageHeader), data + start, chunk_length);
+    frame->mark_dirty();
+    frame->write_unlatch();
+
+    next_page = frame->page_num();
+    disk_buffer_pool_->unpin_page(frame);
+    end = start;
+  }
+
+  if (OB_FAIL(rc)) {
+    // 已经写好的部分是一个完整的链，整个释放掉
+    TextRef partial;
+    partial.first_page = next_page;
+    partial.length     = length - end;
+    RC rc2 = delete_text(partial);
+    if (OB_FAIL(rc2)) {
+      LOG_WARN("failed to free partial text pages. rc=%s", strrc(rc2));
+    }
+    return rc;
+  }
+
+  ref.first_page = next_page;
+  ref.length     = length;
+  return RC::SUCCESS;
+}
+
+RC TextFileHandler::delete_text(const TextRef &ref)
+{
+  PageNum page_num  = ref.first_page;
+  int     remaining = ref.length;
+  while (remaining > 0) {
+    Frame *frame = nullptr;
+    RC     rc    = disk_buffer_pool_->get_this_page(page_num, &frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get text page. page_num=%d, rc=%s", page_num, strrc(rc));
+      return rc;
+    }
+
+    const TextPageHeader *header = reinterpret_cast<const TextPageHeader *>(frame->data());
+    const PageNum next_page = header->next_page;
+    const int     length    = header->length;
+    disk_buffer_pool_->unpin_page(frame);
+    if (length <= 0 || length > PAGE_DATA_SIZE) {
+      LOG_WARN("corrupted text page. page_num=%d, length=%d", page_num, length);
+      return RC::IOERR_READ;
+    }
+    remaining -= length;
+
+    rc = disk_buffer_pool_->dispose_page(page_num);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to dispose text page. page_num=%d, rc=%s", page_num, strrc(rc));
+      return rc;
+    }
+    page_num = next_page;
+  }
+  return RC::SUCCESS;
+}
+
+RC TextFileHandler::read_text(const TextRef &ref, const function<RC(const char *data, int length)> &consumer) const
+{
+  PageNum page_num  = ref.first_page;
+  int     remaining = ref.length;
+  while (remaining > 0) {
+    Frame *frame = nullptr;
+    RC     rc    = disk_buffer_pool_->get_this_page(page_num, &frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get text page. page_num=%d, rc=%s", page_num, strrc(rc));
+      return rc;
+    }
+
+    frame->read_latch();
+    const char           *page_data = frame->data();
+    const TextPageHeader *header    = reinterpret_cast<const TextPageHeader *>(page_data);
+    const PageNum         next_page = header->next_page;
+    const int             length    = header->length;
+    if (length <= 0 || length > PAGE_DATA_SIZE || length > remaining) {
+      LOG_WARN("corrupted text page. page_num=%d, length=%d, remaining=%d", page_num, length, remaining);
+      rc = RC::IOERR_READ;
+    } else {
+      rc = consumer(page_data + sizeof(TextPageHeader), length);
+    }
+    frame->read_unlatch();
+    disk_buffer_pool_->unpin_page(frame);
+
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    remaining -= length;
+    page_num = next_page;
+  }
+  return RC::SUCCESS;
+}
+
+RC TextFileHandler::read_text(const TextRef &ref, string &text) const
+{
+  text.clear();
+  text.reserve(ref.length);
+  return read_text(ref, [&text](const char *data, int length) {
+    text.append(data, length);
+    return RC::SUCCESS;
+  });
+}
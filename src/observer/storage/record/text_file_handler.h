@@ -0,0 +1,89 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+#include "common/rc.h"
+#include "storage/buffer/page.h"
+
+class DiskBufferPool;
+
+/**
+ * @brief 记录中 TEXT 字段保存的内容，指向溢出文件中的页面链
+ * @ingroup RecordManager
+ * @details 长度为0时没有分配页面，first_page 没有意义。全0的字段就是空字符串
+ */
+struct TextRef
+{
+  PageNum first_page = BP_INVALID_PAGE_NUM;
+  int32_t length     = 0;  ///< 文本的总长度
+};
+
+/**
+ * @brief 溢出文件中每个页面的页头
+ * @ingroup RecordManager
+ */
+struct TextPageHeader
+{
+  PageNum next_page;  ///< 链上的下一个页面，最后一个页面是 BP_INVALID_PAGE_NUM
+  int32_t length;     ///< 当前页面保存了多少字节
+};
+
+/**
+ * @brief 管理一张表的 TEXT 溢出文件
+ * @ingroup RecordManager
+ * @details 每张有 TEXT 字段的表有一个单独的溢出文件(表名.text)，文件中只有文本页面，
+ * 数据文件的扫描不会访问它们。一个文本按顺序切成若干块，每块占一个页面，页面通过页头中的 next_page 串起来。
+ * 页头和数据一起持久化，重启之后通过记录中的 TextRef 就能找回整个文本。
+ * 读取时逐个页面交给调用者，不需要把整个文本拼到一块内存中。
+ * 溢出文件本身不做并发控制：一个文本写入之后就不会再修改，只会整个删除。
+ */
+class TextFileHandler
+{
+public:
+  static constexpr int PAGE_DATA_SIZE = BP_PAGE_DATA_SIZE - static_cast<int>(sizeof(TextPageHeader));
+
+public:
+  TextFileHandler() = default;
+  ~TextFileHandler() = default;
+
+  RC   init(DiskBufferPool *buffer_pool);
+  void close();
+
+  /**
+   * @brief 写入一个文本
+   * @details 从最后一块开始写，这样每个页面写入时就知道下一个页面的页面号
+   * @param[out] ref 返回文本的位置，需要保存到记录中
+   */
+  RC insert_text(const char *data, int length, TextRef &ref);
+
+  /**
+   * @brief 删除文本，释放链上所有的页面
+   */
+  RC delete_text(const TextRef &ref);
+
+  /**
+   * @brief 按顺序读取文本，每个页面上的数据调用一次 consumer
+   * @details 调用 consumer 时页面加着读锁，consumer 不能再访问溢出文件。consumer 返回失败时停止读取
+   */
+  RC read_text(const TextRef &ref, const std::function<RC(const char *data, int length)> &consumer) const;
+
+  /**
+   * @brief 读取整个文本
+   */
+  RC read_text(const TextRef &ref, std::string &text) const;
+
+private:
+  DiskBufferPool *disk_buffer_pool_ = nullptr;
+};
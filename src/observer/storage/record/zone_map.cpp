@@ -0,0 +1,367 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include "storage/record/zone_map.h"
+#include "common/log/log.h"
+#include "storage/common/io_backend.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief 把 yyyy-mm-dd 形式的日期转换成 yyyymmdd 形式的整数，日期的先后顺序与整数的大小顺序一致
+ */
+bool parse_date(const char *data, int len, int32_t &result)
+{
+  char buf[32];
+  len = min(len, static_cast<int>(sizeof(buf)) - 1);
+  memcpy(buf, data, len);
+  buf[len] = '\0';
+
+  int year = 0, month = 0, day = 0;
+  if (sscanf(buf, "%d-%d-%d", &year, &month, &day) != 3) {
+    return false;
+  }
+  result = year * 10000 + month * 100 + day;
+  return true;
+}
+
+}  // namespace
+
+ZoneMap::~ZoneMap()
+{
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+string ZoneMap::map_file_name(const char *data_file) { return string(data_file) + ".zm"; }
+
+bool ZoneMap::is_supported(AttrType type) { return type == INTS || type == FLOATS || type == DATES; }
+
+RC ZoneMap::open(const char *file_name, const vector<ZoneColumn> &columns, int32_t page_count, bool &loaded)
+{
+  loaded = false;
+  if (fd_ >= 0) {
+    LOG_WARN("zone map has been opened. file=%s", file_name_.c_str());
+    return RC::RECORD_OPENNED;
+  }
+  if (columns.empty()) {
+    return RC::SUCCESS;
+  }
+
+  int fd = ::open(file_name, O_RDWR | O_CREAT, S_IREAD | S_IWRITE);
+  if (fd < 0) {
+    LOG_ERROR("Failed to open zone map %s, due to %s.", file_name, strerror(errno));
+    return RC::IOERR_ACCESS;
+  }
+
+  columns_ = columns;
+  states_.clear();
+  bounds_.clear();
+
+  const int columns_size = static_cast<int>(sizeof(ZoneColumn) * columns_.size());
+  const int states_size  = page_count;
+  const int bounds_size  = static_cast<int>(sizeof(ZoneBound) * page_count * columns_.size());
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(ZoneMapHeader)) + columns_size + states_size + bounds_size) {
+    ZoneMapHeader header;
+    vector<ZoneColumn> saved_columns(columns_.size());
+    RC rc = IoBackend::instance().read(fd, &header, sizeof(header), 0);
+    if (OB_SUCC(rc) && 0 == memcmp(header.magic, ZoneMapHeader::MAGIC, sizeof(header.magic)) &&
+        header.version == ZoneMapHeader::VERSION && header.clean != 0 && header.page_count == page_count &&
+        header.column_num == static_cast<int32_t>(columns_.size())) {
+      rc = IoBackend::instance().read(fd, saved_columns.data(), columns_size, sizeof(header));
+      if (OB_SUCC(rc) && 0 == memcmp(saved_columns.data(), columns_.data(), columns_size)) {
+        states_.resize(page_count);
+        bounds_.resize(page_count * columns_.size());
+        rc = IoBackend::instance().read(fd, states_.data(), states_size, sizeof(header) + columns_size);
+        if (OB_SUCC(rc)) {
+          rc = IoBackend::instance().read(fd, bounds_.data(), bounds_size, sizeof(header) + columns_size + states_size);
+        }
+        loaded = OB_SUCC(rc);
+      }
+    }
+  }
+  if (!loaded) {
+    LOG_INFO("zone map is not usable, it will be rebuilt. file=%s", file_name);
+    states_.clear();
+    bounds_.clear();
+  }
+  resize(page_count);
+
+  fd_        = fd;
+  file_name_ = file_name;
+
+  // 先把文件标记为没有正常关闭，崩溃之后就不会再使用旧的摘要
+  RC rc = write_header(false /*clean*/, page_count);
+  if (OB_SUCC(rc)) {
+    rc = IoBackend::instance().sync(fd_);
+  }
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to mark zone map as in use. file=%s, rc=%s", file_name, strrc(rc));
+    ::close(fd_);
+    fd_    = -1;
+    loaded = false;
+    columns_.clear();
+    states_.clear();
+    bounds_.clear();
+    return rc;
+  }
+  return RC::SUCCESS;
+}
+
+RC ZoneMap::close(int32_t page_count)
+{
+  if (fd_ < 0) {
+    return RC::SUCCESS;
+  }
+
+  resize(page_count);
+  states_.resize(page_count);
+  bounds_.resize(page_count * columns_.size());
+
+  // 摘要先落盘，然后才能标记为正常关闭
+  const int columns_size = static_cast<int>(sizeof(ZoneColumn) * columns_.size());
+  const int states_size  = page_count;
+  const int bounds_size  = static_cast<int>(sizeof(ZoneBound) * bounds_.size());
+
+  RC rc = IoBackend::instance().write(fd_, columns_.data(), columns_size, sizeof(ZoneMapHeader));
+  if (OB_SUCC(rc)) {
+    rc = IoBackend::instance().write(fd_, states_.data(), states_size, sizeof(ZoneMapHeader) + columns_size);
+  }
+  if (OB_SUCC(rc)) {
+    rc = IoBackend::instance().write(fd_, bounds_.data(), bounds_size, sizeof(ZoneMapHeader) + columns_size + states_size);
+  }
+  if (OB_SUCC(rc)) {
+    rc = IoBackend::instance().sync(fd_);
+  }
+  if (OB_SUCC(rc)) {
+    rc = write_header(true /*clean*/, page_count);
+  }
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to write zone map, it will be rebuilt next time. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+  }
+
+  ::close(fd_);
+  fd_ = -1;
+  columns_.clear();
+  states_.clear();
+  bounds_.clear();
+  return rc;
+}
+
+int ZoneMap::find_column(int offset) const
+{
+  for (size_t i = 0; i < columns_.size(); i++) {
+    if (columns_[i].offset == offset) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void ZoneMap::reset_page(PageNum page_num)
+{
+  if (fd_ < 0 || page_num < 0) {
+    return;
+  }
+
+  lock_.lock();
+  resize(page_num + 1);
+  states_[page_num] = PAGE_TRACKED;
+  for (size_t i = 0; i < columns_.size(); i++) {
+    bounds_[page_num * columns_.size() + i].has_value = 0;
+  }
+  lock_.unlock();
+}
+
+void ZoneMap::forget_page(PageNum page_num)
+{
+  if (fd_ < 0 || page_num < 0) {
+    return;
+  }
+
+  lock_.lock();
+  if (page_num < static_cast<PageNum>(states_.size())) {
+    states_[page_num] = PAGE_UNKNOWN;
+  }
+  lock_.unlock();
+}
+
+void ZoneMap::update(PageNum page_num, const char *record)
+{
+  if (fd_ < 0 || page_num < 0) {
+    return;
+  }
+
+  lock_.lock();
+  // 没有摘要的页面就一直没有摘要，不知道页面上原来有哪些值
+  if (page_num < static_cast<PageNum>(states_.size()) && states_[page_num] == PAGE_TRACKED) {
+    for (size_t i = 0; i < columns_.size(); i++) {
+      const ZoneColumn &column = columns_[i];
+      ZoneValue         value;
+      if (!read_value(column, record, value)) {
+        continue;
+      }
+
+      ZoneBound &bound = bounds_[page_num * columns_.size() + i];
+      if (!bound.has_value) {
+        bound.has_value = 1;
+        bound.min       = value;
+        bound.max       = value;
+      } else if (compare_value(column, value, bound.min) < 0) {
+        bound.min = value;
+      } else if (compare_value(column, value, bound.max) > 0) {
+        bound.max = value;
+      }
+    }
+  }
+  lock_.unlock();
+}
+
+bool ZoneMap::may_match(PageNum page_num, const vector<ZoneCondition> &conditions) const
+{
+  if (fd_ < 0 || conditions.empty()) {
+    return true;
+  }
+
+  bool result = true;
+  lock_.lock_shared();
+  if (page_num >= 0 && page_num < static_cast<PageNum>(states_.size()) && states_[page_num] == PAGE_TRACKED) {
+    for (const ZoneCondition &condition : conditions) {
+      const ZoneBound &bound = bounds_[page_num * columns_.size() + condition.column];
+      if (!bound_may_match(bound, condition)) {
+        result = false;
+        break;
+      }
+    }
+  }
+  lock_.unlock_shared();
+  return result;
+}
+
+bool ZoneMap::read_value(const ZoneColumn &column, const char *record, ZoneValue &value) const
+{
+  if ((record[column.null_byte] & column.null_mask) == 0) {
+    return false;
+  }
+
+  switch (column.type) {
+    case INTS: {
+      memcpy(&value.int_value, record + column.offset, sizeof(value.int_value));
+    } break;
+    case FLOATS: {
+      memcpy(&value.float_value, record + column.offset, sizeof(value.float_value));
+    } break;
+    case DATES: {
+      return parse_date(record + column.offset, column.len, value.int_value);
+    } break;
+    default: {
+      return false;
+    }
+  }
+  return true;
+}
+
+int ZoneMap::compare_value(const ZoneColumn &column, const ZoneValue &left, const ZoneValue &right) const
+{
+  if (column.type == FLOATS) {
+    return (left.float_value < right.float_value) ? -1 : (left.float_value > right.float_value ? 1 : 0);
+  }
+  return (left.int_value < right.int_value) ? -1 : (left.int_value > right.int_value ? 1 : 0);
+}
+
+bool ZoneMap::compare_condition(const ZoneColumn &column, const ZoneValue &value, const Value &other, int &result) const
+{
+  switch (column.type) {
+    case INTS: {
+      return OB_SUCC(Value(value.int_value).compare(other, result));
+    }
+    case FLOATS: {
+      return OB_SUCC(Value(value.float_value).compare(other, result));
+    }
+    case DATES: {
+      ZoneValue other_value;
+      const string str = other.to_string();
+      if (other.attr_type() != DATES || !parse_date(str.c_str(), static_cast<int>(str.size()), other_value.int_value)) {
+        return false;
+      }
+      result = compare_value(column, value, other_value);
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+bool ZoneMap::bound_may_match(const ZoneBound &bound, const ZoneCondition &condition) const
+{
+  // 页面上这个字段都是 null，与 null 比较的结果总是 false
+  if (!bound.has_value) {
+    return false;
+  }
+
+  const AttrType value_type = condition.value.attr_type();
+  if (value_type != INTS && value_type != FLOATS && value_type != DATES) {
+    return true;
+  }
+
+  // 字段的值都在 [min, max] 中。比较结果随字段的值单调变化，只需要看区间的两端
+  const ZoneColumn &column  = columns_[condition.column];
+  int               cmp_min = 0;
+  int               cmp_max = 0;
+  if (!compare_condition(column, bound.min, condition.value, cmp_min) ||
+      !compare_condition(column, bound.max, condition.value, cmp_max)) {
+    return true;
+  }
+
+  switch (condition.op) {
+    case EQUAL_TO: return cmp_min <= 0 && cmp_max >= 0;
+    case LESS_THAN: return cmp_min < 0;
+    case LESS_EQUAL: return cmp_min <= 0;
+    case GREAT_THAN: return cmp_max > 0;
+    case GREAT_EQUAL: return cmp_max >= 0;
+    case NOT_EQUAL: return !(cmp_min == 0 && cmp_max == 0);
+    default: return true;
+  }
+}
+
+void ZoneMap::resize(int32_t page_count)
+{
+  if (static_cast<int32_t>(states_.size()) < page_count) {
+    states_.resize(page_count, PAGE_UNKNOWN);
+    bounds_.resize(page_count * columns_.size());
+  }
+}
+
+RC ZoneMap::write_header(bool clean, int32_t page_count)
+{
+  ZoneMapHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, ZoneMapHeader::MAGIC, sizeof(header.magic));
+  header.version    = ZoneMapHeader::VERSION;
+  header.clean      = clean ? 1 : 0;
+  header.page_count = page_count;
+  header.column_num = static_cast<int32_t>(columns_.size());
+  return IoBackend::instance().write(fd_, &header, sizeof(header), 0);
+}
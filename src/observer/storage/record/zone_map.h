@@ -0,0 +1,179 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "common/enum.h"
+#include "common/lang/mutex.h"
+#include "common/rc.h"
+#include "sql/parser/value.h"
+#include "storage/buffer/page.h"
+
+/**
+ * @brief 记录区间摘要的一个字段
+ * @ingroup RecordManager
+ * @details 只支持 INTS、FLOATS 和 DATES 字段。字段是否为 null 由记录末尾的 null 位图决定，对应的位是0时表示null
+ */
+struct ZoneColumn
+{
+  AttrType type;       ///< 字段类型
+  int32_t  offset;     ///< 字段在记录中的偏移
+  int32_t  len;        ///< 字段的长度
+  int32_t  null_byte;  ///< null 位图中这个字段所在的字节在记录中的偏移
+  int32_t  null_mask;  ///< 这个字段在 null 位图字节中的位
+};
+
+/**
+ * @brief 下推到扫描中的过滤条件，表示 字段 op value
+ * @ingroup RecordManager
+ */
+struct ZoneCondition
+{
+  int    column = -1;  ///< 字段在 ZoneMap 中的下标，参考 ZoneMap::find_column
+  CompOp op     = EQUAL_TO;
+  Value  value;
+};
+
+/**
+ * @brief 区间摘要文件的文件头
+ * @ingroup RecordManager
+ */
+struct ZoneMapHeader
+{
+  static constexpr char    MAGIC[8] = {'M', 'O', 'B', 'Z', 'O', 'N', 'E', 'M'};
+  static constexpr int32_t VERSION  = 1;
+
+  char    magic[8];
+  int32_t version;
+  int32_t clean;       ///< 上次是否正常关闭，与 FreeSpaceMapHeader 相同
+  int32_t page_count;  ///< 关闭时数据文件的页面数
+  int32_t column_num;  ///< 文件头之后是 column_num 个 ZoneColumn，字段变化之后摘要就不能用了
+};
+
+/**
+ * @brief 记录文件中每个页面的区间摘要(zone map)
+ * @ingroup RecordManager
+ * @details 对每个页面的每个数值/日期字段记录最小值和最大值。扫描时如果某个页面的区间不可能满足下推的比较条件，
+ * 就不需要读取这个页面。
+ *
+ * 插入和更新记录时只会扩大区间，删除记录时不缩小，所以区间总是包含页面上所有记录的值，跳过页面不会漏掉数据。
+ * 新分配的页面区间是空的，没有摘要的页面(比如恢复时写入的页面)不会被跳过。
+ *
+ * 与 FreeSpaceMap 一样保存在数据文件旁边的文件中(数据文件名加上 .zm)，关闭时写回。
+ * 没有正常关闭或者字段变化之后摘要不可用，RecordFileHandler 会扫描数据文件重建。
+ */
+class ZoneMap
+{
+public:
+  ZoneMap() = default;
+  ~ZoneMap();
+
+  static std::string map_file_name(const char *data_file);
+
+  /**
+   * @brief 这种类型的字段能否记录区间
+   */
+  static bool is_supported(AttrType type);
+
+  /**
+   * @brief 打开摘要文件，不存在时创建
+   * @param columns     记录区间的字段，为空时不使用摘要
+   * @param page_count  数据文件当前的页面数
+   * @param[out] loaded 摘要是否可用。不可用时所有页面都没有摘要，需要调用者通过 reset_page 和 update 重建
+   */
+  RC open(const char *file_name, const std::vector<ZoneColumn> &columns, int32_t page_count, bool &loaded);
+
+  /**
+   * @brief 写回摘要，标记为正常关闭，然后关闭文件
+   */
+  RC close(int32_t page_count);
+
+  bool is_open() const { return fd_ >= 0; }
+
+  /**
+   * @brief 查找偏移为 offset 的字段
+   * @return 字段的下标，没有记录这个字段的区间时返回 -1
+   */
+  int find_column(int offset) const;
+
+  const ZoneColumn &column(int index) const { return columns_[index]; }
+
+  /**
+   * @brief 页面刚刚初始化，还没有记录，区间是空的
+   */
+  void reset_page(PageNum page_num);
+
+  /**
+   * @brief 页面的摘要不可信了，以后扫描时不再跳过这个页面
+   */
+  void forget_page(PageNum page_num);
+
+  /**
+   * @brief 页面上写入了一条记录，扩大页面的区间
+   */
+  void update(PageNum page_num, const char *record);
+
+  /**
+   * @brief 页面上是否可能有满足所有条件的记录
+   * @details 没有摘要或者无法判断时返回 true
+   */
+  bool may_match(PageNum page_num, const std::vector<ZoneCondition> &conditions) const;
+
+private:
+  /**
+   * @brief 字段的值。日期转换成 yyyymmdd 形式的整数
+   */
+  union ZoneValue
+  {
+    int32_t int_value;
+    float   float_value;
+  };
+
+  /**
+   * @brief 一个页面上一个字段的区间
+   */
+  struct ZoneBound
+  {
+    int32_t   has_value;  ///< 页面上是否有这个字段不为 null 的记录
+    ZoneValue min;
+    ZoneValue max;
+  };
+
+  enum PageState : char
+  {
+    PAGE_UNKNOWN = 0,  ///< 没有摘要，不能跳过
+    PAGE_TRACKED = 1,
+  };
+
+  bool read_value(const ZoneColumn &column, const char *record, ZoneValue &value) const;
+  int  compare_value(const ZoneColumn &column, const ZoneValue &left, const ZoneValue &right) const;
+
+  /**
+   * @brief 比较字段的值与条件中的值，结果与 Value::compare 一致
+   * @return 无法比较时返回 false
+   */
+  bool compare_condition(const ZoneColumn &column, const ZoneValue &value, const Value &other, int &result) const;
+  bool bound_may_match(const ZoneBound &bound, const ZoneCondition &condition) const;
+
+  void resize(int32_t page_count);
+  RC   write_header(bool clean, int32_t page_count);
+
+private:
+  std::string             file_name_;
+  int                     fd_ = -1;
+  std::vector<ZoneColumn> columns_;
+  std::vector<char>       states_;  ///< 每个页面一个 PageState
+  std::vector<ZoneBound>  bounds_;  ///< 页面 i 的第 j 个字段在 i * columns_.size() + j
+  mutable common::SharedMutex lock_;  ///< 当编译时增加-DCONCURRENCY=ON 选项时，才会真正的支持并发
+};
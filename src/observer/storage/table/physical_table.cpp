@@ -17,6 +17,7 @@ See the Mulan PSL v2 for more details. */
 #include <algorithm>
 
 #include "common/defs.h"
+#include "common/global_context.h"
 #include "storage/table/table.h"
 #include "storage/table/physical_table.h"
 #include "storage/table/table_meta.h"
@@ -24,6 +25,7 @@ See the Mulan PSL v2 for more details. */
 #include "common/lang/string.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/record/record_manager.h"
+#include "storage/record/text_file_handler.h"
 #include "storage/common/condition_filter.h"
 #include "storage/common/meta_util.h"
 #include "storage/index/index.h"
@@ -31,8 +33,6 @@ See the Mulan PSL v2 for more details. */
 #include "storage/trx/trx.h"
 #include "event/sql_debug.h"
 
-RC make_text_value(RecordFileHandler *record_handler, Value &value);
-
 PhysicalTable::PhysicalTable() {}
 
 PhysicalTable::~PhysicalTable()
@@ -47,6 +47,16 @@ PhysicalTable::~PhysicalTable()
     data_buffer_pool_ = nullptr;
   }
 
+  if (text_handler_ != nullptr) {
+    delete text_handler_;
+    text_handler_ = nullptr;
+  }
+
+  if (text_buffer_pool_ != nullptr) {
+    text_buffer_pool_->close_file();
+    text_buffer_pool_ = nullptr;
+  }
+
   for (std::vector<Index *>::iterator it = indexes_.begin(); it != indexes_.end(); ++it) {
     Index *index = *it;
     delete index;
@@ -62,6 +72,19 @@ RC PhysicalTable::create(int32_t table_id,
                  const char *base_dir, 
                  int attribute_count, 
                  const AttrInfoSqlNode attributes[])
+{
+  return create(table_id, path, name, base_dir, attribute_count, attributes,
+                nullptr /*compression*/, nullptr /*record_format*/);
+}
+
+RC PhysicalTable::create(int32_t table_id, 
+                 const char *path, 
+                 const char *name, 
+                 const char *base_dir, 
+                 int attribute_count, 
+                 const AttrInfoSqlNode attributes[],
+                 const char *compression,
+                 const char *record_format)
 {
   if (table_id < 0) {
     LOG_WARN("invalid table id. table_id=%d, table_name=%s", table_id, name);
@@ -79,6 +102,12 @@ RC PhysicalTable::create(int32_t table_id,
     return RC::INVALID_ARGUMENT;
   }
 
+  RecordFormat format = RecordFormat::FIXED;
+  if (!record_format_from_name(record_format, format)) {
+    LOG_WARN("Invalid record format. table_name=%s, record_format=%s", name, record_format);
+    return RC::INVALID_ARGUMENT;
+  }
+
   RC rc = RC::SUCCESS;
 
   // 使用 table_name.table记录一个表的元数据
@@ -100,6 +129,7 @@ RC PhysicalTable::create(int32_t table_id,
     LOG_ERROR("Failed to init table meta. name:%s, ret:%d", name, rc);
     return rc;  // delete table file
   }
+  table_meta_.set_record_format(format);
 
   std::fstream fs;
   fs.open(path, std::ios_base::out | std::ios_base::binary);
@@ -114,12 +144,25 @@ RC PhysicalTable::create(int32_t table_id,
 
   std::string data_file = table_data_file(base_dir, name);
   BufferPoolManager &bpm = BufferPoolManager::instance();
-  rc = bpm.create_file(data_file.c_str());
+  rc = bpm.create_file(data_file.c_str(), compression);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to create disk buffer pool of data file. file name=%s", data_file.c_str());
     return rc;
   }
 
+  if (has_text_field()) {
+    std::string text_file = table_text_file(base_dir, name);
+    rc = bpm.create_file(text_file.c_str(), compression);
+    if (rc != RC::SUCCESS) {
+      LOG_ERROR("Failed to create disk buffer pool of text file. file name=%s", text_file.c_str());
+      return rc;
+    }
+  }
+
+  // 同名的表删除时如果没有清理干净，留下的空闲空间映射和区间摘要与新文件无关
+  ::remove(FreeSpaceMap::map_file_name(data_file.c_str()).c_str());
+  ::remove(ZoneMap::map_file_name(data_file.c_str()).c_str());
+
   rc = init_record_handler(base_dir);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to create table %s due to init record handler failed.", data_file.c_str());
@@ -145,6 +188,20 @@ RC PhysicalTable::drop()
     LOG_ERROR("%s", strerror(errno));
     rc = RC::FILE_REMOVE;
   }
+  // 压缩的表还有页面映射文件，没有压缩时文件不存在
+  ::remove(CompressedPageFile::map_file_name(table_data_path.c_str()).c_str());
+  ::remove(FreeSpaceMap::map_file_name(table_data_path.c_str()).c_str());
+  ::remove(ZoneMap::map_file_name(table_data_path.c_str()).c_str());
+
+  // 没有 TEXT 字段的表没有溢出文件
+  if (text_buffer_pool_ != nullptr) {
+    std::string table_text_path = table_text_file(base_dir_.c_str(), table_meta_.name());
+    if (::remove(table_text_path.c_str()) != 0) {
+      LOG_ERROR("%s", strerror(errno));
+      rc = RC::FILE_REMOVE;
+    }
+    ::remove(CompressedPageFile::map_file_name(table_text_path.c_str()).c_str());
+  }
 
   const int index_num = table_meta_.index_num();
   for (int i = 0; i < index_num; i++) {
@@ -154,6 +211,7 @@ RC PhysicalTable::drop()
       LOG_ERROR("%s", strerror(errno));
       rc = RC::FILE_REMOVE;
     }
+    ::remove(CompressedPageFile::map_file_name(index_path.c_str()).c_str());
   }
   return rc;
 }
@@ -224,6 +282,8 @@ RC PhysicalTable::insert_record(Record &record)
       continue;
     rc = index->unique_check(record.data(), &record.rid());
     if (rc != RC::SUCCESS) {
+      // make_record 已经写好了文本，记录插不进去就没有人引用它们了
+      delete_texts(record.data(), nullptr);
       return rc;
     }
   }
@@ -231,6 +291,7 @@ RC PhysicalTable::insert_record(Record &record)
   rc = record_handler_->insert_record(record.data(), table_meta_.record_size(), &record.rid());
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Insert record failed. table name=%s, rc=%s", table_meta_.name(), strrc(rc));
+    delete_texts(record.data(), nullptr);
     return rc;
   }
 
@@ -241,30 +302,122 @@ RC PhysicalTable::insert_record(Record &record)
   return rc;
 }
 
+RC PhysicalTable::insert_records(std::span<Record> records)
+{
+  RC rc = RC::SUCCESS;
+
+  auto delete_all_texts = [this, &records]() {
+    for (Record &record : records) {
+      delete_texts(record.data(), nullptr);
+    }
+  };
+
+  // 这一批记录之间的重复键值在插入索引时检查
+  for (Record &record : records) {
+    for (Index *index : indexes_) {
+      if (ignore_index(index, record))
+        continue;
+      rc = index->unique_check(record.data(), &record.rid());
+      if (rc != RC::SUCCESS) {
+        delete_all_texts();
+        return rc;
+      }
+    }
+  }
+
+  const int                 count = static_cast<int>(records.size());
+  std::vector<const char *> datas(count);
+  std::vector<RID>          rids(count);
+  for (int i = 0; i < count; i++) {
+    datas[i] = records[i].data();
+  }
+
+  rc = record_handler_->insert_records(datas.data(), count, table_meta_.record_size(), rids.data());
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Insert records failed. table name=%s, count=%d, rc=%s", table_meta_.name(), count, strrc(rc));
+    delete_all_texts();
+    return rc;
+  }
+  for (int i = 0; i < count; i++) {
+    records[i].set_rid(rids[i]);
+  }
+
+  // 每个索引只插入索引字段都不是NULL的记录
+  std::vector<const char *> index_datas;
+  std::vector<RID>          index_rids;
+  auto collect = [&](Index *index) {
+    index_datas.clear();
+    index_rids.clear();
+    for (Record &record : records) {
+      if (!ignore_index(index, record)) {
+        index_datas.push_back(record.data());
+        index_rids.push_back(record.rid());
+      }
+    }
+  };
+
+  size_t index_num = 0;
+  for (; index_num < indexes_.size(); index_num++) {
+    Index *index = indexes_[index_num];
+    collect(index);
+    rc = index->insert_entries(index_datas.data(), index_rids.data(), static_cast<int>(index_datas.size()));
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("failed to insert entries into index. table=%s, index=%s, rc=%s",
+               name(), index->index_meta().name(), strrc(rc));
+      break;
+    }
+  }
+
+  if (rc != RC::SUCCESS) {
+    for (size_t i = 0; i < index_num; i++) {
+      collect(indexes_[i]);
+      for (size_t j = 0; j < index_datas.size(); j++) {
+        RC rc2 = indexes_[i]->delete_entry(index_datas[j], &index_rids[j]);
+        if (rc2 != RC::SUCCESS) {
+          LOG_WARN("failed to rollback index entry. table=%s, rid=%s, rc=%s",
+                   name(), index_rids[j].to_string().c_str(), strrc(rc2));
+        }
+      }
+    }
+    for (const RID &rid : rids) {
+      RC rc2 = record_handler_->delete_record(&rid);
+      if (rc2 != RC::SUCCESS) {
+        LOG_WARN("failed to rollback record. table=%s, rid=%s, rc=%s", name(), rid.to_string().c_str(), strrc(rc2));
+      }
+    }
+    delete_all_texts();
+  }
+  return rc;
+}
+
 RC PhysicalTable::update_record_impl(std::vector<const FieldMeta *> &field_metas, std::vector<Value> &values, Record &record) {
   assert(field_metas.size() == values.size());
   for (size_t i = 0; i < field_metas.size(); i++) {
     Value *value = &values[i];
     const FieldMeta *field_meta = field_metas[i];
 
-    if (value->attr_type() != NULL_TYPE) {
+    if (value->attr_type() == TEXTS) {
+      // 旧的文本等记录更新成功之后在 update_record 中释放
+      TextRef ref;
+      RC rc = text_handler_->insert_text(value->data(), value->length(), ref);
+      if (rc != RC::SUCCESS) {
+        LOG_WARN("failed to insert text. table=%s, field=%s, rc=%s", name(), field_meta->name(), strrc(rc));
+        return rc;
+      }
+      memcpy(record.data() + field_meta->offset(), &ref, sizeof(ref));
+    } else if (value->attr_type() != NULL_TYPE) {
       int len;
-      if (value->attr_type() == TEXTS) {
-        len = field_meta->len();
-        RC rc = record_handler_->delete_record(reinterpret_cast<RID *>(record.data() + field_meta->offset()));
-        if (rc != RC::SUCCESS) {
-          LOG_WARN("");
-          return rc;
-        }
-        make_text_value(record_handler_, *value);
-      } else { 
-        if (value->attr_type() == CHARS) {
-          len = min(value->length() + 1, field_meta->len());
-        } else {
-          len = min(value->length(), field_meta->len());
-        }
+      if (value->attr_type() == CHARS) {
+        len = min(value->length() + 1, field_meta->len());
+      } else {
+        len = min(value->length(), field_meta->len());
       }
       memcpy(record.data() + field_meta->offset(), value->data(), len);
+      // 清掉旧值留下的字节，与 make_record 一致
+      memset(record.data() + field_meta->offset() + len, 0, field_meta->len() - len);
+    } else if (field_meta->type() == TEXTS) {
+      // 不再引用旧的文本
+      memset(record.data() + field_meta->offset(), 0, field_meta->len());
     }
 
     if (value->attr_type() == NULL_TYPE) {
@@ -314,7 +467,7 @@ RC PhysicalTable::update_record(Record &record)
   auto copier = [&](Record &record_src) {
     memcpy(data_bak, record_src.data(), record_size);
   };
-  rc = record_handler_->visit_record(record.rid(), false/*readonly*/, copier);
+  rc = record_handler_->visit_record(record.rid(), true/*readonly*/, copier);
   if (rc != RC::SUCCESS) {
     free(data_bak);
     LOG_WARN("failed to visit record");
@@ -327,29 +480,44 @@ RC PhysicalTable::update_record(Record &record)
     if (update_need_unique_check(index, data_bak, record.data())) {
       rc = index->unique_check(record.data(), &record.rid());
       if (rc != RC::SUCCESS) {
+        delete_texts(record.data(), data_bak);
+        free(data_bak);
         return rc;
       }
     }
-    rc = index->delete_entry(data_bak, &record.rid());
+  }
+
+  // 变长格式的表中，记录变长之后可能会搬到其它页面，索引要使用新的位置
+  const RID old_rid = record.rid();
+  rc = record_handler_->update_record(record.data(), table_meta_.record_size(), &record.rid());
+  if (rc != RC::SUCCESS) {
+    delete_texts(record.data(), data_bak);
+    free(data_bak);
+    LOG_WARN("update record error %s", strrc(rc));
+    return rc;
+  }
+
+  // 新的记录已经写下去了，旧记录引用的文本不再需要
+  delete_texts(data_bak, record.data());
+
+  for (Index *index : indexes_) {
+    if (ignore_index(index, record))
+      continue;
+    rc = index->delete_entry(data_bak, &old_rid);
     if (RC::SUCCESS != rc) {
       LOG_WARN("failed to delete entry from index. table name=%s, index name=%s, rid=%s, rc=%s",
-           name(), index->index_meta().name(), record.rid().to_string().c_str(), strrc(rc));
-      return rc;
+           name(), index->index_meta().name(), old_rid.to_string().c_str(), strrc(rc));
+      break;
     }
     rc = index->insert_entry(record.data(), &record.rid());
     if (RC::SUCCESS != rc) {
       LOG_WARN("failed to delete entry from index. table name=%s, index name=%s, rid=%s, rc=%s",
            name(), index->index_meta().name(), record.rid().to_string().c_str(), strrc(rc));
-      return rc;
+      break;
     }
   }
 
-  rc = record_handler_->update_record(record.data(), table_meta_.record_size(), &record.rid());
-  if (rc != RC::SUCCESS) {
-    LOG_WARN("update record error %s", strrc(rc));
-    return rc;
-  }
-
+  free(data_bak);
   return rc;
 }
 
@@ -361,9 +529,6 @@ RC PhysicalTable::visit_record(const RID &rid, bool readonly, std::function<void
 RC PhysicalTable::get_record(const RID &rid, Record &record)
 {
   int record_size = table_meta_.record_size();
-  if (rid.init) {
-    record_size = rid.over_len; 
-  }
   char *record_data = (char *)malloc(record_size);
   ASSERT(nullptr != record_data, "failed to malloc memory. record data size=%d", record_size);
 
@@ -442,8 +607,9 @@ RC PhysicalTable::make_record(int value_num, const Value *values, Record &record
   }
 
   // 需要record末尾几个字节来作为数据是否为null的判据
+  // 没有赋值的字节清零，变长格式的表编码时会把这些0压缩掉
   int record_size = table_meta_.record_size();
-  char *record_data = (char *)malloc(record_size);
+  char *record_data = (char *)calloc(1, record_size);
 
   int column = table_meta_.field_num();
   int nr_null_bytes = NR_NULL_BYTE(column);
@@ -453,28 +619,31 @@ RC PhysicalTable::make_record(int value_num, const Value *values, Record &record
   for (int i = 0; i < value_num; i++) {
     const FieldMeta *field = table_meta_.field(i + normal_field_start_index);
     Value &value = const_cast<Value &>(values[i]);
-    // 如果是字符串类型，则拷贝字符串的len + 1字节。
+    int isnotnull = value.attr_type() != NULL_TYPE;
+    null_bytes[i/8] |= (isnotnull << (i % 8));
+
+    // 文本写到溢出文件中，记录里只保存它的位置
     if (value.attr_type() == TEXTS) {
-      if (value.get_string().length() > 65535) {
-        return RC::TEXT_OVERFLOW;
+      TextRef ref;
+      RC rc = (value.length() > 65535) ? RC::TEXT_OVERFLOW : text_handler_->insert_text(value.data(), value.length(), ref);
+      if (rc != RC::SUCCESS) {
+        LOG_WARN("failed to insert text. table=%s, field=%s, rc=%s", name(), field->name(), strrc(rc));
+        delete_texts(record_data, nullptr);
+        free(record_data);
+        return rc;
       }
-      make_text_value(record_handler_, value);
-      record.add_offset_text(field->offset());
-      record.set_if_text();
+      memcpy(record_data + field->offset(), &ref, sizeof(ref));
+      continue;
     }
 
+    // 如果是字符串类型，则拷贝字符串的len + 1字节。
     size_t copy_len = field->len();
     if (field->type() == CHARS || field->type() == DATES) {
       const size_t data_len = value.length();
       if (copy_len > data_len) {
         copy_len = data_len + 1;
       }
-      if (field->type() == TEXTS) {
-        copy_len = sizeof(RID);
-      }
     }
-    int isnotnull = value.attr_type() != NULL_TYPE;
-    null_bytes[i/8] |= (isnotnull << (i % 8));
     memcpy(record_data + field->offset(), value.data(), copy_len);
   }
   memcpy(record_data + record_size - nr_null_bytes, null_bytes, nr_null_bytes);
@@ -493,8 +662,20 @@ RC PhysicalTable::init_record_handler(const char *base_dir)
     return rc;
   }
 
+  // 数值和日期字段记录每个页面的区间，扫描时跳过不满足条件的页面
+  const int sys_field_num = table_meta_.sys_field_num();
+  const int null_start    = table_meta_.record_size() - NR_NULL_BYTE(table_meta_.field_num());
+  std::vector<ZoneColumn> zone_columns;
+  for (int i = sys_field_num; i < table_meta_.field_num(); i++) {
+    const FieldMeta *field = table_meta_.field(i);
+    if (ZoneMap::is_supported(field->type())) {
+      const int index = i - sys_field_num;
+      zone_columns.push_back(ZoneColumn{field->type(), field->offset(), field->len(), null_start + index / 8, 1 << (index % 8)});
+    }
+  }
+
   record_handler_ = new RecordFileHandler();
-  rc = record_handler_->init(data_buffer_pool_);
+  rc = record_handler_->init(data_buffer_pool_, table_meta_.record_format(), zone_columns);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to init record handler. rc=%s", strrc(rc));
     data_buffer_pool_->close_file();
@@ -504,12 +685,85 @@ RC PhysicalTable::init_record_handler(const char *base_dir)
     return rc;
   }
 
+  return init_text_handler(base_dir);
+}
+
+RC PhysicalTable::init_text_handler(const char *base_dir)
+{
+  if (!has_text_field()) {
+    return RC::SUCCESS;
+  }
+
+  std::string text_file = table_text_file(base_dir, table_meta_.name());
+
+  RC rc = BufferPoolManager::instance().open_file(text_file.c_str(), text_buffer_pool_);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to open disk buffer pool for file:%s. rc=%d:%s", text_file.c_str(), rc, strrc(rc));
+    return rc;
+  }
+
+  text_handler_ = new TextFileHandler();
+  rc = text_handler_->init(text_buffer_pool_);
+  if (rc != RC::SUCCESS) {
+    LOG_ERROR("Failed to init text handler. rc=%s", strrc(rc));
+    text_buffer_pool_->close_file();
+    text_buffer_pool_ = nullptr;
+    delete text_handler_;
+    text_handler_ = nullptr;
+    return rc;
+  }
   return rc;
 }
 
-RC PhysicalTable::get_record_scanner(RecordFileScanner &scanner, Trx *trx, bool readonly)
+bool PhysicalTable::has_text_field() const
+{
+  for (int i = table_meta_.sys_field_num(); i < table_meta_.field_num(); i++) {
+    if (table_meta_.field(i)->type() == TEXTS) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void PhysicalTable::delete_texts(const char *data, const char *keep)
+{
+  if (text_handler_ == nullptr) {
+    return;
+  }
+
+  for (int i = table_meta_.sys_field_num(); i < table_meta_.field_num(); i++) {
+    const FieldMeta *field = table_meta_.field(i);
+    if (field->type() != TEXTS) {
+      continue;
+    }
+    TextRef ref;
+    memcpy(&ref, data + field->offset(), sizeof(ref));
+    if (ref.length == 0 || (keep != nullptr && 0 == memcmp(&ref, keep + field->offset(), sizeof(ref)))) {
+      continue;
+    }
+    RC rc = text_handler_->delete_text(ref);
+    if (rc != RC::SUCCESS) {
+      LOG_WARN("failed to delete text. table=%s, field=%s, rc=%s", name(), field->name(), strrc(rc));
+    }
+  }
+}
+
+RC PhysicalTable::read_text(const Value &value, const std::function<RC(const char *, int)> &consumer) const
+{
+  if (text_handler_ == nullptr || value.attr_type() != TEXTS || value.length() != static_cast<int>(sizeof(TextRef))) {
+    LOG_WARN("value is not a text of this table. table=%s, type=%d, length=%d", name(), value.attr_type(), value.length());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  TextRef ref;
+  memcpy(&ref, value.data(), sizeof(ref));
+  return text_handler_->read_text(ref, consumer);
+}
+
+RC PhysicalTable::get_record_scanner(RecordFileScanner &scanner, Trx *trx, bool readonly,
+                                     PageNum start_page /* = 0 */, PageNum end_page /* = BP_INVALID_PAGE_NUM */)
 {
-  RC rc = scanner.open_scan(this, *data_buffer_pool_, trx, readonly, nullptr);
+  RC rc = scanner.open_scan(this, *data_buffer_pool_, trx, readonly, nullptr, start_page, end_page);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("failed to open scanner. rc=%s", strrc(rc));
   }
@@ -533,7 +787,8 @@ RC PhysicalTable::create_index(Trx *trx, const std::vector<FieldMeta> field_meta
   // 创建索引相关数据
   BplusTreeIndex *index = new BplusTreeIndex();
   std::string index_file = table_index_file(base_dir_.c_str(), name(), index_name);
-  rc = index->create(index_file.c_str(), new_index_meta, field_meta);
+  // 索引文件与数据文件使用相同的压缩算法
+  rc = index->create(index_file.c_str(), new_index_meta, field_meta, data_buffer_pool_->codec_name());
   index->set_index_meta_unique(unique);
   if (rc != RC::SUCCESS) {
     delete index;
@@ -541,7 +796,7 @@ RC PhysicalTable::create_index(Trx *trx, const std::vector<FieldMeta> field_meta
     return rc;
   }
 
-  // 遍历当前的所有数据，插入这个索引
+  // 遍历当前的所有数据，排序后批量构建索引
   RecordFileScanner scanner;
   rc = get_record_scanner(scanner, trx, true/*readonly*/);
   if (rc != RC::SUCCESS) {
@@ -550,20 +805,11 @@ RC PhysicalTable::create_index(Trx *trx, const std::vector<FieldMeta> field_meta
     return rc;
   }
 
-  Record record;
-  while (scanner.has_next()) {
-    rc = scanner.next(record);
-    if (rc != RC::SUCCESS) {
-      LOG_WARN("failed to scan records while creating index. table=%s, index=%s, rc=%s",
-               name(), index_name, strrc(rc));
-      return rc;
-    }
-    rc = index->insert_entry_first(record.data(), &record.rid());
-    if (rc != RC::SUCCESS) {
-      LOG_WARN("failed to insert record into index while creating index. table=%s, index=%s, rc=%s",
-               name(), index_name, strrc(rc));
-      return rc;         
-    }
+  rc = index->bulk_load(scanner, GCTX.index_fill_factor_, GCTX.index_sort_memory_);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to load records into index while creating index. table=%s, index=%s, rc=%s",
+             name(), index_name, strrc(rc));
+    return rc;
   }
   scanner.close_scan();
   LOG_INFO("inserted all records into new index. table=%s, index=%s", name(), index_name);
@@ -622,6 +868,9 @@ RC PhysicalTable::delete_record(const Record &record)
            name(), index->index_meta().name(), record.rid().to_string().c_str(), strrc(rc));
   }
   rc = record_handler_->delete_record(&record.rid());
+  if (rc == RC::SUCCESS) {
+    delete_texts(record.data(), nullptr);
+  }
   return rc;
 }
 
@@ -699,43 +948,3 @@ RC PhysicalTable::sync()
   LOG_INFO("Sync table over. table=%s", name());
   return rc;
 }
-
-RC make_text_value(RecordFileHandler *record_handler, Value &value) 
-{
-  RC rc = RC::SUCCESS;
-  RID *rid = new RID;
-  int MAX_SIZE = 8000;
-  char *ss = new char[value.text_data().length() + 1];
-  strcpy(ss, value.text_data().c_str());
-  const char *end = ss + value.text_data().length();
-
-  while (end - ss > MAX_SIZE) {
-    RID *new_rid = new RID;
-    rc = record_handler->insert_text_record(end - MAX_SIZE, MAX_SIZE, new_rid);
-
-    if (rc != RC::SUCCESS) {
-      LOG_ERROR("Insert text chunk failed: %s", strrc(rc));
-      return rc;
-    }
-
-    if (rid->init == true) {
-      new_rid->next_RID = rid;
-    }
-    rid = new_rid;
-
-    end -= MAX_SIZE;
-  }
-
-  RID *rid_last = new RID;
-  rc = record_handler->insert_text_record(ss, end - ss, rid_last);
-
-  if (rid->init == true) {
-    rid_last->next_RID = rid;
-  }
-  rid = rid_last;
-  rid->text_value = value.text_data().length();
-  value.set_data(reinterpret_cast<char *>(rid),sizeof(RID));
-
-  delete ss;
-  return rc;
-}
@@ -22,6 +22,7 @@ struct RID;
 class Record;
 class DiskBufferPool;
 class RecordFileHandler;
+class TextFileHandler;
 class RecordFileScanner;
 class ConditionFilter;
 class DefaultConditionFilter;
@@ -57,6 +58,20 @@ public:
             int attribute_count, 
             const AttrInfoSqlNode attributes[]) override;
 
+  /**
+   * 创建一个表，数据文件和索引文件的页面使用 compression 压缩
+   * @param compression   页面压缩算法的名字，为空或者 none 时不压缩，参考 PageCodec::create
+   * @param record_format 记录的存放格式，为空时使用定长格式，参考 record_format_from_name
+   */
+  RC create(int32_t table_id, 
+            const char *path, 
+            const char *name, 
+            const char *base_dir, 
+            int attribute_count, 
+            const AttrInfoSqlNode attributes[],
+            const char *compression,
+            const char *record_format);
+
   /**
    * 打开一个表
    * @param meta_file 保存表元数据的文件完整路径
@@ -85,11 +100,19 @@ public:
    * @param record[in/out] 传入的数据包含具体的数据，插入成功会通过此字段返回RID
    */
   RC insert_record(Record &record) override;
+
+  /**
+   * @brief 批量插入记录
+   * @details 记录通过 RecordFileHandler::insert_records 写入，一个页面只加一次写锁；
+   * 每个索引按照键值顺序插入这一批记录。任何一步失败时，已经插入的记录、索引项和文本都会删除
+   */
+  RC insert_records(std::span<Record> records) override;
   RC delete_record(const Record &record) override;
   RC visit_record(const RID &rid, bool readonly, std::function<void(Record &)> visitor) override;
   RC get_record(const RID &rid, Record &record) override;
   RC update_record(Record &record) override;
   RC update_record_impl(std::vector<const FieldMeta *> &field_metas, std::vector<Value> &values, Record &record) override;
+  RC read_text(const Value &value, const std::function<RC(const char *, int)> &consumer) const override;
 
   std::vector<Index *> indexes() override;
 
@@ -100,7 +123,8 @@ public:
   bool ignore_index(Index *index, const Record &record) override;
   bool update_need_unique_check(Index *index, const char *olddata, const char *newdata) override;
 
-  RC get_record_scanner(RecordFileScanner &scanner, Trx *trx, bool readonly) override;
+  RC get_record_scanner(RecordFileScanner &scanner, Trx *trx, bool readonly, PageNum start_page = 0,
+                        PageNum end_page = BP_INVALID_PAGE_NUM) override;
 
   RecordFileHandler *record_handler() const
   {
@@ -120,4 +144,16 @@ private:
   RC insert_entry_of_indexes(const Record &record, const RID &rid) ;
   RC delete_entry_of_indexes(const Record &record, const RID &rid, bool error_on_not_exists,  bool if_update);
   RC init_record_handler(const char *base_dir);
+  RC init_text_handler(const char *base_dir);
+  bool has_text_field() const;
+
+  /**
+   * @brief 释放 data 中 TEXT 字段指向的文本
+   * @param keep 不为空时，与 keep 中相同字段指向同一个文本的不释放
+   */
+  void delete_texts(const char *data, const char *keep);
+
+private:
+  DiskBufferPool  *text_buffer_pool_ = nullptr;  ///< TEXT 字段的溢出文件，没有 TEXT 字段时为空
+  TextFileHandler *text_handler_     = nullptr;
 };
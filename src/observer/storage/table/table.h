@@ -15,7 +15,9 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include <functional>
+#include <span>
 #include "storage/table/table_meta.h"
+#include "storage/buffer/page.h"
 
 struct RID;
 class Record;
@@ -61,12 +63,26 @@ public:
   virtual RC drop() = 0;
 
   virtual RC insert_record(Record &record) = 0;
+
+  /**
+   * @brief 批量插入记录
+   * @details 要么全部插入成功，要么一条都不插入。插入成功后通过每个记录返回RID
+   */
+  virtual RC insert_records(std::span<Record> records) = 0;
   virtual RC delete_record(const Record &record) = 0;
   virtual RC visit_record(const RID &rid, bool readonly, std::function<void(Record &)> visitor) = 0;
   virtual RC get_record(const RID &rid, Record &record) = 0;
   virtual RC update_record(Record &record) = 0;
   virtual RC update_record_impl(std::vector<const FieldMeta *> &field_metas, std::vector<Value> &values, Record &record) = 0;
 
+  /**
+   * @brief 读取 TEXT 字段的内容
+   * @details 记录中只保存了文本的位置，文本本身在溢出文件中，只有真正输出时才读取。
+   * 读出来的数据分段交给 consumer，参考 TextFileHandler::read_text
+   * @param value 从记录中取出的 TEXT 字段
+   */
+  virtual RC read_text(const Value &value, const std::function<RC(const char *, int)> &consumer) const = 0;
+
   virtual std::vector<Index *> indexes() = 0;
 
   virtual RC recover_insert_record(Record &record) = 0;
@@ -75,7 +91,12 @@ public:
   virtual bool ignore_index(Index *index, const Record &record) = 0;
   virtual bool update_need_unique_check(Index *index, const char *olddata, const char *newdata) = 0;
 
-  virtual RC get_record_scanner(RecordFileScanner &scanner, Trx *trx, bool readonly) = 0;
+  /**
+   * @brief 打开一个表扫描
+   * @details 可以只扫描一个范围内的页面，参考 RecordFileScanner::open_scan
+   */
+  virtual RC get_record_scanner(RecordFileScanner &scanner, Trx *trx, bool readonly, PageNum start_page = 0,
+                                PageNum end_page = BP_INVALID_PAGE_NUM) = 0;
 
   virtual RecordFileHandler *record_handler() const = 0;
   virtual Index *find_index(const char *index_name) const = 0;
@@ -19,6 +19,7 @@ See the Mulan PSL v2 for more details. */
 #include "json/json.h"
 #include "common/log/log.h"
 #include "storage/trx/trx.h"
+#include "storage/record/text_file_handler.h"
 #include "sql/parser/parse.h"
 
 using namespace std;
@@ -28,13 +29,15 @@ static const Json::StaticString FIELD_TABLE_NAME("table_name");
 static const Json::StaticString FIELD_FIELDS("fields");
 static const Json::StaticString FIELD_INDEXES("indexes");
 static const Json::StaticString FIELD_VIEW_SELECT("select");
+static const Json::StaticString FIELD_RECORD_FORMAT("record_format");
 
 TableMeta::TableMeta(const TableMeta &other)
     : table_id_(other.table_id_),
     name_(other.name_),
     fields_(other.fields_),
     indexes_(other.indexes_),
-    record_size_(other.record_size_)
+    record_size_(other.record_size_),
+    record_format_(other.record_format_)
 {}
 
 void TableMeta::swap(TableMeta &other) noexcept
@@ -43,6 +46,7 @@ void TableMeta::swap(TableMeta &other) noexcept
   fields_.swap(other.fields_);
   indexes_.swap(other.indexes_);
   std::swap(record_size_, other.record_size_);
+  std::swap(record_format_, other.record_format_);
 }
 
 RC TableMeta::init(int32_t table_id, const char *name, int field_num, const AttrInfoSqlNode attributes[], SelectSqlNode *select)
@@ -79,7 +83,7 @@ RC TableMeta::init(int32_t table_id, const char *name, int field_num, const Attr
   for (int i = 0; i < field_num; i++) {
     AttrInfoSqlNode attr_info = attributes[i];
     if (attr_info.type == TEXTS) {
-      attr_info.length = sizeof(RID);
+      attr_info.length = sizeof(TextRef);
     }
     rc = fields_[i + trx_field_num].init(attr_info.name.c_str(), 
             attr_info.type, field_offset, attr_info.length, true/*visible*/, attr_info.nullable);
@@ -236,6 +240,7 @@ int TableMeta::serialize(std::ostream &ss) const
   table_value[FIELD_TABLE_NAME] = name_;
   if (select_)
     table_value[FIELD_VIEW_SELECT] = select_->select_string;
+  table_value[FIELD_RECORD_FORMAT] = record_format_name(record_format_);
 
   Json::Value fields_value;
   for (const FieldMeta &field : fields_) {
@@ -304,6 +309,17 @@ int TableMeta::deserialize(std::istream &is)
     select_->select_string = select_sql;
   }
 
+  // 没有这个字段的是定长格式的表
+  RecordFormat record_format = RecordFormat::FIXED;
+  const Json::Value &record_format_value = table_value[FIELD_RECORD_FORMAT];
+  if (!record_format_value.empty()) {
+    if (!record_format_value.isString() ||
+        !record_format_from_name(record_format_value.asCString(), record_format)) {
+      LOG_ERROR("Invalid record format. json value=%s", record_format_value.toStyledString().c_str());
+      return -1;
+    }
+  }
+
   const Json::Value &fields_value = table_value[FIELD_FIELDS];
   if (!fields_value.isArray() || fields_value.size() <= 0) {
     LOG_ERROR("Invalid table meta. fields is not array, json value=%s", fields_value.toStyledString().c_str());
@@ -330,6 +346,7 @@ int TableMeta::deserialize(std::istream &is)
   table_id_ = table_id;
   name_.swap(table_name);
   fields_.swap(fields);
+  record_format_ = record_format;
   record_size_ = fields_.back().offset() + fields_.back().len() - fields_.begin()->offset()
     + NR_NULL_BYTE(field_num);
 
@@ -20,6 +20,7 @@ See the Mulan PSL v2 for more details. */
 #include "common/rc.h"
 #include "storage/field/field_meta.h"
 #include "storage/index/index_meta.h"
+#include "storage/record/record_format.h"
 #include "common/lang/serializable.h"
 
 /**
@@ -40,6 +41,11 @@ public:
 
   RC add_index(const IndexMeta &index);
 
+  /**
+   * @brief 表的记录在数据文件中的存放格式，创建表时设置
+   */
+  void set_record_format(RecordFormat format) { record_format_ = format; }
+
 public:
   int32_t table_id() const { return table_id_; }
   const char *name() const;
@@ -62,6 +68,7 @@ public:
   const IndexMeta *index(int i) const;
   int index_num() const;
   int record_size() const;
+  RecordFormat record_format() const { return record_format_; }
   SelectSqlNode *select(bool rebuild) ;
 
 public:
@@ -79,4 +86,5 @@ protected:
   std::vector<IndexMeta> indexes_;
 
   int record_size_ = 0;
+  RecordFormat record_format_ = RecordFormat::FIXED;
 };
@@ -158,6 +158,10 @@ RC View::insert_record(Record &record) {
 	return RC::SUCCESS;
 }
 
+RC View::insert_records(std::span<Record> records) {
+	return RC::SUCCESS;
+}
+
 RC View::delete_record(const Record &record) {
 	return RC::SUCCESS;
 }
@@ -170,6 +174,11 @@ RC View::get_record(const RID &rid, Record &record) {
 	return RC::SUCCESS;
 }
 
+RC View::read_text(const Value &value, const std::function<RC(const char *, int)> &consumer) const {
+	// 视图没有自己的文本文件，经过视图的 TEXT 字段已经由底层表读出了内容
+	return consumer(value.data(), value.length());
+}
+
 RC View::update_record(Record &record) {
 	return RC::SUCCESS;
 
@@ -199,7 +208,7 @@ bool View::update_need_unique_check(Index *index, const char *olddata, const cha
 	return false;
 }
 
-RC View::get_record_scanner(RecordFileScanner &scanner, Trx *trx, bool readonly) {
+RC View::get_record_scanner(RecordFileScanner &scanner, Trx *trx, bool readonly, PageNum start_page, PageNum end_page) {
 	return RC::SUCCESS;
 }
 
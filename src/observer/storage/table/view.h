@@ -53,11 +53,13 @@ public:
   RC drop() override;
 
   RC insert_record(Record &record) override;
+  RC insert_records(std::span<Record> records) override;
   RC delete_record(const Record &record) override;
   RC visit_record(const RID &rid, bool readonly, std::function<void(Record &)> visitor) override;
   RC get_record(const RID &rid, Record &record) override;
   RC update_record(Record &record) override;
   RC update_record_impl(std::vector<const FieldMeta *> &field_metas, std::vector<Value> &values, Record &record) override;
+  RC read_text(const Value &value, const std::function<RC(const char *, int)> &consumer) const override;
 
   std::vector<Index *> indexes() override;
 
@@ -67,7 +69,8 @@ public:
   bool ignore_index(Index *index, const Record &record) override;
   bool update_need_unique_check(Index *index, const char *olddata, const char *newdata) override;
 
-  RC get_record_scanner(RecordFileScanner &scanner, Trx *trx, bool readonly) override;
+  RC get_record_scanner(RecordFileScanner &scanner, Trx *trx, bool readonly, PageNum start_page = 0,
+                        PageNum end_page = BP_INVALID_PAGE_NUM) override;
 
   RecordFileHandler *record_handler() const override;
   Index *find_index(const char *index_name) const override;
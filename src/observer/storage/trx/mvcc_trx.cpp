@@ -12,6 +12,7 @@ See the Mulan PSL v2 for more details. */
 // Created by Wangyunlai on 2023/04/24.
 //
 
+#include <algorithm>
 #include <limits>
 #include "storage/trx/mvcc_trx.h"
 #include "storage/field/field.h"
@@ -160,6 +161,59 @@ RC MvccTrx::insert_record(Table *table, Record &record)
   return rc;
 }
 
+RC MvccTrx::insert_records(Table *table, span<Record> records)
+{
+  if (records.empty()) {
+    return RC::SUCCESS;
+  }
+
+  Field begin_field;
+  Field end_field;
+  trx_fields(table, begin_field, end_field);
+
+  for (Record &record : records) {
+    begin_field.set_int(record, -trx_id_);
+    end_field.set_int(record, trx_kit_.max_trx_id());
+  }
+
+  RC rc = table->insert_records(records);
+  if (rc != RC::SUCCESS) {
+    LOG_WARN("failed to insert records into table. count=%d, rc=%s", static_cast<int>(records.size()), strrc(rc));
+    return rc;
+  }
+
+  // 日志数据中每条记录是 RID 加上完整的记录内容。记录很多时切分成几条日志，每条日志不超过 MAX_INSERT_BATCH_LOG_SIZE
+  const int    record_size   = table->table_meta().record_size();
+  const int    entry_size    = static_cast<int>(sizeof(RID)) + record_size;
+  const size_t entries_per_log = static_cast<size_t>(std::max(MAX_INSERT_BATCH_LOG_SIZE / entry_size, 1));
+  vector<char> log_data;
+  for (size_t start = 0; start < records.size(); start += entries_per_log) {
+    span<const Record> batch = span<const Record>(records).subspan(start, std::min(entries_per_log, records.size() - start));
+    log_data.resize(static_cast<size_t>(entry_size) * batch.size());
+    char *entry = log_data.data();
+    for (const Record &record : batch) {
+      memcpy(entry, &record.rid(), sizeof(RID));
+      memcpy(entry + sizeof(RID), record.data(), record_size);
+      entry += entry_size;
+    }
+
+    rc = log_manager_->append_log(CLogType::INSERT_BATCH, trx_id_, table->table_id(), batch.front().rid(),
+                                  static_cast<int32_t>(log_data.size()), 0 /*offset*/, log_data.data());
+    ASSERT(rc == RC::SUCCESS, "failed to append insert batch log. trx id=%d, table id=%d, count=%d, rc=%s",
+        trx_id_, table->table_id(), static_cast<int>(batch.size()), strrc(rc));
+  }
+
+  for (const Record &record : records) {
+    pair<OperationSet::iterator, bool> ret = 
+          operations_.insert(Operation(Operation::Type::INSERT, table, record.rid()));
+    if (!ret.second) {
+      rc = RC::INTERNAL;
+      LOG_WARN("failed to insert operation(insertion) into operation set: duplicate");
+    }
+  }
+  return rc;
+}
+
 /*
 operation	trx state	  begin_xid	     end_xid
 inserted	committed	   Tc	             +∞
@@ -456,6 +510,7 @@ RC find_table(Db *db, const CLogRecord &log_record, Table *&table)
 {
   switch (clog_type_from_integer(log_record.header().type_)) {
     case CLogType::INSERT:
+    case CLogType::INSERT_BATCH:
     case CLogType::DELETE: {
       const CLogRecordData &data_record = log_record.data_record();
       table = db->find_table(data_record.table_id_);
@@ -497,6 +552,30 @@ RC MvccTrx::redo(Db *db, const CLogRecord &log_record)
       operations_.insert(Operation(Operation::Type::INSERT, table, record.rid()));
     } break;
 
+    case CLogType::INSERT_BATCH: {
+      const CLogRecordData &data_record = log_record.data_record();
+      const int entry_size = static_cast<int>(sizeof(RID)) + table->table_meta().record_size();
+      if (data_record.data_len_ % entry_size != 0) {
+        LOG_WARN("invalid insert batch log. table=%s, log record=%s", table->name(), log_record.to_string().c_str());
+        return RC::INTERNAL;
+      }
+
+      for (int offset = 0; offset < data_record.data_len_; offset += entry_size) {
+        RID rid;
+        memcpy(&rid, data_record.data_ + offset, sizeof(RID));
+        Record record;
+        record.set_data(data_record.data_ + offset + sizeof(RID), entry_size - static_cast<int>(sizeof(RID)));
+        record.set_rid(rid);
+        RC rc = table->recover_insert_record(record);
+        if (OB_FAIL(rc)) {
+          LOG_WARN("failed to recover insert. table=%s, rid=%s, rc=%s",
+                   table->name(), rid.to_string().c_str(), strrc(rc));
+          return rc;
+        }
+        operations_.insert(Operation(Operation::Type::INSERT, table, rid));
+      }
+    } break;
+
     case CLogType::DELETE: {
       const CLogRecordData &data_record = log_record.data_record();
       Field begin_field;
@@ -61,12 +61,21 @@ private:
  */
 class MvccTrx : public Trx
 {
+public:
+  /// 一条 INSERT_BATCH 日志的数据最多多少字节，远小于日志缓冲区的大小
+  static constexpr int MAX_INSERT_BATCH_LOG_SIZE = 64 * 1024;
+
 public:
   MvccTrx(MvccTrxKit &trx_kit, CLogManager *log_manager);
   MvccTrx(MvccTrxKit &trx_kit, int32_t trx_id); // used for recover
   virtual ~MvccTrx();
 
   RC insert_record(Table *table, Record &record) override;
+
+  /**
+   * @brief 批量插入记录，整批记录按大小切分成几条 INSERT_BATCH 日志，参考 MAX_INSERT_BATCH_LOG_SIZE
+   */
+  RC insert_records(Table *table, std::span<Record> records) override;
   RC delete_record(Table *table, Record &record) override;
   RC update_record(Table *table, Record &record) override;
 
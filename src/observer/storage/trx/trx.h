@@ -17,6 +17,7 @@ See the Mulan PSL v2 for more details. */
 #include <stddef.h>
 #include <unordered_set>
 #include <mutex>
+#include <span>
 #include <utility>
 
 #include "sql/parser/parse.h"
@@ -145,6 +146,11 @@ public:
   virtual ~Trx() = default;
 
   virtual RC insert_record(Table *table, Record &record) = 0;
+
+  /**
+   * @brief 在同一张表上批量插入记录，参考 Table::insert_records
+   */
+  virtual RC insert_records(Table *table, std::span<Record> records) = 0;
   virtual RC delete_record(Table *table, Record &record) = 0;
   virtual RC update_record(Table *table, Record &record) = 0;
   virtual RC visit_record(Table *table, Record &record, bool readonly) = 0;
@@ -65,6 +65,19 @@ TEST(test_bitmap, test_bitmap)
   buf3[1] = 0;
   ASSERT_EQ(8, bitmap3.next_unsetted_bit(0));
   ASSERT_EQ(16, bitmap3.next_setted_bit(8));
+
+  // 起始字节全部跳过时，下一个字节要从第0位开始找
+  buf3[0] = -1;
+  buf3[1] = -1;
+  buf3[2] = 0;
+  ASSERT_EQ(16, bitmap3.next_unsetted_bit(1));
+  ASSERT_EQ(16, bitmap3.next_unsetted_bit(5));
+
+  buf3[0] = 0;
+  buf3[1] = 0;
+  buf3[2] = 1;
+  ASSERT_EQ(16, bitmap3.next_setted_bit(1));
+  ASSERT_EQ(16, bitmap3.next_setted_bit(5));
 }
 
 int main(int argc, char **argv)
@@ -13,8 +13,17 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/buffer_ring.h"
 #include "gtest/gtest.h"
 
+#include <string.h>
+#include <unistd.h>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <thread>
+#include <vector>
+
 void test_get(BPFrameManager &frame_manager)
 {
   const int file_desc = 0;
@@ -125,6 +134,959 @@ TEST(test_frame_manager, test_frame_manager_simple_lru)
   frame_manager.cleanup();
 }
 
+TEST(test_frame_manager, test_frame_manager_sharded)
+{
+  BPFrameManager frame_manager("Test");
+  frame_manager.init(2, 4);
+  ASSERT_EQ(4, frame_manager.shard_num());
+
+  test_get(frame_manager);
+
+  test_alloc(frame_manager);
+
+  frame_manager.cleanup();
+}
+
+TEST(test_frame_manager, test_frame_manager_replacers)
+{
+  const char *replacers[] = {"lru", "clock", "lru-k", "2q"};
+  for (const char *replacer : replacers) {
+    BPFrameManager frame_manager("Test");
+    ASSERT_EQ(RC::SUCCESS, frame_manager.init(2, 4, replacer));
+
+    test_get(frame_manager);
+
+    test_alloc(frame_manager);
+
+    frame_manager.cleanup();
+  }
+
+  BPFrameManager frame_manager("Test");
+  ASSERT_NE(RC::SUCCESS, frame_manager.init(2, 4, "not-exist"));
+}
+
+TEST(test_frame_manager, test_frame_manager_purge_across_shards)
+{
+  BPFrameManager frame_manager("Test");
+  frame_manager.init(1, 4);
+
+  const int file_desc = 0;
+  const int frame_count = static_cast<int>(frame_manager.total_frame_num());
+  for (int i = 0; i < frame_count; i++) {
+    Frame *frame = frame_manager.alloc(file_desc, i);
+    ASSERT_NE(frame, nullptr);
+    frame->set_file_desc(file_desc);
+    frame->unpin();
+  }
+  ASSERT_EQ(nullptr, frame_manager.alloc(file_desc, frame_count));
+
+  int purged = 0;
+  auto purger = [&purged](Frame *frame) {
+    purged++;
+    return RC::SUCCESS;
+  };
+  ASSERT_EQ(10, frame_manager.purge_frames(10, purger));
+  ASSERT_EQ(10, purged);
+  ASSERT_EQ(frame_count - 10, static_cast<int>(frame_manager.frame_num()));
+
+  // pinned frames are never purged
+  std::list<Frame *> frames = frame_manager.find_list(file_desc);
+  ASSERT_EQ(frame_count - 10, static_cast<int>(frames.size()));
+  ASSERT_EQ(0, frame_manager.purge_frames(1, purger));
+  for (Frame *frame : frames) {
+    frame->unpin();
+  }
+  ASSERT_EQ(frame_count - 10, frame_manager.purge_frames(frame_count, purger));
+  ASSERT_EQ(0, static_cast<int>(frame_manager.frame_num()));
+
+  frame_manager.cleanup();
+}
+
+TEST(test_frame_manager, test_frame_manager_concurrency)
+{
+  BPFrameManager frame_manager("Test");
+  frame_manager.init(2);
+
+  const int thread_num = 4;
+  const int page_num_per_thread = 32;
+  auto worker = [&frame_manager](int file_desc) {
+    for (int round = 0; round < 100; round++) {
+      for (PageNum page_num = 0; page_num < page_num_per_thread; page_num++) {
+        Frame *frame = frame_manager.alloc(file_desc, page_num);
+        ASSERT_NE(frame, nullptr);
+        frame->set_file_desc(file_desc);
+        frame->unpin();
+      }
+
+      for (PageNum page_num = 0; page_num < page_num_per_thread; page_num++) {
+        Frame *frame = frame_manager.get(file_desc, page_num);
+        ASSERT_NE(frame, nullptr);
+        ASSERT_EQ(frame->page_num(), page_num);
+        ASSERT_EQ(RC::SUCCESS, frame_manager.free(file_desc, page_num, frame));
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; i++) {
+    threads.emplace_back(worker, i);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(0, static_cast<int>(frame_manager.frame_num()));
+  frame_manager.cleanup();
+}
+
+TEST(test_frame_manager, test_frame_manager_purge_clean)
+{
+  BPFrameManager frame_manager("Test");
+  frame_manager.init(1, 4);
+
+  const int file_desc = 0;
+  const int frame_num = static_cast<int>(frame_manager.total_frame_num());
+  for (PageNum page_num = 0; page_num < frame_num; page_num++) {
+    Frame *frame = frame_manager.alloc(file_desc, page_num);
+    ASSERT_NE(frame, nullptr);
+    frame->set_file_desc(file_desc);
+    if (page_num % 2 == 0) {
+      frame->mark_dirty();
+    }
+    frame->unpin();
+  }
+  ASSERT_EQ(0, frame_manager.free_frame_num());
+
+  std::vector<FrameId> dirty_frames;
+  frame_manager.find_dirty_victims(frame_num, dirty_frames);
+  ASSERT_EQ(frame_num / 2, static_cast<int>(dirty_frames.size()));
+
+  // 脏页不会被淘汰
+  ASSERT_EQ(frame_num / 2, frame_manager.purge_clean_frames(frame_num));
+  ASSERT_EQ(frame_num / 2, frame_manager.free_frame_num());
+  for (const FrameId &frame_id : dirty_frames) {
+    Frame *frame = frame_manager.get(frame_id.file_desc(), frame_id.page_num(), false /*touch*/);
+    ASSERT_NE(frame, nullptr);
+    ASSERT_TRUE(frame->dirty());
+    frame->clear_dirty();
+    ASSERT_EQ(RC::SUCCESS, frame_manager.free(frame_id.file_desc(), frame_id.page_num(), frame));
+  }
+
+  ASSERT_EQ(0, static_cast<int>(frame_manager.frame_num()));
+  frame_manager.cleanup();
+}
+
+TEST(test_frame_manager, test_frame_version)
+{
+  Frame frame;
+  frame.pin();
+
+  uint64_t version = 0;
+  ASSERT_TRUE(frame.read_version(version));
+  ASSERT_TRUE(frame.validate_version(version));
+
+  // 读锁不改变版本号
+  frame.read_latch();
+  frame.read_unlatch();
+  ASSERT_TRUE(frame.validate_version(version));
+
+  // 加着写锁时不能乐观读，释放之后之前的版本号失效
+  frame.write_latch();
+  uint64_t locked_version = 0;
+  ASSERT_FALSE(frame.read_version(locked_version));
+  frame.write_latch();
+  frame.write_unlatch();
+  ASSERT_FALSE(frame.read_version(locked_version));
+  frame.write_unlatch();
+
+  uint64_t new_version = 0;
+  ASSERT_TRUE(frame.read_version(new_version));
+  ASSERT_NE(version, new_version);
+  ASSERT_FALSE(frame.validate_version(version));
+  frame.unpin();
+}
+
+TEST(test_buffer_pool, test_page_cleaner)
+{
+  const char *file_name = "page_cleaner_test.bp";
+  ::remove(file_name);
+
+  BufferPoolParam param;
+  param.memory_size            = DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
+  param.cleaner_low_watermark  = 10;
+  param.cleaner_high_watermark = 20;
+  param.cleaner_interval_ms    = 10;
+  BufferPoolManager bpm(param);
+#ifdef CONCURRENCY
+  ASSERT_TRUE(bpm.page_cleaner().running());
+#endif
+
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+
+  std::vector<PageNum> page_nums;
+  auto write_pages = [bp, &page_nums](int count) {
+    for (int i = 0; i < count; i++) {
+      Frame *frame = nullptr;
+      ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+      frame->write_latch();
+      memset(frame->data(), page_nums.size() % 128, BP_PAGE_DATA_SIZE);
+      frame->mark_dirty();
+      frame->write_unlatch();
+      page_nums.push_back(frame->page_num());
+      bp->unpin_page(frame);
+    }
+  };
+
+  // 写入的页面比页帧多，后台线程和前台线程都会刷脏页
+  write_pages(DEFAULT_ITEM_NUM_PER_POOL * 3);
+
+  bpm.page_cleaner().stop();
+  ASSERT_FALSE(bpm.page_cleaner().running());
+
+  // 后台线程停止后把空闲页帧都用完，再手动触发一轮清理
+  write_pages(DEFAULT_ITEM_NUM_PER_POOL);
+  ASSERT_GT(bpm.page_cleaner().clean_once(), 0);
+
+  const int page_num = static_cast<int>(page_nums.size());
+  for (int i = 0; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(page_nums[i], &frame));
+    ASSERT_EQ(i % 128, frame->data()[0]);
+    ASSERT_EQ(i % 128, frame->data()[BP_PAGE_DATA_SIZE - 1]);
+    bp->unpin_page(frame);
+  }
+
+  ASSERT_EQ(RC::SUCCESS, bp->close_file());
+  ::remove(file_name);
+}
+
+TEST(test_buffer_pool, test_allocation_groups)
+{
+  const char *file_name = "allocation_groups_test.bp";
+  ::remove(file_name);
+
+  BufferPoolManager bpm;
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+
+  // 第一个分配的页面总是1号页面，B+树依赖这一点
+  Frame *frame = nullptr;
+  for (PageNum page_num = 1; page_num <= 10; page_num++) {
+    ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+    ASSERT_EQ(page_num, frame->page_num());
+    bp->unpin_page(frame);
+  }
+
+  // 释放还有其它使用者pin住的页面时，页帧不会马上释放，最后一次unpin之后页面才变成未分配状态
+  ASSERT_EQ(RC::SUCCESS, bp->get_this_page(5, &frame));
+  ASSERT_EQ(RC::SUCCESS, bp->dispose_page(5));
+  ASSERT_EQ(11, bp->allocated_pages());
+  ASSERT_EQ(5, frame->page_num());
+  ASSERT_EQ(1, frame->pin_count());
+  bp->unpin_page(frame);
+  ASSERT_EQ(10, bp->allocated_pages());
+
+  // 释放的页面会被优先重新分配
+  ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+  ASSERT_EQ(5, frame->page_num());
+  bp->unpin_page(frame);
+
+  // 恢复一个第1组中的页面，文件会扩展并创建第1组的第一个页面
+  const PageNum group1_start = DiskBufferPool::group_start(1);
+  ASSERT_EQ(BPFileHeader::GROUP_PAGE_NUM, group1_start);
+  ASSERT_EQ(1, DiskBufferPool::group_of(group1_start));
+  ASSERT_EQ(2, DiskBufferPool::group_of(group1_start + BPGroupHeader::GROUP_PAGE_NUM));
+
+  const PageNum recovered_page = group1_start + 3;
+  ASSERT_EQ(RC::SUCCESS, bp->recover_page(recovered_page));
+  ASSERT_EQ(recovered_page + 1, bp->page_count());
+  ASSERT_EQ(13, bp->allocated_pages());
+
+  // 遍历时跳过每个组的第一个页面
+  auto allocated_pages = [&bp]() {
+    std::vector<PageNum> page_nums;
+    BufferPoolIterator iterator;
+    iterator.init(*bp);
+    while (iterator.has_next()) {
+      page_nums.push_back(iterator.next());
+    }
+    return page_nums;
+  };
+  std::vector<PageNum> page_nums = allocated_pages();
+  ASSERT_EQ(11, static_cast<int>(page_nums.size()));
+  ASSERT_EQ(10, page_nums[9]);
+  ASSERT_EQ(recovered_page, page_nums[10]);
+
+  // 第0组中还有空闲页面，先从第0组分配
+  ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+  ASSERT_EQ(11, frame->page_num());
+  bp->unpin_page(frame);
+
+  // 重新打开文件后，分配信息不变
+  ASSERT_EQ(RC::SUCCESS, bp->close_file());
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+  ASSERT_EQ(recovered_page + 1, bp->page_count());
+  ASSERT_EQ(14, bp->allocated_pages());
+  page_nums = allocated_pages();
+  ASSERT_EQ(12, static_cast<int>(page_nums.size()));
+  ASSERT_EQ(recovered_page, page_nums.back());
+
+  // 第1组的第一个页面不能释放
+  ASSERT_NE(RC::SUCCESS, bp->dispose_page(group1_start));
+
+  // 迭代器缓存了分配组的位图，遍历完之后文件末尾扩展的页面也能遍历到
+  BufferPoolIterator iterator;
+  ASSERT_EQ(RC::SUCCESS, iterator.init(*bp, group1_start));
+  ASSERT_TRUE(iterator.has_next());
+  ASSERT_EQ(recovered_page, iterator.next());
+  ASSERT_FALSE(iterator.has_next());
+  ASSERT_EQ(RC::SUCCESS, bp->recover_page(recovered_page + 2));
+  ASSERT_TRUE(iterator.has_next());
+  ASSERT_EQ(recovered_page + 2, iterator.next());
+  ASSERT_FALSE(iterator.has_next());
+
+  ASSERT_EQ(RC::SUCCESS, bp->close_file());
+  ::remove(file_name);
+}
+
+TEST(test_buffer_pool, test_concurrent_get_page)
+{
+  const char *file_name = "concurrent_get_page_test.bp";
+  ::remove(file_name);
+
+  BufferPoolManager bpm(DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE);
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+
+  const int page_num = DEFAULT_ITEM_NUM_PER_POOL * 4;
+  for (int i = 0; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+    *(PageNum *)frame->data() = frame->page_num();
+    frame->mark_dirty();
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bp->flush_all_pages());
+
+  // 页帧比页面少，多个线程同时读取相同和不同的页面，都会发生页面加载
+  const int thread_num = 8;
+  std::atomic<int> mismatch_count{0};
+  auto worker = [bp, &mismatch_count](int index) {
+    for (int round = 0; round < 10; round++) {
+      for (PageNum page_num = 1; page_num <= DEFAULT_ITEM_NUM_PER_POOL * 4; page_num++) {
+        PageNum target = (page_num * (index % 2 == 0 ? 1 : 7)) % (DEFAULT_ITEM_NUM_PER_POOL * 4) + 1;
+        Frame *frame = nullptr;
+        ASSERT_EQ(RC::SUCCESS, bp->get_this_page(target, &frame));
+        if (*(PageNum *)frame->data() != target || frame->page_num() != target) {
+          mismatch_count++;
+        }
+        bp->unpin_page(frame);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; i++) {
+    threads.emplace_back(worker, i);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(0, mismatch_count.load());
+
+  // 读取文件中不存在的页面会失败，页帧也会被释放
+  Frame *frame = nullptr;
+  ASSERT_NE(RC::SUCCESS, bp->get_this_page(page_num * 2, &frame));
+  ASSERT_EQ(RC::SUCCESS, bp->check_all_pages_unpinned());
+
+  ASSERT_EQ(RC::SUCCESS, bp->close_file());
+  ::remove(file_name);
+}
+
+TEST(test_buffer_pool, test_read_ahead)
+{
+  const char *file_name = "read_ahead_test.bp";
+  ::remove(file_name);
+
+  BufferPoolParam param;
+  param.memory_size      = DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
+  param.read_ahead_pages = 16;
+  BufferPoolManager bpm(param);
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+  ASSERT_EQ(16, bp->read_ahead_pages());
+
+  const int page_num = DEFAULT_ITEM_NUM_PER_POOL * 2;
+  for (int i = 0; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+    *(PageNum *)frame->data() = frame->page_num();
+    frame->mark_dirty();
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bp->flush_all_pages());
+
+  // 预读的页面不会被pin住，之后可以正常访问
+  ASSERT_EQ(RC::SUCCESS, bp->prefetch_pages({1, 2, 3}));
+  ASSERT_EQ(RC::SUCCESS, bp->prefetch_pages({1}));
+  ASSERT_NE(RC::SUCCESS, bp->prefetch_pages({page_num * 2}));
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bp->get_this_page(1, &frame));
+  ASSERT_EQ(1, *(PageNum *)frame->data());
+  bp->unpin_page(frame);
+  ASSERT_EQ(RC::SUCCESS, bp->check_all_pages_unpinned());
+
+  // 顺序遍历，后台会预读后面的页面
+  BufferPoolIterator iterator;
+  ASSERT_EQ(RC::SUCCESS, iterator.init(*bp));
+  int count = 0;
+  while (iterator.has_next()) {
+    const PageNum current = iterator.next();
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(current, &frame));
+    ASSERT_EQ(current, *(PageNum *)frame->data());
+    bp->unpin_page(frame);
+    count++;
+  }
+  ASSERT_EQ(page_num, count);
+
+#ifdef CONCURRENCY
+  ASSERT_TRUE(bpm.read_ahead_worker().running());
+  bpm.read_ahead_worker().wait_idle();
+#endif
+  ASSERT_EQ(RC::SUCCESS, bp->check_all_pages_unpinned());
+
+  ASSERT_EQ(RC::SUCCESS, bp->close_file());
+  ::remove(file_name);
+}
+
+TEST(test_frame_manager, test_frame_allocator)
+{
+  FrameAllocator::HugePage huge_page;
+  ASSERT_TRUE(FrameAllocator::huge_page_from_name("Transparent", huge_page));
+  ASSERT_EQ(FrameAllocator::HugePage::TRANSPARENT, huge_page);
+  ASSERT_FALSE(FrameAllocator::huge_page_from_name("unknown", huge_page));
+
+  // 系统没有预留大页时会退化成普通内存页，不管哪种模式，页面都要按页对齐
+  for (FrameAllocator::HugePage mode :
+       {FrameAllocator::HugePage::NONE, FrameAllocator::HugePage::TRANSPARENT, FrameAllocator::HugePage::EXPLICIT}) {
+    BPFrameManager frame_manager("Test");
+    ASSERT_EQ(RC::SUCCESS, frame_manager.init(1, 4, FrameReplacer::DEFAULT_NAME, mode));
+    const FrameAllocator &allocator = frame_manager.allocator();
+    ASSERT_EQ(DEFAULT_ITEM_NUM_PER_POOL, allocator.get_size());
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(allocator.arena()) % getpagesize());
+
+    std::vector<Frame *> frames;
+    for (int i = 0; i < DEFAULT_ITEM_NUM_PER_POOL; i++) {
+      Frame *frame = frame_manager.alloc(0, i);
+      ASSERT_NE(frame, nullptr);
+      ASSERT_EQ(0, reinterpret_cast<uintptr_t>(&frame->page()) % getpagesize());
+      frames.push_back(frame);
+    }
+    ASSERT_EQ(nullptr, frame_manager.alloc(0, DEFAULT_ITEM_NUM_PER_POOL));
+
+    for (Frame *frame : frames) {
+      frame->unpin();
+      ASSERT_EQ(RC::SUCCESS, frame_manager.free(0, frame->page_num(), frame));
+    }
+    ASSERT_EQ(DEFAULT_ITEM_NUM_PER_POOL, frame_manager.free_frame_num());
+    frame_manager.cleanup();
+  }
+}
+
+TEST(test_buffer_pool, test_direct_io)
+{
+  const char *file_name = "direct_io_test.bp";
+  ::remove(file_name);
+
+  BufferPoolParam param;
+  param.memory_size = DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
+  param.direct_io   = true;
+  param.huge_page   = "transparent";
+  BufferPoolManager bpm(param);
+  ASSERT_TRUE(bpm.direct_io());
+
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+
+  // 页面比页帧多，写入的页面会被淘汰到磁盘上，再读回来
+  std::vector<PageNum> pages;
+  for (int i = 0; i < DEFAULT_ITEM_NUM_PER_POOL * 3; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+    memset(frame->data(), frame->page_num() % 128, BP_PAGE_DATA_SIZE);
+    frame->mark_dirty();
+    pages.push_back(frame->page_num());
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bp->flush_all_pages());
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+  for (PageNum page : pages) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(page, &frame));
+    ASSERT_EQ(page, frame->page_num());
+    ASSERT_EQ(page % 128, frame->data()[0]);
+    ASSERT_EQ(page % 128, frame->data()[BP_PAGE_DATA_SIZE - 1]);
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+  ::remove(file_name);
+}
+
+/**
+ * @brief 读取 dump 文件中记录的页面，测试只会打开一个文件
+ */
+std::vector<PageNum> read_dump_pages(const char *dump_file)
+{
+  std::ifstream ifs(dump_file);
+  std::string tag, file_name;
+  int file_num = 0, page_num = 0;
+  ifs >> tag >> file_num;
+  ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  for (int i = 0; i < file_num; i++) {
+    std::getline(ifs, file_name);
+  }
+  ifs >> tag >> page_num;
+
+  std::vector<PageNum> pages;
+  int file_index = 0;
+  PageNum page = 0;
+  while (ifs >> file_index >> page) {
+    pages.push_back(page);
+  }
+  return pages;
+}
+
+TEST(test_buffer_pool, test_dump_and_load_pages)
+{
+  // 文件名中有空格，dump 文件中按行记录文件名
+  const char *file_name = "dump pages test.bp";
+  const char *dump_file = "dump_pages_test.dump";
+  ::remove(file_name);
+  ::remove(dump_file);
+
+  BufferPoolParam param;
+  param.memory_size      = DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
+  param.read_ahead_pages = 0;
+  param.dump_file        = dump_file;
+  BufferPoolManager bpm(param);
+  ASSERT_EQ(RC::FILE_NOT_EXIST, bpm.load_pages());
+
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+
+  std::vector<PageNum> pages;
+  for (int i = 0; i < DEFAULT_ITEM_NUM_PER_POOL / 2; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+    *(PageNum *)frame->data() = frame->page_num();
+    frame->mark_dirty();
+    pages.push_back(frame->page_num());
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bp->flush_all_pages());
+
+  // 最后访问的页面记录在最前面
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bp->get_this_page(pages[3], &frame));
+  bp->unpin_page(frame);
+  ASSERT_EQ(RC::SUCCESS, bpm.dump_pages());
+  std::vector<PageNum> dumped = read_dump_pages(dump_file);
+  ASSERT_FALSE(dumped.empty());
+  ASSERT_EQ(pages[3], dumped.front());
+  std::set<PageNum> dumped_set(dumped.begin(), dumped.end());
+  for (PageNum page : pages) {
+    ASSERT_EQ(1, dumped_set.count(page));
+  }
+
+  // 关闭文件时会清理所有页面，重新打开后加载回来
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+  ASSERT_EQ(RC::SUCCESS, bpm.load_pages());
+  bpm.wait_load_done();
+  ASSERT_EQ(RC::SUCCESS, bp->check_all_pages_unpinned());
+
+  const std::string reload_dump_file = std::string(dump_file) + ".reload";
+  ASSERT_EQ(RC::SUCCESS, bpm.dump_pages(reload_dump_file.c_str()));
+  std::vector<PageNum> reloaded = read_dump_pages(reload_dump_file.c_str());
+  ASSERT_EQ(dumped_set, std::set<PageNum>(reloaded.begin(), reloaded.end()));
+
+  for (PageNum page : pages) {
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(page, &frame));
+    ASSERT_EQ(page, *(PageNum *)frame->data());
+    bp->unpin_page(frame);
+  }
+
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+  ::remove(file_name);
+  ::remove(dump_file);
+  ::remove(reload_dump_file.c_str());
+}
+
+TEST(test_buffer_pool, test_buffer_ring)
+{
+  const char *file_name = "buffer_ring_test.bp";
+  const char *dump_file = "buffer_ring_test.dump";
+  ::remove(file_name);
+
+  BufferPoolParam param;
+  param.memory_size      = DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
+  param.read_ahead_pages = 0;
+  BufferPoolManager bpm(param);
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+
+  // 小文件不使用页帧环
+  BufferRing ring;
+  ASSERT_FALSE(ring.init(*bp));
+
+  std::vector<PageNum> pages;
+  for (int i = 0; i < DEFAULT_ITEM_NUM_PER_POOL * 3; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+    *(PageNum *)frame->data() = frame->page_num();
+    frame->mark_dirty();
+    pages.push_back(frame->page_num());
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+
+  // 先访问一些热点页面，再用页帧环扫描整个文件
+  const int hot_page_num = DEFAULT_ITEM_NUM_PER_POOL / 4;
+  std::set<PageNum> hot_pages;
+  for (int i = 0; i < hot_page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(pages[i * 3], &frame));
+    hot_pages.insert(pages[i * 3]);
+    bp->unpin_page(frame);
+  }
+
+  ASSERT_TRUE(ring.init(*bp));
+  for (PageNum page : pages) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, ring.get_this_page(page, &frame));
+    ASSERT_EQ(page, *(PageNum *)frame->data());
+    bp->unpin_page(frame);
+  }
+  ring.reset();
+
+  // 热点页面都还在，扫描留下来的页面不超过环的大小
+  ASSERT_EQ(RC::SUCCESS, bpm.dump_pages(dump_file));
+  std::vector<PageNum> resident = read_dump_pages(dump_file);
+  std::set<PageNum> resident_set(resident.begin(), resident.end());
+  int scanned_num = 0;
+  for (PageNum page : pages) {
+    if (hot_pages.count(page) > 0) {
+      ASSERT_EQ(1, resident_set.count(page));
+    } else if (resident_set.count(page) > 0) {
+      scanned_num++;
+    }
+  }
+  ASSERT_LE(scanned_num, BufferRing::DEFAULT_RING_SIZE);
+
+  ASSERT_EQ(RC::SUCCESS, bp->check_all_pages_unpinned());
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+  ::remove(file_name);
+  ::remove(dump_file);
+}
+
+TEST(test_buffer_pool, test_coalesced_flush)
+{
+  const char *file_name = "coalesced_flush_test.bp";
+  ::remove(file_name);
+
+  BufferPoolParam param;
+  param.memory_size      = DEFAULT_ITEM_NUM_PER_POOL * 4 * BP_PAGE_SIZE;
+  param.read_ahead_pages = 0;
+  BufferPoolManager bpm(param);
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+
+  std::vector<PageNum> pages;
+  for (int i = 0; i < DiskBufferPool::MAX_WRITE_BATCH_PAGES * 3; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+    pages.push_back(frame->page_num());
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bp->flush_all_pages());
+
+  // 跳过一些页面，脏页中既有很长的连续段，也有单独的页面
+  std::vector<PageNum> dirty_pages;
+  for (size_t i = 0; i < pages.size(); i++) {
+    if (i % 50 == 7) {
+      continue;
+    }
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(pages[i], &frame));
+    *(PageNum *)frame->data() = pages[i] + 1;
+    frame->mark_dirty();
+    dirty_pages.push_back(pages[i]);
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bp->flush_all_pages());
+
+  int fd = open(file_name, O_RDONLY);
+  ASSERT_GE(fd, 0);
+  Page page;
+  for (PageNum page_num : dirty_pages) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(page_num, &frame));
+    ASSERT_FALSE(frame->dirty());
+    bp->unpin_page(frame);
+
+    ASSERT_EQ(BP_PAGE_SIZE, pread(fd, &page, BP_PAGE_SIZE, (off_t)page_num * BP_PAGE_SIZE));
+    ASSERT_EQ(page_num, page.page_num);
+    ASSERT_EQ(page_num + 1, *(PageNum *)page.data);
+  }
+  close(fd);
+
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+  ::remove(file_name);
+}
+
+TEST(test_buffer_pool, test_page_codec)
+{
+  std::unique_ptr<PageCodec> codec = PageCodec::create("LZ");
+  ASSERT_NE(nullptr, codec);
+  ASSERT_EQ(nullptr, PageCodec::create("none"));
+  ASSERT_EQ(nullptr, PageCodec::create("unknown"));
+  ASSERT_FALSE(PageCodec::enabled(""));
+
+  // 定长记录中有很多填充字节和重复的值
+  std::vector<char> src(BP_PAGE_SIZE, 0);
+  for (int i = 0; i + 32 <= BP_PAGE_SIZE; i += 32) {
+    snprintf(&src[i], 32, "name-%d", i % 7);
+    memcpy(&src[i + 24], &i, sizeof(i));
+  }
+  std::vector<char> compressed(BP_PAGE_SIZE);
+  std::vector<char> decompressed(BP_PAGE_SIZE);
+  const int length = codec->compress(src.data(), BP_PAGE_SIZE, compressed.data(), BP_PAGE_SIZE);
+  ASSERT_GT(length, 0);
+  ASSERT_LT(length, BP_PAGE_SIZE / 2);
+  ASSERT_EQ(RC::SUCCESS, codec->decompress(compressed.data(), length, decompressed.data(), BP_PAGE_SIZE));
+  ASSERT_EQ(0, memcmp(src.data(), decompressed.data(), BP_PAGE_SIZE));
+
+  // 随机数据压缩不了，输出缓冲区放不下时返回0
+  srand(1);
+  for (char &c : src) {
+    c = static_cast<char>(rand());
+  }
+  ASSERT_EQ(0, codec->compress(src.data(), BP_PAGE_SIZE, compressed.data(), BP_PAGE_SIZE - 512));
+  compressed.resize(BP_PAGE_SIZE * 2);
+  const int expanded_length = codec->compress(src.data(), BP_PAGE_SIZE, compressed.data(), BP_PAGE_SIZE * 2);
+  ASSERT_GT(expanded_length, 0);
+  ASSERT_EQ(RC::SUCCESS, codec->decompress(compressed.data(), expanded_length, decompressed.data(), BP_PAGE_SIZE));
+  ASSERT_EQ(0, memcmp(src.data(), decompressed.data(), BP_PAGE_SIZE));
+
+  // 数据损坏或者长度不对时返回错误
+  ASSERT_NE(RC::SUCCESS, codec->decompress(compressed.data(), expanded_length / 2, decompressed.data(), BP_PAGE_SIZE));
+  ASSERT_NE(RC::SUCCESS, codec->decompress(compressed.data(), expanded_length, decompressed.data(), BP_PAGE_SIZE - 1));
+}
+
+TEST(test_buffer_pool, test_compressed_file)
+{
+  const char *file_name = "compressed_file_test.bp";
+  const std::string map_file = CompressedPageFile::map_file_name(file_name);
+  ::remove(file_name);
+  ::remove(map_file.c_str());
+
+  BufferPoolParam param;
+  param.memory_size      = DEFAULT_ITEM_NUM_PER_POOL * 4 * BP_PAGE_SIZE;
+  param.read_ahead_pages = 0;
+  BufferPoolManager bpm(param);
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::INVALID_ARGUMENT, bpm.create_file(file_name, "unknown"));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name, "lz"));
+  ASSERT_TRUE(CompressedPageFile::is_compressed(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+  ASSERT_STREQ("lz", bp->codec_name());
+
+  const int page_num = 300;
+  std::vector<PageNum> pages;
+  for (int i = 0; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+    for (int offset = 0; offset + 64 <= BP_PAGE_DATA_SIZE; offset += 64) {
+      snprintf(frame->data() + offset, 64, "page %d record %d", frame->page_num(), offset / 64);
+    }
+    frame->mark_dirty();
+    pages.push_back(frame->page_num());
+    bp->unpin_page(frame);
+  }
+  // 有一个页面压缩不了，按原样保存
+  Frame *random_frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bp->get_this_page(pages[10], &random_frame));
+  srand(2);
+  for (int i = 0; i < BP_PAGE_DATA_SIZE; i++) {
+    random_frame->data()[i] = static_cast<char>(rand());
+  }
+  random_frame->mark_dirty();
+  std::vector<char> random_data(random_frame->data(), random_frame->data() + BP_PAGE_DATA_SIZE);
+  bp->unpin_page(random_frame);
+  ASSERT_EQ(RC::SUCCESS, bp->flush_all_pages());
+
+  // 覆盖写一些页面，再淘汰所有页面，之后都要从压缩的文件中读出来
+  for (int i = 0; i < page_num; i += 3) {
+    if (i == 10) {
+      continue;
+    }
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(pages[i], &frame));
+    snprintf(frame->data(), 64, "updated page %d", pages[i]);
+    frame->mark_dirty();
+    bp->unpin_page(frame);
+    ASSERT_EQ(RC::SUCCESS, bp->purge_page(pages[i]));
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+
+  // 文件大小远小于没有压缩时的大小，旧页面的空间被重新使用了
+  struct stat st;
+  ASSERT_EQ(0, stat(file_name, &st));
+  ASSERT_LT(st.st_size, (int64_t)pages.size() * BP_PAGE_SIZE / 2);
+
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+  for (int i = 0; i < page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(pages[i], &frame));
+    ASSERT_EQ(pages[i], frame->page_num());
+    char expected[64];
+    if (i == 10) {
+      ASSERT_EQ(0, memcmp(random_data.data(), frame->data(), BP_PAGE_DATA_SIZE));
+    } else if (i % 3 == 0) {
+      snprintf(expected, sizeof(expected), "updated page %d", pages[i]);
+      ASSERT_STREQ(expected, frame->data());
+    } else {
+      snprintf(expected, sizeof(expected), "page %d record %d", pages[i], 0);
+      ASSERT_STREQ(expected, frame->data());
+      snprintf(expected, sizeof(expected), "page %d record %d", pages[i], 3);
+      ASSERT_STREQ(expected, frame->data() + 3 * 64);
+    }
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.remove_file(file_name));
+  ASSERT_NE(0, access(map_file.c_str(), F_OK));
+}
+
+TEST(test_buffer_pool, test_resize)
+{
+  const char *file_name = "resize_test.bp";
+  const char *dump_file = "resize_test.dump";
+  ::remove(file_name);
+
+  BufferPoolParam param;
+  param.memory_size      = DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
+  param.read_ahead_pages = 0;
+  BufferPoolManager bpm(param);
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+  ASSERT_EQ(RC::INVALID_ARGUMENT, bpm.resize(BP_PAGE_SIZE));
+
+  std::vector<PageNum> pages;
+  for (int i = 0; i < DEFAULT_ITEM_NUM_PER_POOL * 2; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+    *(PageNum *)frame->data() = frame->page_num();
+    frame->mark_dirty();
+    pages.push_back(frame->page_num());
+    bp->unpin_page(frame);
+  }
+
+  // 扩大之后所有页面都可以留在内存中
+  ASSERT_EQ(RC::SUCCESS, bpm.resize(DEFAULT_ITEM_NUM_PER_POOL * 4 * BP_PAGE_SIZE));
+  ASSERT_EQ(DEFAULT_ITEM_NUM_PER_POOL * 4 * BP_PAGE_SIZE, bpm.memory_size());
+  for (PageNum page : pages) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(page, &frame));
+    ASSERT_EQ(page, *(PageNum *)frame->data());
+    *((PageNum *)frame->data() + 1) = page + 1;
+    frame->mark_dirty();
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.dump_pages(dump_file));
+  ASSERT_GT(read_dump_pages(dump_file).size(), pages.size());
+
+  // 缩小时脏页先刷盘再淘汰，留在内存中的页面不超过新的页帧个数
+  ASSERT_EQ(RC::SUCCESS, bpm.resize(DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE));
+  ASSERT_EQ(DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE, bpm.memory_size());
+  ASSERT_EQ(RC::SUCCESS, bpm.dump_pages(dump_file));
+  ASSERT_LE(read_dump_pages(dump_file).size(), static_cast<size_t>(DEFAULT_ITEM_NUM_PER_POOL));
+
+  for (PageNum page : pages) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(page, &frame));
+    ASSERT_EQ(page, *(PageNum *)frame->data());
+    ASSERT_EQ(page + 1, *((PageNum *)frame->data() + 1));
+    bp->unpin_page(frame);
+  }
+
+  ASSERT_EQ(RC::SUCCESS, bp->check_all_pages_unpinned());
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+  ::remove(file_name);
+  ::remove(dump_file);
+}
+
+TEST(test_buffer_pool, test_frame_quota)
+{
+  const char *file_name = "frame_quota_test.bp";
+  const char *dump_file = "frame_quota_test.dump";
+  ::remove(file_name);
+
+  BufferPoolParam param;
+  param.memory_size      = DEFAULT_ITEM_NUM_PER_POOL * 4 * BP_PAGE_SIZE;
+  param.read_ahead_pages = 0;
+  BufferPoolManager bpm(param);
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name));
+
+  // 文件打开之前设置的配额在打开时生效
+  const int quota = DEFAULT_ITEM_NUM_PER_POOL / 4;
+  ASSERT_EQ(RC::SUCCESS, bpm.set_frame_quota(file_name, quota));
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(file_name, bp));
+  ASSERT_EQ(quota, bp->frame_quota());
+
+  std::vector<PageNum> pages;
+  for (int i = 0; i < DEFAULT_ITEM_NUM_PER_POOL; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+    *(PageNum *)frame->data() = frame->page_num();
+    frame->mark_dirty();
+    pages.push_back(frame->page_num());
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.dump_pages(dump_file));
+  ASSERT_LE(read_dump_pages(dump_file).size(), static_cast<size_t>(quota));
+
+  // 取消配额之后文件可以使用所有的页帧
+  ASSERT_EQ(RC::SUCCESS, bpm.set_frame_quota(file_name, 0));
+  for (PageNum page : pages) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bp->get_this_page(page, &frame));
+    ASSERT_EQ(page, *(PageNum *)frame->data());
+    bp->unpin_page(frame);
+  }
+  ASSERT_EQ(RC::SUCCESS, bpm.dump_pages(dump_file));
+  ASSERT_GT(read_dump_pages(dump_file).size(), pages.size());
+
+  ASSERT_EQ(RC::SUCCESS, bp->check_all_pages_unpinned());
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(file_name));
+  ::remove(file_name);
+  ::remove(dump_file);
+}
+
 int main(int argc, char **argv)
 {
 
@@ -0,0 +1,126 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/index/bplus_tree.h"
+#include "storage/index/bplus_tree_bulk_loader.h"
+
+using namespace std;
+
+BufferPoolManager bpm;
+
+/**
+ * 按顺序扫描整棵树，检查每个键值都出现了一次，并且与RID对应
+ */
+static void check_scan(BplusTreeHandler &handler, int key_num)
+{
+  BplusTreeScanner scanner(handler);
+  ASSERT_EQ(RC::SUCCESS, scanner.open(nullptr, 0, false, nullptr, 0, false));
+
+  int count = 0;
+  RID rid;
+  while (scanner.next_entry(rid) == RC::SUCCESS) {
+    ASSERT_EQ(count / 3, rid.page_num);
+    ASSERT_EQ(count % 3, rid.slot_num);
+    count++;
+  }
+  ASSERT_EQ(key_num * 3, count);
+  scanner.close();
+}
+
+static void bulk_load(int key_num, int fill_factor, size_t memory_limit)
+{
+  const char *index_name = "bulk_load.btree";
+  ::remove(index_name);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_name, {INTS}, {4}, 5 /*internal_max_size*/, 7 /*leaf_max_size*/));
+
+  // 每个键值有3个RID，插入的顺序是打乱的
+  vector<RID> rids;
+  for (int i = 0; i < key_num; i++) {
+    for (int j = 0; j < 3; j++) {
+      rids.push_back(RID(i, j));
+    }
+  }
+  shuffle(rids.begin(), rids.end(), mt19937(key_num));
+
+  BplusTreeBulkLoader loader(handler, fill_factor, memory_limit);
+  for (const RID &rid : rids) {
+    ASSERT_EQ(RC::SUCCESS, loader.add(reinterpret_cast<const char *>(&rid.page_num), rid));
+  }
+  ASSERT_EQ(RC::SUCCESS, loader.finish());
+  ASSERT_EQ(static_cast<int64_t>(rids.size()), loader.count());
+
+  ASSERT_TRUE(handler.validate_tree());
+  check_scan(handler, key_num);
+
+  // 批量构建之后还可以正常地插入和删除
+  for (int i = key_num; i < key_num + 10; i++) {
+    for (int j = 0; j < 3; j++) {
+      RID rid(i, j);
+      ASSERT_EQ(RC::SUCCESS, handler.insert_entry(reinterpret_cast<const char *>(&i), &rid));
+    }
+  }
+  ASSERT_TRUE(handler.validate_tree());
+  check_scan(handler, key_num + 10);
+
+  for (int i = key_num; i < key_num + 10; i++) {
+    for (int j = 0; j < 3; j++) {
+      RID rid(i, j);
+      ASSERT_EQ(RC::SUCCESS, handler.delete_entry(reinterpret_cast<const char *>(&i), &rid));
+    }
+  }
+  ASSERT_TRUE(handler.validate_tree());
+  check_scan(handler, key_num);
+
+  ASSERT_EQ(RC::SUCCESS, handler.sync());
+  handler.close();
+
+  // 重新打开之后根节点还在
+  BplusTreeHandler reopened;
+  ASSERT_EQ(RC::SUCCESS, reopened.open(index_name));
+  check_scan(reopened, key_num);
+  reopened.close();
+
+  ::remove(index_name);
+}
+
+TEST(test_bplus_tree_bulk_load, test_in_memory)
+{
+  bulk_load(1, 90, BplusTreeBulkLoader::DEFAULT_MEMORY_LIMIT);
+  bulk_load(3, 90, BplusTreeBulkLoader::DEFAULT_MEMORY_LIMIT);
+  bulk_load(1000, 90, BplusTreeBulkLoader::DEFAULT_MEMORY_LIMIT);
+  bulk_load(1000, 50, BplusTreeBulkLoader::DEFAULT_MEMORY_LIMIT);
+  bulk_load(1000, 100, BplusTreeBulkLoader::DEFAULT_MEMORY_LIMIT);
+}
+
+TEST(test_bplus_tree_bulk_load, test_external_sort)
+{
+  // 每段最多只能放100个键值
+  bulk_load(1000, 90, 100 * (4 + sizeof(RID) + sizeof(char *)));
+  bulk_load(2000, 70, 1);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  common::LoggerFactory::init_default("bplus_tree_bulk_load_test.log", common::LOG_LEVEL_INFO);
+  BufferPoolManager::set_instance(&bpm);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,163 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <string.h>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/bplus_tree.h"
+
+using namespace std;
+
+static string int_key(int32_t value) { return string(reinterpret_cast<const char *>(&value), sizeof(value)); }
+static string float_key(float value) { return string(reinterpret_cast<const char *>(&value), sizeof(value)); }
+static string chars_key(const char *value, int length)
+{
+  string key(length, '\0');
+  memcpy(&key[0], value, std::min<size_t>(length, strlen(value)));
+  return key;
+}
+
+/**
+ * 按照叶子节点的布局(键值、RID、值)排列数据，每个键值有两个RID。
+ * 对每个可能的查找键值，lower_bound 的结果要与顺序查找的结果一致
+ */
+static void check_search(
+    const vector<AttrType> &types, const vector<int> &lengths, const vector<string> &keys, KeyShape shape)
+{
+  KeyComparator comparator;
+  comparator.init(types, lengths);
+  ASSERT_EQ(shape, comparator.attr_comparator().shape());
+
+  const int key_length = comparator.attr_comparator().attr_length();
+  const int item_size  = key_length + 2 * static_cast<int>(sizeof(RID));
+
+  vector<string> items;
+  for (const string &key : keys) {
+    ASSERT_EQ(key_length, static_cast<int>(key.size()));
+    for (int j = 0; j < 2; j++) {
+      RID    rid(1, j);
+      string item = key;
+      item.append(reinterpret_cast<const char *>(&rid), sizeof(rid));
+      items.push_back(item);
+    }
+  }
+
+  string node;
+  for (const string &item : items) {
+    node += item;
+    node.append(sizeof(RID), '\0');
+  }
+  for (size_t i = 1; i < items.size(); i++) {
+    ASSERT_LT(comparator(items[i - 1].data(), items[i].data()), 0);
+  }
+
+  vector<string> probes;
+  for (const string &key : keys) {
+    for (const RID *rid : {RID::min(), RID::max()}) {
+      string probe = key;
+      probe.append(reinterpret_cast<const char *>(rid), sizeof(*rid));
+      probes.push_back(probe);
+    }
+  }
+  probes.insert(probes.end(), items.begin(), items.end());
+
+  for (bool unique : {false, true}) {
+    if (unique) {
+      comparator.set_unique();
+    }
+    for (const string &probe : probes) {
+      // 节点中的键值个数从0到全部，覆盖查找时区间长度的各种情况
+      for (int count = 0; count <= static_cast<int>(items.size()); count++) {
+        int expected = 0;
+        while (expected < count && comparator(items[expected].data(), probe.data()) < 0) {
+          expected++;
+        }
+        const bool expected_found = expected < count && comparator(items[expected].data(), probe.data()) == 0;
+
+        bool found = !expected_found;
+        ASSERT_EQ(expected, comparator.lower_bound(node.data(), item_size, count, probe.data(), &found));
+        ASSERT_EQ(expected_found, found);
+      }
+    }
+    comparator.recover_unique();
+  }
+}
+
+TEST(test_key_comparator, test_int)
+{
+  const int32_t int_min = numeric_limits<int32_t>::min();
+  const int32_t int_max = numeric_limits<int32_t>::max();
+
+  vector<string> keys;
+  for (int32_t value : {int_min, -100, -1, 0, 1, 2, 3, 50, 100, int_max}) {
+    keys.push_back(int_key(value));
+  }
+  check_search({INTS}, {4}, keys, KeyShape::INT);
+
+  // 不能用相减的方式比较，否则会溢出
+  AttrComparator comparator;
+  comparator.init({INTS}, {4});
+  ASSERT_LT(comparator(int_key(int_min).data(), int_key(1).data()), 0);
+  ASSERT_GT(comparator(int_key(int_max).data(), int_key(-1).data()), 0);
+}
+
+TEST(test_key_comparator, test_float)
+{
+  vector<string> keys;
+  for (float value : {-numeric_limits<float>::infinity(), -3.5f, -1.0f, 0.0f, 0.25f, 1.0f, 1e10f}) {
+    keys.push_back(float_key(value));
+  }
+  check_search({FLOATS}, {4}, keys, KeyShape::FLOAT);
+
+  // 与 common::compare_float 一样，差距很小时认为相等
+  AttrComparator comparator;
+  comparator.init({FLOATS}, {4});
+  ASSERT_EQ(0, comparator(float_key(1.0f).data(), float_key(1.0f + 1e-7f).data()));
+}
+
+TEST(test_key_comparator, test_chars)
+{
+  vector<string> keys;
+  for (const char *value : {"", "a", "ab", "abc", "abcd", "b", "zzzz"}) {
+    keys.push_back(chars_key(value, 4));
+  }
+  check_search({CHARS}, {4}, keys, KeyShape::CHARS);
+}
+
+TEST(test_key_comparator, test_int_int)
+{
+  vector<string> keys;
+  for (int32_t first : {-2, 0, 7}) {
+    for (int32_t second : {numeric_limits<int32_t>::min(), -1, 0, 5}) {
+      keys.push_back(int_key(first) + int_key(second));
+    }
+  }
+  check_search({INTS, INTS}, {4, 4}, keys, KeyShape::INT_INT);
+}
+
+TEST(test_key_comparator, test_generic)
+{
+  vector<string> keys;
+  for (int32_t first : {-1, 3}) {
+    for (const char *second : {"a", "abc", "b"}) {
+      keys.push_back(int_key(first) + chars_key(second, 3));
+    }
+  }
+  check_search({INTS, CHARS}, {4, 3}, keys, KeyShape::GENERIC);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -14,6 +14,12 @@ See the Mulan PSL v2 for more details. */
 
 #include <list>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
 
 #include "storage/index/bplus_tree.h"
 #include "storage/buffer/disk_buffer_pool.h"
@@ -29,6 +35,12 @@ using namespace common;
 #define ORDER 4
 #define INSERT_NUM (TIMES * ORDER * ORDER * ORDER * ORDER)
 #define POOL_NUM 2
+// 页帧的读写锁只有开启 CONCURRENCY 时才生效，否则只能用一个线程
+#ifdef CONCURRENCY
+#define THREAD_NUM 4
+#else
+#define THREAD_NUM 1
+#endif
 
 BufferPoolManager bpm;
 BplusTreeHandler *handler = nullptr;
@@ -318,14 +330,15 @@ TEST(test_bplus_tree, test_leaf_index_node_handle)
   index_file_header.root_page = BP_INVALID_PAGE_NUM;
   index_file_header.internal_max_size = 5;
   index_file_header.leaf_max_size = 5;
-  index_file_header.attr_length = 4;
+  index_file_header.attr_num = 1;
+  index_file_header.attr_length[0] = 4;
   index_file_header.key_length = 4 + sizeof(RID);
-  index_file_header.attr_type = INTS;
+  index_file_header.attr_type[0] = INTS;
 
   Frame frame;
 
   KeyComparator key_comparator;
-  key_comparator.init(INTS, 4);
+  key_comparator.init({INTS}, {4});
 
   LeafIndexNodeHandler leaf_node(index_file_header, &frame);
   leaf_node.init_empty();
@@ -375,14 +388,15 @@ TEST(test_bplus_tree, test_internal_index_node_handle)
   index_file_header.root_page = BP_INVALID_PAGE_NUM;
   index_file_header.internal_max_size = 5;
   index_file_header.leaf_max_size = 5;
-  index_file_header.attr_length = 4;
+  index_file_header.attr_num = 1;
+  index_file_header.attr_length[0] = 4;
   index_file_header.key_length = 4 + sizeof(RID);
-  index_file_header.attr_type = INTS;
+  index_file_header.attr_type[0] = INTS;
 
   Frame frame;
 
   KeyComparator key_comparator;
-  key_comparator.init(INTS, 4);
+  key_comparator.init({INTS}, {4});
 
   InternalIndexNodeHandler internal_node(index_file_header, &frame);
   internal_node.init_empty();
@@ -472,7 +486,7 @@ TEST(test_bplus_tree, test_chars)
   const char *index_name = "chars.btree";
   ::remove(index_name);
   handler = new BplusTreeHandler();
-  handler->create(index_name, CHARS, 8, ORDER, ORDER);
+  handler->create(index_name, {CHARS}, {8}, ORDER, ORDER);
 
   char keys[][9] = {
     "abcdefg",
@@ -515,7 +529,7 @@ TEST(test_bplus_tree, test_scanner)
   const char *index_name = "scanner.btree";
   ::remove(index_name);
   handler = new BplusTreeHandler();
-  handler->create(index_name, INTS, sizeof(int), ORDER, ORDER);
+  handler->create(index_name, {INTS}, {sizeof(int)}, ORDER, ORDER);
 
   int count = 0;
   RC rc = RC::SUCCESS;
@@ -718,13 +732,204 @@ TEST(test_bplus_tree, test_scanner)
   scanner.close();
 }
 
+/**
+ * 扫描 [left, right] 范围内的数据，边界为 -1 时表示没有边界，返回扫描到的RID个数
+ */
+static int range_count(BplusTreeHandler &handler, int left, bool left_inclusive, int right, bool right_inclusive)
+{
+  BplusTreeScanner scanner(handler);
+  RC rc = scanner.open(left < 0 ? nullptr : reinterpret_cast<const char *>(&left), 4, left_inclusive,
+      right < 0 ? nullptr : reinterpret_cast<const char *>(&right), 4, right_inclusive);
+  if (rc != RC::SUCCESS) {
+    return -1;
+  }
+
+  int count = 0;
+  RID rid;
+  while (scanner.next_entry(rid) == RC::SUCCESS) {
+    count++;
+  }
+  scanner.close();
+  return count;
+}
+
+TEST(test_bplus_tree, test_range_scan)
+{
+  const char *index_name = "range_scan.btree";
+  ::remove(index_name);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_name, {INTS}, {sizeof(int)}, ORDER, ORDER));
+
+  // 空树上没有左边界的扫描也能正常结束
+  ASSERT_EQ(0, range_count(handler, -1, false, 10, true));
+  ASSERT_EQ(0, range_count(handler, -1, false, -1, false));
+
+  // 每个键值有3个RID，打乱顺序插入，让叶子节点和内部节点都发生分裂
+  std::vector<RID> rids;
+  for (int i = 0; i < 100; i++) {
+    for (int j = 0; j < 3; j++) {
+      rids.push_back(RID(i, j));
+    }
+  }
+  std::shuffle(rids.begin(), rids.end(), std::mt19937(2022));
+  for (const RID &rid : rids) {
+    const int key = rid.page_num;
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(reinterpret_cast<const char *>(&key), &rid));
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  ASSERT_EQ(30, range_count(handler, -1, false, 10, false));   // a < 10
+  ASSERT_EQ(33, range_count(handler, -1, false, 10, true));    // a <= 10
+  ASSERT_EQ(27, range_count(handler, 90, false, -1, false));   // a > 90
+  ASSERT_EQ(30, range_count(handler, 90, true, -1, false));    // a >= 90
+  ASSERT_EQ(27, range_count(handler, 10, false, 20, false));   // a > 10 AND a < 20
+  ASSERT_EQ(33, range_count(handler, 10, true, 20, true));     // a >= 10 AND a <= 20
+  ASSERT_EQ(3, range_count(handler, 50, true, 50, true));      // a = 50
+  ASSERT_EQ(0, range_count(handler, 200, true, -1, false));    // a >= 200
+  ASSERT_EQ(300, range_count(handler, -1, false, -1, false));
+
+  handler.close();
+  ::remove(index_name);
+}
+
+/**
+ * 多字段索引 (INTS, CHARS(4)) 上的扫描，边界是补齐之后的完整键值
+ */
+static int composite_count(BplusTreeHandler &handler, int a1, const char *b1, bool left_inclusive, int a2,
+    const char *b2, bool right_inclusive)
+{
+  char left[8]  = {0};
+  char right[8] = {0};
+  memcpy(left, &a1, 4);
+  memcpy(left + 4, b1, std::min<size_t>(4, strlen(b1)));
+  memcpy(right, &a2, 4);
+  memcpy(right + 4, b2, std::min<size_t>(4, strlen(b2)));
+
+  BplusTreeScanner scanner(handler);
+  if (scanner.open(left, 8, left_inclusive, right, 8, right_inclusive) != RC::SUCCESS) {
+    return -1;
+  }
+  int count = 0;
+  RID rid;
+  while (scanner.next_entry(rid) == RC::SUCCESS) {
+    count++;
+  }
+  scanner.close();
+  return count;
+}
+
+TEST(test_bplus_tree, test_composite_prefix_scan)
+{
+  const char *index_name = "composite_scan.btree";
+  ::remove(index_name);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_name, {INTS, CHARS}, {4, 4}, ORDER, ORDER));
+
+  // a 取 -5..4，b 取 "a".."j"，每个组合一条数据，打乱顺序插入
+  std::vector<RID> rids;
+  for (int a = -5; a < 5; a++) {
+    for (int b = 0; b < 10; b++) {
+      rids.push_back(RID(a + 5, b));
+    }
+  }
+  std::shuffle(rids.begin(), rids.end(), std::mt19937(2022));
+  for (const RID &rid : rids) {
+    const int a = rid.page_num - 5;
+    char key[8] = {0};
+    memcpy(key, &a, 4);
+    key[4] = static_cast<char>('a' + rid.slot_num);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(key, &rid));
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  const char *min_chars = "";
+  const char *max_chars = "\xff\xff\xff\xff";
+  const int   int_min   = std::numeric_limits<int>::min();
+  const int   int_max   = std::numeric_limits<int>::max();
+
+  // a = 1
+  ASSERT_EQ(10, composite_count(handler, 1, min_chars, true, 1, max_chars, true));
+  // a = -3 AND b > 'c'
+  ASSERT_EQ(7, composite_count(handler, -3, "c", false, -3, max_chars, true));
+  // a = 2 AND b >= 'c' AND b < 'f'
+  ASSERT_EQ(3, composite_count(handler, 2, "c", true, 2, "f", false));
+  // a > 2：左边界排除 a = 2 的所有数据
+  ASSERT_EQ(20, composite_count(handler, 2, max_chars, false, int_max, max_chars, true));
+  // a < -3：右边界排除 a = -3 的所有数据，INT_MIN 不能因为溢出比较错
+  ASSERT_EQ(20, composite_count(handler, int_min, min_chars, true, -3, min_chars, false));
+
+  handler.close();
+  ::remove(index_name);
+}
+
+TEST(test_bplus_tree, test_concurrent_insert_delete)
+{
+  const char *index_name = "concurrent.btree";
+  ::remove(index_name);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS, handler.create(index_name, {INTS}, {sizeof(int)}, ORDER, ORDER));
+
+  // 先插入 [0, KEY_NUM)，然后每个线程删除其中一部分奇数，同时插入 [KEY_NUM, 2 * KEY_NUM) 中的一部分，
+  // 左边的节点不断合并，右边的节点不断分裂。偶数一直都在树中，读线程可以随时查到
+  constexpr int KEY_NUM = 2000;
+  for (int i = 0; i < KEY_NUM; i++) {
+    RID rid(i, 0);
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry(reinterpret_cast<const char *>(&i), &rid));
+  }
+
+  std::atomic<int> failed_num{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREAD_NUM; t++) {
+    threads.emplace_back([&handler, &failed_num, t]() {
+      for (int i = t; i < KEY_NUM; i += THREAD_NUM) {
+        int insert_key = KEY_NUM + i;
+        RID insert_rid(insert_key, 0);
+        if (handler.insert_entry(reinterpret_cast<const char *>(&insert_key), &insert_rid) != RC::SUCCESS) {
+          failed_num++;
+        }
+
+        if (i % 2 == 1) {
+          RID delete_rid(i, 0);
+          if (handler.delete_entry(reinterpret_cast<const char *>(&i), &delete_rid) != RC::SUCCESS) {
+            failed_num++;
+          }
+        }
+
+        int read_key = (i * 7) % KEY_NUM / 2 * 2;
+        std::list<RID> rids;
+        if (handler.get_entry(reinterpret_cast<const char *>(&read_key), 4, rids) != RC::SUCCESS || rids.size() != 1) {
+          failed_num++;
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(0, failed_num.load());
+  ASSERT_TRUE(handler.validate_tree());
+
+  for (int i = 0; i < KEY_NUM * 2; i++) {
+    std::list<RID> rids;
+    ASSERT_EQ(RC::SUCCESS, handler.get_entry(reinterpret_cast<const char *>(&i), 4, rids));
+    ASSERT_EQ((i < KEY_NUM && i % 2 == 1) ? 0 : 1, static_cast<int>(rids.size())) << "key " << i;
+  }
+  ASSERT_EQ(KEY_NUM * 3 / 2, range_count(handler, -1, false, -1, false));
+
+  handler.close();
+  ::remove(index_name);
+}
+
 TEST(test_bplus_tree, test_bplus_tree_insert)
 {
   LoggerFactory::init_default("test.log");
 
   ::remove(index_name);
   handler = new BplusTreeHandler();
-  handler->create(index_name, INTS, sizeof(int), ORDER, ORDER);
+  handler->create(index_name, {INTS}, {sizeof(int)}, ORDER, ORDER);
 
   test_insert();
 
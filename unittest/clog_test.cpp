@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include <string.h>
+#include <string>
 
 #include "common/log/log.h"
 #include "storage/clog/clog.h"
@@ -45,6 +46,41 @@ TEST(test_clog, test_clog)
   */
 }
 
+TEST(test_clog, test_append_more_than_buffer)
+{
+  const char *path = ".";
+  const char *clog_file = "./clog";
+  remove(clog_file);
+
+  // 日志的总大小超过日志缓冲区时，先把缓冲区中的日志写到文件中
+  const int         log_num  = 100;
+  const std::string data(64 * 1024, 'a');
+  {
+    CLogManager log_mgr;
+    ASSERT_EQ(RC::SUCCESS, log_mgr.init(path));
+    for (int i = 0; i < log_num; i++) {
+      ASSERT_EQ(RC::SUCCESS,
+          log_mgr.append_log(CLogType::INSERT, 1 /*trx_id*/, 1 /*table_id*/, RID(1, i),
+              static_cast<int32_t>(data.size()), 0 /*offset*/, data.data()));
+    }
+    ASSERT_EQ(RC::SUCCESS, log_mgr.sync());
+  }
+
+  CLogFile log_file;
+  ASSERT_EQ(RC::SUCCESS, log_file.init(path));
+  CLogRecordIterator iterator;
+  ASSERT_EQ(RC::SUCCESS, iterator.init(log_file));
+  int count = 0;
+  RC rc = RC::SUCCESS;
+  for (rc = iterator.next(); OB_SUCC(rc) && iterator.valid(); rc = iterator.next()) {
+    ASSERT_EQ(RID(1, count), iterator.log_record().data_record().rid_);
+    count++;
+  }
+  ASSERT_EQ(RC::RECORD_EOF, rc);
+  ASSERT_EQ(log_num, count);
+  remove(clog_file);
+}
+
 int main(int argc, char **argv)
 {
   // 分析gtest程序的命令行参数
@@ -0,0 +1,198 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <memory>
+#include <vector>
+
+#include "storage/buffer/frame_replacer.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+
+class FrameReplacerTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    frames_.resize(FRAME_NUM);
+    for (int i = 0; i < FRAME_NUM; i++) {
+      frames_[i].reset(new Frame);
+      frames_[i]->set_file_desc(0);
+      frames_[i]->set_page_num(i);
+    }
+  }
+
+  Frame *frame(int i) { return frames_[i].get(); }
+
+  /**
+   * @brief 返回置换策略给出的第一个可以淘汰的页帧编号
+   */
+  PageNum first_victim(FrameReplacer &replacer)
+  {
+    PageNum page_num = -1;
+    replacer.foreach_victim([&page_num](Frame *frame) {
+      if (!frame->can_purge()) {
+        return true;
+      }
+      page_num = frame->page_num();
+      return false;
+    });
+    return page_num;
+  }
+
+protected:
+  static constexpr int FRAME_NUM = 8;
+  vector<unique_ptr<Frame>> frames_;
+};
+
+TEST(frame_replacer, create)
+{
+  const char *names[] = {"", "lru", "LRU", "clock", "lru-k", "2q"};
+  for (const char *name : names) {
+    unique_ptr<FrameReplacer> replacer(FrameReplacer::create(name, 16));
+    ASSERT_NE(nullptr, replacer);
+  }
+
+  ASSERT_EQ(nullptr, FrameReplacer::create("not-exist", 16));
+}
+
+TEST_F(FrameReplacerTest, lru)
+{
+  LruFrameReplacer replacer;
+  for (int i = 0; i < 4; i++) {
+    replacer.insert(frame(i));
+  }
+  ASSERT_EQ(4, replacer.size());
+  ASSERT_EQ(0, first_victim(replacer));
+
+  replacer.access(frame(0));
+  ASSERT_EQ(1, first_victim(replacer));
+
+  replacer.remove(frame(1));
+  ASSERT_EQ(2, first_victim(replacer));
+  ASSERT_EQ(3, replacer.size());
+}
+
+TEST_F(FrameReplacerTest, clock)
+{
+  ClockFrameReplacer replacer;
+  for (int i = 0; i < 4; i++) {
+    replacer.insert(frame(i));
+  }
+
+  // 第一圈清除所有访问位，第二圈从头开始淘汰
+  ASSERT_EQ(0, first_victim(replacer));
+
+  // 0号被访问过，得到第二次机会
+  replacer.access(frame(0));
+  ASSERT_EQ(1, first_victim(replacer));
+
+  replacer.remove(frame(2));
+  replacer.insert(frame(4));  // 复用2号的槽位
+  ASSERT_EQ(4, replacer.size());
+
+  // pin住的页帧不能淘汰
+  frame(3)->pin();
+  ASSERT_NE(3, first_victim(replacer));
+  frame(3)->unpin();
+}
+
+TEST_F(FrameReplacerTest, clock_candidate_no_side_effect)
+{
+  ClockFrameReplacer replacer;
+  for (int i = 0; i < 4; i++) {
+    replacer.insert(frame(i));
+  }
+  replacer.access(frame(1));
+
+  // 刷脏页时的遍历不清除访问位，也不移动时钟指针，可以重复得到相同的结果
+  for (int i = 0; i < 2; i++) {
+    vector<PageNum> candidates;
+    replacer.foreach_candidate([&candidates](Frame *frame) {
+      candidates.push_back(frame->page_num());
+      return true;
+    });
+    ASSERT_EQ(4, candidates.size());
+  }
+  ASSERT_TRUE(frame(1)->replacer_hook().referenced);
+}
+
+TEST_F(FrameReplacerTest, lru_k_resist_scan)
+{
+  LruKFrameReplacer replacer;
+
+  // 0 和 1 是热点页面，访问了多次
+  replacer.insert(frame(0));
+  replacer.insert(frame(1));
+  replacer.access(frame(0));
+  replacer.access(frame(1));
+
+  // 一次扫描访问了很多页面，每个页面只访问一次
+  for (int i = 2; i < FRAME_NUM; i++) {
+    replacer.insert(frame(i));
+  }
+
+  ASSERT_EQ(2, first_victim(replacer));
+
+  vector<PageNum> victims;
+  replacer.foreach_victim([&victims](Frame *frame) {
+    victims.push_back(frame->page_num());
+    return true;
+  });
+  ASSERT_EQ(FRAME_NUM, victims.size());
+  ASSERT_EQ(0, victims[FRAME_NUM - 2]);
+  ASSERT_EQ(1, victims[FRAME_NUM - 1]);
+
+  replacer.remove(frame(0));
+  ASSERT_EQ(FRAME_NUM - 1, replacer.size());
+}
+
+TEST_F(FrameReplacerTest, two_queue)
+{
+  TwoQueueFrameReplacer replacer(4);
+
+  for (int i = 0; i < 4; i++) {
+    replacer.insert(frame(i));
+  }
+
+  // 都在 A1in 中，先进先出
+  ASSERT_EQ(0, first_victim(replacer));
+  replacer.access(frame(0));
+  ASSERT_EQ(0, first_victim(replacer));
+
+  // 0号被淘汰后再次加载，说明不是只访问一次的页面，进入 Am
+  replacer.evict(frame(0));
+  replacer.insert(frame(0));
+  ASSERT_EQ(1, first_victim(replacer));
+
+  // A1in 不超过容量时优先淘汰 Am
+  replacer.evict(frame(1));
+  replacer.evict(frame(2));
+  ASSERT_EQ(0, first_victim(replacer));
+
+  // 显式删除的页面不记录到 A1out，再次加载时还是放到 A1in 中
+  // A1in 超过容量时从 A1in 中淘汰，3号是 A1in 中最早的页面
+  replacer.remove(frame(3));
+  replacer.insert(frame(3));
+  replacer.insert(frame(4));
+  replacer.insert(frame(5));
+  ASSERT_EQ(3, first_victim(replacer));
+
+  // 被淘汰的 A1in 页面记录到 A1out，再次加载时进入 Am
+  replacer.evict(frame(3));
+  replacer.insert(frame(3));
+  ASSERT_EQ(4, first_victim(replacer));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
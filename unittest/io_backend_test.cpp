@@ -0,0 +1,197 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <memory>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "storage/common/io_backend.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+
+class IoBackendTest : public testing::TestWithParam<const char *>
+{
+protected:
+  static constexpr int BLOCK_SIZE = 4096;
+  static constexpr int BLOCK_NUM  = 200;  // 比 io_uring 队列深度大，需要分多次提交
+
+  void SetUp() override
+  {
+    backend_ = IoBackend::create(GetParam());
+    ASSERT_NE(nullptr, backend_);
+    file_name_ = string("io_backend_test_") + GetParam() + ".data";
+    ::remove(file_name_.c_str());
+  }
+
+  void TearDown() override { ::remove(file_name_.c_str()); }
+
+protected:
+  unique_ptr<IoBackend> backend_;
+  string                file_name_;
+};
+
+TEST_P(IoBackendTest, test_batch_read_write)
+{
+  int fd = open(file_name_.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+  ASSERT_GE(fd, 0);
+
+  vector<vector<char>> blocks(BLOCK_NUM, vector<char>(BLOCK_SIZE));
+  vector<IoRequest>    requests;
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    memset(blocks[i].data(), 'a' + i % 26, BLOCK_SIZE);
+    // 倒序写入，偏移量不连续也没有关系
+    const int block = BLOCK_NUM - 1 - i;
+    requests.push_back(IoRequest::write(fd, blocks[i].data(), BLOCK_SIZE, (int64_t)block * BLOCK_SIZE));
+  }
+  ASSERT_EQ(RC::SUCCESS, backend_->submit(requests));
+  for (const IoRequest &request : requests) {
+    ASSERT_EQ(0, request.error);
+    ASSERT_EQ(BLOCK_SIZE, request.done);
+  }
+
+  vector<vector<char>> read_blocks(BLOCK_NUM, vector<char>(BLOCK_SIZE));
+  requests.clear();
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    requests.push_back(IoRequest::read(fd, read_blocks[i].data(), BLOCK_SIZE, (int64_t)i * BLOCK_SIZE));
+  }
+  ASSERT_EQ(RC::SUCCESS, backend_->submit(requests));
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    ASSERT_EQ(blocks[BLOCK_NUM - 1 - i], read_blocks[i]);
+  }
+
+  // 读到文件尾的请求失败，同一批中的其它请求不受影响
+  vector<char> buf(BLOCK_SIZE);
+  requests.clear();
+  requests.push_back(IoRequest::read(fd, read_blocks[0].data(), BLOCK_SIZE, 0));
+  requests.push_back(IoRequest::read(fd, buf.data(), BLOCK_SIZE, (int64_t)BLOCK_NUM * BLOCK_SIZE));
+  ASSERT_EQ(RC::IOERR_READ, backend_->submit(requests));
+  ASSERT_EQ(0, requests[0].error);
+  ASSERT_EQ(-1, requests[1].error);
+
+  ASSERT_EQ(RC::SUCCESS, backend_->read(fd, buf.data(), BLOCK_SIZE, 0));
+  ASSERT_EQ(blocks[BLOCK_NUM - 1], buf);
+  close(fd);
+}
+
+TEST_P(IoBackendTest, test_append_in_order)
+{
+  int fd = open(file_name_.c_str(), O_RDWR | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR);
+  ASSERT_GE(fd, 0);
+
+  // 追加写的请求要按照提交的顺序落到文件中
+  vector<string>    pieces;
+  vector<IoRequest> requests;
+  string            expected;
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    pieces.push_back(to_string(i) + ",");
+  }
+  for (const string &piece : pieces) {
+    requests.push_back(IoRequest::write(fd, piece.data(), static_cast<int>(piece.size()), -1));
+    expected += piece;
+  }
+  ASSERT_EQ(RC::SUCCESS, backend_->submit(requests));
+  ASSERT_EQ(RC::SUCCESS, backend_->write(fd, "end", 3, -1));
+  expected += "end";
+
+  string content(expected.size(), '\0');
+  ASSERT_EQ(RC::SUCCESS, backend_->read(fd, content.data(), static_cast<int>(content.size()), 0));
+  ASSERT_EQ(expected, content);
+  close(fd);
+}
+
+TEST_P(IoBackendTest, test_vectored_write)
+{
+  int fd = open(file_name_.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+  ASSERT_GE(fd, 0);
+
+  // 不连续的内存块写到文件中连续的位置
+  vector<vector<char>> blocks(BLOCK_NUM, vector<char>(BLOCK_SIZE));
+  vector<struct iovec> iovecs;
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    memset(blocks[i].data(), 'a' + i % 26, BLOCK_SIZE);
+    iovecs.push_back({blocks[i].data(), BLOCK_SIZE});
+  }
+
+  vector<IoRequest> requests;
+  requests.push_back(IoRequest::writev(fd, iovecs.data(), BLOCK_NUM / 2, 0));
+  requests.push_back(IoRequest::writev(fd, iovecs.data() + BLOCK_NUM / 2, BLOCK_NUM / 2, (int64_t)BLOCK_NUM / 2 * BLOCK_SIZE));
+  ASSERT_EQ(RC::SUCCESS, backend_->submit(requests));
+  for (const IoRequest &request : requests) {
+    ASSERT_EQ(0, request.error);
+    ASSERT_EQ(BLOCK_NUM / 2 * BLOCK_SIZE, request.done);
+  }
+  ASSERT_EQ(RC::SUCCESS, backend_->sync(fd));
+
+  vector<char> buf(BLOCK_SIZE);
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    ASSERT_EQ(RC::SUCCESS, backend_->read(fd, buf.data(), BLOCK_SIZE, (int64_t)i * BLOCK_SIZE));
+    ASSERT_EQ(blocks[i], buf);
+  }
+  close(fd);
+}
+
+TEST_P(IoBackendTest, test_vectored_append)
+{
+  int fd = open(file_name_.c_str(), O_RDWR | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR);
+  ASSERT_GE(fd, 0);
+
+  // 与日志刷盘一样，多段数据作为一个向量请求追加到文件末尾
+  vector<string>       pieces;
+  vector<struct iovec> iovecs;
+  string               expected;
+  for (int i = 0; i < BLOCK_NUM; i++) {
+    pieces.push_back(to_string(i) + ",");
+  }
+  for (string &piece : pieces) {
+    iovecs.push_back({piece.data(), piece.size()});
+    expected += piece;
+  }
+  ASSERT_EQ(RC::SUCCESS, backend_->write(fd, "begin,", 6, -1));
+  IoRequest request = IoRequest::writev(fd, iovecs.data(), static_cast<int>(iovecs.size()), -1);
+  ASSERT_EQ(RC::SUCCESS, backend_->submit(&request, 1));
+  ASSERT_EQ(static_cast<int>(expected.size()), request.done);
+  expected = "begin," + expected;
+
+  string content(expected.size(), '\0');
+  ASSERT_EQ(RC::SUCCESS, backend_->read(fd, content.data(), static_cast<int>(content.size()), 0));
+  ASSERT_EQ(expected, content);
+  close(fd);
+}
+
+TEST_P(IoBackendTest, test_bad_request)
+{
+  // 出错的请求不会一直重试
+  char      buf[16] = {0};
+  IoRequest request = IoRequest::write(-1, buf, sizeof(buf), 0);
+  ASSERT_EQ(RC::IOERR_WRITE, backend_->submit(&request, 1));
+  ASSERT_EQ(EBADF, request.error);
+}
+
+INSTANTIATE_TEST_SUITE_P(IoBackends, IoBackendTest, testing::Values("sync", "io_uring"));
+
+TEST(test_io_backend, test_create)
+{
+  ASSERT_EQ(nullptr, IoBackend::create("unknown"));
+  ASSERT_STREQ("sync", IoBackend::create("SYNC")->name());
+  ASSERT_STREQ("sync", IoBackend::instance().name());
+  ASSERT_STREQ("sync", IoBackend::DEFAULT_NAME);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
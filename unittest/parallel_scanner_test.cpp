@@ -0,0 +1,192 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/log/log.h"
+#include "sql/expr/expression.h"
+#include "sql/operator/parallel_scanner.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/field/field.h"
+#include "storage/record/record_manager.h"
+#include "storage/table/physical_table.h"
+#include "storage/trx/trx.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+// 页帧的读写锁只有开启 CONCURRENCY 时才生效，否则只能用一个工作线程
+#ifdef CONCURRENCY
+static constexpr int WORKER_NUM = 4;
+#else
+static constexpr int WORKER_NUM = 1;
+#endif
+
+class ParallelScannerTest : public testing::Test
+{
+protected:
+  static constexpr int RECORD_NUM = 100000;
+
+  void SetUp() override
+  {
+    filesystem::remove_all(base_dir_);
+    filesystem::create_directories(base_dir_);
+
+    bpm_ = make_unique<BufferPoolManager>(static_cast<int64_t>(DEFAULT_ITEM_NUM_PER_POOL) * 4 * BP_PAGE_SIZE);
+    BufferPoolManager::set_instance(bpm_.get());
+
+    AttrInfoSqlNode attr;
+    attr.type     = INTS;
+    attr.name     = "id";
+    attr.length   = sizeof(int);
+    attr.nullable = false;
+
+    const string meta_file = base_dir_ + "/t.table";
+    table_                 = make_unique<PhysicalTable>();
+    ASSERT_EQ(RC::SUCCESS, table_->create(1, meta_file.c_str(), "t", base_dir_.c_str(), 1, &attr));
+
+    for (int i = 0; i < RECORD_NUM; i++) {
+      Value  value(i);
+      Record record;
+      ASSERT_EQ(RC::SUCCESS, table_->make_record(1, &value, record));
+      ASSERT_EQ(RC::SUCCESS, table_->insert_record(record));
+    }
+    page_count_ = table_->record_handler()->page_count();
+    ASSERT_GT(page_count_, ParallelScanner::MIN_PAGES);
+  }
+
+  void TearDown() override
+  {
+    table_.reset();
+    BufferPoolManager::set_instance(nullptr);
+    bpm_.reset();
+    filesystem::remove_all(base_dir_);
+  }
+
+  /**
+   * @brief 扫描整张表，返回每条记录的 id
+   */
+  RC scan(const vector<unique_ptr<Expression>> &predicates, int page_count, int worker_num, vector<int> &ids)
+  {
+    Field field(table_.get(), table_->table_meta().field("id"));
+
+    ParallelScanner scanner;
+    RC rc = scanner.open(table_.get(), nullptr /*trx*/, predicates, {}, page_count, worker_num);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    Record record;
+    while (OB_SUCC(rc = scanner.next(record))) {
+      ids.push_back(field.get_int(record));
+    }
+    scanner.close();
+    return rc == RC::RECORD_EOF ? RC::SUCCESS : rc;
+  }
+
+protected:
+  string                       base_dir_ = "parallel_scanner_test_dir";
+  unique_ptr<BufferPoolManager> bpm_;
+  unique_ptr<PhysicalTable>    table_;
+  int                          page_count_ = 0;
+};
+
+TEST_F(ParallelScannerTest, test_invalid_argument)
+{
+  vector<unique_ptr<Expression>> predicates;
+  ParallelScanner                scanner;
+  ASSERT_EQ(RC::INVALID_ARGUMENT, scanner.open(table_.get(), nullptr, predicates, {}, page_count_, 0));
+  ASSERT_EQ(RC::INVALID_ARGUMENT, scanner.open(table_.get(), nullptr, predicates, {}, 0, WORKER_NUM));
+
+  ASSERT_EQ(RC::SUCCESS, scanner.open(table_.get(), nullptr, predicates, {}, page_count_, WORKER_NUM));
+  ASSERT_EQ(RC::RECORD_OPENNED, scanner.open(table_.get(), nullptr, predicates, {}, page_count_, WORKER_NUM));
+  scanner.close();
+}
+
+TEST_F(ParallelScannerTest, test_complete_and_ordered)
+{
+  // 工作线程比小段多、少，以及只有一个工作线程，结果都与单线程扫描相同：所有记录按照插入的顺序返回
+  vector<unique_ptr<Expression>> predicates;
+  const int morsel_num = (page_count_ + ParallelScanner::MORSEL_PAGES - 1) / ParallelScanner::MORSEL_PAGES;
+  for (int worker_num : {1, WORKER_NUM, morsel_num + 2}) {
+#ifndef CONCURRENCY
+    if (worker_num > 1) {
+      continue;
+    }
+#endif
+    vector<int> ids;
+    ASSERT_EQ(RC::SUCCESS, scan(predicates, page_count_, worker_num, ids));
+    ASSERT_EQ(RECORD_NUM, static_cast<int>(ids.size())) << "worker num " << worker_num;
+    for (int i = 0; i < RECORD_NUM; i++) {
+      ASSERT_EQ(i, ids[i]) << "worker num " << worker_num;
+    }
+  }
+}
+
+TEST_F(ParallelScannerTest, test_page_count)
+{
+  // 只扫描前面的页面，最后一个小段不满
+  const int page_count = ParallelScanner::MORSEL_PAGES * 2 + 3;
+  vector<unique_ptr<Expression>> predicates;
+  vector<int>                    ids;
+  ASSERT_EQ(RC::SUCCESS, scan(predicates, page_count, WORKER_NUM, ids));
+  ASSERT_FALSE(ids.empty());
+  ASSERT_LT(static_cast<int>(ids.size()), RECORD_NUM);
+  for (size_t i = 0; i < ids.size(); i++) {
+    ASSERT_EQ(static_cast<int>(i), ids[i]);
+  }
+}
+
+TEST_F(ParallelScannerTest, test_predicates)
+{
+  // 过滤条件在工作线程中计算：id >= RECORD_NUM / 2 and id < RECORD_NUM / 2 + 100
+  const FieldMeta *field_meta = table_->table_meta().field("id");
+
+  vector<unique_ptr<Expression>> predicates;
+  predicates.emplace_back(new ComparisonExpr(GREAT_EQUAL,
+      make_unique<FieldExpr>(table_.get(), field_meta), make_unique<ValueExpr>(Value(RECORD_NUM / 2))));
+  predicates.emplace_back(new ComparisonExpr(LESS_THAN,
+      make_unique<FieldExpr>(table_.get(), field_meta), make_unique<ValueExpr>(Value(RECORD_NUM / 2 + 100))));
+  ASSERT_TRUE(ParallelScanner::can_parallel(predicates));
+
+  vector<int> ids;
+  ASSERT_EQ(RC::SUCCESS, scan(predicates, page_count_, WORKER_NUM, ids));
+  ASSERT_EQ(100, static_cast<int>(ids.size()));
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(RECORD_NUM / 2 + i, ids[i]);
+  }
+}
+
+TEST_F(ParallelScannerTest, test_close_early)
+{
+  // 调用者没有读完就关闭，工作线程可能正在等待调用者读取结果，也要能正常退出
+  vector<unique_ptr<Expression>> predicates;
+  ParallelScanner                scanner;
+  ASSERT_EQ(RC::SUCCESS, scanner.open(table_.get(), nullptr, predicates, {}, page_count_, WORKER_NUM));
+  Record record;
+  ASSERT_EQ(RC::SUCCESS, scanner.next(record));
+  scanner.close();
+
+  // 关闭之后可以重新打开
+  ASSERT_EQ(RC::SUCCESS, scanner.open(table_.get(), nullptr, predicates, {}, page_count_, WORKER_NUM));
+  scanner.close();
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("parallel_scanner_test.log", LOG_LEVEL_INFO);
+  TrxKit::init_global("vacuous");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,238 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/log/log.h"
+#include "sql/expr/expression.h"
+#include "sql/operator/physical_operator.h"
+#include "sql/operator/table_get_logical_operator.h"
+#include "sql/optimizer/physical_plan_generator.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/field/field.h"
+#include "storage/table/physical_table.h"
+#include "storage/trx/trx.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+/**
+ * @brief 表扫描选择索引的测试
+ * @details 表 t(a, b, c) 上有索引 idx_a(a)、idx_ab(a, b)、idx_ba(b, a) 和 idx_c(c)，
+ * a 和 b 都取 0..9，c = a * 10 + b，一共100条数据
+ */
+class PhysicalPlanGeneratorTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    filesystem::remove_all(base_dir_);
+    filesystem::create_directories(base_dir_);
+
+    bpm_ = make_unique<BufferPoolManager>(static_cast<int64_t>(DEFAULT_ITEM_NUM_PER_POOL) * BP_PAGE_SIZE);
+    BufferPoolManager::set_instance(bpm_.get());
+
+    AttrInfoSqlNode attrs[3];
+    const char     *names[3] = {"a", "b", "c"};
+    for (int i = 0; i < 3; i++) {
+      attrs[i].type     = INTS;
+      attrs[i].name     = names[i];
+      attrs[i].length   = sizeof(int);
+      attrs[i].nullable = false;
+    }
+
+    const string meta_file = base_dir_ + "/t.table";
+    table_                 = make_unique<PhysicalTable>();
+    ASSERT_EQ(RC::SUCCESS, table_->create(1, meta_file.c_str(), "t", base_dir_.c_str(), 3, attrs));
+
+    for (int a = 0; a < 10; a++) {
+      for (int b = 0; b < 10; b++) {
+        Value  values[3] = {Value(a), Value(b), Value(a * 10 + b)};
+        Record record;
+        ASSERT_EQ(RC::SUCCESS, table_->make_record(3, values, record));
+        ASSERT_EQ(RC::SUCCESS, table_->insert_record(record));
+      }
+    }
+
+    // 创建的顺序决定了条件一样好时选择哪个索引
+    ASSERT_EQ(RC::SUCCESS, create_index("idx_a", {"a"}));
+    ASSERT_EQ(RC::SUCCESS, create_index("idx_ab", {"a", "b"}));
+    ASSERT_EQ(RC::SUCCESS, create_index("idx_ba", {"b", "a"}));
+    ASSERT_EQ(RC::SUCCESS, create_index("idx_c", {"c"}));
+  }
+
+  void TearDown() override
+  {
+    table_.reset();
+    BufferPoolManager::set_instance(nullptr);
+    bpm_.reset();
+    filesystem::remove_all(base_dir_);
+  }
+
+  RC create_index(const char *index_name, const vector<const char *> &field_names)
+  {
+    vector<FieldMeta> field_metas;
+    for (const char *field_name : field_names) {
+      field_metas.push_back(*table_->table_meta().field(field_name));
+    }
+    return table_->create_index(nullptr /*trx*/, field_metas, index_name, false /*unique*/);
+  }
+
+  /**
+   * @brief 字段 op 常量
+   */
+  unique_ptr<Expression> compare(const char *field_name, CompOp op, const Value &value)
+  {
+    return make_unique<ComparisonExpr>(op,
+        make_unique<FieldExpr>(table_.get(), table_->table_meta().field(field_name)),
+        make_unique<ValueExpr>(value));
+  }
+
+  /**
+   * @brief 常量 op 字段
+   */
+  unique_ptr<Expression> compare(const Value &value, CompOp op, const char *field_name)
+  {
+    return make_unique<ComparisonExpr>(op,
+        make_unique<ValueExpr>(value),
+        make_unique<FieldExpr>(table_.get(), table_->table_meta().field(field_name)));
+  }
+
+  unique_ptr<PhysicalOperator> plan(vector<unique_ptr<Expression>> predicates)
+  {
+    vector<Field> fields;
+    for (const char *field_name : {"a", "b", "c"}) {
+      fields.emplace_back(table_.get(), table_->table_meta().field(field_name));
+    }
+    TableGetLogicalOperator table_get_oper(table_.get(), fields, true /*readonly*/);
+    table_get_oper.set_predicates(std::move(predicates));
+
+    PhysicalPlanGenerator        generator;
+    unique_ptr<PhysicalOperator> oper;
+    EXPECT_EQ(RC::SUCCESS, generator.create(table_get_oper, oper));
+    return oper;
+  }
+
+  /**
+   * @brief 执行计划，返回满足条件的记录数
+   */
+  int count(PhysicalOperator &oper)
+  {
+    Trx *trx = TrxKit::instance()->create_trx(nullptr /*log_manager*/);
+    EXPECT_EQ(RC::SUCCESS, oper.open(trx));
+    int num = 0;
+    RC  rc  = RC::SUCCESS;
+    while (RC::SUCCESS == (rc = oper.next())) {
+      num++;
+    }
+    EXPECT_EQ(RC::RECORD_EOF, rc);
+    EXPECT_EQ(RC::SUCCESS, oper.close());
+    TrxKit::instance()->destroy_trx(trx);
+    return num;
+  }
+
+  static vector<unique_ptr<Expression>> predicates(unique_ptr<Expression> first, unique_ptr<Expression> second)
+  {
+    vector<unique_ptr<Expression>> result;
+    result.push_back(std::move(first));
+    result.push_back(std::move(second));
+    return result;
+  }
+
+protected:
+  string                        base_dir_ = "physical_plan_generator_test_dir";
+  unique_ptr<BufferPoolManager> bpm_;
+  unique_ptr<PhysicalTable>     table_;
+};
+
+TEST_F(PhysicalPlanGeneratorTest, test_prefix_equal_and_range)
+{
+  // a = 1 AND b > 5：idx_ab 用到了两个条件，idx_ba 的第一个字段不是等值条件，只能用到 b > 5
+  auto oper = plan(predicates(compare("a", EQUAL_TO, Value(1)), compare("b", GREAT_THAN, Value(5))));
+  ASSERT_EQ(PhysicalOperatorType::INDEX_SCAN, oper->type());
+  ASSERT_EQ("idx_ab ON t ((1,5), 1]", oper->param());
+  ASSERT_EQ(4, count(*oper));
+
+  // 条件写在一个 AND 表达式中也一样
+  vector<unique_ptr<Expression>> conjunction;
+  conjunction.push_back(make_unique<ConjunctionExpr>(
+      CONJ_AND, compare("a", EQUAL_TO, Value(1)), compare("b", LESS_EQUAL, Value(2))));
+  oper = plan(std::move(conjunction));
+  ASSERT_EQ(PhysicalOperatorType::INDEX_SCAN, oper->type());
+  ASSERT_EQ("idx_ab ON t [1, (1,2)]", oper->param());
+  ASSERT_EQ(3, count(*oper));
+}
+
+TEST_F(PhysicalPlanGeneratorTest, test_leftmost_prefix)
+{
+  // 只有 b 上的条件：idx_ab 的第一个字段没有条件，不能使用
+  vector<unique_ptr<Expression>> exprs;
+  exprs.push_back(compare("b", GREAT_THAN, Value(5)));
+  auto oper = plan(std::move(exprs));
+  ASSERT_EQ(PhysicalOperatorType::INDEX_SCAN, oper->type());
+  ASSERT_EQ("idx_ba ON t (5, +inf)", oper->param());
+  ASSERT_EQ(40, count(*oper));
+}
+
+TEST_F(PhysicalPlanGeneratorTest, test_tie_breaking)
+{
+  // 都只用到一个条件时，等值条件的范围更窄
+  auto oper = plan(predicates(compare("a", GREAT_THAN, Value(1)), compare("c", EQUAL_TO, Value(35))));
+  ASSERT_EQ(PhysicalOperatorType::INDEX_SCAN, oper->type());
+  ASSERT_EQ("idx_c ON t [35, 35]", oper->param());
+  ASSERT_EQ(1, count(*oper));
+
+  // 条件的个数和等值条件的个数都一样时，使用先创建的索引
+  oper = plan(predicates(compare("b", EQUAL_TO, Value(2)), compare("a", EQUAL_TO, Value(1))));
+  ASSERT_EQ(PhysicalOperatorType::INDEX_SCAN, oper->type());
+  ASSERT_EQ("idx_ab ON t [(1,2), (1,2)]", oper->param());
+  ASSERT_EQ(1, count(*oper));
+
+  // 常量在左边时比较方向反过来，同一个字段上的条件合并成一个范围
+  oper = plan(predicates(compare(Value(3), GREAT_EQUAL, "a"), compare("a", GREAT_THAN, Value(1))));
+  ASSERT_EQ(PhysicalOperatorType::INDEX_SCAN, oper->type());
+  ASSERT_EQ("idx_a ON t (1, 3]", oper->param());
+  ASSERT_EQ(20, count(*oper));
+}
+
+TEST_F(PhysicalPlanGeneratorTest, test_empty_range)
+{
+  auto oper = plan(predicates(compare("a", GREAT_THAN, Value(5)), compare("a", LESS_THAN, Value(2))));
+  ASSERT_EQ(PhysicalOperatorType::INDEX_SCAN, oper->type());
+  ASSERT_EQ("idx_a ON t (5, 2)", oper->param());
+  ASSERT_EQ(0, count(*oper));
+}
+
+TEST_F(PhysicalPlanGeneratorTest, test_table_scan)
+{
+  // 常量的类型与字段不同时不能直接比较键值
+  vector<unique_ptr<Expression>> exprs;
+  exprs.push_back(compare("a", EQUAL_TO, Value("1")));
+  ASSERT_EQ(PhysicalOperatorType::TABLE_SCAN, plan(std::move(exprs))->type());
+
+  // 不等条件不能使用索引
+  exprs.clear();
+  exprs.push_back(compare("c", NOT_EQUAL, Value(35)));
+  auto oper = plan(std::move(exprs));
+  ASSERT_EQ(PhysicalOperatorType::TABLE_SCAN, oper->type());
+  ASSERT_EQ(99, count(*oper));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("physical_plan_generator_test.log", LOG_LEVEL_INFO);
+  TrxKit::init_global("vacuous");
+  return RUN_ALL_TESTS();
+}
@@ -13,11 +13,13 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include <string.h>
+#include <set>
 #include <sstream>
 
 #include "gtest/gtest.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/record/record_manager.h"
+#include "storage/record/text_file_handler.h"
 #include "storage/trx/vacuous_trx.h"
 
 using namespace common;
@@ -179,11 +181,524 @@ TEST(test_record_page_handler, test_record_file_iterator)
   }
   file_scanner.close_scan();
   ASSERT_EQ(count, rids.size() / 2);
+
+  // 按页面范围分段扫描，每段只返回自己范围内的记录，合起来就是全部记录
+  const int page_count = bp->page_count();
+  ASSERT_GT(page_count, 3);
+  count = 0;
+  for (PageNum start = 0; start < page_count; start += 2) {
+    rc = file_scanner.open_scan(nullptr/*table*/, *bp, &trx, true/*readonly*/, nullptr/*condition_filter*/,
+                                start - 1, start + 2);
+    ASSERT_EQ(rc, RC::SUCCESS);
+    while (file_scanner.has_next()) {
+      rc = file_scanner.next(record);
+      ASSERT_EQ(rc, RC::SUCCESS);
+      ASSERT_GE(record.rid().page_num, start);
+      ASSERT_LT(record.rid().page_num, start + 2);
+      count++;
+    }
+    file_scanner.close_scan();
+  }
+  ASSERT_EQ(count, rids.size() / 2);
   
+  file_handler.close();
+  bpm->close_file(record_manager_file);
+  delete bpm;
+}
+
+TEST(test_record_page_handler, test_slotted_record_page)
+{
+  const char *record_manager_file = "record_manager.bp";
+  ::remove(record_manager_file);
+
+  BufferPoolManager *bpm = new BufferPoolManager();
+  DiskBufferPool *bp = nullptr;
+  RC rc = bpm->create_file(record_manager_file);
+  ASSERT_EQ(rc, RC::SUCCESS);
+
+  rc = bpm->open_file(record_manager_file, bp);
+  ASSERT_EQ(rc, RC::SUCCESS);
+
+  Frame *frame = nullptr;
+  rc = bp->allocate_page(&frame);
+  ASSERT_EQ(rc, RC::SUCCESS);
+
+  // 定长格式一个页面只能放30条左右这么长的记录，短字符串编码之后放得下更多
+  const int record_size = 256;
+  RecordPageHandler record_page_handle;
+  rc = record_page_handle.init_empty_page(*bp, frame->page_num(), record_size, RecordFormat::SLOTTED);
+  ASSERT_EQ(rc, RC::SUCCESS);
+  ASSERT_TRUE(record_page_handle.slotted());
+
+  char buf[record_size];
+  std::vector<RID> rids;
+  while (true) {
+    memset(buf, 0, sizeof(buf));
+    snprintf(buf, sizeof(buf), "record-%d", static_cast<int>(rids.size()));
+    RID rid;
+    rc = record_page_handle.insert_record(buf, &rid);
+    if (rc == RC::RECORD_NOMEM) {
+      break;
+    }
+    ASSERT_EQ(rc, RC::SUCCESS);
+    rids.push_back(rid);
+  }
+  ASSERT_GT(rids.size(), 100);
+  ASSERT_FALSE(record_page_handle.can_insert(RecordPageHandler::slotted_record_length(buf, record_size)));
+
+  Record record;
+  for (size_t i = 0; i < rids.size(); i++) {
+    rc = record_page_handle.get_record(&rids[i], &record);
+    ASSERT_EQ(rc, RC::SUCCESS);
+    ASSERT_EQ(record.len(), record_size);
+    ASSERT_EQ(std::string(record.data()), "record-" + std::to_string(i));
+    ASSERT_EQ(record.data()[record_size - 1], 0);
+  }
+
+  // 删除一半记录，留下的碎片要在插入更长的记录时整理掉
+  for (size_t i = 0; i < rids.size(); i += 2) {
+    rc = record_page_handle.delete_record(&rids[i]);
+    ASSERT_EQ(rc, RC::SUCCESS);
+  }
+  ASSERT_EQ(record_page_handle.delete_record(&rids[0]), RC::RECORD_NOT_EXIST);
+
+  memset(buf, 'a', sizeof(buf));
+  RID long_rid;
+  rc = record_page_handle.insert_record(buf, &long_rid);
+  ASSERT_EQ(rc, RC::SUCCESS);
+
+  // 原地更新：变短、变长、变得在页面上放不下
+  RID &rid = rids[1];
+  memset(buf, 0, sizeof(buf));
+  ASSERT_EQ(record_page_handle.update_record(buf, &rid), RC::SUCCESS);
+  memset(buf, 'b', 200);
+  ASSERT_EQ(record_page_handle.update_record(buf, &rid), RC::SUCCESS);
+  memset(buf, 'c', sizeof(buf));
+  int filled = 0;
+  for (size_t i = 3; i < rids.size(); i += 2) {
+    rc = record_page_handle.update_record(buf, &rids[i]);
+    if (rc == RC::RECORD_NOMEM) {
+      break;
+    }
+    ASSERT_EQ(rc, RC::SUCCESS);
+    filled++;
+  }
+  ASSERT_EQ(rc, RC::RECORD_NOMEM);
+  ASSERT_GT(filled, 0);
+
+  rc = record_page_handle.get_record(&rid, &record);
+  ASSERT_EQ(rc, RC::SUCCESS);
+  ASSERT_EQ(0, memcmp(record.data(), std::string(200, 'b').c_str(), 200));
+  ASSERT_EQ(record.data()[200], 0);
+  rc = record_page_handle.get_record(&long_rid, &record);
+  ASSERT_EQ(rc, RC::SUCCESS);
+  ASSERT_EQ(record.data()[record_size - 1], 'a');
+
+  // 遍历时看到所有剩下的记录
+  int count = 0;
+  RecordPageIterator iterator;
+  iterator.init(record_page_handle);
+  while (iterator.has_next()) {
+    rc = iterator.next(record);
+    ASSERT_EQ(rc, RC::SUCCESS);
+    count++;
+  }
+  ASSERT_EQ(count, static_cast<int>(rids.size() / 2) + 1);
+
+  for (size_t i = 1; i < rids.size(); i += 2) {
+    rc = record_page_handle.get_record(&rids[i], &record);
+    ASSERT_EQ(rc, RC::SUCCESS);
+    if (i == 1) {
+      ASSERT_EQ(record.data()[0], 'b');
+    } else if (i < 3 + 2 * static_cast<size_t>(filled)) {
+      ASSERT_EQ(record.data()[record_size - 1], 'c');
+    } else {
+      ASSERT_EQ(std::string(record.data()), "record-" + std::to_string(i));
+    }
+  }
+
+  record_page_handle.cleanup();
+  bpm->close_file(record_manager_file);
+  delete bpm;
+}
+
+TEST(test_record_page_handler, test_slotted_record_file)
+{
+  const char *record_manager_file = "record_manager.bp";
+  ::remove(record_manager_file);
+
+  BufferPoolManager *bpm = new BufferPoolManager();
+  DiskBufferPool *bp = nullptr;
+  RC rc = bpm->create_file(record_manager_file);
+  ASSERT_EQ(rc, RC::SUCCESS);
+
+  rc = bpm->open_file(record_manager_file, bp);
+  ASSERT_EQ(rc, RC::SUCCESS);
+
+  RecordFileHandler file_handler;
+  rc = file_handler.init(bp, RecordFormat::SLOTTED);
+  ASSERT_EQ(rc, RC::SUCCESS);
+
+  const int record_size = 128;
+  const int record_insert_num = 2000;
+  char record_data[record_size];
+  std::vector<RID> rids;
+  for (int i = 0; i < record_insert_num; i++) {
+    memset(record_data, 0, sizeof(record_data));
+    snprintf(record_data, sizeof(record_data), "%d", i);
+    RID rid;
+    rc = file_handler.insert_record(record_data, sizeof(record_data), &rid);
+    ASSERT_EQ(rc, RC::SUCCESS);
+    rids.push_back(rid);
+  }
+  // 定长格式需要 2000/60 = 34 个页面左右
+  ASSERT_LT(bp->page_count(), 15);
+
+  // 把一部分记录更新成很长的数据，原来的页面放不下时会搬到其它页面
+  for (int i = 0; i < record_insert_num; i += 3) {
+    memset(record_data, 'x', sizeof(record_data));
+    snprintf(record_data, sizeof(record_data), "%d", i);
+    rc = file_handler.update_record(record_data, sizeof(record_data), &rids[i]);
+    ASSERT_EQ(rc, RC::SUCCESS);
+  }
+
+  for (int i = 0; i < record_insert_num; i += 3) {
+    std::string data;
+    rc = file_handler.visit_record(rids[i], true /*readonly*/, [&data](Record &r) { data.assign(r.data(), r.len()); });
+    ASSERT_EQ(rc, RC::SUCCESS);
+    ASSERT_EQ(std::string(data.c_str()), std::to_string(i));
+    ASSERT_EQ(data.back(), 'x');
+  }
+
+  // 修改记录的 visitor 写回页面
+  rc = file_handler.visit_record(rids[1], false /*readonly*/, [](Record &r) { r.data()[record_size - 1] = 'y'; });
+  ASSERT_EQ(rc, RC::SUCCESS);
+  rc = file_handler.visit_record(rids[1], true /*readonly*/, [](Record &r) { ASSERT_EQ(r.data()[record_size - 1], 'y'); });
+  ASSERT_EQ(rc, RC::SUCCESS);
+
+  for (int i = 0; i < record_insert_num; i += 2) {
+    rc = file_handler.delete_record(&rids[i]);
+    ASSERT_EQ(rc, RC::SUCCESS);
+  }
+
+  // 扫描时提前读取的记录在换页之后还要能访问
+  VacuousTrx trx;
+  RecordFileScanner file_scanner;
+  rc = file_scanner.open_scan(nullptr/*table*/, *bp, &trx, true/*readonly*/, nullptr/*condition_filter*/);
+  ASSERT_EQ(rc, RC::SUCCESS);
+
+  std::set<int> values;
+  Record record;
+  while (file_scanner.has_next()) {
+    rc = file_scanner.next(record);
+    ASSERT_EQ(rc, RC::SUCCESS);
+    const int value = atoi(record.data());
+    ASSERT_EQ(value % 2, 1);
+    values.insert(value);
+  }
+  file_scanner.close_scan();
+  ASSERT_EQ(values.size(), record_insert_num / 2);
+
+  file_handler.close();
+  bpm->close_file(record_manager_file);
+  delete bpm;
+}
+
+TEST(test_record_page_handler, test_insert_records)
+{
+  const char *record_manager_file = "record_manager.bp";
+  ::remove(record_manager_file);
+  ::remove(FreeSpaceMap::map_file_name(record_manager_file).c_str());
+
+  BufferPoolManager *bpm = new BufferPoolManager();
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm->create_file(record_manager_file));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(record_manager_file, bp));
+
+  RecordFileHandler file_handler;
+  ASSERT_EQ(RC::SUCCESS, file_handler.init(bp));
+
+  const int record_size = 100;
+  const int record_num = 500;
+  std::vector<std::string> datas(record_num);
+  std::vector<const char *> data_ptrs(record_num);
+  for (int i = 0; i < record_num; i++) {
+    datas[i] = std::string(record_size, '\0');
+    snprintf(&datas[i][0], record_size, "%d", i);
+    data_ptrs[i] = datas[i].data();
+  }
+
+  // 单条插入和批量插入混在一起，批量插入要先填满单条插入留下的页面
+  RID rid;
+  ASSERT_EQ(RC::SUCCESS, file_handler.insert_record(data_ptrs[0], record_size, &rid));
+  std::vector<RID> rids(record_num);
+  ASSERT_EQ(RC::SUCCESS, file_handler.insert_records(data_ptrs.data() + 1, record_num - 1, record_size, rids.data()));
+  ASSERT_EQ(rid.page_num, rids[0].page_num);
+
+  std::set<RID, bool (*)(const RID &, const RID &)> rid_set(
+      [](const RID &left, const RID &right) { return RID::compare(&left, &right) < 0; });
+  rid_set.insert(rid);
+  for (int i = 0; i < record_num - 1; i++) {
+    rid_set.insert(rids[i]);
+    std::string data;
+    ASSERT_EQ(RC::SUCCESS, file_handler.visit_record(rids[i], true /*readonly*/, [&data](Record &r) { data.assign(r.data()); }));
+    ASSERT_EQ(data, std::to_string(i + 1));
+  }
+  ASSERT_EQ(rid_set.size(), static_cast<size_t>(record_num));
+
+  const int page_count = bp->page_count();
+  file_handler.close();
+
+  // 变长格式的批量插入
+  ::remove(FreeSpaceMap::map_file_name(record_manager_file).c_str());
+  ASSERT_EQ(RC::SUCCESS, bpm->close_file(record_manager_file));
+  ::remove(record_manager_file);
+  ASSERT_EQ(RC::SUCCESS, bpm->create_file(record_manager_file));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(record_manager_file, bp));
+  ASSERT_EQ(RC::SUCCESS, file_handler.init(bp, RecordFormat::SLOTTED));
+  ASSERT_EQ(RC::SUCCESS, file_handler.insert_records(data_ptrs.data(), record_num, record_size, rids.data()));
+  ASSERT_LT(bp->page_count(), page_count);
+  for (int i = 0; i < record_num; i++) {
+    std::string data;
+    ASSERT_EQ(RC::SUCCESS, file_handler.visit_record(rids[i], true /*readonly*/, [&data](Record &r) { data.assign(r.data()); }));
+    ASSERT_EQ(data, std::to_string(i));
+  }
+
+  file_handler.close();
   bpm->close_file(record_manager_file);
   delete bpm;
 }
 
+TEST(test_free_space_map, test_free_space_map)
+{
+  const char *map_file = "record_manager.fsm";
+  ::remove(map_file);
+
+  // 新建的映射不可用，需要重建
+  bool loaded = true;
+  FreeSpaceMap map;
+  ASSERT_EQ(RC::SUCCESS, map.open(map_file, 100, 90, loaded));
+  ASSERT_FALSE(loaded);
+  map.set_free(3, true);
+  map.set_free(17, true);
+  map.set_free(64, true);
+  map.set_free(17, false);
+  ASSERT_EQ(RC::SUCCESS, map.close(100, 90));
+
+  std::vector<PageNum> pages;
+  auto collector = [&pages](PageNum page_num) { pages.push_back(page_num); };
+  ASSERT_EQ(RC::SUCCESS, map.open(map_file, 100, 90, loaded));
+  ASSERT_TRUE(loaded);
+  map.for_each_free_page(collector);
+  ASSERT_EQ((std::vector<PageNum>{3, 64}), pages);
+
+  // 没有正常关闭(模拟崩溃)，映射不再可用
+  FreeSpaceMap crashed;
+  ASSERT_EQ(RC::SUCCESS, crashed.open(map_file, 100, 90, loaded));
+  ASSERT_FALSE(loaded);
+  ASSERT_EQ(RC::SUCCESS, crashed.close(100, 90));
+  ASSERT_EQ(RC::SUCCESS, map.close(100, 90));
+
+  // 与数据文件对不上
+  ASSERT_EQ(RC::SUCCESS, map.open(map_file, 101, 91, loaded));
+  ASSERT_FALSE(loaded);
+  ASSERT_EQ(RC::SUCCESS, map.close(101, 91));
+  ::remove(map_file);
+}
+
+TEST(test_free_space_map, test_record_file_reopen)
+{
+  const char *record_manager_file = "record_manager.bp";
+  ::remove(record_manager_file);
+  ::remove(FreeSpaceMap::map_file_name(record_manager_file).c_str());
+
+  BufferPoolManager *bpm = new BufferPoolManager();
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm->create_file(record_manager_file));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(record_manager_file, bp));
+
+  RecordFileHandler file_handler;
+  ASSERT_EQ(RC::SUCCESS, file_handler.init(bp));
+
+  char record_data[100];
+  memset(record_data, 0, sizeof(record_data));
+  std::vector<RID> rids;
+  for (int i = 0; i < 1000; i++) {
+    RID rid;
+    ASSERT_EQ(RC::SUCCESS, file_handler.insert_record(record_data, sizeof(record_data), &rid));
+    rids.push_back(rid);
+  }
+
+  // 腾出第一个页面上的一个槽位，其它页面除了最后一个都是满的
+  const RID deleted = rids.front();
+  ASSERT_EQ(RC::SUCCESS, file_handler.delete_record(&deleted));
+  file_handler.close();
+
+  const int page_count = bp->page_count();
+  ASSERT_EQ(RC::SUCCESS, file_handler.init(bp));
+  RID rid;
+  bool reused = false;
+  for (int i = 0; i < 100 && !reused; i++) {
+    ASSERT_EQ(RC::SUCCESS, file_handler.insert_record(record_data, sizeof(record_data), &rid));
+    reused = (rid == deleted);
+  }
+  ASSERT_TRUE(reused);
+  ASSERT_EQ(page_count, bp->page_count());
+
+  file_handler.close();
+  bpm->close_file(record_manager_file);
+  delete bpm;
+}
+
+TEST(test_zone_map, test_skip_pages)
+{
+  const char *record_manager_file = "record_manager.bp";
+  ::remove(record_manager_file);
+  ::remove(FreeSpaceMap::map_file_name(record_manager_file).c_str());
+  ::remove(ZoneMap::map_file_name(record_manager_file).c_str());
+
+  BufferPoolManager *bpm = new BufferPoolManager();
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm->create_file(record_manager_file));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(record_manager_file, bp));
+
+  // 记录的前4个字节是整数，最后一个字节是 null 位图
+  const int record_size = 100;
+  std::vector<ZoneColumn> columns = {ZoneColumn{INTS, 0, 4, record_size - 1, 1}};
+  RecordFileHandler file_handler;
+  ASSERT_EQ(RC::SUCCESS, file_handler.init(bp, RecordFormat::FIXED, columns));
+
+  const int record_num = 1000;
+  char record_data[record_size];
+  memset(record_data, 0, sizeof(record_data));
+  for (int i = 0; i < record_num; i++) {
+    memcpy(record_data, &i, sizeof(i));
+    record_data[record_size - 1] = (i % 10 == 5) ? 0 : 1;  // 一部分记录是 null
+    RID rid;
+    ASSERT_EQ(RC::SUCCESS, file_handler.insert_record(record_data, record_size, &rid));
+  }
+
+  // 返回扫描到的记录数，满足条件的记录一个都不能少
+  auto scan = [&](CompOp op, const Value &value, int expected) {
+    ZoneCondition condition;
+    condition.column = file_handler.zone_map().find_column(0);
+    condition.op     = op;
+    condition.value  = value;
+
+    RecordFileScanner scanner;
+    scanner.set_zone_conditions(&file_handler.zone_map(), {condition});
+    EXPECT_EQ(RC::SUCCESS, scanner.open_scan(nullptr, *bp, nullptr, true /*readonly*/, nullptr));
+    int    scanned = 0;
+    int    matched = 0;
+    Record record;
+    while (scanner.has_next()) {
+      EXPECT_EQ(RC::SUCCESS, scanner.next(record));
+      int  v = *(int *)record.data();
+      bool result = false;
+      EXPECT_EQ(RC::SUCCESS, Value(v).compare_op(value, op, result));
+      if (result && record.data()[record_size - 1] != 0) {
+        matched++;
+      }
+      scanned++;
+    }
+    scanner.close_scan();
+    EXPECT_EQ(expected, matched);
+    return scanned;
+  };
+
+  // 第一个页面是满的，等于0的记录只在第一个页面上
+  ASSERT_GT(bp->page_count(), 5);
+  const int page_records = scan(EQUAL_TO, Value(0), 1);
+  ASSERT_LT(page_records, record_num / 4);
+  ASSERT_LE(scan(GREAT_EQUAL, Value(900), 90), 100 + page_records);
+  ASSERT_LE(scan(LESS_THAN, Value(2.5f), 3), page_records);
+  ASSERT_LE(scan(EQUAL_TO, Value(400), 1), page_records);
+  ASSERT_EQ(0, scan(GREAT_THAN, Value(record_num), 0));
+  ASSERT_EQ(record_num, scan(NOT_EQUAL, Value(-1), record_num - record_num / 10));
+
+  // 正常关闭之后摘要可以直接使用，删除摘要文件之后会重建
+  file_handler.close();
+  ASSERT_EQ(RC::SUCCESS, file_handler.init(bp, RecordFormat::FIXED, columns));
+  ASSERT_LE(scan(GREAT_EQUAL, Value(900), 90), 100 + page_records);
+  file_handler.close();
+
+  ::remove(ZoneMap::map_file_name(record_manager_file).c_str());
+  ASSERT_EQ(RC::SUCCESS, file_handler.init(bp, RecordFormat::FIXED, columns));
+  ASSERT_LE(scan(LESS_EQUAL, Value(99), 90), 100 + page_records);
+
+  file_handler.close();
+  bpm->close_file(record_manager_file);
+  delete bpm;
+  ::remove(ZoneMap::map_file_name(record_manager_file).c_str());
+}
+
+TEST(test_text_file_handler, test_text_file_handler)
+{
+  const char *text_file = "record_manager.text";
+  ::remove(text_file);
+
+  BufferPoolManager *bpm = new BufferPoolManager();
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm->create_file(text_file));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(text_file, bp));
+
+  TextFileHandler text_handler;
+  ASSERT_EQ(RC::SUCCESS, text_handler.init(bp));
+
+  // 3个半页面的长文本，按页面分段读出来
+  std::string long_text;
+  for (int i = 0; static_cast<int>(long_text.size()) < TextFileHandler::PAGE_DATA_SIZE * 7 / 2; i++) {
+    long_text.append(std::to_string(i)).append(",");
+  }
+  TextRef long_ref;
+  ASSERT_EQ(RC::SUCCESS, text_handler.insert_text(long_text.data(), long_text.size(), long_ref));
+  ASSERT_EQ(static_cast<int>(long_text.size()), long_ref.length);
+
+  TextRef short_ref;
+  ASSERT_EQ(RC::SUCCESS, text_handler.insert_text("hello", 5, short_ref));
+  TextRef empty_ref;
+  ASSERT_EQ(RC::SUCCESS, text_handler.insert_text("", 0, empty_ref));
+  ASSERT_EQ(0, empty_ref.length);
+
+  std::string text;
+  int chunk_num = 0;
+  auto consumer = [&](const char *data, int length) {
+    chunk_num++;
+    text.append(data, length);
+    return RC::SUCCESS;
+  };
+  ASSERT_EQ(RC::SUCCESS, text_handler.read_text(long_ref, consumer));
+  ASSERT_EQ(4, chunk_num);
+  ASSERT_EQ(long_text, text);
+
+  ASSERT_EQ(RC::SUCCESS, text_handler.read_text(short_ref, text));
+  ASSERT_EQ("hello", text);
+  ASSERT_EQ(RC::SUCCESS, text_handler.read_text(empty_ref, text));
+  ASSERT_TRUE(text.empty());
+
+  // 页头都保存在页面上，重新打开文件之后还能读出来
+  text_handler.close();
+  ASSERT_EQ(RC::SUCCESS, bpm->close_file(text_file));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(text_file, bp));
+  ASSERT_EQ(RC::SUCCESS, text_handler.init(bp));
+  ASSERT_EQ(RC::SUCCESS, text_handler.read_text(long_ref, text));
+  ASSERT_EQ(long_text, text);
+
+  // 删除之后页面可以重新使用
+  const int page_count = bp->page_count();
+  ASSERT_EQ(RC::SUCCESS, text_handler.delete_text(long_ref));
+  ASSERT_EQ(RC::SUCCESS, text_handler.insert_text(long_text.data(), long_text.size(), long_ref));
+  ASSERT_EQ(page_count, bp->page_count());
+  ASSERT_EQ(RC::SUCCESS, text_handler.read_text(long_ref, text));
+  ASSERT_EQ(long_text, text);
+  ASSERT_EQ(RC::SUCCESS, text_handler.read_text(short_ref, text));
+  ASSERT_EQ("hello", text);
+
+  text_handler.close();
+  bpm->close_file(text_file);
+  delete bpm;
+}
+
 int main(int argc, char **argv)
 {
   // 分析gtest程序的命令行参数
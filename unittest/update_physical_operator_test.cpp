@@ -0,0 +1,142 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/log/log.h"
+#include "sql/operator/table_scan_physical_operator.h"
+#include "sql/operator/update_physical_operator.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/clog/clog.h"
+#include "storage/field/field.h"
+#include "storage/table/physical_table.h"
+#include "storage/trx/trx.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+class UpdatePhysicalOperatorTest : public testing::Test
+{
+protected:
+  static constexpr int RECORD_NUM = 2000;
+  static constexpr int NAME_LEN   = 200;
+
+  void SetUp() override
+  {
+    filesystem::remove_all(base_dir_);
+    filesystem::create_directories(base_dir_);
+
+    bpm_ = make_unique<BufferPoolManager>(static_cast<int64_t>(DEFAULT_ITEM_NUM_PER_POOL) * BP_PAGE_SIZE);
+    BufferPoolManager::set_instance(bpm_.get());
+    ASSERT_EQ(RC::SUCCESS, log_manager_.init(base_dir_.c_str()));
+
+    AttrInfoSqlNode attrs[2];
+    attrs[0].type     = INTS;
+    attrs[0].name     = "id";
+    attrs[0].length   = sizeof(int);
+    attrs[0].nullable = false;
+    attrs[1].type     = CHARS;
+    attrs[1].name     = "name";
+    attrs[1].length   = NAME_LEN;
+    attrs[1].nullable = false;
+
+    // 变长格式的页面上，短字符串只占很少的空间，修改成长字符串之后原来的页面就放不下了
+    const string meta_file = base_dir_ + "/t.table";
+    table_                 = make_unique<PhysicalTable>();
+    ASSERT_EQ(RC::SUCCESS,
+        table_->create(1, meta_file.c_str(), "t", base_dir_.c_str(), 2, attrs, nullptr /*compression*/, "slotted"));
+
+    Trx *trx = TrxKit::instance()->create_trx(&log_manager_);
+    ASSERT_EQ(RC::SUCCESS, trx->start_if_need());
+    for (int i = 0; i < RECORD_NUM; i++) {
+      Value  values[2] = {Value(i), Value("a")};
+      Record record;
+      ASSERT_EQ(RC::SUCCESS, table_->make_record(2, values, record));
+      ASSERT_EQ(RC::SUCCESS, trx->insert_record(table_.get(), record));
+    }
+    ASSERT_EQ(RC::SUCCESS, trx->commit());
+    TrxKit::instance()->destroy_trx(trx);
+    ASSERT_GT(table_->record_handler()->page_count(), 1);
+  }
+
+  void TearDown() override
+  {
+    table_.reset();
+    BufferPoolManager::set_instance(nullptr);
+    bpm_.reset();
+    filesystem::remove_all(base_dir_);
+  }
+
+protected:
+  string                        base_dir_ = "update_physical_operator_test_dir";
+  unique_ptr<BufferPoolManager> bpm_;
+  CLogManager                   log_manager_;
+  unique_ptr<PhysicalTable>     table_;
+};
+
+TEST_F(UpdatePhysicalOperatorTest, test_grow_records_across_pages)
+{
+  const int page_count = table_->record_handler()->page_count();
+
+  // 每条记录都变长，大部分要移动到后面的页面，扫描还没有到达这些页面
+  const string new_name(NAME_LEN - 1, 'x');
+  vector<const FieldMeta *> field_metas = {table_->table_meta().field("name")};
+  vector<Value>             values      = {Value(new_name.c_str())};
+
+  Trx *trx = TrxKit::instance()->create_trx(&log_manager_);
+  ASSERT_EQ(RC::SUCCESS, trx->start_if_need());
+
+  UpdatePhysicalOperator update_oper(table_.get(), values, field_metas);
+  update_oper.add_child(make_unique<TableScanPhysicalOperator>(table_.get(), false /*readonly*/));
+  ASSERT_EQ(RC::SUCCESS, update_oper.open(trx));
+  ASSERT_EQ(RC::RECORD_EOF, update_oper.next());
+  ASSERT_EQ(RC::SUCCESS, update_oper.close());
+  ASSERT_EQ(RC::SUCCESS, trx->commit());
+  TrxKit::instance()->destroy_trx(trx);
+  ASSERT_GT(table_->record_handler()->page_count(), page_count);
+
+  // 每一行都只出现一次，并且都是新的值
+  trx = TrxKit::instance()->create_trx(&log_manager_);
+  ASSERT_EQ(RC::SUCCESS, trx->start_if_need());
+
+  Field id_field(table_.get(), table_->table_meta().field("id"));
+  Field name_field(table_.get(), table_->table_meta().field("name"));
+
+  TableScanPhysicalOperator scan_oper(table_.get(), true /*readonly*/);
+  ASSERT_EQ(RC::SUCCESS, scan_oper.open(trx));
+  vector<int> id_count(RECORD_NUM, 0);
+  RC          rc = RC::SUCCESS;
+  while (RC::SUCCESS == (rc = scan_oper.next())) {
+    Record &record = static_cast<RowTuple *>(scan_oper.current_tuple())->record();
+    const int id   = id_field.get_int(record);
+    ASSERT_TRUE(id >= 0 && id < RECORD_NUM);
+    id_count[id]++;
+    ASSERT_EQ(new_name, string(record.data() + name_field.meta()->offset()));
+  }
+  ASSERT_EQ(RC::RECORD_EOF, rc);
+  ASSERT_EQ(RC::SUCCESS, scan_oper.close());
+  for (int i = 0; i < RECORD_NUM; i++) {
+    ASSERT_EQ(1, id_count[i]) << "id " << i;
+  }
+  ASSERT_EQ(RC::SUCCESS, trx->commit());
+  TrxKit::instance()->destroy_trx(trx);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  LoggerFactory::init_default("update_physical_operator_test.log", LOG_LEVEL_INFO);
+  TrxKit::init_global("mvcc");
+  return RUN_ALL_TESTS();
+}